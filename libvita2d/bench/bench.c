@@ -0,0 +1,353 @@
+/*
+ * Host CPU microbenchmarks for vita2d's hot paths. vita2d's own sources run on
+ * the vitaGL shim in shim/: the draw timings use its null mode, which records
+ * the draws without rasterizing them, so they measure vita2d's vertex math,
+ * batching and glyph caching. The _raster variants put the vita2d_sw
+ * rasterizer behind the same calls.
+ *
+ * Usage: bench [-s scale] [-o output.json]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <vitagl_sw.h>
+#include "vita2d_vgl.h"
+#include "texture_atlas.h"
+#include "int_htab.h"
+#include "bin_packing_2d.h"
+#include "utils.h"
+
+#define MAX_RESULTS 64
+
+typedef struct bench_result {
+	const char *name;
+	unsigned long iterations;
+	double ns_per_op;
+} bench_result;
+
+static bench_result results[MAX_RESULTS];
+static int num_results;
+static double scale = 1.0;
+static volatile unsigned int sink;
+
+static vita2d_texture *texture;
+static vita2d_font *font;
+static vita2d_pgf *pgf;
+static vita2d_pvf *pvf;
+
+static const char text[] = "The quick brown fox jumps over the lazy dog";
+
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long iterations(unsigned long base)
+{
+	unsigned long n = base * scale;
+	return n ? n : 1;
+}
+
+static void report(const char *name, unsigned long n, double elapsed)
+{
+	bench_result *r = &results[num_results++];
+	r->name = name;
+	r->iterations = n;
+	r->ns_per_op = elapsed / n;
+	fprintf(stderr, "%-48s %12.2f ns/op\n", name, r->ns_per_op);
+}
+
+/* Times n calls, including the flush of whatever they left batched */
+#define BENCH_DRAW(name, base, call) do { \
+		unsigned long i_, n_ = iterations(base); \
+		double start_ = now_ns(); \
+		for (i_ = 0; i_ < n_; i_++) \
+			call; \
+		vita2d_wait_rendering_done(); \
+		report(name, n_, now_ns() - start_); \
+	} while (0)
+
+static void bench_draws(void)
+{
+	const unsigned int tint = RGBA8(0xFF, 0x80, 0x40, 0xC0);
+
+	vitagl_sw_set_rasterize(0);
+
+	BENCH_DRAW("vita2d_draw_rectangle", 2000000, vita2d_draw_rectangle(100.5f, 80.5f, 100, 100, RGBA8(0xFF, 0, 0, 0xFF)));
+	BENCH_DRAW("vita2d_draw_fill_circle", 200000, vita2d_draw_fill_circle(300, 200, 50, RGBA8(0, 0xFF, 0, 0xFF)));
+	BENCH_DRAW("vita2d_draw_texture", 5000000, vita2d_draw_texture(texture, 100.5f, 80.5f));
+	BENCH_DRAW("vita2d_draw_texture_tint", 5000000, vita2d_draw_texture_tint(texture, 100.5f, 80.5f, tint));
+	BENCH_DRAW("vita2d_draw_texture_scale", 5000000, vita2d_draw_texture_scale(texture, 100.5f, 80.5f, 2, 2));
+	BENCH_DRAW("vita2d_draw_texture_rotate", 5000000, vita2d_draw_texture_rotate(texture, 132.5f, 112.5f, 0.5f));
+	BENCH_DRAW("vita2d_draw_texture_rotate_hotspot", 5000000, vita2d_draw_texture_rotate_hotspot(texture, 132.5f, 112.5f, 0.5f, 8, 8));
+	BENCH_DRAW("vita2d_draw_texture_part", 5000000, vita2d_draw_texture_part(texture, 100.5f, 80.5f, 16, 16, 32, 32));
+	BENCH_DRAW("vita2d_draw_texture_part_scale", 5000000, vita2d_draw_texture_part_scale(texture, 100.5f, 80.5f, 16, 16, 32, 32, 2, 2));
+	BENCH_DRAW("vita2d_draw_texture_scale_rotate", 5000000, vita2d_draw_texture_scale_rotate(texture, 164.5f, 144.5f, 2, 2, 0.5f));
+	BENCH_DRAW("vita2d_draw_texture_scale_rotate_hotspot", 5000000, vita2d_draw_texture_scale_rotate_hotspot(texture, 164.5f, 144.5f, 2, 2, 0.5f, 8, 8));
+	BENCH_DRAW("vita2d_draw_texture_part_scale_rotate", 5000000, vita2d_draw_texture_part_scale_rotate(texture, 132.5f, 112.5f, 16, 16, 32, 32, 2, 2, 0.5f));
+	BENCH_DRAW("vita2d_draw_texture_tint_scale_rotate", 5000000, vita2d_draw_texture_tint_scale_rotate(texture, 164.5f, 144.5f, 2, 2, 0.5f, tint));
+	BENCH_DRAW("vita2d_draw_texture_tint_scale", 5000000, vita2d_draw_texture_tint_scale(texture, 100.5f, 80.5f, 2, 2, tint));
+	BENCH_DRAW("vita2d_draw_texture_tint_rotate", 5000000, vita2d_draw_texture_tint_rotate(texture, 132.5f, 112.5f, 0.5f, tint));
+	BENCH_DRAW("vita2d_draw_texture_tint_rotate_hotspot", 5000000, vita2d_draw_texture_tint_rotate_hotspot(texture, 132.5f, 112.5f, 0.5f, 8, 8, tint));
+	BENCH_DRAW("vita2d_draw_texture_tint_part", 5000000, vita2d_draw_texture_tint_part(texture, 100.5f, 80.5f, 16, 16, 32, 32, tint));
+	BENCH_DRAW("vita2d_draw_texture_tint_part_scale", 5000000, vita2d_draw_texture_tint_part_scale(texture, 100.5f, 80.5f, 16, 16, 32, 32, 2, 2, tint));
+	BENCH_DRAW("vita2d_draw_texture_tint_scale_rotate_hotspot", 5000000, vita2d_draw_texture_tint_scale_rotate_hotspot(texture, 164.5f, 144.5f, 2, 2, 0.5f, 8, 8, tint));
+	BENCH_DRAW("vita2d_draw_texture_part_tint_scale_rotate", 5000000, vita2d_draw_texture_part_tint_scale_rotate(texture, 132.5f, 112.5f, 16, 16, 32, 32, 2, 2, 0.5f, tint));
+
+	/* Glyphs are cached on the first draw, time the steady state */
+	vita2d_font_draw_text(font, 20, 300, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 16, text);
+	vita2d_pgf_draw_text(pgf, 20, 300, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 1.0f, text);
+	vita2d_pvf_draw_text(pvf, 20, 300, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 1.0f, text);
+	BENCH_DRAW("vita2d_font_draw_text", 200000, vita2d_font_draw_text(font, 20, 300, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 16, text));
+	BENCH_DRAW("vita2d_pgf_draw_text", 200000, vita2d_pgf_draw_text(pgf, 20, 300, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 1.0f, text));
+	BENCH_DRAW("vita2d_pvf_draw_text", 200000, vita2d_pvf_draw_text(pvf, 20, 300, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 1.0f, text));
+
+	vitagl_sw_set_rasterize(1);
+
+	BENCH_DRAW("vita2d_draw_rectangle_raster", 200000, vita2d_draw_rectangle(100.5f, 80.5f, 100, 100, RGBA8(0xFF, 0, 0, 0xFF)));
+	BENCH_DRAW("vita2d_draw_rectangle_alpha_raster", 200000, vita2d_draw_rectangle(100.5f, 80.5f, 100, 100, RGBA8(0xFF, 0, 0, 0x80)));
+	vita2d_set_blend_mode_add(1);
+	BENCH_DRAW("vita2d_draw_rectangle_additive_raster", 200000, vita2d_draw_rectangle(100.5f, 80.5f, 100, 100, RGBA8(0xFF, 0, 0, 0x80)));
+	vita2d_set_blend_mode_add(0);
+	BENCH_DRAW("vita2d_draw_fill_circle_raster", 50000, vita2d_draw_fill_circle(300, 200, 50, RGBA8(0, 0xFF, 0, 0xFF)));
+	BENCH_DRAW("vita2d_draw_texture_raster", 50000, vita2d_draw_texture(texture, 100.5f, 80.5f));
+	BENCH_DRAW("vita2d_draw_texture_scale_rotate_raster", 20000, vita2d_draw_texture_scale_rotate(texture, 164.5f, 144.5f, 2, 2, 0.5f));
+	vita2d_texture_set_filters(texture, SCE_GXM_TEXTURE_FILTER_LINEAR, SCE_GXM_TEXTURE_FILTER_LINEAR);
+	BENCH_DRAW("vita2d_draw_texture_scale_linear_raster", 20000, vita2d_draw_texture_scale(texture, 100.5f, 80.5f, 2, 2));
+	vita2d_texture_set_filters(texture, SCE_GXM_TEXTURE_FILTER_POINT, SCE_GXM_TEXTURE_FILTER_POINT);
+	BENCH_DRAW("vita2d_font_draw_text_raster", 20000, vita2d_font_draw_text(font, 20, 300, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 16, text));
+}
+
+static void bench_texture_atlas(void)
+{
+	const unsigned int keys = 1024;
+	unsigned long i, n = iterations(1000000);
+	unsigned long inserted = 0;
+	texture_atlas_entry_data data = {0};
+	bp2d_rectangle rect;
+	bp2d_position pos;
+	double start, elapsed = 0;
+	texture_atlas *atlas;
+
+	/* The glyph cache pattern: fill, then recreate once the atlas is full */
+	atlas = texture_atlas_create(512, 512, SCE_GXM_TEXTURE_FORMAT_U8_R);
+	for (i = 0; i < n; i++) {
+		bp2d_size size = {8 + i % 13, 10 + i % 7};
+		start = now_ns();
+		int ret = texture_atlas_insert(atlas, i, &size, &data, &pos);
+		elapsed += now_ns() - start;
+		if (!ret) {
+			texture_atlas_free(atlas);
+			atlas = texture_atlas_create(512, 512, SCE_GXM_TEXTURE_FORMAT_U8_R);
+		}
+		inserted++;
+	}
+	report("texture_atlas_insert", inserted, elapsed);
+	texture_atlas_free(atlas);
+
+	atlas = texture_atlas_create(1024, 1024, SCE_GXM_TEXTURE_FORMAT_U8_R);
+	for (i = 0; i < keys; i++) {
+		bp2d_size size = {8 + i % 13, 10 + i % 7};
+		texture_atlas_insert(atlas, i, &size, &data, &pos);
+	}
+
+	n = iterations(10000000);
+	start = now_ns();
+	for (i = 0; i < n; i++)
+		sink += texture_atlas_get(atlas, i % keys, &rect, &data);
+	report("texture_atlas_get", n, now_ns() - start);
+
+	texture_atlas_free(atlas);
+}
+
+static void bench_int_htab(void)
+{
+	const unsigned int keys = 4096;
+	unsigned long i, n = iterations(10000000);
+	unsigned int k;
+	int_htab *htab;
+	void **values;
+	unsigned char *erased;
+	double start, elapsed;
+
+	/* int_htab_free frees the values, so every key gets its own allocation */
+	values = malloc(keys * sizeof(*values));
+	erased = malloc(keys);
+
+	elapsed = 0;
+	for (i = 0; i < n / keys; i++) {
+		for (k = 0; k < keys; k++)
+			values[k] = malloc(sizeof(unsigned int));
+		htab = int_htab_create(256);
+		start = now_ns();
+		for (k = 0; k < keys; k++)
+			int_htab_insert(htab, k * 2654435761U, values[k]);
+		elapsed += now_ns() - start;
+		int_htab_free(htab);
+	}
+	report("int_htab_insert", (n / keys) * keys, elapsed);
+
+	htab = int_htab_create(256);
+	for (k = 0; k < keys; k++)
+		int_htab_insert(htab, k * 2654435761U, malloc(sizeof(unsigned int)));
+
+	start = now_ns();
+	for (i = 0; i < n; i++)
+		sink += int_htab_find(htab, (i % keys) * 2654435761U) != NULL;
+	report("int_htab_find", n, now_ns() - start);
+
+	start = now_ns();
+	for (i = 0; i < n; i++)
+		sink += int_htab_find(htab, (i % keys) * 2654435761U + 1) != NULL;
+	report("int_htab_find_miss", n, now_ns() - start);
+
+	int_htab_free(htab);
+
+	/* Erased values are ours again, the ones erase missed still belong to the table */
+	elapsed = 0;
+	for (i = 0; i < n / keys; i++) {
+		htab = int_htab_create(8192);
+		for (k = 0; k < keys; k++)
+			int_htab_insert(htab, k * 2654435761U, malloc(sizeof(unsigned int)));
+		for (k = 0; k < keys; k++)
+			values[k] = int_htab_find(htab, k * 2654435761U);
+		start = now_ns();
+		for (k = 0; k < keys; k++)
+			erased[k] = int_htab_erase(htab, k * 2654435761U);
+		elapsed += now_ns() - start;
+		for (k = 0; k < keys; k++) {
+			if (erased[k])
+				free(values[k]);
+		}
+		int_htab_free(htab);
+	}
+	report("int_htab_erase", (n / keys) * keys, elapsed);
+
+	free(values);
+	free(erased);
+}
+
+/* bp2d is the packer behind texture_atlas_insert */
+static void bench_bin_packing(void)
+{
+	bp2d_rectangle rect = {0, 0, 512, 512};
+	unsigned long i, n = iterations(1000000);
+	unsigned long inserted = 0;
+	bp2d_node *root = bp2d_create(&rect);
+
+	double start = now_ns();
+	for (i = 0; i < n; i++) {
+		bp2d_size size = {8 + i % 13, 10 + i % 7};
+		bp2d_position pos;
+		if (!bp2d_insert(root, &size, &pos, NULL)) {
+			bp2d_free(root);
+			root = bp2d_create(&rect);
+		}
+		inserted++;
+	}
+	report("bp2d_insert", inserted, now_ns() - start);
+
+	bp2d_free(root);
+}
+
+static void bench_utf8_to_ucs2(void)
+{
+	static const char text[] = "ascii text, \xc3\xa9\xc3\xa8 latin, \xe3\x81\x82\xe3\x81\x84 kana";
+	unsigned long i, n = iterations(10000000);
+	unsigned long chars = 0;
+	unsigned int character;
+	int j;
+
+	double start = now_ns();
+	for (i = 0; i < n; ) {
+		for (j = 0; text[j] && i < n; i++, chars++) {
+			j += utf8_to_ucs2(&text[j], &character);
+			sink += character;
+		}
+	}
+	report("utf8_to_ucs2", chars, now_ns() - start);
+}
+
+static int write_json(FILE *fp)
+{
+	int i;
+	fprintf(fp, "{\n\t\"unit\": \"ns/op\",\n\t\"results\": [\n");
+	for (i = 0; i < num_results; i++) {
+		fprintf(fp, "\t\t{\"name\": \"%s\", \"iterations\": %lu, \"ns_per_op\": %.3f}%s\n",
+			results[i].name, results[i].iterations, results[i].ns_per_op,
+			i + 1 < num_results ? "," : "");
+	}
+	fprintf(fp, "\t]\n}\n");
+	return ferror(fp) ? -1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *output = NULL;
+	const void *font_data;
+	size_t font_size;
+	unsigned int *pixels;
+	unsigned int stride;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+			scale = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+			output = argv[++i];
+		} else {
+			fprintf(stderr, "usage: %s [-s scale] [-o output.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	vita2d_init();
+	font_data = vitagl_sw_get_builtin_font(&font_size);
+	texture = vita2d_create_empty_texture(64, 64);
+	font = font_data ? vita2d_load_font_mem(font_data, font_size) : NULL;
+	pgf = vita2d_load_default_pgf();
+	pvf = vita2d_load_default_pvf();
+	if (!texture || !font || !pgf || !pvf) {
+		fprintf(stderr, "bench: vita2d setup failed\n");
+		return 1;
+	}
+
+	pixels = vita2d_texture_get_datap(texture);
+	stride = vita2d_texture_get_stride(texture) / 4;
+	for (i = 0; i < 64 * 64; i++)
+		pixels[(i / 64) * stride + i % 64] = RGBA8(i, i >> 3, i >> 6, 0x80 + (i & 0x7F));
+
+	vita2d_start_drawing();
+	vita2d_clear_screen();
+	bench_draws();
+	vita2d_end_drawing();
+
+	bench_texture_atlas();
+	bench_int_htab();
+	bench_bin_packing();
+	bench_utf8_to_ucs2();
+
+	vita2d_free_font(font);
+	vita2d_free_pgf(pgf);
+	vita2d_free_pvf(pvf);
+	vita2d_free_texture(texture);
+	vita2d_fini();
+
+	if (output) {
+		FILE *fp = fopen(output, "w");
+		if (!fp) {
+			perror(output);
+			return 1;
+		}
+		int ret = write_json(fp);
+		fclose(fp);
+		return ret ? 1 : 0;
+	}
+
+	return write_json(stdout) ? 1 : 0;
+}
@@ -0,0 +1,791 @@
+/*
+ * Host benchmark for the image decoding behind vita2d_load_*_buffer/file.
+ * Runs a generated corpus (PNG paletted, RGBA and interlaced, baseline and
+ * progressive JPEG, BMP, each at several sizes) plus any files from -d through:
+ *   buffer    image_decode_buffer, what vita2d_load_*_buffer calls
+ *   stream    image_decode_callbacks, what vita2d_load_*_file calls
+ *   stb_image stbi_load_from_memory, the fallback vita2d.c compiles in
+ * Registered decoders show up in the per-decoder stats at the end.
+ * Images with oversized headers are checked first, they must be rejected
+ * before the destination is allocated.
+ *
+ * Usage: decode_bench [-s scale] [-d corpus_dir] [-o output.json]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <png.h>
+#include <zlib.h>
+#include <jpeglib.h>
+#include "image_decode.h"
+
+// vita2d's copy of stb_image uses the SceLibc memcpy
+#define sceClibMemcpy memcpy
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#define MAX_IMAGES  128
+#define MAX_RESULTS (MAX_IMAGES * 3)
+
+typedef struct corpus_image {
+	char name[256];
+	uint8_t *data;
+	unsigned long size;
+} corpus_image;
+
+typedef struct bench_result {
+	char name[272];
+	const char *decoder;
+	unsigned long bytes_in;
+	unsigned int w;
+	unsigned int h;
+	unsigned long iterations;
+	double ms_per_image;
+	double mb_per_s;   // encoded input
+	double mpix_per_s;
+	size_t peak_heap;  // bytes above the starting point, including the output
+} bench_result;
+
+static corpus_image corpus[MAX_IMAGES];
+static int num_images;
+static bench_result results[MAX_RESULTS];
+static int num_results;
+static double scale = 1.0;
+
+/*
+ * Peak heap tracking: malloc and friends are replaced for the whole process
+ * (libpng, libjpeg and zlib included) and forwarded to glibc.
+ */
+#ifdef __GLIBC__
+#include <malloc.h>
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
+
+static size_t heap_used;
+static size_t heap_peak;
+
+static void *heap_track(void *ptr)
+{
+	if (ptr) {
+		heap_used += malloc_usable_size(ptr);
+		if (heap_used > heap_peak)
+			heap_peak = heap_used;
+	}
+	return ptr;
+}
+
+void *malloc(size_t size)
+{
+	return heap_track(__libc_malloc(size));
+}
+
+void *calloc(size_t n, size_t size)
+{
+	return heap_track(__libc_calloc(n, size));
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	if (ptr)
+		heap_used -= malloc_usable_size(ptr);
+	void *r = __libc_realloc(ptr, size);
+	if (!r && ptr && size) {
+		heap_used += malloc_usable_size(ptr);
+		return NULL;
+	}
+	return heap_track(r);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+	return heap_track(__libc_memalign(alignment, size));
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+	return heap_track(__libc_memalign(alignment, size));
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+	void *r = heap_track(__libc_memalign(alignment, size));
+	if (!r)
+		return 12; // ENOMEM
+	*ptr = r;
+	return 0;
+}
+
+void free(void *ptr)
+{
+	if (ptr)
+		heap_used -= malloc_usable_size(ptr);
+	__libc_free(ptr);
+}
+
+static void heap_reset_peak(void)
+{
+	heap_peak = heap_used;
+}
+
+static size_t heap_peak_since(size_t start)
+{
+	return heap_peak - start;
+}
+
+static size_t heap_current(void)
+{
+	return heap_used;
+}
+#else
+static void heap_reset_peak(void)
+{
+}
+
+static size_t heap_peak_since(size_t start)
+{
+	return 0;
+}
+
+static size_t heap_current(void)
+{
+	return 0;
+}
+#endif
+
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Mirrors vita2d.c's stb_image fallback decoder
+static int stb_copy(uint8_t *data, int w, int h, image_decode_alloc alloc, void *userdata)
+{
+	unsigned int stride;
+	int y;
+
+	if (!data)
+		return IMAGE_DECODE_UNSUPPORTED;
+
+	uint8_t *dst = alloc(w, h, &stride, userdata);
+	if (dst) {
+		for (y = 0; y < h; y++)
+			memcpy(dst + y * stride, data + y * w * 4, w * 4);
+	}
+	stbi_image_free(data);
+	return dst ? IMAGE_DECODE_OK : IMAGE_DECODE_ERROR;
+}
+
+static int stb_decode_buffer(const void *buffer, unsigned long size, image_decode_alloc alloc, void *userdata)
+{
+	int w, h;
+	uint8_t *data = stbi_load_from_memory(buffer, size, &w, &h, NULL, 4);
+	return stb_copy(data, w, h, alloc, userdata);
+}
+
+static int stb_read(void *user, char *data, int size)
+{
+	return image_stream_read(user, data, size);
+}
+
+static void stb_skip(void *user, int n)
+{
+	if (n > 0)
+		image_stream_skip(user, n);
+}
+
+static int stb_eof(void *user)
+{
+	return image_stream_eof(user);
+}
+
+static int stb_decode_stream(image_stream *stream, image_decode_alloc alloc, void *userdata)
+{
+	const stbi_io_callbacks io = {stb_read, stb_skip, stb_eof};
+	int w, h;
+	uint8_t *data = stbi_load_from_callbacks(&io, stream, &w, &h, NULL, 4);
+	return stb_copy(data, w, h, alloc, userdata);
+}
+
+static const image_decoder stb_decoder = {"stb_image", NULL, 0, NULL, stb_decode_buffer, stb_decode_stream};
+
+/* Destination laid out like a vita2d texture (8 pixel aligned rows) */
+
+typedef struct destination {
+	uint8_t *pixels;
+	unsigned int w;
+	unsigned int h;
+} destination;
+
+static void *alloc_destination(unsigned int w, unsigned int h, unsigned int *stride, void *userdata)
+{
+	destination *dst = userdata;
+
+	*stride = ((w + 7) & ~7) * 4;
+	dst->pixels = malloc((size_t)*stride * h);
+	dst->w = w;
+	dst->h = h;
+	return dst->pixels;
+}
+
+/* Corpus generation */
+
+// Smooth gradients with some noise, compresses roughly like a photo or UI art
+static uint8_t *generate_pixels(unsigned int w, unsigned int h)
+{
+	uint8_t *pixels = malloc(w * h * 4);
+	unsigned int x, y, seed = 0x12345678;
+
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			uint8_t *p = pixels + (y * w + x) * 4;
+			seed = seed * 1664525 + 1013904223;
+			unsigned int noise = (seed >> 24) & 0x0F;
+			p[0] = (x * 255 / w + noise) & 0xFF;
+			p[1] = (y * 255 / h + noise) & 0xFF;
+			p[2] = ((x + y) * 128 / (w + h) + ((x / 16 + y / 16) & 1) * 64) & 0xFF;
+			p[3] = 0x80 + (x * 127 / w);
+		}
+	}
+	return pixels;
+}
+
+typedef struct memory_writer {
+	uint8_t *data;
+	unsigned long size;
+	unsigned long capacity;
+} memory_writer;
+
+static void memory_write(memory_writer *mem, const void *data, unsigned long size)
+{
+	if (mem->size + size > mem->capacity) {
+		while (mem->size + size > mem->capacity)
+			mem->capacity = mem->capacity ? mem->capacity * 2 : 4096;
+		mem->data = realloc(mem->data, mem->capacity);
+	}
+	memcpy(mem->data + mem->size, data, size);
+	mem->size += size;
+}
+
+static void png_write_memory(png_structp png_ptr, png_bytep data, png_size_t size)
+{
+	memory_write(png_get_io_ptr(png_ptr), data, size);
+}
+
+static void png_flush_memory(png_structp png_ptr)
+{
+}
+
+static void encode_png(memory_writer *out, const uint8_t *pixels, unsigned int w, unsigned int h, int paletted, int interlaced)
+{
+	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	png_infop info_ptr = png_create_info_struct(png_ptr);
+	uint8_t *row = malloc(w * 4);
+	unsigned int x, y;
+	int passes, pass;
+
+	png_set_write_fn(png_ptr, out, png_write_memory, png_flush_memory);
+	png_set_IHDR(png_ptr, info_ptr, w, h, 8, paletted ? PNG_COLOR_TYPE_PALETTE : PNG_COLOR_TYPE_RGBA,
+		     interlaced ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+	// 6x6x6 color cube
+	if (paletted) {
+		png_color palette[216];
+		for (x = 0; x < 216; x++) {
+			palette[x].red = (x % 6) * 51;
+			palette[x].green = (x / 6 % 6) * 51;
+			palette[x].blue = (x / 36) * 51;
+		}
+		png_set_PLTE(png_ptr, info_ptr, palette, 216);
+	}
+
+	png_write_info(png_ptr, info_ptr);
+	passes = png_set_interlace_handling(png_ptr);
+	for (pass = 0; pass < passes; pass++) {
+		for (y = 0; y < h; y++) {
+			const uint8_t *p = pixels + y * w * 4;
+			if (paletted) {
+				for (x = 0; x < w; x++, p += 4)
+					row[x] = p[0] / 43 + p[1] / 43 * 6 + p[2] / 43 * 36;
+				png_write_row(png_ptr, row);
+			} else {
+				png_write_row(png_ptr, (png_bytep)p);
+			}
+		}
+	}
+	png_write_end(png_ptr, NULL);
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+	free(row);
+}
+
+static void encode_jpeg(memory_writer *out, const uint8_t *pixels, unsigned int w, unsigned int h, int progressive)
+{
+	struct jpeg_compress_struct cinfo;
+	struct jpeg_error_mgr err;
+	unsigned char *data = NULL;
+	unsigned long size = 0;
+	uint8_t *row = malloc(w * 3);
+	unsigned int x;
+
+	cinfo.err = jpeg_std_error(&err);
+	jpeg_create_compress(&cinfo);
+	jpeg_mem_dest(&cinfo, &data, &size);
+	cinfo.image_width = w;
+	cinfo.image_height = h;
+	cinfo.input_components = 3;
+	cinfo.in_color_space = JCS_RGB;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, 90, TRUE);
+	if (progressive)
+		jpeg_simple_progression(&cinfo);
+
+	jpeg_start_compress(&cinfo, TRUE);
+	while (cinfo.next_scanline < h) {
+		const uint8_t *p = pixels + cinfo.next_scanline * w * 4;
+		for (x = 0; x < w; x++) {
+			row[x * 3 + 0] = p[x * 4 + 0];
+			row[x * 3 + 1] = p[x * 4 + 1];
+			row[x * 3 + 2] = p[x * 4 + 2];
+		}
+		jpeg_write_scanlines(&cinfo, &row, 1);
+	}
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+
+	memory_write(out, data, size);
+	free(data);
+	free(row);
+}
+
+static void put_le(uint8_t *p, uint32_t v, int bytes)
+{
+	while (bytes-- > 0) {
+		*p++ = v & 0xFF;
+		v >>= 8;
+	}
+}
+
+// 24 bpp, bottom-up
+static void encode_bmp(memory_writer *out, const uint8_t *pixels, unsigned int w, unsigned int h)
+{
+	unsigned int row_size = (w * 3 + 3) & ~3;
+	uint8_t header[54] = {'B', 'M'};
+	uint8_t *row = calloc(row_size, 1);
+	unsigned int x, y;
+
+	put_le(header + 2, sizeof(header) + row_size * h, 4);
+	put_le(header + 10, sizeof(header), 4);
+	put_le(header + 14, 40, 4);
+	put_le(header + 18, w, 4);
+	put_le(header + 22, h, 4);
+	put_le(header + 26, 1, 2);
+	put_le(header + 28, 24, 2);
+	put_le(header + 34, row_size * h, 4);
+	memory_write(out, header, sizeof(header));
+
+	for (y = h; y-- > 0;) {
+		const uint8_t *p = pixels + y * w * 4;
+		for (x = 0; x < w; x++, p += 4) {
+			row[x * 3 + 0] = p[2];
+			row[x * 3 + 1] = p[1];
+			row[x * 3 + 2] = p[0];
+		}
+		memory_write(out, row, row_size);
+	}
+	free(row);
+}
+
+static void add_image(const char *name, uint8_t *data, unsigned long size)
+{
+	if (num_images == MAX_IMAGES) {
+		free(data);
+		return;
+	}
+	corpus_image *image = &corpus[num_images++];
+	snprintf(image->name, sizeof(image->name), "%s", name);
+	image->data = data;
+	image->size = size;
+}
+
+static void generate_corpus(void)
+{
+	static const unsigned int sizes[] = {64, 256, 1024};
+	char name[256];
+	unsigned int i;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+		unsigned int w = sizes[i], h = sizes[i] * 3 / 4;
+		uint8_t *pixels = generate_pixels(w, h);
+		memory_writer out;
+
+#define ADD(kind, encode) \
+		memset(&out, 0, sizeof(out)); \
+		encode; \
+		snprintf(name, sizeof(name), kind "_%ux%u", w, h); \
+		add_image(name, out.data, out.size);
+
+		ADD("png_paletted", encode_png(&out, pixels, w, h, 1, 0));
+		ADD("png_rgba", encode_png(&out, pixels, w, h, 0, 0));
+		ADD("png_rgba_interlaced", encode_png(&out, pixels, w, h, 0, 1));
+		ADD("jpeg_baseline", encode_jpeg(&out, pixels, w, h, 0));
+		ADD("jpeg_progressive", encode_jpeg(&out, pixels, w, h, 1));
+		ADD("bmp_24", encode_bmp(&out, pixels, w, h));
+#undef ADD
+		free(pixels);
+	}
+}
+
+static void load_corpus_dir(const char *path)
+{
+	DIR *dir = opendir(path);
+	struct dirent *entry;
+	char filename[1280];
+
+	if (!dir) {
+		perror(path);
+		return;
+	}
+
+	while ((entry = readdir(dir))) {
+		if (entry->d_name[0] == '.')
+			continue;
+
+		snprintf(filename, sizeof(filename), "%s/%s", path, entry->d_name);
+		FILE *fp = fopen(filename, "rb");
+		if (!fp)
+			continue;
+
+		fseek(fp, 0, SEEK_END);
+		long size = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		uint8_t *data = size > 0 ? malloc(size) : NULL;
+		if (data && fread(data, 1, size, fp) == (size_t)size)
+			add_image(entry->d_name, data, size);
+		else
+			free(data);
+		fclose(fp);
+	}
+	closedir(dir);
+}
+
+/* Decode paths */
+
+typedef struct memory_io {
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+} memory_io;
+
+static int memory_read(void *user, char *data, int size)
+{
+	memory_io *mem = user;
+
+	if ((size_t)size > mem->size - mem->pos)
+		size = mem->size - mem->pos;
+	memcpy(data, mem->data + mem->pos, size);
+	mem->pos += size;
+	return size;
+}
+
+static void memory_skip(void *user, int n)
+{
+	memory_io *mem = user;
+
+	mem->pos = (size_t)n > mem->size - mem->pos ? mem->size : mem->pos + n;
+}
+
+static int memory_eof(void *user)
+{
+	memory_io *mem = user;
+	return mem->pos >= mem->size;
+}
+
+static int decode_buffer(const corpus_image *image, destination *dst)
+{
+	return image_decode_buffer(image->data, image->size, alloc_destination, dst);
+}
+
+static int decode_stream(const corpus_image *image, destination *dst)
+{
+	static const image_decode_io io = {memory_read, memory_skip, memory_eof};
+	memory_io mem = {image->data, image->size, 0};
+	return image_decode_callbacks(&io, &mem, alloc_destination, dst);
+}
+
+static int decode_stb(const corpus_image *image, destination *dst)
+{
+	return stb_decode_buffer(image->data, image->size, alloc_destination, dst);
+}
+
+// The decoder image_decode picked, found by which stats moved
+static const char *decoder_used(const image_decoder_stats *before)
+{
+	unsigned int i, count = image_decode_get_decoder_count();
+	image_decoder_stats stats;
+
+	for (i = 0; i < count; i++) {
+		const image_decoder *decoder = image_decode_get_decoder(i, &stats);
+		if (stats.images != before[i].images)
+			return decoder->name;
+	}
+	return "none";
+}
+
+static void bench_image(const corpus_image *image, const char *path, int (*decode)(const corpus_image *, destination *))
+{
+	image_decoder_stats before[IMAGE_DECODE_MAX_DECODERS + 8];
+	unsigned int i, count = image_decode_get_decoder_count();
+	const char *decoder = "stb_image";
+	destination dst;
+	unsigned long n = 0;
+	double elapsed = 0;
+
+	for (i = 0; i < count; i++)
+		image_decode_get_decoder(i, &before[i]);
+
+	// First run: correctness, peak heap and which decoder took it
+	size_t start = heap_current();
+	heap_reset_peak();
+	memset(&dst, 0, sizeof(dst));
+	int ret = decode(image, &dst);
+	size_t peak = heap_peak_since(start);
+	free(dst.pixels);
+	if (ret != IMAGE_DECODE_OK) {
+		fprintf(stderr, "%-40s %-9s failed (%d)\n", image->name, path, ret);
+		return;
+	}
+	if (decode != decode_stb)
+		decoder = decoder_used(before);
+
+	// Then as many runs as fit in ~0.2 s (scaled), at least 3
+	double budget = 2e8 * scale;
+	while (n < 3 || elapsed < budget) {
+		double t = now_ns();
+		decode(image, &dst);
+		elapsed += now_ns() - t;
+		free(dst.pixels);
+		n++;
+	}
+
+	bench_result *r = &results[num_results++];
+	snprintf(r->name, sizeof(r->name), "%s/%s", image->name, path);
+	r->decoder = decoder;
+	r->bytes_in = image->size;
+	r->w = dst.w;
+	r->h = dst.h;
+	r->iterations = n;
+	r->ms_per_image = elapsed / n / 1e6;
+	r->mb_per_s = image->size / (elapsed / n / 1e9) / (1024 * 1024);
+	r->mpix_per_s = (double)dst.w * dst.h / (elapsed / n / 1e3);
+	r->peak_heap = peak;
+	fprintf(stderr, "%-40s %-9s %-10s %9.3f ms %8.2f MB/s %8.2f MP/s %9zu B peak\n", image->name, path,
+		decoder, r->ms_per_image, r->mb_per_s, r->mpix_per_s, r->peak_heap);
+}
+
+/* Oversized images */
+
+static void put_be(uint8_t *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static void png_chunk(memory_writer *out, const char *type, const uint8_t *data, uint32_t size)
+{
+	uint8_t buf[8];
+
+	put_be(buf, size);
+	memcpy(buf + 4, type, 4);
+	memory_write(out, buf, 8);
+	if (size)
+		memory_write(out, data, size);
+	put_be(buf, crc32(crc32(0, buf + 4, 4), data, size));
+	memory_write(out, buf, 4);
+}
+
+// The header plus one row of data, the decoders must give up at IHDR
+static void encode_png_header(memory_writer *out, uint32_t w, uint32_t h)
+{
+	static const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	uint8_t ihdr[13] = {0}, row[64] = {0}, idat[128];
+	uLongf idat_size = sizeof(idat);
+
+	put_be(ihdr, w);
+	put_be(ihdr + 4, h);
+	ihdr[8] = 8; // bit depth
+	ihdr[9] = 6; // RGBA
+	memory_write(out, signature, sizeof(signature));
+	png_chunk(out, "IHDR", ihdr, sizeof(ihdr));
+	compress(idat, &idat_size, row, sizeof(row));
+	png_chunk(out, "IDAT", idat, idat_size);
+	png_chunk(out, "IEND", NULL, 0);
+}
+
+// A small JPEG with the frame header patched to w x h
+static void encode_jpeg_header(memory_writer *out, unsigned int w, unsigned int h)
+{
+	uint8_t *pixels = generate_pixels(16, 16);
+	unsigned long i;
+
+	encode_jpeg(out, pixels, 16, 16, 0);
+	free(pixels);
+	for (i = 0; i + 9 < out->size; i++) {
+		if (out->data[i] == 0xFF && out->data[i + 1] == 0xC0) {
+			out->data[i + 5] = h >> 8;
+			out->data[i + 6] = h;
+			out->data[i + 7] = w >> 8;
+			out->data[i + 8] = w;
+			break;
+		}
+	}
+}
+
+// 32 bpp header with a single row of data
+static void encode_bmp_header(memory_writer *out, uint32_t w, uint32_t h)
+{
+	uint8_t header[54] = {'B', 'M'};
+	uint8_t row[64] = {0};
+
+	put_le(header + 10, sizeof(header), 4);
+	put_le(header + 14, 40, 4);
+	put_le(header + 18, w, 4);
+	put_le(header + 22, h, 4);
+	put_le(header + 26, 1, 2);
+	put_le(header + 28, 32, 2);
+	memory_write(out, header, sizeof(header));
+	memory_write(out, row, sizeof(row));
+}
+
+static void *alloc_counted(unsigned int w, unsigned int h, unsigned int *stride, void *userdata)
+{
+	(*(unsigned int *)userdata)++;
+	return NULL;
+}
+
+// Returns the number of oversized images that weren't rejected up front
+static int check_oversized(void)
+{
+	static const image_decode_io io = {memory_read, memory_skip, memory_eof};
+	static const struct {
+		const char *name;
+		int kind;
+		uint32_t w, h;
+	} cases[] = {
+		{"png_32768x32768", 0, 32768, 32768},  // w * h * 4 wraps to 0 in 32 bits
+		{"png_65537x65536", 0, 65537, 65536},
+		{"png_16385x1", 0, IMAGE_DECODE_MAX_DIMENSION + 1, 1},
+		{"jpeg_65000x65000", 1, 65000, 65000},
+		{"bmp_1073741824x1", 2, 0x40000000, 1}, // w * 4 wraps in 32 bits
+		{"bmp_32768x-32768", 2, 32768, (uint32_t)-32768},
+	};
+	unsigned int i;
+	int failed = 0;
+
+	for (i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+		memory_writer out;
+		unsigned int allocs = 0;
+		int ret_buffer, ret_stream;
+
+		memset(&out, 0, sizeof(out));
+		if (cases[i].kind == 0)
+			encode_png_header(&out, cases[i].w, cases[i].h);
+		else if (cases[i].kind == 1)
+			encode_jpeg_header(&out, cases[i].w, cases[i].h);
+		else
+			encode_bmp_header(&out, cases[i].w, cases[i].h);
+
+		memory_io mem = {out.data, out.size, 0};
+		ret_buffer = image_decode_buffer(out.data, out.size, alloc_counted, &allocs);
+		ret_stream = image_decode_callbacks(&io, &mem, alloc_counted, &allocs);
+		free(out.data);
+
+		if (ret_buffer == IMAGE_DECODE_OK || ret_stream == IMAGE_DECODE_OK || allocs != 0) {
+			fprintf(stderr, "%-40s not rejected (%d, %d, %u allocations)\n", cases[i].name,
+				ret_buffer, ret_stream, allocs);
+			failed++;
+		}
+	}
+	return failed;
+}
+
+static int write_json(FILE *fp)
+{
+	unsigned int i, count = image_decode_get_decoder_count();
+	image_decoder_stats stats;
+
+	fprintf(fp, "{\n\t\"results\": [\n");
+	for (i = 0; i < (unsigned int)num_results; i++) {
+		const bench_result *r = &results[i];
+		fprintf(fp, "\t\t{\"name\": \"%s\", \"decoder\": \"%s\", \"bytes_in\": %lu, \"width\": %u, \"height\": %u, "
+			"\"iterations\": %lu, \"ms_per_image\": %.4f, \"mb_per_s\": %.3f, \"mpix_per_s\": %.3f, \"peak_heap\": %zu}%s\n",
+			r->name, r->decoder, r->bytes_in, r->w, r->h, r->iterations, r->ms_per_image, r->mb_per_s,
+			r->mpix_per_s, r->peak_heap, i + 1 < (unsigned int)num_results ? "," : "");
+	}
+	fprintf(fp, "\t],\n\t\"decoders\": [\n");
+	for (i = 0; i < count; i++) {
+		const image_decoder *decoder = image_decode_get_decoder(i, &stats);
+		fprintf(fp, "\t\t{\"name\": \"%s\", \"images\": %u, \"failures\": %u, \"bytes_in\": %llu, "
+			"\"pixels_out\": %llu, \"time_us\": %llu}%s\n",
+			decoder->name, stats.images, stats.failures, (unsigned long long)stats.bytes_in,
+			(unsigned long long)stats.pixels_out, (unsigned long long)stats.time_us, i + 1 < count ? "," : "");
+	}
+	fprintf(fp, "\t]\n}\n");
+	return ferror(fp) ? -1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *output = NULL;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+			scale = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+			load_corpus_dir(argv[++i]);
+		} else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+			output = argv[++i];
+		} else {
+			fprintf(stderr, "usage: %s [-s scale] [-d corpus_dir] [-o output.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	image_decode_set_fallback(&stb_decoder);
+	if (check_oversized() > 0)
+		return 1;
+	generate_corpus();
+	image_decode_reset_stats();
+
+	for (i = 0; i < num_images; i++) {
+		bench_image(&corpus[i], "buffer", decode_buffer);
+		bench_image(&corpus[i], "stream", decode_stream);
+		bench_image(&corpus[i], "stb_image", decode_stb);
+	}
+
+	for (i = 0; i < num_images; i++)
+		free(corpus[i].data);
+
+	if (output) {
+		FILE *fp = fopen(output, "w");
+		if (!fp) {
+			perror(output);
+			return 1;
+		}
+		int ret = write_json(fp);
+		fclose(fp);
+		return ret ? 1 : 0;
+	}
+
+	return write_json(stdout) ? 1 : 0;
+}
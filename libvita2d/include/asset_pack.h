@@ -0,0 +1,57 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Asset pack, written by tools/asset_packer: a header, num_entries entries sorted
+ * by hash, the string table with the entry names, then the blobs, each starting
+ * ASSET_PACK_ALIGNMENT aligned. All little-endian, offsets are from the start of
+ * the pack, so it's used straight from memory.
+ */
+
+#define ASSET_PACK_MAGIC     0x4B503256 // "V2PK"
+#define ASSET_PACK_VERSION   1
+#define ASSET_PACK_ALIGNMENT 16
+
+typedef struct asset_pack_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t num_entries;
+	uint32_t names_offset; // NUL terminated names
+	uint32_t names_size;
+	uint32_t reserved[3];
+} asset_pack_header;
+
+typedef struct asset_pack_entry {
+	uint32_t hash; // asset_pack_hash() of the name
+	uint32_t name; // offset in the string table
+	uint32_t offset;
+	uint32_t size;
+} asset_pack_entry;
+
+// FNV-1a of the name (the path relative to the packed directory, '/' separated)
+uint32_t asset_pack_hash(const char *name);
+// Returns the header if the buffer holds a complete pack, NULL otherwise
+const asset_pack_header *asset_pack_validate(const void *buffer, size_t size);
+static inline const asset_pack_entry *asset_pack_entries(const asset_pack_header *header)
+{
+	return (const asset_pack_entry *)(header + 1);
+}
+static inline const char *asset_pack_name(const asset_pack_header *header, const asset_pack_entry *entry)
+{
+	return (const char *)header + header->names_offset + entry->name;
+}
+// Index of the entry with this name in asset_pack_entries(), -1 if there isn't one
+int asset_pack_find(const asset_pack_header *header, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
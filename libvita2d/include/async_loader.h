@@ -0,0 +1,17 @@
+#ifndef ASYNC_LOADER_H
+#define ASYNC_LOADER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Render thread side of the async loader, called once per frame by vita2d_swap_buffers
+void async_loader_upload(void);
+// Stops the workers and frees every request still in flight
+void async_loader_fini(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
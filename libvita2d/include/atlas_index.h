@@ -0,0 +1,53 @@
+#ifndef ATLAS_INDEX_H
+#define ATLAS_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Baked sprite atlas index, written by tools/atlas_baker. The file is a header
+ * followed by num_sprites entries sorted by hash, all little-endian and 4 byte
+ * aligned, so it's used straight from memory. The pages live in a GXT file,
+ * page i being its i-th texture.
+ */
+
+#define ATLAS_INDEX_MAGIC   0x41443256 // "V2DA"
+#define ATLAS_INDEX_VERSION 1
+
+typedef struct atlas_index_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t num_pages;
+	uint32_t num_sprites;
+	char texture_file[64]; // GXT file name, relative to the index
+} atlas_index_header;
+
+typedef struct atlas_index_sprite {
+	uint32_t hash; // atlas_index_hash() of the sprite name
+	uint16_t page;
+	uint16_t w;
+	uint16_t h;
+	uint16_t reserved;
+	float uv[4]; // u0, v0, u1, v1
+} atlas_index_sprite;
+
+// FNV-1a of the name (the image file name without its extension)
+uint32_t atlas_index_hash(const char *name);
+// Returns the header if the buffer holds a complete index, NULL otherwise
+const atlas_index_header *atlas_index_validate(const void *buffer, size_t size);
+static inline const atlas_index_sprite *atlas_index_sprites(const atlas_index_header *header)
+{
+	return (const atlas_index_sprite *)(header + 1);
+}
+// Index of the sprite with this name in atlas_index_sprites(), -1 if there isn't one
+int atlas_index_find(const atlas_index_header *header, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
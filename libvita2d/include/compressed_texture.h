@@ -0,0 +1,59 @@
+#ifndef COMPRESSED_TEXTURE_H
+#define COMPRESSED_TEXTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * DDS, PVR (v2 and v3) and KTX (v1) container parsing. Only the block
+ * compressed formats the GXM samples natively are recognized. No Vita SDK
+ * dependency, so it can be built for the host as well.
+ */
+
+#define COMPRESSED_TEXTURE_MAX_LEVELS 16
+
+typedef enum compressed_texture_format {
+	COMPRESSED_TEXTURE_UNKNOWN,
+	COMPRESSED_TEXTURE_DXT1_RGB,
+	COMPRESSED_TEXTURE_DXT1_RGBA,
+	COMPRESSED_TEXTURE_DXT3,
+	COMPRESSED_TEXTURE_DXT5,
+	COMPRESSED_TEXTURE_PVRTC_2BPP_RGB,
+	COMPRESSED_TEXTURE_PVRTC_2BPP_RGBA,
+	COMPRESSED_TEXTURE_PVRTC_4BPP_RGB,
+	COMPRESSED_TEXTURE_PVRTC_4BPP_RGBA,
+	COMPRESSED_TEXTURE_ETC1
+} compressed_texture_format;
+
+typedef struct compressed_texture_level {
+	const uint8_t *data; // points inside the parsed buffer
+	size_t size;
+	unsigned int w;
+	unsigned int h;
+} compressed_texture_level;
+
+typedef struct compressed_texture {
+	compressed_texture_format format;
+	unsigned int w;
+	unsigned int h;
+	unsigned int num_levels;
+	compressed_texture_level levels[COMPRESSED_TEXTURE_MAX_LEVELS];
+} compressed_texture;
+
+// Payload size in bytes of one w x h level
+size_t compressed_texture_level_size(compressed_texture_format format, unsigned int w, unsigned int h);
+/*
+ * Detects the container from its magic and fills 'tex'. Levels that would run
+ * past the end of the buffer are dropped. Returns 0 on success, -1 otherwise.
+ */
+int compressed_texture_parse(const void *buffer, size_t size, compressed_texture *tex);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef DISK_CACHE_H
+#define DISK_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Decoded texture cache entries, one file per image: a header followed by the
+ * texture memory (stride * h bytes) compressed as one LZ4 block. Entries are
+ * written in native byte order, they're only meant for the device that wrote them.
+ */
+
+#define DISK_CACHE_MAGIC     0x43443256 // "V2DC"
+#define DISK_CACHE_VERSION   2
+#define DISK_CACHE_EXTENSION ".v2dc"
+
+// Everything the pixels depend on, hashed as is for the file name (no padding)
+typedef struct disk_cache_key {
+	uint64_t hash;       // hash_buffer() of the encoded image, or of the normalized path for files
+	uint64_t mtime;      // modification time of files, 0 for buffers
+	uint32_t size;       // encoded image size
+	uint32_t format;     // texture format
+	uint32_t options[4]; // anything else that changes the pixels (dithering, scaling)
+} disk_cache_key;
+
+typedef struct disk_cache_header {
+	uint32_t magic;
+	uint32_t version;
+	disk_cache_key key;
+	uint32_t w;
+	uint32_t h;
+	uint32_t stride;
+	uint32_t decode_us;       // what decoding the image took when the entry was written
+	uint32_t compressed_size;
+	uint32_t reserved;
+	uint64_t checksum;        // hash_buffer() of the compressed pixels
+} disk_cache_header;
+
+// Returns where the pixels go, stride * h bytes, or NULL to give up
+typedef void *(*disk_cache_alloc)(const disk_cache_header *header, void *userdata);
+
+// dir/<key hash>.v2dc, returns 0 on success, -1 if it doesn't fit in size
+int disk_cache_path(const char *dir, const disk_cache_key *key, char *path, size_t size);
+/*
+ * Returns 0 on a hit, -1 if the entry is missing, was written for another key or
+ * version, or is corrupt. header is filled on a hit, userdata owns whatever alloc
+ * made in both cases.
+ */
+int disk_cache_read(const char *path, const disk_cache_key *key, disk_cache_alloc alloc, void *userdata,
+		    disk_cache_header *header);
+/*
+ * Writes the entry through a temporary file, so an interrupted write never leaves a
+ * truncated entry behind. Returns the file size, -1 on error.
+ */
+long disk_cache_write(const char *path, const disk_cache_key *key, unsigned int w, unsigned int h,
+		      unsigned int stride, uint32_t decode_us, const void *pixels);
+// Total size of the entries in dir, their count goes to entries if not NULL
+uint64_t disk_cache_size(const char *dir, unsigned int *entries);
+// Deletes the entries in dir, returns how many were deleted
+unsigned int disk_cache_clear(const char *dir);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef GXT_H
+#define GXT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * GXT (version 3) container parsing. Texture types and formats are kept as
+ * the raw SceGxmTextureType/SceGxmTextureFormat values so this builds without
+ * the Vita SDK.
+ */
+
+#define GXT_NO_PALETTE 0xFFFFFFFF
+
+typedef struct gxt_texture {
+	const uint8_t *data; // points inside the parsed buffer
+	uint32_t size;
+	uint32_t type;
+	uint32_t format;
+	unsigned int w;
+	unsigned int h;
+	unsigned int mip_count;
+	const uint8_t *palette; // 16 or 256 RGBA entries, NULL if none
+	uint32_t palette_size;
+} gxt_texture;
+
+// Number of textures in the file, -1 if the header isn't valid
+int gxt_get_texture_count(const void *buffer, size_t size);
+// Fills 'tex' with the index-th texture. Returns 0 on success, -1 otherwise.
+int gxt_get_texture(const void *buffer, size_t size, unsigned int index, gxt_texture *tex);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef IMAGE_DECODE_H
+#define IMAGE_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Image decoding to RGBA8 through a registry of decoders picked by the magic bytes
+ * at the start of the image. Once the header is parsed, decoders ask the caller for
+ * the destination (usually texture memory), so the image is never held in a temporary
+ * buffer. Files and callback sources are streamed through small fixed buffers.
+ * Built in: PNG (libpng), JPEG (libjpeg) and uncompressed BMP/TGA, all of which can
+ * shrink the image while decoding it.
+ * Doesn't need the Vita SDK.
+ */
+
+#define IMAGE_DECODE_OK           0
+#define IMAGE_DECODE_ERROR       -1 // corrupt image or the destination couldn't be allocated
+#define IMAGE_DECODE_UNSUPPORTED -2 // not handled by the decoder, nothing was allocated
+
+#define IMAGE_DECODE_MAX_DECODERS 16
+#define IMAGE_DECODE_HEADER_SIZE  64 // bytes seen by probe()
+/*
+ * Images wider or taller than this are rejected before anything is allocated. It's
+ * well above the 4096 texture limit, so big images can still be decoded scaled, and
+ * small enough that w * h * 4 always fits in 32 bits.
+ */
+#define IMAGE_DECODE_MAX_DIMENSION 16384
+
+// Returns the destination for a w x h image, rows 'stride' bytes apart, or NULL to abort
+typedef void *(*image_decode_alloc)(unsigned int w, unsigned int h, unsigned int *stride, void *userdata);
+
+#define IMAGE_DECODE_FILTER_POINT 0 // nearest source pixel
+#define IMAGE_DECODE_FILTER_BOX   1 // average of the source pixels covered
+
+// Scaled decoding: images bigger than max_w x max_h are shrunk to fit, keeping the aspect ratio
+typedef struct image_decode_scale {
+	unsigned int max_w; // 0 for no limit
+	unsigned int max_h;
+	int filter;
+} image_decode_scale;
+
+// Same contract as stbi_io_callbacks
+typedef struct image_decode_io {
+	int (*read)(void *user, char *data, int size); // returns the number of bytes read
+	void (*skip)(void *user, int n);
+	int (*eof)(void *user); // nonzero at the end of the data
+} image_decode_io;
+
+/*
+ * What stream decoders read from. Decoders may only return IMAGE_DECODE_UNSUPPORTED
+ * after reading at most IMAGE_DECODE_HEADER_SIZE bytes, those are replayed to the next one.
+ */
+typedef struct image_stream image_stream;
+
+size_t image_stream_read(image_stream *stream, void *data, size_t size);
+void image_stream_skip(image_stream *stream, size_t n);
+int image_stream_eof(image_stream *stream);
+/*
+ * The requested scale, NULL for full size. Decoders may allocate the reduced size
+ * straight away, bigger images are decoded to a temporary buffer and shrunk afterwards.
+ */
+const image_decode_scale *image_stream_scale(image_stream *stream);
+
+typedef struct image_decoder {
+	const char *name;
+	const void *magic; // NULL to rely on probe()
+	unsigned int magic_size;
+	int (*probe)(const uint8_t *header, size_t size); // optional, 1 if the image looks like ours
+	// At least one of them. Buffer only decoders get streams read whole, the other way round is free.
+	int (*decode_buffer)(const void *buffer, unsigned long size, image_decode_alloc alloc, void *userdata);
+	int (*decode_stream)(image_stream *stream, image_decode_alloc alloc, void *userdata);
+} image_decoder;
+
+typedef struct image_decoder_stats {
+	unsigned int images;   // successful decodes
+	unsigned int failures;
+	uint64_t bytes_in;     // encoded size of the successful decodes
+	uint64_t pixels_out;
+	uint64_t time_us;      // spent in successful decodes
+} image_decoder_stats;
+
+/*
+ * Registered decoders are tried newest first, before the built in ones. The fallback
+ * (set by vita2d to stb_image) is tried last for any image. The decoder is not copied.
+ * Returns -1 if the registry is full.
+ */
+int image_decode_register(const image_decoder *decoder);
+void image_decode_set_fallback(const image_decoder *decoder);
+
+int image_decode_file(const char *filename, image_decode_alloc alloc, void *userdata);
+int image_decode_buffer(const void *buffer, unsigned long size, image_decode_alloc alloc, void *userdata);
+int image_decode_callbacks(const image_decode_io *io, void *user, image_decode_alloc alloc, void *userdata);
+int image_decode_file_scaled(const char *filename, const image_decode_scale *scale, image_decode_alloc alloc, void *userdata);
+int image_decode_callbacks_scaled(const image_decode_io *io, void *user, const image_decode_scale *scale,
+				  image_decode_alloc alloc, void *userdata);
+
+// Registered, built in and fallback decoders, in the order they're tried
+unsigned int image_decode_get_decoder_count(void);
+const image_decoder *image_decode_get_decoder(unsigned int index, image_decoder_stats *stats);
+void image_decode_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
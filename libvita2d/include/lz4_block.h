@@ -0,0 +1,27 @@
+#ifndef LZ4_BLOCK_H
+#define LZ4_BLOCK_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * LZ4 block format (no frame header or checksum), compatible with
+ * LZ4_compress_default() and LZ4_decompress_safe().
+ */
+
+// Largest compressed size of size bytes of input
+#define LZ4_BLOCK_BOUND(size) ((size) + (size) / 255 + 16)
+
+// Returns the compressed size, -1 if dst_size is too small
+int lz4_block_compress(const void *src, size_t src_size, void *dst, size_t dst_size);
+// Returns the decompressed size, -1 if the data is corrupt or doesn't fit in dst_size
+int lz4_block_decompress(const void *src, size_t src_size, void *dst, size_t dst_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
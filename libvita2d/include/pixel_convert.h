@@ -0,0 +1,37 @@
+#ifndef PIXEL_CONVERT_H
+#define PIXEL_CONVERT_H
+
+#include <stdint.h>
+#include <psp2/gxm.h>
+#include "vita2d_vgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t bpp_from_format(SceGxmTextureFormat format);
+// 1 if the format can be converted from/to, 0 otherwise
+int pixel_convert_supported(SceGxmTextureFormat format);
+void pixel_convert_row(void *dst, SceGxmTextureFormat dst_format,
+		       const void *src, SceGxmTextureFormat src_format,
+		       unsigned int n);
+/*
+ * Converts a whole RGBA8 (U8U8U8U8_ABGR) image, dithering channels that lose precision.
+ * Returns 0 on success, -1 if the error diffusion buffers can't be allocated.
+ */
+int pixel_convert_image_dither(void *dst, unsigned int dst_stride, SceGxmTextureFormat dst_format,
+			       const void *src, unsigned int src_stride,
+			       unsigned int w, unsigned int h, vita2d_dither_mode mode);
+
+/*
+ * Halves an RGBA8 image with a rounded 2x2 box filter (1 texel wide/high
+ * sources stay 1 texel wide/high). src_stride must be a multiple of 4.
+ */
+void pixel_downsample_box(void *dst, unsigned int dst_stride, const void *src, unsigned int src_stride,
+			  unsigned int src_w, unsigned int src_h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
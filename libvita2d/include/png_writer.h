@@ -0,0 +1,15 @@
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Waits for the queued PNG writes to finish and stops the worker thread
+void png_writer_fini(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,15 +1,29 @@
 #ifndef UTILS_H
 #define UTILS_H
 
-#include <psp2/gxm.h>
-#include <psp2/types.h>
-#include <psp2/kernel/sysmem.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /* Misc utils */
 #define ALIGN(x, a)	(((x) + ((a) - 1)) & ~((a) - 1))
 #define	UNUSED(a)	(void)(a)
 #define SCREEN_DPI	220
 
+/* File utils */
+// Reads a whole file into a malloc'd buffer, NULL on error
+void *read_file(const char *path, unsigned long *size);
+/*
+ * Malloc'd copy of path that names the same file as every other spelling of it:
+ * lowercase, '/' separators, no empty/"." components, ".." resolved and "dev:" followed by '/'.
+ */
+char *normalize_path(const char *path);
+
+/* Hash utils */
+// 64-bit MurmurHash64A of the buffer, reads 8 bytes per step
+uint64_t hash_buffer(const void *buffer, size_t size);
+// 32-bit FNV-1a of a NUL-terminated string, the name hash of the baked file formats
+uint32_t hash_string(const char *str);
+
 /* Font utils */
 int utf8_to_ucs2(const char *utf8, unsigned int *character);
 
@@ -0,0 +1,112 @@
+#ifndef VITA2D_INTERNAL_H
+#define VITA2D_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "vita2d_vgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// State and helpers vita2d.c shares with the other vita2d_*.c modules
+
+#define SCREEN_W 960
+#define SCREEN_H 544
+
+/*
+ * Frames vitaGL may still be rendering after vglSwapBuffers returns. vitaGL has no way
+ * to ask when a frame is done, so this matches its default double buffered display
+ * queue and has to be raised if vitaGL is built with more display buffers. Streaming
+ * textures reuse their buffers and readbacks read their results based on it.
+ */
+#ifndef GPU_FRAMES_IN_FLIGHT
+#define GPU_FRAMES_IN_FLIGHT 2
+#endif
+
+struct vita2d_managed_texture {
+	vita2d_texture *texture;
+	char *filename;
+	const void *buffer;
+	unsigned long buffer_size;
+	vita2d_file_loader file_loader;
+	vita2d_buffer_loader buffer_loader;
+	int resident;
+	size_t bytes;
+	int want_mipmaps;
+	// Resident managed textures, most recently drawn first
+	vita2d_managed_texture *prev;
+	vita2d_managed_texture *next;
+};
+
+typedef struct decoded_image {
+	uint8_t *pixels;
+	unsigned int w;
+	unsigned int h;
+} decoded_image;
+
+/* vita2d.c */
+extern vita2d_draw_stats v2d_stats;
+extern unsigned int v2d_frame; // 0 is reserved for textures never drawn
+extern GLuint v2d_bound_fbo;   // what start_drawing bound
+
+// Submits the pending batched quads
+void _flush_batch(void);
+// For changes to a texture, which pending quads may still sample
+void _bind_texture(GLuint tex_id);
+void _reset_blending(void);
+// Zeroed texture, linked into the memory report
+vita2d_texture *_alloc_texture(void);
+void _untrack_texture(vita2d_texture *texture);
+// Memory used by the texture levels and palette
+size_t _texture_bytes(const vita2d_texture *texture);
+// Updates the byte totals after the texture got (re)allocated, evicted or changed category
+void _account_texture(vita2d_texture *texture);
+// image_decode_alloc filling a decoded_image with malloc'd RGBA8 pixels
+void *_decode_alloc_rgba(unsigned int w, unsigned int h, unsigned int *stride, void *userdata);
+
+static inline int _is_paletted(SceGxmTextureFormat format) {
+	return (format & SCE_GXM_TEXTURE_BASE_FORMAT_MASK) == SCE_GXM_TEXTURE_BASE_FORMAT_P4 ||
+	       (format & SCE_GXM_TEXTURE_BASE_FORMAT_MASK) == SCE_GXM_TEXTURE_BASE_FORMAT_P8;
+}
+
+static inline unsigned int _palette_entries(SceGxmTextureFormat format) {
+	return (format & SCE_GXM_TEXTURE_BASE_FORMAT_MASK) == SCE_GXM_TEXTURE_BASE_FORMAT_P4 ? 16 : 256;
+}
+
+/* vita2d_sprite_atlas.c */
+// Copies w x h RGBA8 pixels to dst, surrounded by a ring of their edge texels
+void _blit_with_ring(uint8_t *dst, unsigned int dst_stride, const uint8_t *src, unsigned int src_stride,
+		     unsigned int w, unsigned int h);
+
+/* vita2d_texture_cache.c */
+extern vita2d_texture_cache_stats v2d_cache_stats;
+
+// Reloads an evicted managed texture, returns 0 if that failed
+int _make_resident(vita2d_texture *texture);
+// 'keep' is about to be used and is never evicted
+void _enforce_texture_budget(const vita2d_managed_texture *keep);
+void _managed_texture_free(vita2d_managed_texture *m);
+// Drops a reference to a cached texture, returns how many are left
+unsigned int _texture_cache_release(vita2d_cached_texture *c);
+
+/* vita2d_readback.c */
+/*
+ * Frame being captured for screen readbacks. The first vita2d_start_drawing() of a
+ * frame renders to it instead of the screen, vita2d_swap_buffers() copies it over.
+ */
+extern vita2d_texture *v2d_capture;
+extern GLboolean v2d_capturing;
+
+// Puts the captured frame on the screen, its readbacks count from this frame
+void _finish_capture(void);
+// Runs the callbacks of the readbacks the GPU is done with
+void _process_readbacks(void);
+// Fails every pending readback
+void _readbacks_fini(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef VITA2D_SW_H
+#define VITA2D_SW_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * CPU reference rasterizer. It consumes the same vertex streams vita2d feeds
+ * to vitaGL (x/y pairs, u/v pairs, one color per draw) and renders them into
+ * an RGBA8 memory framebuffer. It has no dependency on the Vita SDK, so it
+ * can be built for the host with Makefile.host.
+ */
+
+#ifndef RGBA8
+#define RGBA8(r,g,b,a) ((((a)&0xFF)<<24) | (((b)&0xFF)<<16) | (((g)&0xFF)<<8) | (((r)&0xFF)<<0))
+#endif
+
+typedef enum vita2d_sw_primitive {
+	VITA2D_SW_POINTS,
+	VITA2D_SW_LINES,
+	VITA2D_SW_TRIANGLES,
+	VITA2D_SW_TRIANGLE_STRIP,
+	VITA2D_SW_TRIANGLE_FAN
+} vita2d_sw_primitive;
+
+typedef enum vita2d_sw_format {
+	VITA2D_SW_FORMAT_RGBA8, /* SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR */
+	VITA2D_SW_FORMAT_U8_R   /* SCE_GXM_TEXTURE_FORMAT_U8_R, sampled as (1, 1, 1, R) */
+} vita2d_sw_format;
+
+typedef enum vita2d_sw_filter {
+	VITA2D_SW_FILTER_POINT,
+	VITA2D_SW_FILTER_LINEAR
+} vita2d_sw_filter;
+
+typedef struct vita2d_sw_texture {
+	const void *data;
+	unsigned int w;
+	unsigned int h;
+	unsigned int stride; /* in bytes */
+	vita2d_sw_format format;
+	vita2d_sw_filter filter;
+} vita2d_sw_texture;
+
+typedef struct vita2d_sw_target {
+	uint32_t *pixels;
+	unsigned int w;
+	unsigned int h;
+	unsigned int stride; /* in pixels */
+	int owns_pixels;
+	int clipping;
+	int clip[4]; /* x_min, y_min, x_max, y_max */
+	int additive_blending;
+	int no_blending; /* sources overwrite the target, like glDisable(GL_BLEND) */
+	uint32_t clear_color;
+	/* Submission counters, same meaning as vita2d_draw_stats */
+	unsigned int draw_calls;
+	unsigned int vertices;
+} vita2d_sw_target;
+
+vita2d_sw_target *vita2d_sw_create_target(unsigned int w, unsigned int h);
+void vita2d_sw_init_target(vita2d_sw_target *target, uint32_t *pixels, unsigned int w, unsigned int h, unsigned int stride);
+void vita2d_sw_free_target(vita2d_sw_target *target);
+
+void vita2d_sw_set_clear_color(vita2d_sw_target *target, uint32_t color);
+void vita2d_sw_clear_screen(vita2d_sw_target *target);
+void vita2d_sw_set_blend_mode_add(vita2d_sw_target *target, int enable);
+/* Blending is on by default, off copies the (tinted) source as is */
+void vita2d_sw_set_blending(vita2d_sw_target *target, int enable);
+void vita2d_sw_enable_clipping(vita2d_sw_target *target);
+void vita2d_sw_disable_clipping(vita2d_sw_target *target);
+void vita2d_sw_set_clip_rectangle(vita2d_sw_target *target, int x_min, int y_min, int x_max, int y_max);
+
+void vita2d_sw_init_texture(vita2d_sw_texture *texture, const void *data, unsigned int w, unsigned int h, unsigned int stride, vita2d_sw_format format);
+
+/* tcoord and texture may be NULL for untextured primitives */
+void vita2d_sw_draw_arrays(vita2d_sw_target *target, vita2d_sw_primitive mode, const float *vtx, const float *tcoord, unsigned int count, uint32_t color, const vita2d_sw_texture *texture);
+void vita2d_sw_draw_elements(vita2d_sw_target *target, vita2d_sw_primitive mode, const float *vtx, const float *tcoord, const uint16_t *indices, unsigned int count, uint32_t color, const vita2d_sw_texture *texture);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -30,6 +30,36 @@ typedef struct vita2d_texture_vertex {
 	float v;
 } vita2d_texture_vertex;
 
+typedef enum vita2d_mip_filter {
+	VITA2D_MIP_FILTER_NONE,    // only the base level is sampled
+	VITA2D_MIP_FILTER_NEAREST, // closest level
+	VITA2D_MIP_FILTER_LINEAR   // blend of the two closest levels (trilinear with a linear min filter)
+} vita2d_mip_filter;
+
+typedef struct vita2d_managed_texture vita2d_managed_texture;
+typedef struct vita2d_cached_texture vita2d_cached_texture;
+
+typedef enum vita2d_texture_category {
+	VITA2D_TEXTURE_CATEGORY_USER,
+	VITA2D_TEXTURE_CATEGORY_FONT_ATLAS,
+	VITA2D_TEXTURE_CATEGORY_RENDER_TARGET,
+	VITA2D_TEXTURE_CATEGORY_COUNT
+} vita2d_texture_category;
+
+// Reference counted P4/P8 palette, can be shared by several textures
+typedef struct vita2d_palette vita2d_palette;
+
+typedef struct vita2d_image_request vita2d_image_request;
+typedef struct vita2d_image_batch vita2d_image_batch;
+
+typedef enum vita2d_image_status {
+	VITA2D_IMAGE_PENDING,   // waiting for a worker
+	VITA2D_IMAGE_DECODING,
+	VITA2D_IMAGE_UPLOADING, // decoded, copied to the texture over the next frames
+	VITA2D_IMAGE_READY,
+	VITA2D_IMAGE_FAILED
+} vita2d_image_status;
+
 typedef struct vita2d_texture {
 	GLuint tex_id;
 	GLuint fbo;
@@ -37,8 +67,119 @@ typedef struct vita2d_texture {
 	uint32_t w;
 	uint32_t h;
 	SceGxmTextureFilter filters[2];
+	void *staging;         // the dirty region, tightly packed, until it's uploaded
+	unsigned int dirty[4]; // x_min, y_min, x_max, y_max of pending vita2d_texture_update_region writes
+	unsigned int last_frame; // frame of the last draw using the texture, 0 if never drawn
+	vita2d_palette *palette; // NULL unless the format is P4/P8
+	unsigned int mip_levels; // levels including the base one, 0 if the texture has no mip chain
+	vita2d_mip_filter mip_filter;
+	vita2d_managed_texture *managed; // NULL unless created by vita2d_load_managed_*
+	vita2d_cached_texture *cached; // NULL unless returned by vita2d_texture_cache_get*
+	// Memory accounting, see vita2d_get_memory_report()
+	char *tag;
+	vita2d_texture_category category;
+	size_t accounted_bytes;
+	struct vita2d_texture *prev_live;
+	struct vita2d_texture *next_live;
+	// Sprite atlas entries share the GL texture of their page and only sample uv[] (u0, v0, u1, v1)
+	struct vita2d_texture *parent;
+	float uv[4];
 } vita2d_texture;
 
+/*
+ * A vita2d_subtexture is accepted by every vita2d_draw_texture_* function and w/h/part
+ * coordinates are relative to the sprite. Subtextures are owned by their atlas: don't
+ * pass them to vita2d_free_texture. Filters are shared by the whole page.
+ */
+typedef vita2d_texture vita2d_subtexture;
+typedef struct vita2d_sprite_atlas vita2d_sprite_atlas;
+typedef struct vita2d_animation vita2d_animation;
+typedef struct vita2d_asset_pack vita2d_asset_pack;
+
+typedef struct vita2d_memory_report_entry {
+	const vita2d_texture *texture;
+	unsigned int w;
+	unsigned int h;
+	SceGxmTextureFormat format;
+	size_t bytes; // levels and palette, 0 for evicted managed textures
+	vita2d_texture_category category;
+	const char *tag; // file name or vita2d_texture_set_tag() string, NULL if unknown
+} vita2d_memory_report_entry;
+
+typedef struct vita2d_memory_report {
+	size_t total_bytes;
+	size_t peak_total_bytes;
+	size_t category_bytes[VITA2D_TEXTURE_CATEGORY_COUNT];
+	size_t category_peak_bytes[VITA2D_TEXTURE_CATEGORY_COUNT];
+	unsigned int num_textures;
+	vita2d_memory_report_entry *entries; // newest texture first
+} vita2d_memory_report;
+
+typedef vita2d_texture *(*vita2d_file_loader)(const char *filename);
+typedef vita2d_texture *(*vita2d_buffer_loader)(const void *buffer, unsigned long buffer_size);
+// Returns where to write a w x h RGBA8 image, rows 'stride' bytes apart, NULL on failure
+typedef void *(*vita2d_image_alloc)(unsigned int w, unsigned int h, unsigned int *stride, void *userdata);
+
+// Same contract as stbi_io_callbacks: read returns the bytes read, eof is nonzero at the end
+typedef struct vita2d_io_callbacks {
+	int (*read)(void *user, char *data, int size);
+	void (*skip)(void *user, int n);
+	int (*eof)(void *user);
+} vita2d_io_callbacks;
+
+typedef struct vita2d_image_decoder {
+	const char *name;
+	const void *magic; // bytes the image starts with, NULL to rely on probe
+	unsigned int magic_size;
+	int (*probe)(const uint8_t *header, size_t size); // sees the first 64 bytes (or less), 1 if the image is handled
+	// Calls alloc once the size is known. Returns 0 on success, -1 on error, -2 to let the next decoder try.
+	int (*decode)(const void *buffer, unsigned long size, vita2d_image_alloc alloc, void *userdata);
+} vita2d_image_decoder;
+// pixels are RGBA8 rows 'stride' bytes apart, only valid during the call. NULL if the read failed.
+typedef void (*vita2d_readback_callback)(const void *pixels, unsigned int w, unsigned int h, unsigned int stride, void *userdata);
+// result is 0 on success, -1 on error. Called from the PNG writer thread.
+typedef void (*vita2d_png_done_callback)(int result, void *userdata);
+
+typedef enum vita2d_dither_mode {
+	VITA2D_DITHER_NONE,
+	VITA2D_DITHER_ORDERED,         // 4x4 Bayer matrix
+	VITA2D_DITHER_ERROR_DIFFUSION  // Floyd-Steinberg
+} vita2d_dither_mode;
+
+typedef struct vita2d_draw_stats {
+	unsigned int draw_calls;
+	unsigned int vertices;
+	unsigned int texture_binds; // textured draw calls, each binds its texture
+} vita2d_draw_stats;
+
+// Per decoder counters, throughput is bytes_in / time_us (MB/s) or pixels_out / time_us
+typedef struct vita2d_image_decoder_stats {
+	const char *name;
+	unsigned int images;   // successful decodes
+	unsigned int failures;
+	uint64_t bytes_in;     // encoded size of the successful decodes
+	uint64_t pixels_out;
+	uint64_t time_us;      // spent in successful decodes
+} vita2d_image_decoder_stats;
+
+typedef struct vita2d_texture_cache_stats {
+	unsigned int hits;         // draws of managed textures that were resident
+	unsigned int misses;       // draws (or get_datap calls) that had to reload the texture
+	unsigned int evictions;
+	unsigned int reload_failures;
+	size_t resident_bytes;     // memory held by resident managed textures
+	size_t budget_bytes;       // 0 means no budget
+} vita2d_texture_cache_stats;
+
+typedef struct vita2d_disk_cache_stats {
+	unsigned int hits;
+	unsigned int misses;       // loads that had to decode, including stale or corrupt entries
+	unsigned int writes;
+	uint64_t time_saved_us;    // decode time recorded in the hit entries minus what loading them took
+	uint64_t disk_bytes;       // size of the entries in the cache directory
+	unsigned int entries;
+} vita2d_disk_cache_stats;
+
 typedef struct vita2d_system_pgf_config {
 	SceFontLanguageCode code;
 	int (*in_font_group)(unsigned int c);
@@ -49,6 +190,7 @@ typedef struct vita2d_system_pvf_config {
 	int (*in_font_group)(unsigned int c);
 } vita2d_system_pvf_config;
 
+typedef struct vita2d_streaming_texture vita2d_streaming_texture;
 typedef struct vita2d_font vita2d_font;
 typedef struct vita2d_pgf vita2d_pgf;
 typedef struct vita2d_pvf vita2d_pvf;
@@ -64,6 +206,11 @@ void vita2d_swap_buffers();
 
 void vita2d_start_drawing();
 void vita2d_start_drawing_advanced(vita2d_texture *target, unsigned int flags);
+/*
+ * Consecutive textured draws using the same texture (sprites of one atlas page, glyphs
+ * of one font) and color are batched into a single draw call. end_drawing submits the
+ * pending ones, call it before making GL calls of your own.
+ */
 void vita2d_end_drawing();
 
 int vita2d_common_dialog_update();
@@ -71,6 +218,37 @@ int vita2d_common_dialog_update();
 void vita2d_set_clear_color(unsigned int color);
 unsigned int vita2d_get_clear_color();
 void vita2d_set_vblank_wait(int enable);
+/* Counters accumulate until vita2d_reset_draw_stats() is called */
+void vita2d_get_draw_stats(vita2d_draw_stats *stats);
+void vita2d_reset_draw_stats();
+/*
+ * Snapshot of every live texture and the texture memory totals, peaks included.
+ * Returns 0 on success, -1 if the entries can't be allocated.
+ * The tags point into the textures, so free the report before them.
+ */
+int vita2d_get_memory_report(vita2d_memory_report *report);
+void vita2d_free_memory_report(vita2d_memory_report *report);
+// printf()s the report, largest textures first
+void vita2d_print_memory_report();
+/*
+ * Reads back a rectangle of a render target (or of the screen when target is NULL)
+ * without stalling: the callback is run from vita2d_swap_buffers() once the GPU is
+ * done with it, a few frames later. Render targets are copied on the
+ * GPU when this is called, so later draws to them don't show up. For the screen, the
+ * frame is drawn to an offscreen copy from its first vita2d_start_drawing() and put on
+ * the screen by vita2d_swap_buffers(): that's the current frame if drawing it hasn't
+ * started yet (or it's already being captured), the next one otherwise.
+ * The internal copies don't count in the draw stats.
+ * Returns 0 on success, -1 on invalid rectangle or allocation failure.
+ */
+int vita2d_read_pixels_async(const vita2d_texture *target, int x, int y, unsigned int w, unsigned int h, vita2d_readback_callback callback, void *userdata);
+/*
+ * Copies the RGBA8 pixels and encodes them to a PNG file on a worker thread.
+ * done may be NULL. Returns 0 if the write was queued, -1 otherwise.
+ */
+int vita2d_write_PNG_async(const char *filename, const void *pixels, unsigned int w, unsigned int h, unsigned int stride, vita2d_png_done_callback done, void *userdata);
+// vita2d_read_pixels_async() of the whole target followed by vita2d_write_PNG_async()
+int vita2d_screenshot_async(const vita2d_texture *target, const char *filename);
 //void *vita2d_get_current_fb();
 //SceGxmContext *vita2d_get_context();
 //SceGxmShaderPatcher *vita2d_get_shader_patcher();
@@ -107,11 +285,68 @@ unsigned int vita2d_texture_get_width(const vita2d_texture *texture);
 unsigned int vita2d_texture_get_height(const vita2d_texture *texture);
 unsigned int vita2d_texture_get_stride(const vita2d_texture *texture);
 SceGxmTextureFormat vita2d_texture_get_format(const vita2d_texture *texture);
+// NULL for subtextures, their texels belong to the atlas page
 void *vita2d_texture_get_datap(const vita2d_texture *texture);
-//void *vita2d_texture_get_palette(const vita2d_texture *texture);
+// Palette colors (RGBA8, 16 entries for P4 formats, 256 for P8), NULL for non paletted textures
+void *vita2d_texture_get_palette(const vita2d_texture *texture);
+/*
+ * Makes the texture use 'palette' (it takes a reference). The palette size has to
+ * match the format. Returns 0 on success, -1 otherwise.
+ */
+int vita2d_texture_set_palette(vita2d_texture *texture, vita2d_palette *palette);
+/*
+ * Converts src to the texture's format and queues it for upload. Pending regions are
+ * uploaded together, as their bounding box, on the next draw of the texture,
+ * vita2d_texture_flush() or when drawing to it starts. Only the bounding box is kept
+ * in memory until then. Returns 0 on success, -1 on invalid region, unsupported format
+ * or a subtexture.
+ */
+int vita2d_texture_update_region(vita2d_texture *texture, unsigned int x, unsigned int y, unsigned int w, unsigned int h, const void *src, unsigned int src_stride, SceGxmTextureFormat src_format);
+// Returns 1 and the bounding box of the pending updates, 0 if there are none
+int vita2d_texture_get_dirty_region(const vita2d_texture *texture, unsigned int *x, unsigned int *y, unsigned int *w, unsigned int *h);
+void vita2d_texture_flush(vita2d_texture *texture);
 SceGxmTextureFilter vita2d_texture_get_min_filter(const vita2d_texture *texture);
 SceGxmTextureFilter vita2d_texture_get_mag_filter(const vita2d_texture *texture);
+/*
+ * Palettes for P4 (16 entries) and P8 (256 entries) textures, created with every
+ * color set to 0. Updates are seen by every texture using the palette, including
+ * draws of the current frame the GPU hasn't executed yet.
+ */
+vita2d_palette *vita2d_create_palette(unsigned int entries);
+// Drops a reference, the palette is freed once no texture uses it anymore
+void vita2d_free_palette(vita2d_palette *palette);
+unsigned int vita2d_palette_get_entries(const vita2d_palette *palette);
+// Copies count RGBA8 colors starting at entry first. Returns 0 on success, -1 if out of range.
+int vita2d_palette_update(vita2d_palette *palette, unsigned int first, unsigned int count, const unsigned int *colors);
+
 void vita2d_texture_set_filters(vita2d_texture *texture, SceGxmTextureFilter min_filter, SceGxmTextureFilter mag_filter);
+// Names the texture in memory reports (copied), file loaders use the file name
+void vita2d_texture_set_tag(vita2d_texture *texture, const char *tag);
+const char *vita2d_texture_get_tag(const vita2d_texture *texture);
+void vita2d_texture_set_category(vita2d_texture *texture, vita2d_texture_category category);
+/*
+ * Builds the mip chain down to 1x1 from the base level: RGBA8 textures are box filtered
+ * on the CPU, other uncompressed formats go through glGenerateMipmap. It has to be called
+ * again after the base level changes. Returns 0 on success, -1 for compressed/paletted
+ * formats, subtextures or when the texture memory isn't available.
+ */
+int vita2d_texture_generate_mipmaps(vita2d_texture *texture);
+// Selects how mip levels are sampled on minification, no effect without a mip chain
+void vita2d_texture_set_mip_filter(vita2d_texture *texture, vita2d_mip_filter mip_filter);
+vita2d_mip_filter vita2d_texture_get_mip_filter(const vita2d_texture *texture);
+
+/*
+ * Streaming textures rotate between 'buffers' (at least 2) textures so that a new frame can be
+ * written while the GPU still samples the previous ones. begin_write returns the data pointer
+ * of a buffer the GPU is done with (and its stride), or NULL if all of them may still be in use;
+ * 3 buffers are enough for one write per frame. end_write makes it the texture that gets drawn,
+ * until then begin_write keeps returning the same buffer.
+ */
+vita2d_streaming_texture *vita2d_create_streaming_texture(unsigned int w, unsigned int h, SceGxmTextureFormat format, unsigned int buffers);
+void vita2d_free_streaming_texture(vita2d_streaming_texture *stream);
+void *vita2d_streaming_texture_begin_write(vita2d_streaming_texture *stream, unsigned int *stride);
+void vita2d_streaming_texture_end_write(vita2d_streaming_texture *stream);
+vita2d_texture *vita2d_streaming_texture_get_texture(const vita2d_streaming_texture *stream);
 
 void vita2d_draw_texture(const vita2d_texture *texture, float x, float y);
 void vita2d_draw_texture_rotate(const vita2d_texture *texture, float x, float y, float rad);
@@ -143,6 +378,202 @@ vita2d_texture *vita2d_load_JPEG_buffer(const void *buffer, unsigned long buffer
 vita2d_texture *vita2d_load_BMP_file(const char *filename);
 vita2d_texture *vita2d_load_BMP_buffer(const void *buffer, unsigned long buffer_size);
 
+/*
+ * Same as above, but converted to 'format' at load time (U5U6U5_RGB, U4U4U4U4_RGBA, U5U5U5U1_RGBA,
+ * U8U8U8_RGB, U8_R, ...). Dithering only applies to formats with less than 8 bits per channel.
+ */
+vita2d_texture *vita2d_load_PNG_file_format(const char *filename, SceGxmTextureFormat format, vita2d_dither_mode dither);
+vita2d_texture *vita2d_load_PNG_buffer_format(const void *buffer, unsigned long buffer_size, SceGxmTextureFormat format, vita2d_dither_mode dither);
+vita2d_texture *vita2d_load_JPEG_file_format(const char *filename, SceGxmTextureFormat format, vita2d_dither_mode dither);
+vita2d_texture *vita2d_load_JPEG_buffer_format(const void *buffer, unsigned long buffer_size, SceGxmTextureFormat format, vita2d_dither_mode dither);
+vita2d_texture *vita2d_load_BMP_file_format(const char *filename, SceGxmTextureFormat format, vita2d_dither_mode dither);
+vita2d_texture *vita2d_load_BMP_buffer_format(const void *buffer, unsigned long buffer_size, SceGxmTextureFormat format, vita2d_dither_mode dither);
+
+/*
+ * Any supported image read through callbacks (archive entries, custom sources, ...).
+ * Built in decoders stream it through small fixed buffers instead of reading it whole.
+ */
+vita2d_texture *vita2d_load_image_callbacks(const vita2d_io_callbacks *callbacks, void *user);
+vita2d_texture *vita2d_load_image_callbacks_format(const vita2d_io_callbacks *callbacks, void *user, SceGxmTextureFormat format, vita2d_dither_mode dither);
+
+/*
+ * Loads the image shrunk to fit in max_w x max_h (0 for no limit) keeping its aspect ratio,
+ * for thumbnails. JPEGs are scaled down while decoding and PNG, BMP and TGA rows as they come,
+ * so memory use follows the output size (interlaced PNGs and other formats are decoded whole).
+ * filter: SCE_GXM_TEXTURE_FILTER_POINT keeps the nearest pixel, LINEAR averages them.
+ */
+vita2d_texture *vita2d_load_image_scaled(const char *filename, unsigned int max_w, unsigned int max_h, SceGxmTextureFilter filter);
+
+/*
+ * Loads an indexed color PNG as a P4 (up to 16 colors) or P8 texture, keeping its
+ * palette (including tRNS alpha). Returns NULL if the PNG doesn't have a palette.
+ */
+vita2d_texture *vita2d_load_PNG_file_paletted(const char *filename);
+vita2d_texture *vita2d_load_PNG_buffer_paletted(const void *buffer, unsigned long buffer_size);
+
+/*
+ * Managed textures remember how they were loaded. When the resident managed textures
+ * exceed the budget, the least recently drawn ones (not drawn in the current frame) give
+ * their memory back and are loaded again by the next draw or vita2d_texture_get_datap.
+ * Changes made through get_datap/update_region are lost on eviction. For the buffer
+ * variant, the buffer has to stay valid until the texture is freed.
+ */
+vita2d_texture *vita2d_load_managed_file(const char *filename, vita2d_file_loader loader);
+vita2d_texture *vita2d_load_managed_buffer(const void *buffer, unsigned long buffer_size, vita2d_buffer_loader loader);
+// Budget in bytes for all managed textures, 0 (the default) disables eviction
+void vita2d_set_texture_budget(size_t bytes);
+void vita2d_get_texture_cache_stats(vita2d_texture_cache_stats *stats);
+void vita2d_reset_texture_cache_stats();
+// 1 if the texture currently holds its memory (always 1 for non managed textures)
+int vita2d_texture_is_resident(const vita2d_texture *texture);
+
+/*
+ * Every image load picks its decoder by the first bytes of the image: registered decoders
+ * (newest first), then the built in PNG (libpng), JPEG (libjpeg), uncompressed BMP and TGA
+ * ones, then stb_image for anything else. The decoder is copied, up to 16 can be registered.
+ * Registered decoders get callback and file sources read whole into memory.
+ * Returns 0 on success, -1 if the registry is full.
+ */
+int vita2d_register_image_decoder(const vita2d_image_decoder *decoder);
+// Decoders in the order they're tried, stb_image last
+unsigned int vita2d_get_image_decoder_count();
+// Returns 0 on success, -1 if index is out of range
+int vita2d_get_image_decoder_stats(unsigned int index, vita2d_image_decoder_stats *stats);
+void vita2d_reset_image_decoder_stats();
+
+/*
+ * Disk cache of decoded textures, off by default. While it's on, image loads from files
+ * and buffers (not callbacks) look for an entry keyed by the texture format, dithering,
+ * scaling and, for files, their path, size and modification time (a file rewritten with
+ * the same size within a second keeps its entry), for buffers the 64-bit hash of the
+ * encoded image and its size. A hit fills the texture from the LZ4 compressed entry
+ * instead of decoding, a miss decodes (streaming files) and writes the entry.
+ * Entries from another cache version or texture layout count as misses and get replaced.
+ * dir is created if needed, NULL turns the cache off. Returns 0 on success, -1 on error.
+ */
+int vita2d_set_disk_cache(const char *dir);
+// disk_bytes and entries are measured on the cache directory by each call
+void vita2d_get_disk_cache_stats(vita2d_disk_cache_stats *stats);
+void vita2d_reset_disk_cache_stats();
+// Deletes every entry in the cache directory, returns how many were deleted
+unsigned int vita2d_clear_disk_cache();
+
+/*
+ * Shared textures: every get of the same file (compared after normalizing the path)
+ * or of the same content (compared by size and 64-bit hash) returns the same texture
+ * with one more reference. vita2d_free_texture drops a reference and frees the texture
+ * with the last one. Images are decoded like vita2d_load_PNG_file/buffer.
+ */
+vita2d_texture *vita2d_texture_cache_get(const char *filename);
+vita2d_texture *vita2d_texture_cache_get_buffer(const void *buffer, unsigned long buffer_size);
+
+/*
+ * Asynchronous loading: images are decoded (like vita2d_load_PNG_file) by a pool of worker
+ * threads, higher priorities first, then copied into their texture by vita2d_swap_buffers()
+ * on the render thread, at most 'budget' bytes per frame (1 MiB by default, 0 = no limit).
+ * The worker count has to be set before the first request, it defaults to 2 (at most 4).
+ */
+void vita2d_set_image_loader_workers(unsigned int count);
+void vita2d_set_upload_budget(size_t bytes_per_frame);
+// Returned by vita2d_image_request_get_texture until the image is ready, NULL by default
+void vita2d_set_image_placeholder(vita2d_texture *texture);
+vita2d_image_request *vita2d_load_image_async(const char *filename, int priority);
+vita2d_image_status vita2d_image_request_get_status(const vita2d_image_request *req);
+// The loaded texture once ready, the placeholder otherwise. It's owned by the request.
+vita2d_texture *vita2d_image_request_get_texture(const vita2d_image_request *req);
+// Hands the loaded texture over to the caller, NULL if not ready
+vita2d_texture *vita2d_image_request_take_texture(vita2d_image_request *req);
+// Cancels the load if still in progress, frees the texture unless it was taken
+void vita2d_free_image_request(vita2d_image_request *req);
+vita2d_image_batch *vita2d_load_image_batch_async(const char * const *filenames, unsigned int count, int priority);
+vita2d_image_request *vita2d_image_batch_get_request(const vita2d_image_batch *batch, unsigned int index);
+// Progress of the whole batch in [0, 1], finished (may be NULL) gets the ready + failed count
+float vita2d_image_batch_get_progress(const vita2d_image_batch *batch, unsigned int *finished);
+// Frees every request of the batch
+void vita2d_free_image_batch(vita2d_image_batch *batch);
+
+/*
+ * Packs RGBA8 images into shared page_w x page_h pages, so draws of sprites from the
+ * same page don't switch textures. Each sprite gets 'padding' pixels of free space
+ * around it, the first ring of which repeats its edge and corner texels (avoids bleeding with
+ * linear filtering).
+ */
+vita2d_sprite_atlas *vita2d_create_sprite_atlas(unsigned int page_w, unsigned int page_h, unsigned int padding);
+// Frees the pages and every subtexture of the atlas
+void vita2d_free_sprite_atlas(vita2d_sprite_atlas *atlas);
+// Copies w x h RGBA8 (U8U8U8U8_ABGR) pixels into a page, NULL if it's larger than a page
+vita2d_subtexture *vita2d_sprite_atlas_add(vita2d_sprite_atlas *atlas, const void *pixels, unsigned int w, unsigned int h, unsigned int stride);
+vita2d_subtexture *vita2d_sprite_atlas_load_PNG_file(vita2d_sprite_atlas *atlas, const char *filename);
+vita2d_subtexture *vita2d_sprite_atlas_load_PNG_buffer(vita2d_sprite_atlas *atlas, const void *buffer, unsigned long buffer_size);
+/*
+ * Loads an atlas baked by tools/atlas_baker: the index (.v2da) and its GXT pages. Sprites
+ * are looked up by name (their PNG file name without extension) with vita2d_sprite_atlas_find.
+ * More sprites can be added at runtime, they go to new pages.
+ */
+vita2d_sprite_atlas *vita2d_load_sprite_atlas(const char *index_filename);
+// NULL if the baked index has no sprite with this name
+vita2d_subtexture *vita2d_sprite_atlas_find(const vita2d_sprite_atlas *atlas, const char *name);
+unsigned int vita2d_sprite_atlas_get_page_count(const vita2d_sprite_atlas *atlas);
+vita2d_texture *vita2d_sprite_atlas_get_page(const vita2d_sprite_atlas *atlas, unsigned int page);
+
+/*
+ * Loads every frame of an animated GIF into a single texture, laid out in a grid, along
+ * with the frame delays. Other images load as a one frame animation. Frames are w x h
+ * subtextures of the sheet (with a ring of edge texels around each, so they can be scaled
+ * with linear filtering). NULL if the frames don't fit in a 4096x4096 texture.
+ */
+vita2d_animation *vita2d_load_animation(const char *filename);
+vita2d_animation *vita2d_load_animation_buffer(const void *buffer, unsigned long buffer_size);
+void vita2d_free_animation(vita2d_animation *anim);
+unsigned int vita2d_animation_get_frame_count(const vita2d_animation *anim);
+// Length of one loop in ms
+unsigned int vita2d_animation_get_duration(const vita2d_animation *anim);
+// The sheet holding every frame, for filters
+vita2d_texture *vita2d_animation_get_texture(const vita2d_animation *anim);
+// NULL if out of range, delay (may be NULL) gets how long the frame is shown in ms
+vita2d_subtexture *vita2d_animation_get_frame(const vita2d_animation *anim, unsigned int index, unsigned int *delay);
+// Frame shown 'time' ms after the start, the animation loops. Any vita2d_draw_texture_* can draw it.
+vita2d_subtexture *vita2d_animation_get_frame_at(const vita2d_animation *anim, unsigned int time);
+void vita2d_draw_animation(const vita2d_animation *anim, unsigned int time, float x, float y);
+
+/*
+ * Asset packs, built by tools/asset_packer: many files in one, looked up by their path
+ * relative to the packed directory ("ui/button.png"). The pack is read in one go and
+ * assets are served from that memory without copying, so it has to stay open while
+ * fonts loaded from it are in use. Buffers passed to vita2d_open_asset_pack_buffer
+ * must be 4 byte aligned and aren't copied either.
+ */
+vita2d_asset_pack *vita2d_open_asset_pack(const char *filename);
+vita2d_asset_pack *vita2d_open_asset_pack_buffer(const void *buffer, unsigned long buffer_size);
+void vita2d_close_asset_pack(vita2d_asset_pack *pack);
+// The asset's bytes (16 byte aligned within the pack), NULL if there's no such name
+const void *vita2d_asset_pack_find(const vita2d_asset_pack *pack, const char *name, unsigned long *size);
+unsigned int vita2d_asset_pack_get_count(const vita2d_asset_pack *pack);
+const char *vita2d_asset_pack_get_name(const vita2d_asset_pack *pack, unsigned int index);
+// Any image vita2d_load_PNG_buffer handles, GXT (first texture), DDS, PVR or KTX
+vita2d_texture *vita2d_asset_pack_load_texture(const vita2d_asset_pack *pack, const char *name);
+vita2d_font *vita2d_asset_pack_load_font(const vita2d_asset_pack *pack, const char *name);
+
+/*
+ * Loads a block compressed texture (DXT1/3/5, PVRTC 2/4bpp, ETC1) from a DDS, PVR or KTX
+ * container without decoding it. All the mip levels stored in the file are uploaded.
+ */
+vita2d_texture *vita2d_load_compressed_file(const char *filename);
+vita2d_texture *vita2d_load_compressed_buffer(const void *buffer, unsigned long buffer_size);
+
+/*
+ * Loads the index-th texture of a GXT file. The payload is already in GXM layout
+ * (swizzled, tiled or linear, possibly compressed or paletted) and is copied as is.
+ */
+vita2d_texture *vita2d_load_GXT_file(const char *filename, unsigned int index);
+vita2d_texture *vita2d_load_GXT_buffer(const void *buffer, unsigned long buffer_size, unsigned int index);
+/*
+ * Loads up to max_textures textures of a GXT file into 'textures'.
+ * Returns the number of textures loaded, -1 on error (nothing is left allocated).
+ */
+int vita2d_load_GXT_file_all(const char *filename, vita2d_texture **textures, unsigned int max_textures);
+int vita2d_load_GXT_buffer_all(const void *buffer, unsigned long buffer_size, vita2d_texture **textures, unsigned int max_textures);
+
 vita2d_font *vita2d_load_font_file(const char *filename);
 vita2d_font *vita2d_load_font_mem(const void *buffer, unsigned int size);
 void vita2d_free_font(vita2d_font *font);
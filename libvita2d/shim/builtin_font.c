@@ -0,0 +1,272 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vitagl_sw.h>
+
+/*
+ * A TrueType font generated on first use, so the host build has a system font
+ * without shipping one. Printable ASCII gets one 5x7 block pattern per glyph,
+ * derived from the character code: unreadable, but every glyph differs and all
+ * of it is hinting free, integral outlines that rasterize the same everywhere.
+ */
+
+#define FIRST_CHAR 0x20
+#define LAST_CHAR 0x7E
+#define NUM_GLYPHS (LAST_CHAR - FIRST_CHAR + 2) /* + .notdef */
+#define CELL 128
+#define COLS 5
+#define ROWS 7
+#define UNITS_PER_EM 1024
+#define ADVANCE ((COLS + 1) * CELL)
+#define ASCENT (ROWS * CELL)
+#define DESCENT (2 * CELL)
+#define NUM_TABLES 9
+
+typedef struct buffer {
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+	int failed;
+} buffer;
+
+static uint8_t *font_data;
+static size_t font_size;
+
+static int put(buffer *b, const void *data, size_t size)
+{
+	if (b->size + size > b->capacity) {
+		size_t capacity = b->capacity ? b->capacity * 2 : 4096;
+		while (capacity < b->size + size)
+			capacity *= 2;
+		uint8_t *p = realloc(b->data, capacity);
+		if (!p) {
+			b->failed = 1;
+			return -1;
+		}
+		b->data = p;
+		b->capacity = capacity;
+	}
+	memcpy(b->data + b->size, data, size);
+	b->size += size;
+	return 0;
+}
+
+static void put16(buffer *b, unsigned int v)
+{
+	uint8_t d[2] = {v >> 8, v};
+	put(b, d, 2);
+}
+
+static void put32(buffer *b, uint32_t v)
+{
+	uint8_t d[4] = {v >> 24, v >> 16, v >> 8, v};
+	put(b, d, 4);
+}
+
+static void pad4(buffer *b)
+{
+	while (b->size & 3)
+		put(b, "", 1);
+}
+
+/* Row bits of glyph c, bit 4 is the leftmost column. Never an empty row, so the
+ * glyph box is always the full cell grid. */
+static unsigned int glyph_row(unsigned int c, int row)
+{
+	uint32_t h = 2166136261U;
+	h = (h ^ c) * 16777619U;
+	h = (h ^ row) * 16777619U;
+	h ^= h >> 15;
+	return (h & 0x1F) | (row & 1 ? 0x01 : 0x10);
+}
+
+static void put_glyph(buffer *b, unsigned int c)
+{
+	int row, col, n = 0;
+
+	for (row = 0; row < ROWS; row++)
+		for (col = 0; col < COLS; col++)
+			n += (glyph_row(c, row) >> (COLS - 1 - col)) & 1;
+
+	put16(b, n);
+	put16(b, 0);
+	put16(b, 0);
+	put16(b, COLS * CELL);
+	put16(b, ROWS * CELL);
+	for (row = 0; row < n; row++)
+		put16(b, row * 4 + 3);
+	put16(b, 0); /* no instructions */
+	for (row = 0; row < n * 4; row++)
+		put(b, "\x01", 1); /* on curve, 16-bit coordinates */
+
+	/* One clockwise square per set cell, x deltas then y deltas */
+	for (int pass = 0; pass < 2; pass++) {
+		int last = 0;
+		for (row = 0; row < ROWS; row++) {
+			for (col = 0; col < COLS; col++) {
+				if (!((glyph_row(c, row) >> (COLS - 1 - col)) & 1))
+					continue;
+				int x0 = col * CELL, x1 = x0 + CELL;
+				int y0 = (ROWS - 1 - row) * CELL, y1 = y0 + CELL;
+				int pts[4] = {
+					pass ? y0 : x0, pass ? y1 : x0,
+					pass ? y1 : x1, pass ? y0 : x1
+				};
+				for (int i = 0; i < 4; i++) {
+					put16(b, (uint16_t)(pts[i] - last));
+					last = pts[i];
+				}
+			}
+		}
+	}
+}
+
+static int build(void)
+{
+	buffer tables[NUM_TABLES] = {{0}};
+	static const char tags[NUM_TABLES][5] = {
+		"cmap", "glyf", "head", "hhea", "hmtx", "loca", "maxp", "name", "post"
+	};
+	buffer *cmap = &tables[0], *glyf = &tables[1], *head = &tables[2];
+	buffer *hhea = &tables[3], *hmtx = &tables[4], *loca = &tables[5];
+	buffer *maxp = &tables[6], *name = &tables[7], *post = &tables[8];
+	buffer out = {0};
+	unsigned int c;
+	int i, ret = -1;
+
+	/* .notdef and space are empty */
+	put32(loca, 0);
+	put32(loca, 0);
+	put32(loca, 0);
+	for (c = FIRST_CHAR + 1; c <= LAST_CHAR; c++) {
+		put_glyph(glyf, c);
+		pad4(glyf);
+		put32(loca, glyf->size);
+	}
+
+	for (i = 0; i < NUM_GLYPHS; i++) {
+		put16(hmtx, ADVANCE);
+		put16(hmtx, 0);
+	}
+
+	/* Format 4, one segment for printable ASCII plus the 0xFFFF terminator */
+	put16(cmap, 0);
+	put16(cmap, 1);
+	put16(cmap, 3); /* Windows, Unicode BMP */
+	put16(cmap, 1);
+	put32(cmap, 12);
+	put16(cmap, 4);
+	put16(cmap, 32);
+	put16(cmap, 0);
+	put16(cmap, 4); /* segCountX2 */
+	put16(cmap, 4);
+	put16(cmap, 1);
+	put16(cmap, 0);
+	put16(cmap, LAST_CHAR);
+	put16(cmap, 0xFFFF);
+	put16(cmap, 0);
+	put16(cmap, FIRST_CHAR);
+	put16(cmap, 0xFFFF);
+	put16(cmap, (uint16_t)(1 - FIRST_CHAR));
+	put16(cmap, 1);
+	put16(cmap, 0);
+	put16(cmap, 0);
+
+	put32(head, 0x00010000);
+	put32(head, 0x00010000);
+	put32(head, 0); /* checksum adjustment, FreeType doesn't check it */
+	put32(head, 0x5F0F3CF5);
+	put16(head, 0x000B);
+	put16(head, UNITS_PER_EM);
+	put32(head, 0);
+	put32(head, 0);
+	put32(head, 0);
+	put32(head, 0);
+	put16(head, 0);
+	put16(head, 0);
+	put16(head, COLS * CELL);
+	put16(head, ROWS * CELL);
+	put16(head, 0);
+	put16(head, 8);
+	put16(head, 2);
+	put16(head, 1); /* long loca */
+	put16(head, 0);
+
+	put32(hhea, 0x00010000);
+	put16(hhea, ASCENT);
+	put16(hhea, (uint16_t)-DESCENT);
+	put16(hhea, 0);
+	put16(hhea, ADVANCE);
+	put16(hhea, 0);
+	put16(hhea, CELL);
+	put16(hhea, COLS * CELL);
+	put16(hhea, 1);
+	put16(hhea, 0);
+	put16(hhea, 0);
+	for (i = 0; i < 5; i++)
+		put16(hhea, 0);
+	put16(hhea, NUM_GLYPHS);
+
+	put32(maxp, 0x00010000);
+	put16(maxp, NUM_GLYPHS);
+	put16(maxp, COLS * ROWS * 4);
+	put16(maxp, COLS * ROWS);
+	put16(maxp, 0);
+	put16(maxp, 0);
+	put16(maxp, 2);
+	for (i = 0; i < 8; i++)
+		put16(maxp, 0);
+
+	put16(name, 0);
+	put16(name, 0);
+	put16(name, 6);
+
+	put32(post, 0x00030000);
+	for (i = 0; i < 7; i++)
+		put32(post, 0);
+
+	/* Offset table and directory, tags are already sorted */
+	put32(&out, 0x00010000);
+	put16(&out, NUM_TABLES);
+	put16(&out, 128);
+	put16(&out, 3);
+	put16(&out, NUM_TABLES * 16 - 128);
+
+	uint32_t offset = 12 + NUM_TABLES * 16;
+	for (i = 0; i < NUM_TABLES; i++) {
+		put(&out, tags[i], 4);
+		put32(&out, 0);
+		put32(&out, offset);
+		put32(&out, tables[i].size);
+		offset += (tables[i].size + 3) & ~3;
+	}
+	for (i = 0; i < NUM_TABLES; i++) {
+		if (tables[i].size)
+			put(&out, tables[i].data, tables[i].size);
+		pad4(&out);
+	}
+
+	int failed = out.failed;
+	for (i = 0; i < NUM_TABLES; i++)
+		failed |= tables[i].failed;
+
+	if (!failed) {
+		font_data = out.data;
+		font_size = out.size;
+		ret = 0;
+	} else {
+		free(out.data);
+	}
+
+	for (i = 0; i < NUM_TABLES; i++)
+		free(tables[i].data);
+	return ret;
+}
+
+const void *vitagl_sw_get_builtin_font(size_t *size)
+{
+	if (!font_data && build() < 0)
+		return NULL;
+	*size = font_size;
+	return font_data;
+}
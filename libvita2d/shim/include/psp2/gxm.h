@@ -0,0 +1,97 @@
+#ifndef _PSP2_GXM_H_
+#define _PSP2_GXM_H_
+
+#include <psp2/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The texture formats, types and filters vita2d uses, laid out like the SDK's
+ * (base format in the top bits, swizzle below). SceGxmTexture is the shim's own,
+ * it describes what vitagl_sw samples.
+ */
+
+#define SCE_GXM_TEXTURE_BASE_FORMAT_U8          0x00000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_U4U4U4U4    0x02000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_U1U5U5U5    0x04000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_U5U6U5      0x05000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_U8U8U8U8    0x0C000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_PVRT2BPP    0x80000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_PVRT4BPP    0x81000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_PVRTII2BPP  0x82000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_PVRTII4BPP  0x83000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_UBC1        0x85000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_UBC2        0x86000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_UBC3        0x87000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_P4          0x94000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_P8          0x95000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_U8U8U8      0x98000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_ETC1        0x9B000000U
+#define SCE_GXM_TEXTURE_BASE_FORMAT_MASK        0x9F000000U
+
+typedef enum SceGxmTextureFormat {
+	SCE_GXM_TEXTURE_FORMAT_U8_R             = 0x00000000U,
+	SCE_GXM_TEXTURE_FORMAT_U8_R111          = 0x00007000U,
+	SCE_GXM_TEXTURE_FORMAT_U4U4U4U4_RGBA    = 0x02002000U,
+	SCE_GXM_TEXTURE_FORMAT_U5U5U5U1_RGBA    = 0x04002000U,
+	SCE_GXM_TEXTURE_FORMAT_U5U6U5_RGB       = 0x05001000U,
+	SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR    = 0x0C000000U,
+	SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ARGB    = 0x0C001000U,
+	SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_RGBA    = 0x0C002000U,
+	SCE_GXM_TEXTURE_FORMAT_PVRT2BPP_ABGR    = 0x80000000U,
+	SCE_GXM_TEXTURE_FORMAT_PVRT4BPP_ABGR    = 0x81000000U,
+	SCE_GXM_TEXTURE_FORMAT_PVRTII2BPP_ABGR  = 0x82000000U,
+	SCE_GXM_TEXTURE_FORMAT_PVRTII4BPP_ABGR  = 0x83000000U,
+	SCE_GXM_TEXTURE_FORMAT_UBC1_ABGR        = 0x85000000U,
+	SCE_GXM_TEXTURE_FORMAT_UBC2_ABGR        = 0x86000000U,
+	SCE_GXM_TEXTURE_FORMAT_UBC3_ABGR        = 0x87000000U,
+	SCE_GXM_TEXTURE_FORMAT_P4_ABGR          = 0x94000000U,
+	SCE_GXM_TEXTURE_FORMAT_P8_ABGR          = 0x95000000U,
+	SCE_GXM_TEXTURE_FORMAT_U8U8U8_BGR       = 0x98000000U,
+	SCE_GXM_TEXTURE_FORMAT_U8U8U8_RGB       = 0x98001000U,
+	SCE_GXM_TEXTURE_FORMAT_ETC1_RGB         = 0x9B001000U
+} SceGxmTextureFormat;
+
+typedef enum SceGxmTextureType {
+	SCE_GXM_TEXTURE_SWIZZLED           = 0x00000000U,
+	SCE_GXM_TEXTURE_LINEAR             = 0x60000000U,
+	SCE_GXM_TEXTURE_TILED              = 0x80000000U,
+	SCE_GXM_TEXTURE_SWIZZLED_ARBITRARY = 0xA0000000U
+} SceGxmTextureType;
+
+typedef enum SceGxmTextureFilter {
+	SCE_GXM_TEXTURE_FILTER_POINT  = 0x00000000U,
+	SCE_GXM_TEXTURE_FILTER_LINEAR = 0x00000001U
+} SceGxmTextureFilter;
+
+#define SCE_GXM_PALETTE_ALIGNMENT 64
+#define SCE_GXM_TEXTURE_ALIGNMENT 16
+
+typedef struct SceGxmTexture {
+	const void *data;
+	const void *palette;
+	SceGxmTextureFormat format;
+	SceGxmTextureType type;
+	unsigned int width;
+	unsigned int height;
+	unsigned int mip_count;
+} SceGxmTexture;
+
+int sceGxmTextureInitLinear(SceGxmTexture *texture, const void *data, SceGxmTextureFormat format,
+			    unsigned int width, unsigned int height, unsigned int mipCount);
+int sceGxmTextureInitSwizzled(SceGxmTexture *texture, const void *data, SceGxmTextureFormat format,
+			      unsigned int width, unsigned int height, unsigned int mipCount);
+int sceGxmTextureInitSwizzledArbitrary(SceGxmTexture *texture, const void *data, SceGxmTextureFormat format,
+				       unsigned int width, unsigned int height, unsigned int mipCount);
+int sceGxmTextureInitTiled(SceGxmTexture *texture, const void *data, SceGxmTextureFormat format,
+			   unsigned int width, unsigned int height, unsigned int mipCount);
+int sceGxmTextureSetFormat(SceGxmTexture *texture, SceGxmTextureFormat format);
+int sceGxmTextureSetPalette(SceGxmTexture *texture, const void *paletteData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef _PSP2_KERNEL_CLIB_H_
+#define _PSP2_KERNEL_CLIB_H_
+
+#include <string.h>
+#include <psp2/types.h>
+
+// stb_image's Vita path copies rows with it
+#define sceClibMemcpy(dst, src, len) memcpy(dst, src, len)
+
+#endif
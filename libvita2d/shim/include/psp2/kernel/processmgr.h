@@ -0,0 +1,17 @@
+#ifndef _PSP2_KERNEL_PROCESSMGR_H_
+#define _PSP2_KERNEL_PROCESSMGR_H_
+
+#include <psp2/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Microseconds from a monotonic clock
+SceUInt64 sceKernelGetProcessTimeWide(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
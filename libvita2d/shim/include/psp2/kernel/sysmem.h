@@ -0,0 +1,7 @@
+#ifndef _PSP2_KERNEL_SYSMEM_H_
+#define _PSP2_KERNEL_SYSMEM_H_
+
+// vita2d doesn't allocate memory blocks itself, vglMalloc covers it
+#include <psp2/types.h>
+
+#endif
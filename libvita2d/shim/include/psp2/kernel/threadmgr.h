@@ -0,0 +1,41 @@
+#ifndef _PSP2_KERNEL_THREADMGR_H_
+#define _PSP2_KERNEL_THREADMGR_H_
+
+#include <pthread.h>
+#include <psp2/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Threads, semaphores and lightweight mutexes on top of pthreads */
+
+typedef int (*SceKernelThreadEntry)(SceSize args, void *argp);
+
+typedef struct SceKernelLwMutexWork {
+	pthread_mutex_t mutex; // recursive, like SCE_KERNEL_MUTEX_ATTR_RECURSIVE
+} SceKernelLwMutexWork;
+
+SceUID sceKernelCreateThread(const char *name, SceKernelThreadEntry entry, int initPriority,
+			     int stackSize, SceUInt32 attr, int cpuAffinityMask, const void *option);
+int sceKernelStartThread(SceUID thid, SceSize arglen, void *argp);
+int sceKernelExitDeleteThread(int status);
+int sceKernelWaitThreadEnd(SceUID thid, int *stat, SceUInt32 *timeout);
+int sceKernelDelayThread(SceUInt32 delay);
+
+SceUID sceKernelCreateSema(const char *name, SceUInt32 attr, int initVal, int maxVal, void *option);
+int sceKernelDeleteSema(SceUID semaid);
+int sceKernelSignalSema(SceUID semaid, int signal);
+int sceKernelWaitSema(SceUID semaid, int signal, SceUInt32 *timeout);
+
+int sceKernelCreateLwMutex(SceKernelLwMutexWork *pWork, const char *pName, unsigned int attr,
+			   int initCount, const void *pOptParam);
+int sceKernelDeleteLwMutex(SceKernelLwMutexWork *pWork);
+int sceKernelLockLwMutex(SceKernelLwMutexWork *pWork, int lockCount, unsigned int *pTimeout);
+int sceKernelUnlockLwMutex(SceKernelLwMutexWork *pWork, int unlockCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
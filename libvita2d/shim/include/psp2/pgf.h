@@ -0,0 +1,112 @@
+#ifndef _PSP2_PGF_H_
+#define _PSP2_PGF_H_
+
+#include <psp2/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * sceFont (PGF) on FreeType. The system font is whatever was registered with
+ * vitagl_sw_set_system_font(), user files are anything FreeType opens.
+ */
+
+typedef void *SceFontLibHandle;
+typedef void *SceFontHandle;
+
+typedef enum SceFontLanguageCode {
+	SCE_FONT_LANGUAGE_DEFAULT  = 0x0,
+	SCE_FONT_LANGUAGE_JAPANESE = 0x1,
+	SCE_FONT_LANGUAGE_LATIN    = 0x2,
+	SCE_FONT_LANGUAGE_KOREAN   = 0x3,
+	SCE_FONT_LANGUAGE_CHINESE  = 0x4
+} SceFontLanguageCode;
+
+typedef enum SceFontPixelFormatCode {
+	SCE_FONT_PIXELFORMAT_4     = 0,
+	SCE_FONT_PIXELFORMAT_4_REV = 1,
+	SCE_FONT_PIXELFORMAT_8     = 2,
+	SCE_FONT_PIXELFORMAT_24    = 3,
+	SCE_FONT_PIXELFORMAT_32    = 4
+} SceFontPixelFormatCode;
+
+typedef struct SceFontNewLibParams {
+	void *userData;
+	unsigned int numFonts;
+	void *cacheData;
+	void *(*allocFunc)(void *, unsigned int);
+	void (*freeFunc)(void *, void *);
+	void *openFunc;
+	void *closeFunc;
+	void *readFunc;
+	void *seekFunc;
+	void *errorFunc;
+	void *ioFinishFunc;
+} SceFontNewLibParams;
+
+typedef struct SceFontStyle {
+	float fontH;
+	float fontV;
+	float fontHRes;
+	float fontVRes;
+	float fontWeight;
+	unsigned short fontFamily;
+	unsigned short fontStyle;
+	unsigned short fontStyleSub;
+	unsigned short fontLanguage;
+	unsigned short fontRegion;
+	unsigned short fontCountry;
+	char fontName[64];
+	char fontFileName[64];
+	unsigned int fontAttributes;
+	unsigned int fontExpire;
+} SceFontStyle;
+
+typedef struct SceFontInfo {
+	int maxGlyphWidthI;
+	int maxGlyphHeightI;
+	int maxGlyphAscenderI;
+	int maxGlyphDescenderI;
+	SceFontStyle fontStyle;
+} SceFontInfo;
+
+typedef struct SceFontCharInfo {
+	unsigned int bitmapWidth;
+	unsigned int bitmapHeight;
+	unsigned int bitmapLeft;
+	unsigned int bitmapTop;
+	int sfp26Ascender;
+	int sfp26Descender;
+	int sfp26BearingHX;
+	int sfp26BearingHY;
+	int sfp26AdvanceH;
+	int sfp26AdvanceV;
+} SceFontCharInfo;
+
+typedef struct SceFontGlyphImage {
+	SceFontPixelFormatCode pixelFormat;
+	int xPos64; // where the bitmap's top left corner goes, 26.6 fixed point
+	int yPos64;
+	unsigned short bufWidth;
+	unsigned short bufHeight;
+	unsigned short bytesPerLine;
+	unsigned short pad;
+	uintptr_t bufferPtr; // a 32-bit address in the SDK, which doesn't hold host pointers
+} SceFontGlyphImage;
+
+SceFontLibHandle sceFontNewLib(SceFontNewLibParams *params, unsigned int *errorCode);
+int sceFontDoneLib(SceFontLibHandle libHandle);
+int sceFontFindOptimumFont(SceFontLibHandle libHandle, SceFontStyle *fontStyle, unsigned int *errorCode);
+SceFontHandle sceFontOpen(SceFontLibHandle libHandle, int index, int mode, unsigned int *errorCode);
+SceFontHandle sceFontOpenUserFile(SceFontLibHandle libHandle, char *file, int mode, unsigned int *errorCode);
+int sceFontClose(SceFontHandle fontHandle);
+int sceFontGetFontInfo(SceFontHandle fontHandle, SceFontInfo *fontInfo);
+int sceFontGetCharInfo(SceFontHandle fontHandle, unsigned int charCode, SceFontCharInfo *charInfo);
+int sceFontGetCharGlyphImage(SceFontHandle fontHandle, unsigned int charCode, SceFontGlyphImage *glyphImage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef _PSP2_PVF_H_
+#define _PSP2_PVF_H_
+
+#include <psp2/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * scePvf on FreeType. The system font is whatever was registered with
+ * vitagl_sw_set_system_font(), user files are anything FreeType opens.
+ */
+
+typedef uint8_t ScePvfU8;
+typedef uint16_t ScePvfU16;
+typedef int32_t ScePvfS32;
+typedef uint32_t ScePvfU32;
+typedef float ScePvfFloat32;
+typedef int ScePvfError;
+typedef void *ScePvfLibId;
+typedef void *ScePvfFontId;
+typedef int ScePvfFontIndex;
+typedef void *ScePvfPointer;
+
+typedef enum ScePvfLanguageCode {
+	SCE_PVF_DEFAULT_LANGUAGE_CODE = 0,
+	SCE_PVF_LANGUAGE_J            = 1,
+	SCE_PVF_LANGUAGE_LATIN        = 2,
+	SCE_PVF_LANGUAGE_K            = 3,
+	SCE_PVF_LANGUAGE_C            = 4,
+	SCE_PVF_LANGUAGE_CJK          = 5
+} ScePvfLanguageCode;
+
+#define SCE_PVF_DEFAULT_FAMILY_CODE 0
+#define SCE_PVF_DEFAULT_STYLE_CODE  0
+
+typedef enum ScePvfUserImageBufferPixelFormatType {
+	SCE_PVF_USERIMAGE_DIRECT4_L = 0,
+	SCE_PVF_USERIMAGE_DIRECT4_R = 1,
+	SCE_PVF_USERIMAGE_DIRECT8   = 2
+} ScePvfUserImageBufferPixelFormatType;
+
+typedef struct ScePvfInitRec {
+	ScePvfPointer userData;
+	ScePvfU32 maxNumFonts;
+	ScePvfPointer cache;
+	void *reserved;
+	void *(*allocFunc)(ScePvfPointer, ScePvfU32);
+	void *(*reallocFunc)(ScePvfPointer, void *, ScePvfU32);
+	void (*freeFunc)(ScePvfPointer, void *);
+} ScePvfInitRec;
+
+typedef struct ScePvfFontStyleInfo {
+	ScePvfFloat32 weight;
+	ScePvfU16 familyCode;
+	ScePvfU16 style;
+	ScePvfU16 subStyle;
+	ScePvfU16 languageCode;
+	ScePvfU16 regionCode;
+	ScePvfU16 countryCode;
+	ScePvfU8 fontName[64];
+	ScePvfU8 styleName[64];
+	ScePvfU8 fileName[64];
+	ScePvfU32 extraAttributes;
+	ScePvfU32 expireDate;
+} ScePvfFontStyleInfo;
+
+typedef struct ScePvfFontInfo {
+	ScePvfS32 maxIGlyphMetrics[10];
+	ScePvfFontStyleInfo fontStyleInfo;
+} ScePvfFontInfo;
+
+typedef struct ScePvfCharGlyphMetricsInfo {
+	ScePvfS32 width64;
+	ScePvfS32 height64;
+	ScePvfS32 ascender64;
+	ScePvfS32 descender64;
+	ScePvfS32 horizontalBearingX64;
+	ScePvfS32 horizontalBearingY64;
+	ScePvfS32 verticalBearingX64;
+	ScePvfS32 verticalBearingY64;
+	ScePvfS32 horizontalAdvance64;
+	ScePvfS32 verticalAdvance64;
+} ScePvfCharGlyphMetricsInfo;
+
+typedef struct ScePvfCharInfo {
+	ScePvfU32 bitmapWidth;
+	ScePvfU32 bitmapHeight;
+	ScePvfU32 bitmapLeft;
+	ScePvfU32 bitmapTop;
+	ScePvfCharGlyphMetricsInfo glyphMetrics;
+} ScePvfCharInfo;
+
+typedef struct ScePvfIrect {
+	ScePvfU16 width;
+	ScePvfU16 height;
+} ScePvfIrect;
+
+typedef struct ScePvfKerningInfo {
+	struct {
+		ScePvfFloat32 xOffset;
+		ScePvfFloat32 yOffset;
+	} fKerningInfo;
+} ScePvfKerningInfo;
+
+typedef struct ScePvfUserImageBufferRec {
+	ScePvfU32 pixelFormat;
+	ScePvfS32 xPos64; // pen position on the baseline, 26.6 fixed point
+	ScePvfS32 yPos64;
+	ScePvfIrect rect;
+	ScePvfU16 bytesPerLine;
+	ScePvfU16 reserved;
+	ScePvfU8 *buffer;
+} ScePvfUserImageBufferRec;
+
+ScePvfLibId scePvfNewLib(ScePvfInitRec *initParam, ScePvfError *errorCode);
+ScePvfError scePvfDoneLib(ScePvfLibId libID);
+ScePvfError scePvfSetEM(ScePvfLibId libID, ScePvfFloat32 emValue);
+ScePvfError scePvfSetResolution(ScePvfLibId libID, ScePvfFloat32 hResolution, ScePvfFloat32 vResolution);
+ScePvfFontIndex scePvfFindOptimumFont(ScePvfLibId libID, ScePvfFontStyleInfo *fontStyleInfo, ScePvfError *errorCode);
+ScePvfFontId scePvfOpen(ScePvfLibId libID, ScePvfFontIndex fontIndex, ScePvfU32 mode, ScePvfError *errorCode);
+ScePvfFontId scePvfOpenUserFile(ScePvfLibId libID, ScePvfPointer filename, ScePvfU32 mode, ScePvfError *errorCode);
+ScePvfError scePvfClose(ScePvfFontId fontID);
+ScePvfError scePvfSetCharSize(ScePvfFontId fontID, ScePvfFloat32 hSize, ScePvfFloat32 vSize);
+ScePvfError scePvfGetFontInfo(ScePvfFontId fontID, ScePvfFontInfo *fontInfo);
+ScePvfError scePvfGetCharInfo(ScePvfFontId fontID, ScePvfU32 character, ScePvfCharInfo *charInfo);
+ScePvfError scePvfGetCharImageRect(ScePvfFontId fontID, ScePvfU32 character, ScePvfIrect *rect);
+ScePvfError scePvfGetCharGlyphImage(ScePvfFontId fontID, ScePvfU32 character, ScePvfUserImageBufferRec *imageBuffer);
+ScePvfError scePvfGetKerningInfo(ScePvfFontId fontID, ScePvfU32 leftCharacter, ScePvfU32 rightCharacter,
+				 ScePvfKerningInfo *kerningInfo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
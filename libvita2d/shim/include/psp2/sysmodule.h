@@ -0,0 +1,17 @@
+#ifndef _PSP2_SYSMODULE_H_
+#define _PSP2_SYSMODULE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCE_SYSMODULE_PGF 0x0009
+
+// Nothing to load on the host, always succeeds
+int sceSysmoduleLoadModule(unsigned short id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef _PSP2_TYPES_H_
+#define _PSP2_TYPES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int8_t SceChar8;
+typedef uint8_t SceUChar8;
+typedef int8_t SceInt8;
+typedef uint8_t SceUInt8;
+typedef int16_t SceShort16;
+typedef uint16_t SceUShort16;
+typedef int16_t SceInt16;
+typedef uint16_t SceUInt16;
+typedef int32_t SceInt32;
+typedef uint32_t SceUInt32;
+typedef int32_t SceInt;
+typedef uint32_t SceUInt;
+typedef int64_t SceInt64;
+typedef uint64_t SceUInt64;
+typedef float SceFloat;
+typedef float SceFloat32;
+typedef unsigned int SceSize;
+typedef int SceSSize;
+typedef int SceUID;
+typedef int64_t SceOff;
+typedef int SceMode;
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef _VITAGL_H_
+#define _VITAGL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <psp2/gxm.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The fixed function subset of vitaGL that vita2d uses, rasterized by vita2d_sw
+ * (see vitagl_sw.h). Enum values are the standard GL ones.
+ */
+
+typedef unsigned int GLenum;
+typedef unsigned char GLboolean;
+typedef unsigned int GLbitfield;
+typedef void GLvoid;
+typedef int GLint;
+typedef unsigned char GLubyte;
+typedef unsigned short GLushort;
+typedef unsigned int GLuint;
+typedef int GLsizei;
+typedef float GLfloat;
+
+#define GL_FALSE 0
+#define GL_TRUE  1
+
+#define GL_POINTS                           0x0000
+#define GL_LINES                            0x0001
+#define GL_TRIANGLES                        0x0004
+#define GL_TRIANGLE_STRIP                   0x0005
+#define GL_TRIANGLE_FAN                     0x0006
+
+#define GL_ZERO                             0
+#define GL_ONE                              1
+#define GL_SRC_ALPHA                        0x0302
+#define GL_ONE_MINUS_SRC_ALPHA              0x0303
+#define GL_FUNC_ADD                         0x8006
+
+#define GL_LIGHTING                         0x0B50
+#define GL_FOG                              0x0B60
+#define GL_DEPTH_TEST                       0x0B71
+#define GL_STENCIL_TEST                     0x0B90
+#define GL_ALPHA_TEST                       0x0BC0
+#define GL_BLEND                            0x0BE2
+#define GL_SCISSOR_TEST                     0x0C11
+#define GL_UNPACK_ALIGNMENT                 0x0CF5
+#define GL_TEXTURE_2D                       0x0DE1
+
+#define GL_COLOR_BUFFER_BIT                 0x00004000
+
+#define GL_UNSIGNED_BYTE                    0x1401
+#define GL_UNSIGNED_SHORT                   0x1403
+#define GL_FLOAT                            0x1406
+
+#define GL_MODELVIEW                        0x1700
+#define GL_PROJECTION                       0x1701
+
+#define GL_RED                              0x1903
+#define GL_RGB                              0x1907
+#define GL_RGBA                             0x1908
+#define GL_ABGR_EXT                         0x8000
+#define GL_BGR                              0x80E0
+#define GL_BGRA                             0x80E1
+#define GL_UNSIGNED_SHORT_4_4_4_4           0x8033
+#define GL_UNSIGNED_SHORT_5_5_5_1           0x8034
+#define GL_UNSIGNED_SHORT_5_6_5             0x8363
+
+#define GL_NEAREST                          0x2600
+#define GL_LINEAR                           0x2601
+#define GL_NEAREST_MIPMAP_NEAREST           0x2700
+#define GL_LINEAR_MIPMAP_NEAREST            0x2701
+#define GL_NEAREST_MIPMAP_LINEAR            0x2702
+#define GL_LINEAR_MIPMAP_LINEAR             0x2703
+#define GL_TEXTURE_MAG_FILTER               0x2800
+#define GL_TEXTURE_MIN_FILTER               0x2801
+
+#define GL_VERTEX_ARRAY                     0x8074
+#define GL_COLOR_ARRAY                      0x8076
+#define GL_TEXTURE_COORD_ARRAY              0x8078
+
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT     0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT    0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT    0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT    0x83F3
+#define GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG  0x8C00
+#define GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG  0x8C01
+#define GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG 0x8C02
+#define GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG 0x8C03
+#define GL_ETC1_RGB8_OES                    0x8D64
+
+#define GL_COLOR_ATTACHMENT0                0x8CE0
+#define GL_FRAMEBUFFER                      0x8D40
+
+void glEnable(GLenum cap);
+void glDisable(GLenum cap);
+void glEnableClientState(GLenum array);
+void glDisableClientState(GLenum array);
+void glBlendFunc(GLenum sfactor, GLenum dfactor);
+void glBlendEquation(GLenum mode);
+void glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+void glUseProgram(GLuint program);
+
+void glMatrixMode(GLenum mode);
+void glLoadIdentity(void);
+void glOrthof(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat nearVal, GLfloat farVal);
+
+void glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+void glClear(GLbitfield mask);
+void glColor4ubv(const GLubyte *v);
+void glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
+void glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
+void glDrawArrays(GLenum mode, GLint first, GLsizei count);
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices);
+void glFinish(void);
+
+void glGenTextures(GLsizei n, GLuint *textures);
+void glBindTexture(GLenum target, GLuint texture);
+void glDeleteTextures(GLsizei n, const GLuint *textures);
+void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+		  GLint border, GLenum format, GLenum type, const GLvoid *data);
+void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+		     GLenum format, GLenum type, const GLvoid *pixels);
+void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height,
+			    GLint border, GLsizei imageSize, const GLvoid *data);
+void glTexParameteri(GLenum target, GLenum pname, GLint param);
+void glPixelStorei(GLenum pname, GLint param);
+void glGenerateMipmap(GLenum target);
+
+void glGenFramebuffers(GLsizei n, GLuint *ids);
+void glBindFramebuffer(GLenum target, GLuint fb);
+void glDeleteFramebuffers(GLsizei n, const GLuint *framebuffers);
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+
+void *vglMalloc(size_t size);
+void *vglMemalign(size_t alignment, size_t size);
+void vglFree(void *addr);
+void *vglGetTexDataPointer(GLenum target);
+SceGxmTexture *vglGetGxmTexture(GLenum target);
+void vglSwapBuffers(GLboolean has_commondialog);
+void vglWaitVblankStart(GLboolean enable);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
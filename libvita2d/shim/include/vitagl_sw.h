@@ -0,0 +1,42 @@
+#ifndef VITAGL_SW_H
+#define VITAGL_SW_H
+
+#include <stddef.h>
+#include "vita2d_sw.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Host backend for vita2d: the vitaGL, GXM and SDK calls vita2d makes, with the
+ * draws submitted to the vita2d_sw rasterizer. Building vita2d's own sources with
+ * shim/include first on the include path (Makefile.host does) runs the code we
+ * ship headless, on any OS with pthreads and FreeType.
+ *
+ * Vertices are taken as pixels, which is what vita2d's 960x544 orthographic
+ * projection gives. Compressed, swizzled and tiled textures can't be sampled,
+ * draws using them are counted but not rasterized.
+ */
+
+// The 960x544 display, what framebuffer 0 renders to
+vita2d_sw_target *vitagl_sw_get_screen(void);
+
+// 0 only records the draws, the null backend for timing vita2d's CPU side. 1 by default.
+void vitagl_sw_set_rasterize(int enable);
+
+// Draws and vertices submitted since the last reset, rasterized or not
+void vitagl_sw_get_draw_stats(unsigned int *draw_calls, unsigned int *vertices);
+void vitagl_sw_reset_draw_stats(void);
+
+// Font file (any format FreeType reads) sceFont and scePvf open as the system font, data must outlive them
+void vitagl_sw_set_system_font(const void *data, size_t size);
+
+// The generated TrueType font used when no system font is set, one 5x7 block pattern per printable ASCII char
+const void *vitagl_sw_get_builtin_font(size_t *size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef _VITASDK_H_
+#define _VITASDK_H_
+
+/*
+ * Host stand-in for the Vita SDK: the parts vita2d uses, implemented on libc,
+ * pthreads and FreeType. See vitagl_sw.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <psp2/types.h>
+#include <psp2/gxm.h>
+#include <psp2/kernel/clib.h>
+#include <psp2/kernel/processmgr.h>
+#include <psp2/kernel/sysmem.h>
+#include <psp2/kernel/threadmgr.h>
+#include <psp2/sysmodule.h>
+#include <psp2/pgf.h>
+#include <psp2/pvf.h>
+
+#endif
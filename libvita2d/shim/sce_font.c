@@ -0,0 +1,393 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <psp2/pgf.h>
+#include <psp2/pvf.h>
+#include "vitagl_sw.h"
+
+/*
+ * sceFont and scePvf both open FreeType faces. Glyphs are rendered unhinted, so
+ * they don't depend on the FreeType build's hinters.
+ */
+
+#define LOAD_FLAGS (FT_LOAD_RENDER | FT_LOAD_NO_HINTING)
+
+/* What the system fonts are drawn at: 10.125 points at 128 dpi, 18 pixels */
+#define DEFAULT_POINTS     10.125f
+#define DEFAULT_RESOLUTION 128.0f
+
+typedef struct sce_font_lib {
+	FT_Library library;
+	float h_res;
+	float v_res;
+} sce_font_lib;
+
+typedef struct sce_font {
+	FT_Face face;
+	float h_size; /* points */
+	float v_size;
+	float h_res;  /* dpi */
+	float v_res;
+} sce_font;
+
+static const void *system_font;
+static size_t system_font_size;
+
+void vitagl_sw_set_system_font(const void *data, size_t size)
+{
+	system_font = data;
+	system_font_size = size;
+}
+
+/* Falls back to the generated font when the test or tool didn't set one */
+static int have_system_font(void)
+{
+	if (!system_font)
+		system_font = vitagl_sw_get_builtin_font(&system_font_size);
+	return system_font != NULL;
+}
+
+static sce_font_lib *lib_new(void)
+{
+	sce_font_lib *lib = calloc(1, sizeof(*lib));
+	if (!lib)
+		return NULL;
+	if (FT_Init_FreeType(&lib->library) != 0) {
+		free(lib);
+		return NULL;
+	}
+	lib->h_res = DEFAULT_RESOLUTION;
+	lib->v_res = DEFAULT_RESOLUTION;
+	return lib;
+}
+
+static int lib_done(sce_font_lib *lib)
+{
+	if (!lib)
+		return -1;
+	FT_Done_FreeType(lib->library);
+	free(lib);
+	return 0;
+}
+
+static int set_size(sce_font *font)
+{
+	return FT_Set_Char_Size(font->face, font->h_size * 64, font->v_size * 64,
+				font->h_res, font->v_res) == 0 ? 0 : -1;
+}
+
+/* The system font when path is NULL */
+static sce_font *font_open(sce_font_lib *lib, const char *path)
+{
+	sce_font *font;
+	FT_Error error;
+
+	if (!lib || (!path && !have_system_font()))
+		return NULL;
+
+	font = calloc(1, sizeof(*font));
+	if (!font)
+		return NULL;
+
+	if (path)
+		error = FT_New_Face(lib->library, path, 0, &font->face);
+	else
+		error = FT_New_Memory_Face(lib->library, system_font, system_font_size, 0, &font->face);
+	if (error != 0) {
+		free(font);
+		return NULL;
+	}
+
+	font->h_size = DEFAULT_POINTS;
+	font->v_size = DEFAULT_POINTS;
+	font->h_res = lib->h_res;
+	font->v_res = lib->v_res;
+	if (set_size(font) < 0) {
+		FT_Done_Face(font->face);
+		free(font);
+		return NULL;
+	}
+	return font;
+}
+
+static int font_close(sce_font *font)
+{
+	if (!font)
+		return -1;
+	FT_Done_Face(font->face);
+	free(font);
+	return 0;
+}
+
+/* Renders the glyph into the face's slot, characters the font lacks fail */
+static FT_GlyphSlot render_glyph(sce_font *font, unsigned int character)
+{
+	FT_UInt index;
+
+	if (!font)
+		return NULL;
+	index = FT_Get_Char_Index(font->face, character);
+	if (index == 0 || FT_Load_Glyph(font->face, index, LOAD_FLAGS) != 0 ||
+	    font->face->glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
+		return NULL;
+	return font->face->glyph;
+}
+
+/* Copies the rendered glyph with its top left corner at x, y, clipped to the buffer */
+static void blit_glyph(const FT_Bitmap *bitmap, int x, int y, uint8_t *buffer,
+		       unsigned int buf_w, unsigned int buf_h, unsigned int bytes_per_line)
+{
+	unsigned int row, col;
+
+	for (row = 0; row < bitmap->rows; row++) {
+		int dy = y + (int)row;
+		if (dy < 0 || dy >= (int)buf_h)
+			continue;
+		for (col = 0; col < bitmap->width; col++) {
+			int dx = x + (int)col;
+			if (dx < 0 || dx >= (int)buf_w)
+				continue;
+			buffer[dy * bytes_per_line + dx] = bitmap->buffer[row * bitmap->pitch + col];
+		}
+	}
+}
+
+/* sceFont */
+
+SceFontLibHandle sceFontNewLib(SceFontNewLibParams *params, unsigned int *errorCode)
+{
+	sce_font_lib *lib = lib_new();
+	*errorCode = lib ? 0 : 1;
+	return lib;
+}
+
+int sceFontDoneLib(SceFontLibHandle libHandle)
+{
+	return lib_done(libHandle);
+}
+
+int sceFontFindOptimumFont(SceFontLibHandle libHandle, SceFontStyle *fontStyle, unsigned int *errorCode)
+{
+	/* One system font serves every style and language */
+	int found = have_system_font();
+	*errorCode = found ? 0 : 1;
+	return found ? 0 : -1;
+}
+
+SceFontHandle sceFontOpen(SceFontLibHandle libHandle, int index, int mode, unsigned int *errorCode)
+{
+	sce_font *font = index == 0 ? font_open(libHandle, NULL) : NULL;
+	*errorCode = font ? 0 : 1;
+	return font;
+}
+
+SceFontHandle sceFontOpenUserFile(SceFontLibHandle libHandle, char *file, int mode, unsigned int *errorCode)
+{
+	sce_font *font = file ? font_open(libHandle, file) : NULL;
+	*errorCode = font ? 0 : 1;
+	return font;
+}
+
+int sceFontClose(SceFontHandle fontHandle)
+{
+	return font_close(fontHandle);
+}
+
+int sceFontGetFontInfo(SceFontHandle fontHandle, SceFontInfo *fontInfo)
+{
+	sce_font *font = fontHandle;
+
+	if (!font)
+		return -1;
+	memset(fontInfo, 0, sizeof(*fontInfo));
+	fontInfo->maxGlyphWidthI = font->face->size->metrics.max_advance >> 6;
+	fontInfo->maxGlyphHeightI = font->face->size->metrics.height >> 6;
+	fontInfo->maxGlyphAscenderI = font->face->size->metrics.ascender >> 6;
+	fontInfo->maxGlyphDescenderI = font->face->size->metrics.descender >> 6;
+	fontInfo->fontStyle.fontH = font->h_size;
+	fontInfo->fontStyle.fontV = font->v_size;
+	fontInfo->fontStyle.fontHRes = font->h_res;
+	fontInfo->fontStyle.fontVRes = font->v_res;
+	return 0;
+}
+
+int sceFontGetCharInfo(SceFontHandle fontHandle, unsigned int charCode, SceFontCharInfo *charInfo)
+{
+	sce_font *font = fontHandle;
+	FT_GlyphSlot slot = render_glyph(font, charCode);
+
+	if (!slot)
+		return -1;
+	memset(charInfo, 0, sizeof(*charInfo));
+	charInfo->bitmapWidth = slot->bitmap.width;
+	charInfo->bitmapHeight = slot->bitmap.rows;
+	charInfo->bitmapLeft = slot->bitmap_left;
+	charInfo->bitmapTop = slot->bitmap_top;
+	charInfo->sfp26Ascender = font->face->size->metrics.ascender;
+	charInfo->sfp26Descender = font->face->size->metrics.descender;
+	charInfo->sfp26BearingHX = slot->metrics.horiBearingX;
+	charInfo->sfp26BearingHY = slot->metrics.horiBearingY;
+	charInfo->sfp26AdvanceH = slot->advance.x;
+	charInfo->sfp26AdvanceV = font->face->size->metrics.height;
+	return 0;
+}
+
+int sceFontGetCharGlyphImage(SceFontHandle fontHandle, unsigned int charCode, SceFontGlyphImage *glyphImage)
+{
+	FT_GlyphSlot slot;
+
+	if (glyphImage->pixelFormat != SCE_FONT_PIXELFORMAT_8 || !glyphImage->bufferPtr)
+		return -1;
+	slot = render_glyph(fontHandle, charCode);
+	if (!slot)
+		return -1;
+
+	blit_glyph(&slot->bitmap, glyphImage->xPos64 >> 6, glyphImage->yPos64 >> 6, (uint8_t *)glyphImage->bufferPtr,
+		   glyphImage->bufWidth, glyphImage->bufHeight, glyphImage->bytesPerLine);
+	return 0;
+}
+
+/* scePvf */
+
+ScePvfLibId scePvfNewLib(ScePvfInitRec *initParam, ScePvfError *errorCode)
+{
+	sce_font_lib *lib = lib_new();
+	*errorCode = lib ? 0 : 1;
+	return lib;
+}
+
+ScePvfError scePvfDoneLib(ScePvfLibId libID)
+{
+	return lib_done(libID);
+}
+
+ScePvfError scePvfSetEM(ScePvfLibId libID, ScePvfFloat32 emValue)
+{
+	/* Metrics are always 26.6 pixels */
+	return libID ? 0 : -1;
+}
+
+ScePvfError scePvfSetResolution(ScePvfLibId libID, ScePvfFloat32 hResolution, ScePvfFloat32 vResolution)
+{
+	sce_font_lib *lib = libID;
+
+	if (!lib || hResolution <= 0.0f || vResolution <= 0.0f)
+		return -1;
+	lib->h_res = hResolution;
+	lib->v_res = vResolution;
+	return 0;
+}
+
+ScePvfFontIndex scePvfFindOptimumFont(ScePvfLibId libID, ScePvfFontStyleInfo *fontStyleInfo, ScePvfError *errorCode)
+{
+	int found = have_system_font();
+	*errorCode = found ? 0 : 1;
+	return found ? 0 : -1;
+}
+
+ScePvfFontId scePvfOpen(ScePvfLibId libID, ScePvfFontIndex fontIndex, ScePvfU32 mode, ScePvfError *errorCode)
+{
+	sce_font *font = fontIndex == 0 ? font_open(libID, NULL) : NULL;
+	*errorCode = font ? 0 : 1;
+	return font;
+}
+
+ScePvfFontId scePvfOpenUserFile(ScePvfLibId libID, ScePvfPointer filename, ScePvfU32 mode, ScePvfError *errorCode)
+{
+	sce_font *font = filename ? font_open(libID, filename) : NULL;
+	*errorCode = font ? 0 : 1;
+	return font;
+}
+
+ScePvfError scePvfClose(ScePvfFontId fontID)
+{
+	return font_close(fontID);
+}
+
+ScePvfError scePvfSetCharSize(ScePvfFontId fontID, ScePvfFloat32 hSize, ScePvfFloat32 vSize)
+{
+	sce_font *font = fontID;
+
+	if (!font || hSize <= 0.0f || vSize <= 0.0f)
+		return -1;
+	font->h_size = hSize;
+	font->v_size = vSize;
+	return set_size(font);
+}
+
+ScePvfError scePvfGetFontInfo(ScePvfFontId fontID, ScePvfFontInfo *fontInfo)
+{
+	if (!fontID)
+		return -1;
+	memset(fontInfo, 0, sizeof(*fontInfo));
+	return 0;
+}
+
+ScePvfError scePvfGetCharInfo(ScePvfFontId fontID, ScePvfU32 character, ScePvfCharInfo *charInfo)
+{
+	sce_font *font = fontID;
+	FT_GlyphSlot slot = render_glyph(font, character);
+
+	if (!slot)
+		return -1;
+	memset(charInfo, 0, sizeof(*charInfo));
+	charInfo->bitmapWidth = slot->bitmap.width;
+	charInfo->bitmapHeight = slot->bitmap.rows;
+	charInfo->bitmapLeft = slot->bitmap_left;
+	charInfo->bitmapTop = slot->bitmap_top;
+	/* Bearings of the rendered bitmap, so that they place it exactly */
+	charInfo->glyphMetrics.width64 = slot->bitmap.width << 6;
+	charInfo->glyphMetrics.height64 = slot->bitmap.rows << 6;
+	charInfo->glyphMetrics.ascender64 = font->face->size->metrics.ascender;
+	charInfo->glyphMetrics.descender64 = font->face->size->metrics.descender;
+	charInfo->glyphMetrics.horizontalBearingX64 = slot->bitmap_left * 64;
+	charInfo->glyphMetrics.horizontalBearingY64 = slot->bitmap_top * 64;
+	charInfo->glyphMetrics.horizontalAdvance64 = slot->advance.x;
+	charInfo->glyphMetrics.verticalAdvance64 = font->face->size->metrics.height;
+	return 0;
+}
+
+ScePvfError scePvfGetCharImageRect(ScePvfFontId fontID, ScePvfU32 character, ScePvfIrect *rect)
+{
+	FT_GlyphSlot slot = render_glyph(fontID, character);
+
+	if (!slot)
+		return -1;
+	rect->width = slot->bitmap.width;
+	rect->height = slot->bitmap.rows;
+	return 0;
+}
+
+ScePvfError scePvfGetCharGlyphImage(ScePvfFontId fontID, ScePvfU32 character, ScePvfUserImageBufferRec *imageBuffer)
+{
+	FT_GlyphSlot slot;
+
+	if (imageBuffer->pixelFormat != SCE_PVF_USERIMAGE_DIRECT8 || !imageBuffer->buffer)
+		return -1;
+	slot = render_glyph(fontID, character);
+	if (!slot)
+		return -1;
+
+	/* The position is the pen on the baseline */
+	blit_glyph(&slot->bitmap, (imageBuffer->xPos64 >> 6) + slot->bitmap_left,
+		   (imageBuffer->yPos64 >> 6) - slot->bitmap_top, imageBuffer->buffer,
+		   imageBuffer->rect.width, imageBuffer->rect.height, imageBuffer->bytesPerLine);
+	return 0;
+}
+
+ScePvfError scePvfGetKerningInfo(ScePvfFontId fontID, ScePvfU32 leftCharacter, ScePvfU32 rightCharacter,
+				 ScePvfKerningInfo *kerningInfo)
+{
+	sce_font *font = fontID;
+	FT_Vector delta;
+
+	if (!font)
+		return -1;
+	memset(kerningInfo, 0, sizeof(*kerningInfo));
+	if (FT_HAS_KERNING(font->face) &&
+	    FT_Get_Kerning(font->face, FT_Get_Char_Index(font->face, leftCharacter),
+			   FT_Get_Char_Index(font->face, rightCharacter), FT_KERNING_DEFAULT, &delta) == 0)
+		kerningInfo->fKerningInfo.xOffset = delta.x / 64.0f;
+	return 0;
+}
@@ -0,0 +1,247 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <psp2/kernel/processmgr.h>
+#include <psp2/kernel/threadmgr.h>
+#include <psp2/sysmodule.h>
+
+#define MAX_THREADS 64
+#define MAX_SEMAS 64
+
+typedef struct sce_thread {
+	int used;
+	int started;
+	pthread_t thread;
+	SceKernelThreadEntry entry;
+	SceSize arglen;
+	void *argp; /* StartThread copies the arguments, like the kernel does */
+} sce_thread;
+
+typedef struct sce_sema {
+	int used;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int count;
+	int max;
+} sce_sema;
+
+/* UIDs are the index + 1, the tables are guarded by table_mutex */
+static pthread_mutex_t table_mutex = PTHREAD_MUTEX_INITIALIZER;
+static sce_thread threads[MAX_THREADS];
+static sce_sema semas[MAX_SEMAS];
+
+static sce_thread *get_thread(SceUID thid)
+{
+	return thid > 0 && thid <= MAX_THREADS && threads[thid - 1].used ? &threads[thid - 1] : NULL;
+}
+
+static sce_sema *get_sema(SceUID semaid)
+{
+	return semaid > 0 && semaid <= MAX_SEMAS && semas[semaid - 1].used ? &semas[semaid - 1] : NULL;
+}
+
+SceUInt64 sceKernelGetProcessTimeWide(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (SceUInt64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int sceSysmoduleLoadModule(unsigned short id)
+{
+	return 0;
+}
+
+SceUID sceKernelCreateThread(const char *name, SceKernelThreadEntry entry, int initPriority,
+			     int stackSize, SceUInt32 attr, int cpuAffinityMask, const void *option)
+{
+	SceUID thid = -1;
+	int i;
+
+	pthread_mutex_lock(&table_mutex);
+	for (i = 0; i < MAX_THREADS; i++) {
+		if (!threads[i].used) {
+			memset(&threads[i], 0, sizeof(threads[i]));
+			threads[i].used = 1;
+			threads[i].entry = entry;
+			thid = i + 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&table_mutex);
+	return thid;
+}
+
+static void *thread_main(void *arg)
+{
+	sce_thread *t = arg;
+	return (void *)(intptr_t)t->entry(t->arglen, t->argp);
+}
+
+int sceKernelStartThread(SceUID thid, SceSize arglen, void *argp)
+{
+	sce_thread *t = get_thread(thid);
+
+	if (!t || t->started)
+		return -1;
+
+	if (arglen && argp) {
+		t->argp = malloc(arglen);
+		if (!t->argp)
+			return -1;
+		memcpy(t->argp, argp, arglen);
+		t->arglen = arglen;
+	}
+
+	if (pthread_create(&t->thread, NULL, thread_main, t) != 0) {
+		free(t->argp);
+		t->argp = NULL;
+		return -1;
+	}
+	t->started = 1;
+	return 0;
+}
+
+int sceKernelExitDeleteThread(int status)
+{
+	/* The slot is released by sceKernelWaitThreadEnd, which has to join anyway */
+	pthread_exit((void *)(intptr_t)status);
+	return 0;
+}
+
+int sceKernelWaitThreadEnd(SceUID thid, int *stat, SceUInt32 *timeout)
+{
+	sce_thread *t = get_thread(thid);
+	void *ret;
+
+	if (!t || !t->started || pthread_join(t->thread, &ret) != 0)
+		return -1;
+	if (stat)
+		*stat = (int)(intptr_t)ret;
+
+	pthread_mutex_lock(&table_mutex);
+	free(t->argp);
+	t->used = 0;
+	pthread_mutex_unlock(&table_mutex);
+	return 0;
+}
+
+int sceKernelDelayThread(SceUInt32 delay)
+{
+	struct timespec ts = {delay / 1000000, (delay % 1000000) * 1000};
+	return nanosleep(&ts, NULL);
+}
+
+SceUID sceKernelCreateSema(const char *name, SceUInt32 attr, int initVal, int maxVal, void *option)
+{
+	SceUID semaid = -1;
+	int i;
+
+	if (initVal < 0 || maxVal < initVal)
+		return -1;
+
+	pthread_mutex_lock(&table_mutex);
+	for (i = 0; i < MAX_SEMAS; i++) {
+		if (!semas[i].used) {
+			pthread_mutex_init(&semas[i].mutex, NULL);
+			pthread_cond_init(&semas[i].cond, NULL);
+			semas[i].count = initVal;
+			semas[i].max = maxVal;
+			semas[i].used = 1;
+			semaid = i + 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&table_mutex);
+	return semaid;
+}
+
+int sceKernelDeleteSema(SceUID semaid)
+{
+	sce_sema *s = get_sema(semaid);
+
+	if (!s)
+		return -1;
+
+	pthread_mutex_lock(&table_mutex);
+	pthread_cond_destroy(&s->cond);
+	pthread_mutex_destroy(&s->mutex);
+	s->used = 0;
+	pthread_mutex_unlock(&table_mutex);
+	return 0;
+}
+
+int sceKernelSignalSema(SceUID semaid, int signal)
+{
+	sce_sema *s = get_sema(semaid);
+
+	if (!s || signal < 0)
+		return -1;
+
+	pthread_mutex_lock(&s->mutex);
+	if (s->count > s->max - signal) {
+		pthread_mutex_unlock(&s->mutex);
+		return -1;
+	}
+	s->count += signal;
+	pthread_cond_broadcast(&s->cond);
+	pthread_mutex_unlock(&s->mutex);
+	return 0;
+}
+
+int sceKernelWaitSema(SceUID semaid, int signal, SceUInt32 *timeout)
+{
+	sce_sema *s = get_sema(semaid);
+
+	/* vita2d never waits with a timeout */
+	if (!s || signal <= 0 || signal > s->max)
+		return -1;
+
+	pthread_mutex_lock(&s->mutex);
+	while (s->count < signal)
+		pthread_cond_wait(&s->cond, &s->mutex);
+	s->count -= signal;
+	pthread_mutex_unlock(&s->mutex);
+	return 0;
+}
+
+int sceKernelCreateLwMutex(SceKernelLwMutexWork *pWork, const char *pName, unsigned int attr,
+			   int initCount, const void *pOptParam)
+{
+	pthread_mutexattr_t mattr;
+	int i;
+
+	pthread_mutexattr_init(&mattr);
+	pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE);
+	int ret = pthread_mutex_init(&pWork->mutex, &mattr);
+	pthread_mutexattr_destroy(&mattr);
+	if (ret != 0)
+		return -1;
+
+	for (i = 0; i < initCount; i++)
+		pthread_mutex_lock(&pWork->mutex);
+	return 0;
+}
+
+int sceKernelDeleteLwMutex(SceKernelLwMutexWork *pWork)
+{
+	return pthread_mutex_destroy(&pWork->mutex) == 0 ? 0 : -1;
+}
+
+int sceKernelLockLwMutex(SceKernelLwMutexWork *pWork, int lockCount, unsigned int *pTimeout)
+{
+	int i;
+	for (i = 0; i < lockCount; i++)
+		pthread_mutex_lock(&pWork->mutex);
+	return 0;
+}
+
+int sceKernelUnlockLwMutex(SceKernelLwMutexWork *pWork, int unlockCount)
+{
+	int i;
+	for (i = 0; i < unlockCount; i++)
+		pthread_mutex_unlock(&pWork->mutex);
+	return 0;
+}
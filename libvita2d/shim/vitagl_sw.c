@@ -0,0 +1,806 @@
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <math.h>
+#include <vitaGL.h>
+#include "vitagl_sw.h"
+#include "pixel_convert.h"
+#include "utils.h"
+
+#define SCREEN_W 960
+#define SCREEN_H 544
+#define MAX_LEVELS 13 /* 4096x4096 down to 1x1 */
+
+typedef struct sw_level {
+	uint8_t *data;
+	unsigned int w;
+	unsigned int h;
+} sw_level;
+
+typedef struct sw_texture {
+	SceGxmTexture gxm; /* what gets sampled, level 0 unless re-described through GXM */
+	sw_level levels[MAX_LEVELS];
+	unsigned int num_levels;
+	unsigned int bpp; /* of the storage glTexImage2D allocated */
+	GLint min_filter;
+	GLint mag_filter;
+} sw_texture;
+
+typedef struct sw_framebuffer {
+	GLuint texture;
+	vita2d_sw_target target; /* over the texture memory, set up before each draw */
+} sw_framebuffer;
+
+/* Indexed by GL name, 0 is never used */
+static sw_texture **textures;
+static GLuint num_textures;
+static sw_framebuffer **framebuffers;
+static GLuint num_framebuffers;
+
+static vita2d_sw_target *screen;
+
+static struct {
+	GLuint texture;
+	GLuint framebuffer;
+	int texture_2d;
+	int blend;
+	int additive;
+	int scissor_test;
+	GLint scissor[4];
+	GLfloat ortho_h; /* glScissor's y counts up from the projection's bottom edge */
+	int vertex_array;
+	int texcoord_array;
+	const GLfloat *vertices;
+	const GLfloat *tcoords;
+	uint32_t color;
+	uint32_t clear_color;
+	GLint unpack_alignment;
+	int rasterize;
+	unsigned int draw_calls;
+	unsigned int num_vertices;
+} gl = {
+	.scissor = {0, 0, SCREEN_W, SCREEN_H},
+	.ortho_h = SCREEN_H,
+	.color = 0xFFFFFFFF,
+	.unpack_alignment = 4,
+	.rasterize = 1,
+};
+
+/* Slot for a new name in a table indexed by name, grown as needed */
+static GLuint alloc_name(void ***table, GLuint *size, void *entry)
+{
+	GLuint i;
+
+	for (i = 1; i < *size; i++) {
+		if (!(*table)[i]) {
+			(*table)[i] = entry;
+			return i;
+		}
+	}
+
+	GLuint new_size = *size ? *size * 2 : 64;
+	void **grown = realloc(*table, new_size * sizeof(*grown));
+	if (!grown)
+		return 0;
+	memset(grown + *size, 0, (new_size - *size) * sizeof(*grown));
+	*table = grown;
+	i = *size ? *size : 1;
+	*size = new_size;
+	(*table)[i] = entry;
+	return i;
+}
+
+static sw_texture *get_texture(GLuint name)
+{
+	return name < num_textures ? textures[name] : NULL;
+}
+
+static sw_texture *bound_texture(void)
+{
+	return get_texture(gl.texture);
+}
+
+static void free_levels(sw_texture *tex)
+{
+	unsigned int i;
+	for (i = 0; i < MAX_LEVELS; i++) {
+		free(tex->levels[i].data);
+		tex->levels[i].data = NULL;
+	}
+	tex->num_levels = 0;
+}
+
+vita2d_sw_target *vitagl_sw_get_screen(void)
+{
+	if (!screen)
+		screen = vita2d_sw_create_target(SCREEN_W, SCREEN_H);
+	return screen;
+}
+
+void vitagl_sw_set_rasterize(int enable)
+{
+	gl.rasterize = enable;
+}
+
+void vitagl_sw_get_draw_stats(unsigned int *draw_calls, unsigned int *vertices)
+{
+	*draw_calls = gl.draw_calls;
+	*vertices = gl.num_vertices;
+}
+
+void vitagl_sw_reset_draw_stats(void)
+{
+	gl.draw_calls = 0;
+	gl.num_vertices = 0;
+}
+
+/* State */
+
+static void set_cap(GLenum cap, int enable)
+{
+	switch (cap) {
+	case GL_TEXTURE_2D:
+		gl.texture_2d = enable;
+		break;
+	case GL_BLEND:
+		gl.blend = enable;
+		break;
+	case GL_SCISSOR_TEST:
+		gl.scissor_test = enable;
+		break;
+	default:
+		/* Depth, stencil, alpha test, lighting and fog stay off in vita2d */
+		break;
+	}
+}
+
+void glEnable(GLenum cap)
+{
+	set_cap(cap, 1);
+}
+
+void glDisable(GLenum cap)
+{
+	set_cap(cap, 0);
+}
+
+static void set_client_state(GLenum array, int enable)
+{
+	if (array == GL_VERTEX_ARRAY)
+		gl.vertex_array = enable;
+	else if (array == GL_TEXTURE_COORD_ARRAY)
+		gl.texcoord_array = enable;
+}
+
+void glEnableClientState(GLenum array)
+{
+	set_client_state(array, 1);
+}
+
+void glDisableClientState(GLenum array)
+{
+	set_client_state(array, 0);
+}
+
+void glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+	/* vita2d only uses additive and source-over blending */
+	gl.additive = sfactor == GL_ONE && dfactor == GL_ONE;
+}
+
+void glBlendEquation(GLenum mode)
+{
+}
+
+void glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+}
+
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	gl.scissor[0] = x;
+	gl.scissor[1] = y;
+	gl.scissor[2] = width;
+	gl.scissor[3] = height;
+}
+
+void glUseProgram(GLuint program)
+{
+}
+
+void glMatrixMode(GLenum mode)
+{
+}
+
+void glLoadIdentity(void)
+{
+}
+
+void glOrthof(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat nearVal, GLfloat farVal)
+{
+	gl.ortho_h = fabsf(bottom - top);
+}
+
+void glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+	gl.clear_color = RGBA8(lrintf(red * 255.0f), lrintf(green * 255.0f),
+			       lrintf(blue * 255.0f), lrintf(alpha * 255.0f));
+}
+
+void glColor4ubv(const GLubyte *v)
+{
+	gl.color = RGBA8(v[0], v[1], v[2], v[3]);
+}
+
+void glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer)
+{
+	/* vita2d_sw reads packed x/y floats, which is all vita2d submits */
+	gl.vertices = size == 2 && type == GL_FLOAT && (stride == 0 || stride == 2 * sizeof(GLfloat)) ? pointer : NULL;
+}
+
+void glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer)
+{
+	gl.tcoords = size == 2 && type == GL_FLOAT && (stride == 0 || stride == 2 * sizeof(GLfloat)) ? pointer : NULL;
+}
+
+void glPixelStorei(GLenum pname, GLint param)
+{
+	if (pname == GL_UNPACK_ALIGNMENT && (param == 1 || param == 2 || param == 4 || param == 8))
+		gl.unpack_alignment = param;
+}
+
+void glFinish(void)
+{
+}
+
+void vglSwapBuffers(GLboolean has_commondialog)
+{
+}
+
+void vglWaitVblankStart(GLboolean enable)
+{
+}
+
+/* Memory */
+
+void *vglMalloc(size_t size)
+{
+	return malloc(size);
+}
+
+void *vglMemalign(size_t alignment, size_t size)
+{
+	return memalign(alignment, size);
+}
+
+void vglFree(void *addr)
+{
+	free(addr);
+}
+
+/* Textures */
+
+void glGenTextures(GLsizei n, GLuint *names)
+{
+	GLsizei i;
+	for (i = 0; i < n; i++) {
+		sw_texture *tex = calloc(1, sizeof(*tex));
+		names[i] = tex ? alloc_name((void ***)&textures, &num_textures, tex) : 0;
+		if (!names[i]) {
+			free(tex);
+			continue;
+		}
+		tex->min_filter = GL_NEAREST_MIPMAP_LINEAR;
+		tex->mag_filter = GL_LINEAR;
+	}
+}
+
+void glBindTexture(GLenum target, GLuint texture)
+{
+	gl.texture = texture;
+}
+
+void glDeleteTextures(GLsizei n, const GLuint *names)
+{
+	GLsizei i;
+	for (i = 0; i < n; i++) {
+		sw_texture *tex = get_texture(names[i]);
+		if (!tex)
+			continue;
+		free_levels(tex);
+		free(tex);
+		textures[names[i]] = NULL;
+		if (gl.texture == names[i])
+			gl.texture = 0;
+	}
+}
+
+/* The GXM format vitaGL stores a format/type pair as, the inverse of vita2d's mapping */
+static int gxm_format_from_gl(GLenum format, GLenum type, SceGxmTextureFormat *gxm_format, unsigned int *bpp)
+{
+	switch (format) {
+	case GL_RGB:
+		if (type != GL_UNSIGNED_SHORT_5_6_5)
+			return 0;
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_U5U6U5_RGB;
+		*bpp = 2;
+		return 1;
+	case GL_BGR:
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_U8U8U8_RGB;
+		*bpp = 3;
+		return 1;
+	case GL_BGRA:
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ARGB;
+		*bpp = 4;
+		return 1;
+	case GL_ABGR_EXT:
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_RGBA;
+		*bpp = 4;
+		return 1;
+	case GL_RGBA:
+		if (type == GL_UNSIGNED_SHORT_4_4_4_4) {
+			*gxm_format = SCE_GXM_TEXTURE_FORMAT_U4U4U4U4_RGBA;
+			*bpp = 2;
+		} else if (type == GL_UNSIGNED_SHORT_5_5_5_1) {
+			*gxm_format = SCE_GXM_TEXTURE_FORMAT_U5U5U5U1_RGBA;
+			*bpp = 2;
+		} else {
+			*gxm_format = SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR;
+			*bpp = 4;
+		}
+		return 1;
+	case GL_RED:
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_U8_R;
+		*bpp = 1;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* Copies client rows, which follow GL_UNPACK_ALIGNMENT, to texture rows */
+static void unpack_rows(uint8_t *dst, unsigned int dst_stride, const uint8_t *src,
+			unsigned int row_bytes, unsigned int h)
+{
+	unsigned int src_stride = ALIGN(row_bytes, (unsigned int)gl.unpack_alignment);
+	unsigned int y;
+	for (y = 0; y < h; y++)
+		memcpy(dst + y * dst_stride, src + y * src_stride, row_bytes);
+}
+
+void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+		  GLint border, GLenum format, GLenum type, const GLvoid *data)
+{
+	sw_texture *tex = bound_texture();
+	SceGxmTextureFormat gxm_format;
+	unsigned int bpp;
+
+	if (!tex || level < 0 || level >= MAX_LEVELS || width <= 0 || height <= 0 ||
+	    !gxm_format_from_gl(format, type, &gxm_format, &bpp))
+		return;
+
+	/* Rows are 8 texel aligned, vita2d_texture_get_stride relies on it */
+	unsigned int stride = ALIGN((unsigned int)width, 8) * bpp;
+	uint8_t *storage = calloc(height, stride);
+	if (!storage)
+		return;
+	if (data)
+		unpack_rows(storage, stride, data, width * bpp, height);
+
+	if (level == 0) {
+		free_levels(tex);
+		tex->bpp = bpp;
+		sceGxmTextureInitLinear(&tex->gxm, storage, gxm_format, width, height, 0);
+	} else {
+		free(tex->levels[level].data);
+	}
+	tex->levels[level].data = storage;
+	tex->levels[level].w = width;
+	tex->levels[level].h = height;
+	if ((unsigned int)level >= tex->num_levels)
+		tex->num_levels = level + 1;
+}
+
+void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+		     GLenum format, GLenum type, const GLvoid *pixels)
+{
+	sw_texture *tex = bound_texture();
+	SceGxmTextureFormat gxm_format;
+	unsigned int bpp;
+
+	if (!tex || level < 0 || (unsigned int)level >= tex->num_levels || !tex->levels[level].data ||
+	    !gxm_format_from_gl(format, type, &gxm_format, &bpp) || bpp != tex->bpp ||
+	    xoffset < 0 || yoffset < 0 || width <= 0 || height <= 0 ||
+	    (unsigned int)(xoffset + width) > tex->levels[level].w ||
+	    (unsigned int)(yoffset + height) > tex->levels[level].h)
+		return;
+
+	unsigned int stride = ALIGN(tex->levels[level].w, 8) * bpp;
+	unpack_rows(tex->levels[level].data + yoffset * stride + xoffset * bpp, stride, pixels, width * bpp, height);
+}
+
+void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height,
+			    GLint border, GLsizei imageSize, const GLvoid *data)
+{
+	sw_texture *tex = bound_texture();
+
+	if (!tex || level < 0 || level >= MAX_LEVELS || imageSize <= 0)
+		return;
+
+	/* Kept for vglGetTexDataPointer, never sampled */
+	uint8_t *storage = malloc(imageSize);
+	if (!storage)
+		return;
+	memcpy(storage, data, imageSize);
+
+	if (level == 0) {
+		free_levels(tex);
+		tex->bpp = 0;
+		sceGxmTextureInitSwizzled(&tex->gxm, storage, SCE_GXM_TEXTURE_FORMAT_UBC1_ABGR, width, height, 0);
+	} else {
+		free(tex->levels[level].data);
+	}
+	tex->levels[level].data = storage;
+	tex->levels[level].w = width;
+	tex->levels[level].h = height;
+	if ((unsigned int)level >= tex->num_levels)
+		tex->num_levels = level + 1;
+}
+
+void glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+	sw_texture *tex = bound_texture();
+	if (!tex)
+		return;
+	if (pname == GL_TEXTURE_MIN_FILTER)
+		tex->min_filter = param;
+	else if (pname == GL_TEXTURE_MAG_FILTER)
+		tex->mag_filter = param;
+}
+
+void glGenerateMipmap(GLenum target)
+{
+	sw_texture *tex = bound_texture();
+	unsigned int level;
+
+	/* Box filtered like vita2d's own RGBA8 chains, other formats keep only level 0 */
+	if (!tex || tex->gxm.format != SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR ||
+	    tex->gxm.type != SCE_GXM_TEXTURE_LINEAR || !tex->levels[0].data)
+		return;
+
+	for (level = 1; level < MAX_LEVELS; level++) {
+		const sw_level *src = &tex->levels[level - 1];
+		sw_level *dst = &tex->levels[level];
+		if (src->w == 1 && src->h == 1)
+			break;
+		free(dst->data);
+		dst->w = src->w > 1 ? src->w / 2 : 1;
+		dst->h = src->h > 1 ? src->h / 2 : 1;
+		dst->data = calloc(dst->h, ALIGN(dst->w, 8) * 4);
+		if (!dst->data)
+			break;
+		pixel_downsample_box(dst->data, ALIGN(dst->w, 8) * 4, src->data, ALIGN(src->w, 8) * 4, src->w, src->h);
+	}
+	tex->num_levels = level;
+}
+
+void *vglGetTexDataPointer(GLenum target)
+{
+	sw_texture *tex = bound_texture();
+	return tex ? (void *)tex->gxm.data : NULL;
+}
+
+SceGxmTexture *vglGetGxmTexture(GLenum target)
+{
+	sw_texture *tex = bound_texture();
+	return tex ? &tex->gxm : NULL;
+}
+
+/* GXM texture descriptors */
+
+static int init_texture(SceGxmTexture *texture, const void *data, SceGxmTextureFormat format, SceGxmTextureType type,
+			unsigned int width, unsigned int height, unsigned int mipCount)
+{
+	if (!texture)
+		return -1;
+	texture->data = data;
+	texture->format = format;
+	texture->type = type;
+	texture->width = width;
+	texture->height = height;
+	texture->mip_count = mipCount;
+	return 0;
+}
+
+int sceGxmTextureInitLinear(SceGxmTexture *texture, const void *data, SceGxmTextureFormat format,
+			    unsigned int width, unsigned int height, unsigned int mipCount)
+{
+	return init_texture(texture, data, format, SCE_GXM_TEXTURE_LINEAR, width, height, mipCount);
+}
+
+int sceGxmTextureInitSwizzled(SceGxmTexture *texture, const void *data, SceGxmTextureFormat format,
+			      unsigned int width, unsigned int height, unsigned int mipCount)
+{
+	return init_texture(texture, data, format, SCE_GXM_TEXTURE_SWIZZLED, width, height, mipCount);
+}
+
+int sceGxmTextureInitSwizzledArbitrary(SceGxmTexture *texture, const void *data, SceGxmTextureFormat format,
+				       unsigned int width, unsigned int height, unsigned int mipCount)
+{
+	return init_texture(texture, data, format, SCE_GXM_TEXTURE_SWIZZLED_ARBITRARY, width, height, mipCount);
+}
+
+int sceGxmTextureInitTiled(SceGxmTexture *texture, const void *data, SceGxmTextureFormat format,
+			   unsigned int width, unsigned int height, unsigned int mipCount)
+{
+	return init_texture(texture, data, format, SCE_GXM_TEXTURE_TILED, width, height, mipCount);
+}
+
+int sceGxmTextureSetFormat(SceGxmTexture *texture, SceGxmTextureFormat format)
+{
+	if (!texture)
+		return -1;
+	texture->format = format;
+	return 0;
+}
+
+int sceGxmTextureSetPalette(SceGxmTexture *texture, const void *paletteData)
+{
+	if (!texture)
+		return -1;
+	texture->palette = paletteData;
+	return 0;
+}
+
+/* Framebuffers */
+
+static sw_framebuffer *get_framebuffer(GLuint name)
+{
+	return name < num_framebuffers ? framebuffers[name] : NULL;
+}
+
+void glGenFramebuffers(GLsizei n, GLuint *ids)
+{
+	GLsizei i;
+	for (i = 0; i < n; i++) {
+		sw_framebuffer *fb = calloc(1, sizeof(*fb));
+		ids[i] = fb ? alloc_name((void ***)&framebuffers, &num_framebuffers, fb) : 0;
+		if (!ids[i])
+			free(fb);
+	}
+}
+
+void glBindFramebuffer(GLenum target, GLuint fb)
+{
+	gl.framebuffer = fb;
+}
+
+void glDeleteFramebuffers(GLsizei n, const GLuint *ids)
+{
+	GLsizei i;
+	for (i = 0; i < n; i++) {
+		sw_framebuffer *fb = get_framebuffer(ids[i]);
+		if (!fb)
+			continue;
+		free(fb);
+		framebuffers[ids[i]] = NULL;
+		if (gl.framebuffer == ids[i])
+			gl.framebuffer = 0;
+	}
+}
+
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
+{
+	sw_framebuffer *fb = get_framebuffer(gl.framebuffer);
+	if (fb)
+		fb->texture = texture;
+}
+
+/* Drawing */
+
+/* The render target with the current scissor and blend state, NULL if it can't be drawn to */
+static vita2d_sw_target *current_target(void)
+{
+	vita2d_sw_target *target;
+
+	if (gl.framebuffer == 0) {
+		target = vitagl_sw_get_screen();
+		if (!target)
+			return NULL;
+	} else {
+		sw_framebuffer *fb = get_framebuffer(gl.framebuffer);
+		sw_texture *tex = fb ? get_texture(fb->texture) : NULL;
+		/* vita2d's render targets are RGBA8 */
+		if (!tex || tex->gxm.format != SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR ||
+		    tex->gxm.type != SCE_GXM_TEXTURE_LINEAR)
+			return NULL;
+		target = &fb->target;
+		vita2d_sw_init_target(target, (uint32_t *)tex->gxm.data, tex->gxm.width, tex->gxm.height,
+				      ALIGN(tex->gxm.width, 8));
+	}
+
+	/* vitaGL counts the scissor's y down from the top, at the projection's height */
+	target->clipping = gl.scissor_test;
+	vita2d_sw_set_clip_rectangle(target, gl.scissor[0], gl.ortho_h - gl.scissor[1],
+				     gl.scissor[0] + gl.scissor[2], gl.ortho_h - gl.scissor[1] + gl.scissor[3]);
+	vita2d_sw_set_blending(target, gl.blend);
+	vita2d_sw_set_blend_mode_add(target, gl.additive);
+	return target;
+}
+
+void glClear(GLbitfield mask)
+{
+	vita2d_sw_target *target;
+	int x0 = 0, y0 = 0, x1, y1, y;
+
+	if (!(mask & GL_COLOR_BUFFER_BIT) || !gl.rasterize || !(target = current_target()))
+		return;
+
+	/* Unlike vita2d_sw_clear_screen, glClear honors the scissor */
+	x1 = target->w;
+	y1 = target->h;
+	if (target->clipping) {
+		if (target->clip[0] > x0) x0 = target->clip[0];
+		if (target->clip[1] > y0) y0 = target->clip[1];
+		if (target->clip[2] < x1) x1 = target->clip[2];
+		if (target->clip[3] < y1) y1 = target->clip[3];
+	}
+	for (y = y0; y < y1; y++) {
+		int x;
+		uint32_t *row = &target->pixels[y * target->stride];
+		for (x = x0; x < x1; x++)
+			row[x] = gl.clear_color;
+	}
+}
+
+/* Texels per pixel along one axis, from the first triangle's areas */
+static float texel_ratio(const sw_texture *tex, const GLfloat *vtx, const GLfloat *tc, const GLushort *indices)
+{
+	unsigned int i0 = indices ? indices[0] : 0;
+	unsigned int i1 = indices ? indices[1] : 1;
+	unsigned int i2 = indices ? indices[2] : 2;
+
+	float pixels = fabsf((vtx[i1 * 2] - vtx[i0 * 2]) * (vtx[i2 * 2 + 1] - vtx[i0 * 2 + 1]) -
+			     (vtx[i1 * 2 + 1] - vtx[i0 * 2 + 1]) * (vtx[i2 * 2] - vtx[i0 * 2]));
+	float texels = fabsf((tc[i1 * 2] - tc[i0 * 2]) * (tc[i2 * 2 + 1] - tc[i0 * 2 + 1]) -
+			     (tc[i1 * 2 + 1] - tc[i0 * 2 + 1]) * (tc[i2 * 2] - tc[i0 * 2])) *
+		       tex->gxm.width * tex->gxm.height;
+
+	return pixels > 0.0f ? sqrtf(texels / pixels) : 1.0f;
+}
+
+/* Expands paletted texels to RGBA8, P4 keeps the first texel in the low nibble */
+static void expand_palette(uint32_t *dst, const uint8_t *src, unsigned int src_stride, unsigned int w, unsigned int h,
+			   const uint32_t *palette, int p4)
+{
+	unsigned int x, y;
+	for (y = 0; y < h; y++) {
+		const uint8_t *row = src + y * src_stride;
+		for (x = 0; x < w; x++) {
+			unsigned int index = p4 ? (row[x / 2] >> ((x & 1) * 4)) & 0xF : row[x];
+			*dst++ = palette ? palette[index] : 0;
+		}
+	}
+}
+
+/*
+ * Describes the texture level to vita2d_sw. RGBA8 and U8 are sampled in place,
+ * other linear formats are converted to a malloc'd RGBA8 copy returned in 'converted'.
+ * Returns 0 if the texture can't be sampled.
+ */
+static int setup_sampling(const sw_texture *tex, unsigned int level, vita2d_sw_texture *st, void **converted)
+{
+	SceGxmTextureFormat format = tex->gxm.format;
+	SceGxmTextureFormat base = format & SCE_GXM_TEXTURE_BASE_FORMAT_MASK;
+	const uint8_t *data = level ? tex->levels[level].data : tex->gxm.data;
+	unsigned int w = level ? tex->levels[level].w : tex->gxm.width;
+	unsigned int h = level ? tex->levels[level].h : tex->gxm.height;
+	unsigned int y;
+
+	*converted = NULL;
+	if (tex->gxm.type != SCE_GXM_TEXTURE_LINEAR || !data || w == 0 || h == 0)
+		return 0;
+
+	if (format == SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR) {
+		vita2d_sw_init_texture(st, data, w, h, ALIGN(w, 8) * 4, VITA2D_SW_FORMAT_RGBA8);
+		return 1;
+	}
+	if (format == SCE_GXM_TEXTURE_FORMAT_U8_R || format == SCE_GXM_TEXTURE_FORMAT_U8_R111) {
+		vita2d_sw_init_texture(st, data, w, h, ALIGN(w, 8), VITA2D_SW_FORMAT_U8_R);
+		return 1;
+	}
+
+	uint32_t *rgba = malloc((size_t)w * h * 4);
+	if (!rgba)
+		return 0;
+
+	if (base == SCE_GXM_TEXTURE_BASE_FORMAT_P4) {
+		expand_palette(rgba, data, ALIGN(w, 8) / 2, w, h, tex->gxm.palette, 1);
+	} else if (base == SCE_GXM_TEXTURE_BASE_FORMAT_P8) {
+		expand_palette(rgba, data, ALIGN(w, 8), w, h, tex->gxm.palette, 0);
+	} else if (pixel_convert_supported(format)) {
+		unsigned int stride = ALIGN(w, 8) * bpp_from_format(format);
+		for (y = 0; y < h; y++)
+			pixel_convert_row(rgba + y * w, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR,
+					  data + y * stride, format, w);
+	} else {
+		free(rgba);
+		return 0;
+	}
+
+	vita2d_sw_init_texture(st, rgba, w, h, w * 4, VITA2D_SW_FORMAT_RGBA8);
+	*converted = rgba;
+	return 1;
+}
+
+static void draw(GLenum mode, const GLushort *indices, GLint first, GLsizei count)
+{
+	vita2d_sw_primitive prim;
+	vita2d_sw_texture sampled, *texture = NULL;
+	const GLfloat *tcoords = NULL;
+	void *converted = NULL;
+	vita2d_sw_target *target;
+
+	switch (mode) {
+	case GL_POINTS: prim = VITA2D_SW_POINTS; break;
+	case GL_LINES: prim = VITA2D_SW_LINES; break;
+	case GL_TRIANGLES: prim = VITA2D_SW_TRIANGLES; break;
+	case GL_TRIANGLE_STRIP: prim = VITA2D_SW_TRIANGLE_STRIP; break;
+	case GL_TRIANGLE_FAN: prim = VITA2D_SW_TRIANGLE_FAN; break;
+	default: return;
+	}
+
+	gl.draw_calls++;
+	gl.num_vertices += count;
+
+	if (!gl.rasterize || count <= 0 || !gl.vertex_array || !gl.vertices || !(target = current_target()))
+		return;
+
+	const GLfloat *vertices = indices ? gl.vertices : gl.vertices + first * 2;
+
+	if (gl.texture_2d && gl.texcoord_array && gl.tcoords) {
+		const sw_texture *tex = bound_texture();
+		unsigned int level = 0;
+		int minify;
+
+		tcoords = indices ? gl.tcoords : gl.tcoords + first * 2;
+		if (!tex || count < 3)
+			return;
+
+		float ratio = texel_ratio(tex, vertices, tcoords, indices);
+		minify = ratio > 1.0f;
+		if (minify && tex->min_filter != GL_NEAREST && tex->min_filter != GL_LINEAR && tex->num_levels > 1) {
+			/* Nearest level for both mip filters, vita2d_sw has no trilinear path */
+			level = (unsigned int)lrintf(log2f(ratio));
+			if (level >= tex->num_levels)
+				level = tex->num_levels - 1;
+			if (!tex->levels[level].data)
+				level = 0;
+		}
+		if (!setup_sampling(tex, level, &sampled, &converted))
+			return;
+
+		GLint filter = minify ? tex->min_filter : tex->mag_filter;
+		sampled.filter = filter == GL_NEAREST || filter == GL_NEAREST_MIPMAP_NEAREST ||
+				 filter == GL_NEAREST_MIPMAP_LINEAR ? VITA2D_SW_FILTER_POINT : VITA2D_SW_FILTER_LINEAR;
+		texture = &sampled;
+	}
+
+	if (indices)
+		vita2d_sw_draw_elements(target, prim, vertices, tcoords, indices, count, gl.color, texture);
+	else
+		vita2d_sw_draw_arrays(target, prim, vertices, tcoords, count, gl.color, texture);
+	free(converted);
+}
+
+void glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	draw(mode, NULL, first, count);
+}
+
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices)
+{
+	if (type != GL_UNSIGNED_SHORT)
+		return;
+	draw(mode, indices, 0, count);
+}
@@ -0,0 +1,61 @@
+#include <string.h>
+#include "asset_pack.h"
+#include "utils.h"
+
+uint32_t asset_pack_hash(const char *name)
+{
+	return hash_string(name);
+}
+
+const asset_pack_header *asset_pack_validate(const void *buffer, size_t size)
+{
+	const asset_pack_header *header = buffer;
+	const asset_pack_entry *entries;
+	const char *names;
+	unsigned int i;
+
+	if (size < sizeof(*header) || header->magic != ASSET_PACK_MAGIC ||
+	    header->version != ASSET_PACK_VERSION ||
+	    header->num_entries > (size - sizeof(*header)) / sizeof(asset_pack_entry) ||
+	    header->names_offset > size || header->names_size > size - header->names_offset ||
+	    header->names_size == 0)
+		return NULL;
+
+	// Every name and blob has to be inside the pack, the string table ends with a NUL
+	names = (const char *)buffer + header->names_offset;
+	if (names[header->names_size - 1] != '\0')
+		return NULL;
+
+	entries = asset_pack_entries(header);
+	for (i = 0; i < header->num_entries; i++) {
+		if (entries[i].name >= header->names_size || entries[i].offset > size ||
+		    entries[i].size > size - entries[i].offset ||
+		    (i > 0 && entries[i].hash < entries[i - 1].hash))
+			return NULL;
+	}
+
+	return header;
+}
+
+int asset_pack_find(const asset_pack_header *header, const char *name)
+{
+	const asset_pack_entry *entries = asset_pack_entries(header);
+	uint32_t hash = asset_pack_hash(name);
+	unsigned int lo = 0, hi = header->num_entries;
+
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+		if (entries[mid].hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	// Names sharing a hash are next to each other
+	for (; lo < header->num_entries && entries[lo].hash == hash; lo++) {
+		if (!strcmp(asset_pack_name(header, &entries[lo]), name))
+			return (int)lo;
+	}
+
+	return -1;
+}
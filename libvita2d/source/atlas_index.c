@@ -0,0 +1,38 @@
+#include <string.h>
+#include "atlas_index.h"
+#include "utils.h"
+
+uint32_t atlas_index_hash(const char *name)
+{
+	return hash_string(name);
+}
+
+const atlas_index_header *atlas_index_validate(const void *buffer, size_t size)
+{
+	const atlas_index_header *header = buffer;
+
+	if (size < sizeof(*header) || header->magic != ATLAS_INDEX_MAGIC ||
+	    header->version != ATLAS_INDEX_VERSION ||
+	    header->num_sprites > (size - sizeof(*header)) / sizeof(atlas_index_sprite) ||
+	    memchr(header->texture_file, '\0', sizeof(header->texture_file)) == NULL)
+		return NULL;
+
+	return header;
+}
+
+int atlas_index_find(const atlas_index_header *header, const char *name)
+{
+	const atlas_index_sprite *sprites = atlas_index_sprites(header);
+	uint32_t hash = atlas_index_hash(name);
+	unsigned int lo = 0, hi = header->num_sprites;
+
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+		if (sprites[mid].hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo < header->num_sprites && sprites[lo].hash == hash ? (int)lo : -1;
+}
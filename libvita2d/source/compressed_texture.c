@@ -0,0 +1,344 @@
+#include <string.h>
+#include "compressed_texture.h"
+
+#define DDS_MAGIC            0x20534444 // "DDS "
+#define DDS_HEADER_SIZE      124
+#define DDS_DX10_HEADER_SIZE 20
+#define DDSD_MIPMAPCOUNT     0x20000
+#define DDPF_FOURCC          0x4
+#define FOURCC(a, b, c, d)   ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+#define PVR3_MAGIC       0x03525650 // "PVR\3"
+#define PVR3_HEADER_SIZE 52
+#define PVR2_HEADER_SIZE 52
+#define PVR2_TAG         0x21525650 // "PVR!"
+
+#define KTX_HEADER_SIZE 64
+#define KTX_ENDIANNESS  0x04030201
+
+static const uint8_t ktx_identifier[12] = {
+	0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+static uint32_t read_u32(const uint8_t *p, int swap)
+{
+	if (swap)
+		return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+	return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t compressed_texture_level_size(compressed_texture_format format, unsigned int w, unsigned int h)
+{
+	size_t bw = (w + 3) / 4;
+	size_t bh = (h + 3) / 4;
+
+	if (bw == 0)
+		bw = 1;
+	if (bh == 0)
+		bh = 1;
+
+	switch (format) {
+	case COMPRESSED_TEXTURE_DXT1_RGB:
+	case COMPRESSED_TEXTURE_DXT1_RGBA:
+	case COMPRESSED_TEXTURE_ETC1:
+		return bw * bh * 8;
+	case COMPRESSED_TEXTURE_DXT3:
+	case COMPRESSED_TEXTURE_DXT5:
+		return bw * bh * 16;
+	// PVRTC needs at least 2x2 blocks: 16x8 pixels at 2bpp, 8x8 at 4bpp
+	case COMPRESSED_TEXTURE_PVRTC_2BPP_RGB:
+	case COMPRESSED_TEXTURE_PVRTC_2BPP_RGBA:
+		return (size_t)(w < 16 ? 16 : w) * (h < 8 ? 8 : h) * 2 / 8;
+	case COMPRESSED_TEXTURE_PVRTC_4BPP_RGB:
+	case COMPRESSED_TEXTURE_PVRTC_4BPP_RGBA:
+		return (size_t)(w < 8 ? 8 : w) * (h < 8 ? 8 : h) * 4 / 8;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Fills tex->levels from tightly packed mips starting at 'data'. Each level is
+ * repeated 'level_mult' times (faces/surfaces), only the first copy is kept.
+ */
+static int fill_levels(compressed_texture *tex, const uint8_t *data, const uint8_t *end,
+		       unsigned int num_levels, unsigned int level_mult)
+{
+	unsigned int i, w = tex->w, h = tex->h;
+
+	if (num_levels == 0)
+		num_levels = 1;
+	if (num_levels > COMPRESSED_TEXTURE_MAX_LEVELS)
+		num_levels = COMPRESSED_TEXTURE_MAX_LEVELS;
+
+	tex->num_levels = 0;
+	for (i = 0; i < num_levels; i++) {
+		size_t size = compressed_texture_level_size(tex->format, w, h);
+		if (size == 0 || size > (size_t)(end - data))
+			break;
+
+		tex->levels[i].data = data;
+		tex->levels[i].size = size;
+		tex->levels[i].w = w;
+		tex->levels[i].h = h;
+		tex->num_levels++;
+
+		if (size * level_mult > (size_t)(end - data))
+			break;
+		data += size * level_mult;
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+	}
+
+	return tex->num_levels > 0 ? 0 : -1;
+}
+
+static compressed_texture_format dds_format(const uint8_t *header, const uint8_t **data, const uint8_t *end)
+{
+	const uint8_t *pf = header + 72;
+	uint32_t fourcc;
+
+	if (!(read_u32(pf + 4, 0) & DDPF_FOURCC))
+		return COMPRESSED_TEXTURE_UNKNOWN;
+
+	fourcc = read_u32(pf + 8, 0);
+	switch (fourcc) {
+	case FOURCC('D', 'X', 'T', '1'):
+		return COMPRESSED_TEXTURE_DXT1_RGBA;
+	case FOURCC('D', 'X', 'T', '2'):
+	case FOURCC('D', 'X', 'T', '3'):
+		return COMPRESSED_TEXTURE_DXT3;
+	case FOURCC('D', 'X', 'T', '4'):
+	case FOURCC('D', 'X', 'T', '5'):
+		return COMPRESSED_TEXTURE_DXT5;
+	case FOURCC('E', 'T', 'C', '1'):
+		return COMPRESSED_TEXTURE_ETC1;
+	case FOURCC('D', 'X', '1', '0'):
+		if (end - *data < DDS_DX10_HEADER_SIZE)
+			return COMPRESSED_TEXTURE_UNKNOWN;
+		fourcc = read_u32(*data, 0); // DXGI_FORMAT
+		*data += DDS_DX10_HEADER_SIZE;
+		switch (fourcc) {
+		case 71: // BC1_UNORM
+		case 72: // BC1_UNORM_SRGB
+			return COMPRESSED_TEXTURE_DXT1_RGBA;
+		case 74: // BC2_UNORM
+		case 75: // BC2_UNORM_SRGB
+			return COMPRESSED_TEXTURE_DXT3;
+		case 77: // BC3_UNORM
+		case 78: // BC3_UNORM_SRGB
+			return COMPRESSED_TEXTURE_DXT5;
+		}
+		return COMPRESSED_TEXTURE_UNKNOWN;
+	default:
+		return COMPRESSED_TEXTURE_UNKNOWN;
+	}
+}
+
+static int parse_dds(const uint8_t *buf, const uint8_t *end, compressed_texture *tex)
+{
+	const uint8_t *header = buf + 4;
+	const uint8_t *data = header + DDS_HEADER_SIZE;
+	unsigned int levels = 1;
+
+	if (end - buf < 4 + DDS_HEADER_SIZE || read_u32(header, 0) != DDS_HEADER_SIZE)
+		return -1;
+
+	tex->h = read_u32(header + 8, 0);
+	tex->w = read_u32(header + 12, 0);
+	if (read_u32(header + 4, 0) & DDSD_MIPMAPCOUNT)
+		levels = read_u32(header + 24, 0);
+
+	tex->format = dds_format(header, &data, end);
+	if (tex->format == COMPRESSED_TEXTURE_UNKNOWN)
+		return -1;
+
+	// Cube maps and arrays store each face's full mip chain in turn, the first one is used
+	return fill_levels(tex, data, end, levels, 1);
+}
+
+static compressed_texture_format pvr3_format(uint32_t format)
+{
+	switch (format) {
+	case 0: return COMPRESSED_TEXTURE_PVRTC_2BPP_RGB;
+	case 1: return COMPRESSED_TEXTURE_PVRTC_2BPP_RGBA;
+	case 2: return COMPRESSED_TEXTURE_PVRTC_4BPP_RGB;
+	case 3: return COMPRESSED_TEXTURE_PVRTC_4BPP_RGBA;
+	case 6: return COMPRESSED_TEXTURE_ETC1;
+	case 7: return COMPRESSED_TEXTURE_DXT1_RGBA;
+	case 8:
+	case 9: return COMPRESSED_TEXTURE_DXT3;
+	case 10:
+	case 11: return COMPRESSED_TEXTURE_DXT5;
+	default: return COMPRESSED_TEXTURE_UNKNOWN;
+	}
+}
+
+static int parse_pvr3(const uint8_t *buf, const uint8_t *end, compressed_texture *tex)
+{
+	uint32_t surfaces, faces, depth, meta_size;
+
+	if (end - buf < PVR3_HEADER_SIZE)
+		return -1;
+
+	// The high word is non-zero for uncompressed channel layouts
+	if (read_u32(buf + 12, 0) != 0)
+		return -1;
+
+	tex->format = pvr3_format(read_u32(buf + 8, 0));
+	tex->h = read_u32(buf + 24, 0);
+	tex->w = read_u32(buf + 28, 0);
+	depth = read_u32(buf + 32, 0);
+	surfaces = read_u32(buf + 36, 0);
+	faces = read_u32(buf + 40, 0);
+	meta_size = read_u32(buf + 48, 0);
+
+	if (tex->format == COMPRESSED_TEXTURE_UNKNOWN || meta_size > (size_t)(end - buf) - PVR3_HEADER_SIZE)
+		return -1;
+
+	// Each level holds every surface, face and slice before the next level starts
+	return fill_levels(tex, buf + PVR3_HEADER_SIZE + meta_size, end, read_u32(buf + 44, 0),
+			   (surfaces ? surfaces : 1) * (faces ? faces : 1) * (depth ? depth : 1));
+}
+
+static int parse_pvr2(const uint8_t *buf, const uint8_t *end, compressed_texture *tex)
+{
+	uint32_t flags, alpha_mask;
+
+	if (end - buf < PVR2_HEADER_SIZE)
+		return -1;
+
+	flags = read_u32(buf + 16, 0);
+	alpha_mask = read_u32(buf + 40, 0);
+
+	switch (flags & 0xFF) {
+	case 0x18: // OGL_PVRTC2
+		tex->format = alpha_mask ? COMPRESSED_TEXTURE_PVRTC_2BPP_RGBA : COMPRESSED_TEXTURE_PVRTC_2BPP_RGB;
+		break;
+	case 0x19: // OGL_PVRTC4
+		tex->format = alpha_mask ? COMPRESSED_TEXTURE_PVRTC_4BPP_RGBA : COMPRESSED_TEXTURE_PVRTC_4BPP_RGB;
+		break;
+	case 0x36: // ETC_RGB_4BPP
+		tex->format = COMPRESSED_TEXTURE_ETC1;
+		break;
+	default:
+		return -1;
+	}
+
+	tex->h = read_u32(buf + 4, 0);
+	tex->w = read_u32(buf + 8, 0);
+
+	// Legacy headers don't count the top level
+	return fill_levels(tex, buf + read_u32(buf, 0), end, read_u32(buf + 12, 0) + 1, 1);
+}
+
+static compressed_texture_format ktx_format(uint32_t internal_format)
+{
+	switch (internal_format) {
+	case 0x83F0: return COMPRESSED_TEXTURE_DXT1_RGB;
+	case 0x83F1: return COMPRESSED_TEXTURE_DXT1_RGBA;
+	case 0x83F2: return COMPRESSED_TEXTURE_DXT3;
+	case 0x83F3: return COMPRESSED_TEXTURE_DXT5;
+	case 0x8C00: return COMPRESSED_TEXTURE_PVRTC_4BPP_RGB;
+	case 0x8C01: return COMPRESSED_TEXTURE_PVRTC_2BPP_RGB;
+	case 0x8C02: return COMPRESSED_TEXTURE_PVRTC_4BPP_RGBA;
+	case 0x8C03: return COMPRESSED_TEXTURE_PVRTC_2BPP_RGBA;
+	case 0x8D64: return COMPRESSED_TEXTURE_ETC1;
+	default: return COMPRESSED_TEXTURE_UNKNOWN;
+	}
+}
+
+static int parse_ktx(const uint8_t *buf, const uint8_t *end, compressed_texture *tex)
+{
+	const uint8_t *data;
+	unsigned int i, num_levels, w, h;
+	uint32_t endianness, kv_size;
+	int swap;
+
+	if (end - buf < KTX_HEADER_SIZE)
+		return -1;
+
+	endianness = read_u32(buf + 12, 0);
+	if (endianness == KTX_ENDIANNESS)
+		swap = 0;
+	else if (read_u32(buf + 12, 1) == KTX_ENDIANNESS)
+		swap = 1;
+	else
+		return -1;
+
+	// glType is 0 for compressed payloads
+	if (read_u32(buf + 16, swap) != 0)
+		return -1;
+
+	tex->format = ktx_format(read_u32(buf + 28, swap));
+	tex->w = read_u32(buf + 36, swap);
+	tex->h = read_u32(buf + 40, swap);
+	num_levels = read_u32(buf + 56, swap);
+	kv_size = read_u32(buf + 60, swap);
+
+	if (tex->format == COMPRESSED_TEXTURE_UNKNOWN || kv_size > (size_t)(end - buf) - KTX_HEADER_SIZE)
+		return -1;
+
+	if (num_levels == 0)
+		num_levels = 1;
+	if (num_levels > COMPRESSED_TEXTURE_MAX_LEVELS)
+		num_levels = COMPRESSED_TEXTURE_MAX_LEVELS;
+
+	// Every level is prefixed by its size, so don't rely on our own block math to walk them
+	data = buf + KTX_HEADER_SIZE + kv_size;
+	w = tex->w;
+	h = tex->h;
+	tex->num_levels = 0;
+	for (i = 0; i < num_levels; i++) {
+		size_t size, image_size;
+
+		if (end - data < 4)
+			break;
+		image_size = read_u32(data, swap);
+		data += 4;
+
+		size = compressed_texture_level_size(tex->format, w, h);
+		if (image_size < size || image_size > (size_t)(end - data))
+			break;
+
+		tex->levels[i].data = data;
+		tex->levels[i].size = size;
+		tex->levels[i].w = w;
+		tex->levels[i].h = h;
+		tex->num_levels++;
+
+		// Non-array cube maps store the six faces back to back, each padded to 4 bytes
+		image_size = (image_size + 3) & ~(size_t)3; // cubePadding/mipPadding
+		if (read_u32(buf + 48, swap) == 0 && read_u32(buf + 52, swap) == 6)
+			image_size *= 6;
+		if (image_size > (size_t)(end - data))
+			break;
+		data += image_size;
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+	}
+
+	return tex->num_levels > 0 ? 0 : -1;
+}
+
+int compressed_texture_parse(const void *buffer, size_t size, compressed_texture *tex)
+{
+	const uint8_t *buf = buffer;
+	const uint8_t *end = buf + size;
+
+	memset(tex, 0, sizeof(*tex));
+
+	if (size < 16)
+		return -1;
+
+	if (read_u32(buf, 0) == DDS_MAGIC)
+		return parse_dds(buf, end, tex);
+	if (read_u32(buf, 0) == PVR3_MAGIC)
+		return parse_pvr3(buf, end, tex);
+	if (memcmp(buf, ktx_identifier, sizeof(ktx_identifier)) == 0)
+		return parse_ktx(buf, end, tex);
+	if (size >= PVR2_HEADER_SIZE && read_u32(buf, 0) == PVR2_HEADER_SIZE && read_u32(buf + 44, 0) == PVR2_TAG)
+		return parse_pvr2(buf, end, tex);
+
+	return -1;
+}
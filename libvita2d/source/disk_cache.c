@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "disk_cache.h"
+#include "lz4_block.h"
+#include "utils.h"
+
+// Entries bigger than this are corrupt, the largest texture is 4096x4096 RGBA
+#define MAX_PIXELS_SIZE (4096u * 4096u * 4u)
+
+int disk_cache_path(const char *dir, const disk_cache_key *key, char *path, size_t size)
+{
+	int len = snprintf(path, size, "%s/%016llx" DISK_CACHE_EXTENSION, dir,
+			   (unsigned long long)hash_buffer(key, sizeof(*key)));
+	return len < 0 || (size_t)len >= size ? -1 : 0;
+}
+
+int disk_cache_read(const char *path, const disk_cache_key *key, disk_cache_alloc alloc, void *userdata,
+		    disk_cache_header *header)
+{
+	FILE *fp = fopen(path, "rb");
+	void *compressed = NULL, *pixels;
+	size_t pixels_size;
+	int ret = -1;
+
+	if (!fp)
+		return -1;
+
+	if (fread(header, sizeof(*header), 1, fp) != 1 || header->magic != DISK_CACHE_MAGIC ||
+	    header->version != DISK_CACHE_VERSION || memcmp(&header->key, key, sizeof(*key)) != 0)
+		goto done;
+
+	pixels_size = (uint64_t)header->stride * header->h;
+	if (header->w == 0 || header->h == 0 || pixels_size > MAX_PIXELS_SIZE ||
+	    header->compressed_size > LZ4_BLOCK_BOUND(pixels_size))
+		goto done;
+
+	compressed = malloc(header->compressed_size);
+	if (!compressed || fread(compressed, 1, header->compressed_size, fp) != header->compressed_size ||
+	    hash_buffer(compressed, header->compressed_size) != header->checksum)
+		goto done;
+
+	pixels = alloc(header, userdata);
+	if (pixels && lz4_block_decompress(compressed, header->compressed_size, pixels, pixels_size) == (int)pixels_size)
+		ret = 0;
+
+done:
+	free(compressed);
+	fclose(fp);
+	return ret;
+}
+
+long disk_cache_write(const char *path, const disk_cache_key *key, unsigned int w, unsigned int h,
+		      unsigned int stride, uint32_t decode_us, const void *pixels)
+{
+	size_t pixels_size = (size_t)stride * h;
+	disk_cache_header header;
+	char tmp_path[512];
+	void *compressed;
+	int compressed_size;
+	FILE *fp;
+
+	if (pixels_size == 0 || pixels_size > MAX_PIXELS_SIZE ||
+	    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path))
+		return -1;
+
+	compressed = malloc(LZ4_BLOCK_BOUND(pixels_size));
+	if (!compressed)
+		return -1;
+	compressed_size = lz4_block_compress(pixels, pixels_size, compressed, LZ4_BLOCK_BOUND(pixels_size));
+	if (compressed_size < 0) {
+		free(compressed);
+		return -1;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.magic = DISK_CACHE_MAGIC;
+	header.version = DISK_CACHE_VERSION;
+	header.key = *key;
+	header.w = w;
+	header.h = h;
+	header.stride = stride;
+	header.decode_us = decode_us;
+	header.compressed_size = compressed_size;
+	header.checksum = hash_buffer(compressed, compressed_size);
+
+	fp = fopen(tmp_path, "wb");
+	if (!fp) {
+		free(compressed);
+		return -1;
+	}
+	int ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+		 fwrite(compressed, 1, compressed_size, fp) == (size_t)compressed_size;
+	ok = fclose(fp) == 0 && ok;
+	free(compressed);
+
+	// The Vita can't rename over an existing file
+	remove(path);
+	if (!ok || rename(tmp_path, path) != 0) {
+		remove(tmp_path);
+		return -1;
+	}
+
+	return sizeof(header) + compressed_size;
+}
+
+static int is_entry(const char *name)
+{
+	size_t len = strlen(name), ext_len = strlen(DISK_CACHE_EXTENSION);
+	return len > ext_len && strcmp(name + len - ext_len, DISK_CACHE_EXTENSION) == 0;
+}
+
+uint64_t disk_cache_size(const char *dir_path, unsigned int *entries)
+{
+	DIR *dir = opendir(dir_path);
+	struct dirent *entry;
+	char path[512];
+	uint64_t size = 0;
+	unsigned int count = 0;
+
+	if (dir) {
+		while ((entry = readdir(dir))) {
+			struct stat st;
+			if (!is_entry(entry->d_name))
+				continue;
+			snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+			if (stat(path, &st) == 0) {
+				size += st.st_size;
+				count++;
+			}
+		}
+		closedir(dir);
+	}
+
+	if (entries)
+		*entries = count;
+	return size;
+}
+
+unsigned int disk_cache_clear(const char *dir_path)
+{
+	DIR *dir = opendir(dir_path);
+	struct dirent *entry;
+	char path[512];
+	unsigned int count = 0;
+
+	if (!dir)
+		return 0;
+
+	while ((entry = readdir(dir))) {
+		if (!is_entry(entry->d_name))
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+		if (remove(path) == 0)
+			count++;
+	}
+	closedir(dir);
+	return count;
+}
@@ -0,0 +1,95 @@
+#include <string.h>
+#include "gxt.h"
+
+#define GXT_MAGIC        0x00545847 // "GXT\0"
+#define GXT_VERSION_3    0x10000003
+#define GXT_HEADER_SIZE  32
+#define GXT_INFO_SIZE    32
+#define GXT_P4_SIZE      (16 * 4)
+#define GXT_P8_SIZE      (256 * 4)
+
+// SceGxmTextureFormat base formats (the top byte, swizzle bits masked out)
+#define GXT_BASE_FORMAT_MASK 0x9F000000
+#define GXT_BASE_FORMAT_P4   0x94000000
+#define GXT_BASE_FORMAT_P8   0x95000000
+
+static uint32_t read_u32(const uint8_t *p)
+{
+	return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read_u16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+int gxt_get_texture_count(const void *buffer, size_t size)
+{
+	const uint8_t *buf = buffer;
+	uint32_t count;
+
+	if (size < GXT_HEADER_SIZE || read_u32(buf) != GXT_MAGIC || read_u32(buf + 4) != GXT_VERSION_3)
+		return -1;
+
+	count = read_u32(buf + 8);
+	if (count > (size - GXT_HEADER_SIZE) / GXT_INFO_SIZE)
+		return -1;
+
+	return count;
+}
+
+int gxt_get_texture(const void *buffer, size_t size, unsigned int index, gxt_texture *tex)
+{
+	const uint8_t *buf = buffer;
+	const uint8_t *info;
+	uint32_t data_offset, data_size, num_p4, num_p8, palette_index, base;
+	size_t palettes_offset;
+	int count = gxt_get_texture_count(buffer, size);
+
+	memset(tex, 0, sizeof(*tex));
+
+	if (count < 0 || index >= (unsigned int)count)
+		return -1;
+
+	data_offset = read_u32(buf + 12);
+	data_size = read_u32(buf + 16);
+	num_p4 = read_u32(buf + 20);
+	num_p8 = read_u32(buf + 24);
+
+	if (data_offset > size || data_size > size - data_offset)
+		return -1;
+
+	info = buf + GXT_HEADER_SIZE + index * GXT_INFO_SIZE;
+	tex->size = read_u32(info + 4);
+	palette_index = read_u32(info + 8);
+	tex->type = read_u32(info + 16);
+	tex->format = read_u32(info + 20);
+	tex->w = read_u16(info + 24);
+	tex->h = read_u16(info + 26);
+	tex->mip_count = info[28];
+
+	if (read_u32(info) > size || tex->size > size - read_u32(info))
+		return -1;
+	tex->data = buf + read_u32(info);
+
+	if (palette_index == GXT_NO_PALETTE)
+		return 0;
+
+	// Palettes sit at the end of the data block, all the P4 ones first
+	if ((uint64_t)num_p4 * GXT_P4_SIZE + (uint64_t)num_p8 * GXT_P8_SIZE > data_size)
+		return -1;
+	palettes_offset = data_offset + data_size - num_p4 * GXT_P4_SIZE - num_p8 * GXT_P8_SIZE;
+
+	base = tex->format & GXT_BASE_FORMAT_MASK;
+	if (base == GXT_BASE_FORMAT_P4 && palette_index < num_p4) {
+		tex->palette = buf + palettes_offset + palette_index * GXT_P4_SIZE;
+		tex->palette_size = GXT_P4_SIZE;
+	} else if (base == GXT_BASE_FORMAT_P8 && palette_index < num_p8) {
+		tex->palette = buf + palettes_offset + num_p4 * GXT_P4_SIZE + palette_index * GXT_P8_SIZE;
+		tex->palette_size = GXT_P8_SIZE;
+	} else {
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,995 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <png.h>
+#include <jpeglib.h>
+#include <jerror.h>
+#include "image_decode.h"
+#include "utils.h"
+
+#ifdef __vita__
+#include <psp2/kernel/processmgr.h>
+#else
+#include <time.h>
+#endif
+
+#define JPEG_BUFFER_SIZE   4096
+#define BMP_FILE_HEADER    14
+#define BMP_INFO_HEADER    40
+#define TGA_HEADER         18
+
+struct image_stream {
+	const image_decode_io *io;
+	void *user;
+	uint8_t header[IMAGE_DECODE_HEADER_SIZE];
+	size_t header_size;
+	size_t pos; // bytes consumed, the first header_size come from header[]
+	const image_decode_scale *scale;
+};
+
+/*
+ * Shrinks rows as they're decoded, so only one source row and one row of sums are
+ * held at a time. Rows may come in any order as long as the ones feeding the same
+ * destination row are consecutive (bottom-up images are fine).
+ */
+typedef struct row_scaler {
+	unsigned int src_w;
+	unsigned int src_h;
+	unsigned int dst_w;
+	unsigned int dst_h;
+	int filter;
+	uint8_t *dst;
+	unsigned int stride;
+	uint8_t *row;  // source row, NULL when rows are decoded straight into dst
+	uint32_t *x0;  // first source column of each destination column, dst_w + 1 of them
+	uint32_t *sum; // box filter sums of the destination row being built
+	int cur;       // that row, -1 if none
+	unsigned int rows;
+} row_scaler;
+
+typedef struct scaled_alloc {
+	image_decode_alloc alloc;
+	void *userdata;
+	const image_decode_scale *scale;
+	uint8_t *full; // image from a decoder that didn't scale
+	unsigned int w;
+	unsigned int h;
+} scaled_alloc;
+
+typedef struct png_buffer_source {
+	const uint8_t *data;
+	size_t size;
+	size_t offset;
+} png_buffer_source;
+
+typedef struct jpeg_error {
+	struct jpeg_error_mgr mgr;
+	jmp_buf jmp;
+} jpeg_error;
+
+typedef struct jpeg_stream_source {
+	struct jpeg_source_mgr mgr;
+	image_stream *stream;
+	JOCTET buffer[JPEG_BUFFER_SIZE];
+} jpeg_stream_source;
+
+typedef struct memory_io {
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+} memory_io;
+
+size_t image_stream_read(image_stream *stream, void *data, size_t size)
+{
+	size_t done = 0;
+
+	if (stream->pos < stream->header_size) {
+		done = stream->header_size - stream->pos;
+		if (done > size)
+			done = size;
+		memcpy(data, stream->header + stream->pos, done);
+		stream->pos += done;
+	}
+
+	while (done < size) {
+		int chunk = size - done > 0x40000000 ? 0x40000000 : (int)(size - done);
+		int n = stream->io->read(stream->user, (char *)data + done, chunk);
+		if (n <= 0)
+			break;
+		done += n;
+		stream->pos += n;
+	}
+
+	return done;
+}
+
+void image_stream_skip(image_stream *stream, size_t n)
+{
+	if (stream->pos < stream->header_size) {
+		size_t in_header = stream->header_size - stream->pos;
+		if (in_header > n)
+			in_header = n;
+		stream->pos += in_header;
+		n -= in_header;
+	}
+
+	while (n > 0) {
+		int chunk = n > 0x40000000 ? 0x40000000 : (int)n;
+		stream->io->skip(stream->user, chunk);
+		stream->pos += chunk;
+		n -= chunk;
+	}
+}
+
+int image_stream_eof(image_stream *stream)
+{
+	return stream->pos >= stream->header_size && stream->io->eof(stream->user);
+}
+
+const image_decode_scale *image_stream_scale(image_stream *stream)
+{
+	return stream->scale;
+}
+
+// Largest size within the limits with the same aspect ratio, never bigger than w x h
+static void fit_size(const image_decode_scale *scale, unsigned int w, unsigned int h, unsigned int *dw, unsigned int *dh)
+{
+	*dw = w;
+	*dh = h;
+	if (!scale || !((scale->max_w && w > scale->max_w) || (scale->max_h && h > scale->max_h)))
+		return;
+
+	if (scale->max_w && (!scale->max_h || (uint64_t)w * scale->max_h >= (uint64_t)h * scale->max_w)) {
+		*dw = scale->max_w;
+		*dh = ((uint64_t)h * scale->max_w + w / 2) / w;
+	} else {
+		*dh = scale->max_h;
+		*dw = ((uint64_t)w * scale->max_h + h / 2) / h;
+	}
+	if (*dw == 0)
+		*dw = 1;
+	if (*dh == 0)
+		*dh = 1;
+}
+
+static int size_ok(unsigned int w, unsigned int h)
+{
+	return w > 0 && h > 0 && w <= IMAGE_DECODE_MAX_DIMENSION && h <= IMAGE_DECODE_MAX_DIMENSION;
+}
+
+// Destination pixel d covers the source pixels [box_start(d), box_start(d + 1))
+static unsigned int box_start(unsigned int d, unsigned int src, unsigned int dst)
+{
+	return ((uint64_t)d * src + dst - 1) / dst;
+}
+
+static void row_scaler_free(row_scaler *s)
+{
+	free(s->row);
+	free(s->x0);
+	free(s->sum);
+	s->row = NULL;
+	s->x0 = NULL;
+	s->sum = NULL;
+}
+
+// Allocates the dst_w x dst_h destination, which can't be bigger than the source
+static uint8_t *row_scaler_init(row_scaler *s, unsigned int src_w, unsigned int src_h, unsigned int dst_w,
+				unsigned int dst_h, int filter, image_decode_alloc alloc, void *userdata)
+{
+	unsigned int x;
+
+	memset(s, 0, sizeof(*s));
+	if (!size_ok(src_w, src_h))
+		return NULL;
+	s->src_w = src_w;
+	s->src_h = src_h;
+	s->dst_w = dst_w;
+	s->dst_h = dst_h;
+	s->cur = -1;
+
+	// The sums are 32 bit, extreme ratios are point sampled
+	if ((uint64_t)(src_w / dst_w + 1) * (src_h / dst_h + 1) * 255 > UINT32_MAX)
+		filter = IMAGE_DECODE_FILTER_POINT;
+	s->filter = filter;
+
+	if (src_w != dst_w || src_h != dst_h) {
+		s->row = malloc((size_t)src_w * 4);
+		s->x0 = malloc(((size_t)dst_w + 1) * sizeof(uint32_t));
+		if (filter == IMAGE_DECODE_FILTER_BOX)
+			s->sum = calloc((size_t)dst_w * 4, sizeof(uint32_t));
+		if (!s->row || !s->x0 || (filter == IMAGE_DECODE_FILTER_BOX && !s->sum)) {
+			row_scaler_free(s);
+			return NULL;
+		}
+		for (x = 0; x <= dst_w; x++)
+			s->x0[x] = box_start(x, src_w, dst_w);
+	}
+
+	s->dst = alloc(dst_w, dst_h, &s->stride, userdata);
+	if (!s->dst)
+		row_scaler_free(s);
+	return s->dst;
+}
+
+// Where source row y is decoded to
+static uint8_t *row_scaler_row(row_scaler *s, unsigned int y)
+{
+	return s->row ? s->row : s->dst + y * s->stride;
+}
+
+static void row_scaler_flush(row_scaler *s)
+{
+	unsigned int x, c;
+
+	if (s->cur < 0)
+		return;
+
+	uint8_t *out = s->dst + s->cur * s->stride;
+	uint32_t *sum = s->sum;
+	for (x = 0; x < s->dst_w; x++, out += 4, sum += 4) {
+		uint32_t n = (s->x0[x + 1] - s->x0[x]) * s->rows;
+		for (c = 0; c < 4; c++) {
+			out[c] = (sum[c] + n / 2) / n;
+			sum[c] = 0;
+		}
+	}
+	s->cur = -1;
+	s->rows = 0;
+}
+
+static void row_scaler_push(row_scaler *s, unsigned int y, const uint8_t *row)
+{
+	unsigned int dy, x, i;
+
+	if (!s->row)
+		return;
+
+	dy = (uint64_t)y * s->dst_h / s->src_h;
+
+	if (s->filter == IMAGE_DECODE_FILTER_POINT) {
+		// Only the middle row and column of each box are kept
+		if (y != (box_start(dy, s->src_h, s->dst_h) + box_start(dy + 1, s->src_h, s->dst_h) - 1) / 2)
+			return;
+		uint8_t *out = s->dst + dy * s->stride;
+		for (x = 0; x < s->dst_w; x++)
+			memcpy(out + x * 4, row + (s->x0[x] + s->x0[x + 1] - 1) / 2 * 4, 4);
+		return;
+	}
+
+	if ((int)dy != s->cur) {
+		row_scaler_flush(s);
+		s->cur = dy;
+	}
+
+	uint32_t *sum = s->sum;
+	for (x = 0; x < s->dst_w; x++, sum += 4) {
+		for (i = s->x0[x]; i < s->x0[x + 1]; i++, row += 4) {
+			sum[0] += row[0];
+			sum[1] += row[1];
+			sum[2] += row[2];
+			sum[3] += row[3];
+		}
+	}
+	s->rows++;
+}
+
+static void row_scaler_finish(row_scaler *s)
+{
+	if (s->sum)
+		row_scaler_flush(s);
+	row_scaler_free(s);
+}
+
+static void png_read_buffer(png_structp png_ptr, png_bytep out, png_size_t count)
+{
+	png_buffer_source *src = png_get_io_ptr(png_ptr);
+
+	if (count > src->size - src->offset)
+		png_error(png_ptr, "read past the end of the buffer");
+	memcpy(out, src->data + src->offset, count);
+	src->offset += count;
+}
+
+static void png_read_stream(png_structp png_ptr, png_bytep out, png_size_t count)
+{
+	if (image_stream_read(png_get_io_ptr(png_ptr), out, count) != count)
+		png_error(png_ptr, "read past the end of the stream");
+}
+
+// libpng pulls the data through read_fn, a chunk at a time
+static int decode_png(png_rw_ptr read_fn, void *io_ptr, const image_decode_scale *scale, image_decode_alloc alloc, void *userdata)
+{
+	png_structp png_ptr;
+	png_infop info_ptr;
+	png_uint_32 w, h, y;
+	int bit_depth, color_type, passes, pass;
+	unsigned int dw, dh;
+	row_scaler scaler;
+
+	memset(&scaler, 0, sizeof(scaler));
+	png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	info_ptr = png_ptr ? png_create_info_struct(png_ptr) : NULL;
+	if (!info_ptr) {
+		png_destroy_read_struct(&png_ptr, NULL, NULL);
+		return IMAGE_DECODE_ERROR;
+	}
+
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+		row_scaler_free(&scaler);
+		return IMAGE_DECODE_ERROR;
+	}
+
+	png_set_read_fn(png_ptr, io_ptr, read_fn);
+	png_set_user_limits(png_ptr, IMAGE_DECODE_MAX_DIMENSION, IMAGE_DECODE_MAX_DIMENSION);
+	png_read_info(png_ptr, info_ptr);
+	png_get_IHDR(png_ptr, info_ptr, &w, &h, &bit_depth, &color_type, NULL, NULL, NULL);
+	if (!size_ok(w, h))
+		png_error(png_ptr, "image too large");
+
+	// Everything ends up as 8 bit R, G, B, A
+	if (color_type == PNG_COLOR_TYPE_PALETTE)
+		png_set_palette_to_rgb(png_ptr);
+	if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
+		png_set_expand_gray_1_2_4_to_8(png_ptr);
+	if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
+		png_set_tRNS_to_alpha(png_ptr);
+	if (bit_depth == 16)
+		png_set_strip_16(png_ptr);
+	if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+		png_set_gray_to_rgb(png_ptr);
+	if (!(color_type & PNG_COLOR_MASK_ALPHA) && !png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
+		png_set_filler(png_ptr, 0xFF, PNG_FILLER_AFTER);
+	passes = png_set_interlace_handling(png_ptr);
+	png_read_update_info(png_ptr, info_ptr);
+
+	if (png_get_rowbytes(png_ptr, info_ptr) != w * 4)
+		png_error(png_ptr, "unexpected row size");
+
+	// Interlaced images are refined in place, each pass reads the rows back, so they
+	// are decoded whole and shrunk afterwards (see scaled_alloc)
+	dw = w;
+	dh = h;
+	if (passes == 1)
+		fit_size(scale, w, h, &dw, &dh);
+	if (!row_scaler_init(&scaler, w, h, dw, dh, scale ? scale->filter : 0, alloc, userdata))
+		png_error(png_ptr, "allocation failed");
+
+	for (pass = 0; pass < passes; pass++) {
+		for (y = 0; y < h; y++) {
+			uint8_t *row = row_scaler_row(&scaler, y);
+			png_read_row(png_ptr, row, NULL);
+			row_scaler_push(&scaler, y, row);
+		}
+	}
+	row_scaler_finish(&scaler);
+
+	png_read_end(png_ptr, NULL);
+	png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+	return IMAGE_DECODE_OK;
+}
+
+static void jpeg_error_exit(j_common_ptr cinfo)
+{
+	jpeg_error *err = (jpeg_error *)cinfo->err;
+	longjmp(err->jmp, 1);
+}
+
+static void jpeg_stream_init(j_decompress_ptr cinfo)
+{
+}
+
+static boolean jpeg_stream_fill(j_decompress_ptr cinfo)
+{
+	jpeg_stream_source *src = (jpeg_stream_source *)cinfo->src;
+	size_t n = image_stream_read(src->stream, src->buffer, JPEG_BUFFER_SIZE);
+
+	// Truncated image: warn and feed an EOI marker, like jpeg_stdio_src
+	if (n == 0) {
+		WARNMS(cinfo, JWRN_JPEG_EOF);
+		src->buffer[0] = 0xFF;
+		src->buffer[1] = JPEG_EOI;
+		n = 2;
+	}
+
+	src->mgr.next_input_byte = src->buffer;
+	src->mgr.bytes_in_buffer = n;
+	return TRUE;
+}
+
+static void jpeg_stream_skip(j_decompress_ptr cinfo, long n)
+{
+	jpeg_stream_source *src = (jpeg_stream_source *)cinfo->src;
+
+	if (n <= 0)
+		return;
+	if ((size_t)n <= src->mgr.bytes_in_buffer) {
+		src->mgr.next_input_byte += n;
+		src->mgr.bytes_in_buffer -= n;
+		return;
+	}
+
+	image_stream_skip(src->stream, n - src->mgr.bytes_in_buffer);
+	src->mgr.bytes_in_buffer = 0;
+}
+
+static void jpeg_stream_term(j_decompress_ptr cinfo)
+{
+}
+
+// Either stream or buffer is used
+static int decode_jpeg(image_stream *stream, const uint8_t *buffer, size_t size, const image_decode_scale *scale,
+		       image_decode_alloc alloc, void *userdata)
+{
+	struct jpeg_decompress_struct cinfo;
+	jpeg_stream_source *src = NULL;
+	jpeg_error err;
+	unsigned int dw, dh, denom;
+	row_scaler scaler;
+
+	memset(&scaler, 0, sizeof(scaler));
+
+	if (stream) {
+		src = malloc(sizeof(*src));
+		if (!src)
+			return IMAGE_DECODE_ERROR;
+		src->mgr.init_source = jpeg_stream_init;
+		src->mgr.fill_input_buffer = jpeg_stream_fill;
+		src->mgr.skip_input_data = jpeg_stream_skip;
+		src->mgr.resync_to_restart = jpeg_resync_to_restart;
+		src->mgr.term_source = jpeg_stream_term;
+		src->mgr.next_input_byte = NULL;
+		src->mgr.bytes_in_buffer = 0;
+		src->stream = stream;
+	}
+
+	cinfo.err = jpeg_std_error(&err.mgr);
+	err.mgr.error_exit = jpeg_error_exit;
+	if (setjmp(err.jmp)) {
+		jpeg_destroy_decompress(&cinfo);
+		row_scaler_free(&scaler);
+		free(src);
+		return IMAGE_DECODE_ERROR;
+	}
+
+	jpeg_create_decompress(&cinfo);
+	if (src)
+		cinfo.src = &src->mgr;
+	else
+		jpeg_mem_src(&cinfo, (unsigned char *)buffer, size);
+	jpeg_read_header(&cinfo, TRUE);
+	if (!size_ok(cinfo.image_width, cinfo.image_height)) {
+		jpeg_destroy_decompress(&cinfo);
+		free(src);
+		return IMAGE_DECODE_ERROR;
+	}
+
+	// The IDCT scales by 1/2, 1/4 or 1/8 for free, the row scaler does the rest
+	fit_size(scale, cinfo.image_width, cinfo.image_height, &dw, &dh);
+	for (denom = 8; denom > 1; denom /= 2) {
+		if ((cinfo.image_width + denom - 1) / denom >= dw && (cinfo.image_height + denom - 1) / denom >= dh)
+			break;
+	}
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = denom;
+#ifdef JCS_EXTENSIONS
+	cinfo.out_color_space = JCS_EXT_RGBA;
+#else
+	cinfo.out_color_space = JCS_RGB;
+#endif
+	jpeg_start_decompress(&cinfo);
+
+	if (!row_scaler_init(&scaler, cinfo.output_width, cinfo.output_height, dw, dh, scale ? scale->filter : 0, alloc, userdata)) {
+		jpeg_destroy_decompress(&cinfo);
+		free(src);
+		return IMAGE_DECODE_ERROR;
+	}
+
+	while (cinfo.output_scanline < cinfo.output_height) {
+		unsigned int y = cinfo.output_scanline;
+		uint8_t *row = row_scaler_row(&scaler, y);
+		jpeg_read_scanlines(&cinfo, &row, 1);
+#ifndef JCS_EXTENSIONS
+		// Spread RGB to RGBA from the end so the row can be expanded in place
+		unsigned int x;
+		for (x = cinfo.output_width; x-- > 0;) {
+			row[x * 4 + 3] = 0xFF;
+			row[x * 4 + 2] = row[x * 3 + 2];
+			row[x * 4 + 1] = row[x * 3 + 1];
+			row[x * 4 + 0] = row[x * 3 + 0];
+		}
+#endif
+		row_scaler_push(&scaler, y, row);
+	}
+	row_scaler_finish(&scaler);
+
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	free(src);
+	return IMAGE_DECODE_OK;
+}
+
+static int png_decode_buffer(const void *buffer, unsigned long size, image_decode_alloc alloc, void *userdata)
+{
+	png_buffer_source src = {buffer, size, 0};
+	return decode_png(png_read_buffer, &src, NULL, alloc, userdata);
+}
+
+static int png_decode_stream(image_stream *stream, image_decode_alloc alloc, void *userdata)
+{
+	return decode_png(png_read_stream, stream, stream->scale, alloc, userdata);
+}
+
+static int jpeg_decode_buffer(const void *buffer, unsigned long size, image_decode_alloc alloc, void *userdata)
+{
+	return decode_jpeg(NULL, buffer, size, NULL, alloc, userdata);
+}
+
+static int jpeg_decode_stream(image_stream *stream, image_decode_alloc alloc, void *userdata)
+{
+	return decode_jpeg(stream, NULL, 0, stream->scale, alloc, userdata);
+}
+
+static uint32_t read_le(const uint8_t *p, int bytes)
+{
+	uint32_t v = 0;
+	while (bytes-- > 0)
+		v = (v << 8) | p[bytes];
+	return v;
+}
+
+/*
+ * Uncompressed 24/32 bpp BGR(A) rows, shared by BMP and TGA. Rows are read one at a time
+ * into a row buffer and swizzled into the destination, bottom-up images from the last row.
+ * 32 bpp images whose alpha is all 0 are made opaque, like stb_image.
+ */
+static int decode_bgr(image_stream *stream, unsigned int w, unsigned int h, unsigned int bpp,
+		      unsigned long row_size, int bottom_up, image_decode_alloc alloc, void *userdata)
+{
+	unsigned int dw, dh, x, y;
+	uint8_t alpha_or = 0;
+	uint8_t *in;
+	row_scaler scaler;
+
+	if (!size_ok(w, h))
+		return IMAGE_DECODE_ERROR;
+	in = malloc(row_size);
+	if (!in)
+		return IMAGE_DECODE_ERROR;
+
+	fit_size(stream->scale, w, h, &dw, &dh);
+	if (!row_scaler_init(&scaler, w, h, dw, dh, stream->scale ? stream->scale->filter : 0, alloc, userdata)) {
+		free(in);
+		return IMAGE_DECODE_ERROR;
+	}
+
+	for (y = 0; y < h; y++) {
+		unsigned int image_y = bottom_up ? h - 1 - y : y;
+		uint8_t *out = row_scaler_row(&scaler, image_y);
+		uint8_t *row = out;
+		const uint8_t *p = in;
+
+		if (image_stream_read(stream, in, row_size) != row_size) {
+			row_scaler_free(&scaler);
+			free(in);
+			return IMAGE_DECODE_ERROR;
+		}
+
+		if (bpp == 32) {
+			for (x = 0; x < w; x++, p += 4, row += 4) {
+				row[0] = p[2];
+				row[1] = p[1];
+				row[2] = p[0];
+				row[3] = p[3];
+				alpha_or |= p[3];
+			}
+		} else {
+			for (x = 0; x < w; x++, p += 3, row += 4) {
+				row[0] = p[2];
+				row[1] = p[1];
+				row[2] = p[0];
+				row[3] = 0xFF;
+			}
+		}
+		row_scaler_push(&scaler, image_y, out);
+	}
+	row_scaler_finish(&scaler);
+	free(in);
+
+	if (bpp == 32 && alpha_or == 0) {
+		for (y = 0; y < dh; y++) {
+			for (x = 0; x < dw; x++)
+				scaler.dst[y * scaler.stride + x * 4 + 3] = 0xFF;
+		}
+	}
+
+	return IMAGE_DECODE_OK;
+}
+
+static int bmp_decode_stream(image_stream *stream, image_decode_alloc alloc, void *userdata)
+{
+	uint8_t bmp[BMP_FILE_HEADER + BMP_INFO_HEADER];
+
+	if (image_stream_read(stream, bmp, sizeof(bmp)) != sizeof(bmp) || read_le(bmp + 14, 4) < BMP_INFO_HEADER)
+		return IMAGE_DECODE_UNSUPPORTED;
+
+	uint32_t offset = read_le(bmp + 10, 4);
+	int32_t w = (int32_t)read_le(bmp + 18, 4);
+	int32_t h = (int32_t)read_le(bmp + 22, 4);
+	unsigned int bpp = read_le(bmp + 28, 2);
+	uint32_t compression = read_le(bmp + 30, 4);
+
+	// Only BI_RGB truecolor, stb_image handles palettes, bitfields and RLE
+	if (compression != 0 || (bpp != 24 && bpp != 32) || w <= 0 || h == 0 || h == INT32_MIN)
+		return IMAGE_DECODE_UNSUPPORTED;
+	if (offset < sizeof(bmp) || w > IMAGE_DECODE_MAX_DIMENSION)
+		return IMAGE_DECODE_ERROR;
+
+	image_stream_skip(stream, offset - sizeof(bmp));
+
+	// Rows are stored bottom-up unless the height is negative
+	return decode_bgr(stream, w, h < 0 ? -h : h, bpp, ALIGN((unsigned long)w * (bpp / 8), 4), h > 0, alloc, userdata);
+}
+
+static int tga_probe(const uint8_t *header, size_t size)
+{
+	// No color map, uncompressed truecolor, 24/32 bpp, no right-to-left pixels
+	return size >= TGA_HEADER && header[1] == 0 && header[2] == 2 &&
+	       (header[16] == 24 || header[16] == 32) && !(header[17] & 0x10) &&
+	       read_le(header + 12, 2) > 0 && read_le(header + 14, 2) > 0;
+}
+
+static int tga_decode_stream(image_stream *stream, image_decode_alloc alloc, void *userdata)
+{
+	uint8_t tga[TGA_HEADER];
+
+	if (image_stream_read(stream, tga, sizeof(tga)) != sizeof(tga) || !tga_probe(tga, sizeof(tga)))
+		return IMAGE_DECODE_UNSUPPORTED;
+
+	unsigned int w = read_le(tga + 12, 2);
+	unsigned int h = read_le(tga + 14, 2);
+	unsigned int bpp = tga[16];
+	image_stream_skip(stream, tga[0]);
+
+	// Bottom-up unless the descriptor says the origin is at the top
+	return decode_bgr(stream, w, h, bpp, (unsigned long)w * (bpp / 8), !(tga[17] & 0x20), alloc, userdata);
+}
+
+static const uint8_t png_magic[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+static const uint8_t jpeg_magic[] = {0xFF, 0xD8, 0xFF};
+static const uint8_t bmp_magic[] = {'B', 'M'};
+
+static const image_decoder builtin_decoders[] = {
+	{"png", png_magic, sizeof(png_magic), NULL, png_decode_buffer, png_decode_stream},
+	{"jpeg", jpeg_magic, sizeof(jpeg_magic), NULL, jpeg_decode_buffer, jpeg_decode_stream},
+	{"bmp", bmp_magic, sizeof(bmp_magic), NULL, NULL, bmp_decode_stream},
+	{"tga", NULL, 0, tga_probe, NULL, tga_decode_stream},
+};
+
+#define NUM_BUILTIN_DECODERS (sizeof(builtin_decoders) / sizeof(*builtin_decoders))
+
+static const image_decoder *registered_decoders[IMAGE_DECODE_MAX_DECODERS];
+static unsigned int num_registered_decoders;
+static const image_decoder *fallback_decoder;
+// Parallel to the decoder arrays
+static image_decoder_stats registered_stats[IMAGE_DECODE_MAX_DECODERS];
+static image_decoder_stats builtin_stats[NUM_BUILTIN_DECODERS];
+static image_decoder_stats fallback_stats;
+
+typedef struct alloc_tracker {
+	image_decode_alloc alloc;
+	void *userdata;
+	unsigned int w;
+	unsigned int h;
+} alloc_tracker;
+
+static void *tracked_alloc(unsigned int w, unsigned int h, unsigned int *stride, void *userdata)
+{
+	alloc_tracker *tracker = userdata;
+
+	// Also covers registered decoders that don't check the header themselves
+	if (!size_ok(w, h))
+		return NULL;
+	tracker->w = w;
+	tracker->h = h;
+	return tracker->alloc(w, h, stride, tracker->userdata);
+}
+
+// Decoders that allocate more than the fitted size get a temporary buffer instead
+static void *scaled_alloc_fn(unsigned int w, unsigned int h, unsigned int *stride, void *userdata)
+{
+	scaled_alloc *ctx = userdata;
+	unsigned int dw, dh;
+
+	if (!size_ok(w, h))
+		return NULL;
+	fit_size(ctx->scale, w, h, &dw, &dh);
+	if (dw == w && dh == h)
+		return ctx->alloc(w, h, stride, ctx->userdata);
+
+	free(ctx->full);
+	ctx->full = malloc((size_t)w * h * 4);
+	ctx->w = w;
+	ctx->h = h;
+	*stride = w * 4;
+	return ctx->full;
+}
+
+static int scaled_alloc_finish(scaled_alloc *ctx, int ret)
+{
+	unsigned int dw, dh, y;
+	row_scaler scaler;
+
+	if (ctx->full && ret == IMAGE_DECODE_OK) {
+		fit_size(ctx->scale, ctx->w, ctx->h, &dw, &dh);
+		if (row_scaler_init(&scaler, ctx->w, ctx->h, dw, dh, ctx->scale->filter, ctx->alloc, ctx->userdata)) {
+			for (y = 0; y < ctx->h; y++)
+				row_scaler_push(&scaler, y, ctx->full + (size_t)y * ctx->w * 4);
+			row_scaler_finish(&scaler);
+		} else {
+			ret = IMAGE_DECODE_ERROR;
+		}
+	}
+
+	free(ctx->full);
+	ctx->full = NULL;
+	return ret;
+}
+
+static uint64_t time_us(void)
+{
+#ifdef __vita__
+	return sceKernelGetProcessTimeWide();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static const image_decoder *get_decoder(unsigned int index, image_decoder_stats **stats)
+{
+	if (index < num_registered_decoders) {
+		index = num_registered_decoders - 1 - index;
+		*stats = &registered_stats[index];
+		return registered_decoders[index];
+	}
+	index -= num_registered_decoders;
+	if (index < NUM_BUILTIN_DECODERS) {
+		*stats = &builtin_stats[index];
+		return &builtin_decoders[index];
+	}
+	index -= NUM_BUILTIN_DECODERS;
+	if (index == 0 && fallback_decoder) {
+		*stats = &fallback_stats;
+		return fallback_decoder;
+	}
+	return NULL;
+}
+
+static int decoder_matches(const image_decoder *decoder, const uint8_t *header, size_t size)
+{
+	if (decoder == fallback_decoder)
+		return 1;
+	if (decoder->magic)
+		return size >= decoder->magic_size && !memcmp(header, decoder->magic, decoder->magic_size);
+	return decoder->probe && decoder->probe(header, size);
+}
+
+// Loads may run on several threads (see vita2d_load_image_async)
+static void account(image_decoder_stats *stats, int ret, unsigned long size, const alloc_tracker *tracker, uint64_t start)
+{
+	if (ret != IMAGE_DECODE_OK) {
+		__atomic_fetch_add(&stats->failures, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	__atomic_fetch_add(&stats->images, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&stats->bytes_in, size, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&stats->pixels_out, (uint64_t)tracker->w * tracker->h, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&stats->time_us, time_us() - start, __ATOMIC_RELAXED);
+}
+
+int image_decode_register(const image_decoder *decoder)
+{
+	if (num_registered_decoders == IMAGE_DECODE_MAX_DECODERS)
+		return -1;
+	memset(&registered_stats[num_registered_decoders], 0, sizeof(image_decoder_stats));
+	registered_decoders[num_registered_decoders++] = decoder;
+	return 0;
+}
+
+void image_decode_set_fallback(const image_decoder *decoder)
+{
+	fallback_decoder = decoder;
+}
+
+static int memory_io_read(void *user, char *data, int size)
+{
+	memory_io *mem = user;
+
+	if ((size_t)size > mem->size - mem->pos)
+		size = mem->size - mem->pos;
+	memcpy(data, mem->data + mem->pos, size);
+	mem->pos += size;
+	return size;
+}
+
+static void memory_io_skip(void *user, int n)
+{
+	memory_io *mem = user;
+
+	mem->pos = (size_t)n > mem->size - mem->pos ? mem->size : mem->pos + n;
+}
+
+static int memory_io_eof(void *user)
+{
+	memory_io *mem = user;
+	return mem->pos >= mem->size;
+}
+
+static const image_decode_io memory_io_callbacks = {memory_io_read, memory_io_skip, memory_io_eof};
+
+static int file_io_read(void *user, char *data, int size)
+{
+	return fread(data, 1, size, user);
+}
+
+static void file_io_skip(void *user, int n)
+{
+	fseek(user, n, SEEK_CUR);
+}
+
+static int file_io_eof(void *user)
+{
+	return feof((FILE *)user);
+}
+
+static const image_decode_io file_io_callbacks = {file_io_read, file_io_skip, file_io_eof};
+
+// For decoders that only take buffers: the header plus whatever is left in the stream
+static uint8_t *read_stream(image_stream *stream, unsigned long *size)
+{
+	unsigned long capacity = 64 * 1024, used = 0;
+	uint8_t *data = malloc(capacity);
+
+	while (data) {
+		used += image_stream_read(stream, data + used, capacity - used);
+		if (used < capacity)
+			break;
+
+		uint8_t *grown = realloc(data, capacity * 2);
+		if (!grown)
+			free(data);
+		data = grown;
+		capacity *= 2;
+	}
+
+	*size = used;
+	return data;
+}
+
+int image_decode_buffer(const void *buffer, unsigned long size, image_decode_alloc alloc, void *userdata)
+{
+	memory_io mem = {buffer, size, 0};
+	alloc_tracker tracker = {alloc, userdata, 0, 0};
+	const image_decoder *decoder;
+	image_decoder_stats *stats;
+	unsigned int i;
+
+	for (i = 0; (decoder = get_decoder(i, &stats)); i++) {
+		if (!decoder_matches(decoder, buffer, size))
+			continue;
+
+		uint64_t start = time_us();
+		int ret;
+		if (decoder->decode_buffer) {
+			ret = decoder->decode_buffer(buffer, size, tracked_alloc, &tracker);
+		} else {
+			image_stream stream = {&memory_io_callbacks, &mem, {0}, 0, 0, NULL};
+			mem.pos = 0;
+			ret = decoder->decode_stream(&stream, tracked_alloc, &tracker);
+		}
+
+		if (ret != IMAGE_DECODE_UNSUPPORTED) {
+			account(stats, ret, size, &tracker, start);
+			return ret;
+		}
+	}
+
+	return IMAGE_DECODE_UNSUPPORTED;
+}
+
+int image_decode_callbacks_scaled(const image_decode_io *io, void *user, const image_decode_scale *scale,
+				  image_decode_alloc alloc, void *userdata)
+{
+	alloc_tracker tracker = {alloc, userdata, 0, 0};
+	scaled_alloc scaled = {tracked_alloc, &tracker, scale, NULL, 0, 0};
+	image_decode_alloc decoder_alloc = scale ? scaled_alloc_fn : tracked_alloc;
+	void *decoder_userdata = scale ? (void *)&scaled : (void *)&tracker;
+	const image_decoder *decoder;
+	image_decoder_stats *stats;
+	image_stream stream;
+	unsigned int i;
+
+	stream.io = io;
+	stream.user = user;
+	stream.header_size = 0;
+	stream.pos = 0;
+	stream.scale = scale;
+	stream.header_size = image_stream_read(&stream, stream.header, sizeof(stream.header));
+	stream.pos = 0;
+
+	for (i = 0; (decoder = get_decoder(i, &stats)); i++) {
+		if (!decoder_matches(decoder, stream.header, stream.header_size))
+			continue;
+
+		uint64_t start = time_us();
+		int ret;
+		if (decoder->decode_stream) {
+			ret = decoder->decode_stream(&stream, decoder_alloc, decoder_userdata);
+		} else {
+			unsigned long size;
+			uint8_t *data = read_stream(&stream, &size);
+			ret = data ? decoder->decode_buffer(data, size, decoder_alloc, decoder_userdata) : IMAGE_DECODE_ERROR;
+			free(data);
+		}
+		ret = scaled_alloc_finish(&scaled, ret);
+
+		if (ret != IMAGE_DECODE_UNSUPPORTED) {
+			account(stats, ret, stream.pos, &tracker, start);
+			return ret;
+		}
+
+		// The next decoder can only start over if this one stayed within the header
+		if (stream.pos > stream.header_size)
+			return IMAGE_DECODE_ERROR;
+		stream.pos = 0;
+	}
+
+	return IMAGE_DECODE_UNSUPPORTED;
+}
+
+int image_decode_callbacks(const image_decode_io *io, void *user, image_decode_alloc alloc, void *userdata)
+{
+	return image_decode_callbacks_scaled(io, user, NULL, alloc, userdata);
+}
+
+int image_decode_file_scaled(const char *filename, const image_decode_scale *scale, image_decode_alloc alloc, void *userdata)
+{
+	FILE *fp = fopen(filename, "rb");
+	if (!fp)
+		return IMAGE_DECODE_ERROR;
+
+	int ret = image_decode_callbacks_scaled(&file_io_callbacks, fp, scale, alloc, userdata);
+	fclose(fp);
+	return ret;
+}
+
+int image_decode_file(const char *filename, image_decode_alloc alloc, void *userdata)
+{
+	return image_decode_file_scaled(filename, NULL, alloc, userdata);
+}
+
+unsigned int image_decode_get_decoder_count(void)
+{
+	return num_registered_decoders + NUM_BUILTIN_DECODERS + (fallback_decoder ? 1 : 0);
+}
+
+const image_decoder *image_decode_get_decoder(unsigned int index, image_decoder_stats *stats)
+{
+	image_decoder_stats *s;
+	const image_decoder *decoder = get_decoder(index, &s);
+
+	if (decoder && stats)
+		*stats = *s;
+	return decoder;
+}
+
+void image_decode_reset_stats(void)
+{
+	memset(registered_stats, 0, sizeof(registered_stats));
+	memset(builtin_stats, 0, sizeof(builtin_stats));
+	memset(&fallback_stats, 0, sizeof(fallback_stats));
+}
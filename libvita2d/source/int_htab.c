@@ -35,6 +35,7 @@ void int_htab_free(int_htab *htab)
 		if (htab->entries[i].value != NULL)
 			free(htab->entries[i].value);
 	}
+	free(htab->entries);
 	free(htab);
 }
 
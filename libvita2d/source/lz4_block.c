@@ -0,0 +1,179 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lz4_block.h"
+
+#define MIN_MATCH     4
+#define LAST_LITERALS 5  // the block always ends with at least 5 literals
+#define MF_LIMIT      12 // and the last match starts at least 12 bytes before its end
+#define MAX_OFFSET    65535
+#define HASH_LOG      12
+
+static inline uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static inline uint32_t hash4(uint32_t v)
+{
+	return (v * 2654435761u) >> (32 - HASH_LOG);
+}
+
+static uint8_t *write_length(uint8_t *op, size_t len)
+{
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = len;
+	return op;
+}
+
+// match_len 0 writes the last sequence, which only has literals
+static uint8_t *write_sequence(uint8_t *op, const uint8_t *oend, const uint8_t *literals, size_t lit_len,
+			       size_t offset, size_t match_len)
+{
+	size_t ml = match_len ? match_len - MIN_MATCH : 0;
+	uint8_t *token;
+
+	if ((size_t)(oend - op) < 1 + lit_len / 255 + 1 + lit_len + 2 + ml / 255 + 1)
+		return NULL;
+
+	token = op++;
+	*token = (lit_len >= 15 ? 15 : lit_len) << 4;
+	if (lit_len >= 15)
+		op = write_length(op, lit_len - 15);
+	memcpy(op, literals, lit_len);
+	op += lit_len;
+
+	if (match_len) {
+		*op++ = offset;
+		*op++ = offset >> 8;
+		*token |= ml >= 15 ? 15 : ml;
+		if (ml >= 15)
+			op = write_length(op, ml - 15);
+	}
+	return op;
+}
+
+int lz4_block_compress(const void *src, size_t src_size, void *dst, size_t dst_size)
+{
+	const uint8_t *base = src, *ip = base, *anchor = base, *iend = base + src_size;
+	uint8_t *op = dst, *oend = op + dst_size;
+	uint32_t *table;
+
+	if (src_size > 0x7E000000)
+		return -1;
+
+	if (src_size > MF_LIMIT) {
+		const uint8_t *mflimit = iend - MF_LIMIT, *matchlimit = iend - LAST_LITERALS;
+
+		table = calloc(1 << HASH_LOG, sizeof(*table));
+		if (!table)
+			return -1;
+
+		ip++;
+		while (ip <= mflimit) {
+			uint32_t seq = read32(ip), h = hash4(seq);
+			const uint8_t *ref = base + table[h];
+			const uint8_t *mp, *mr;
+
+			table[h] = ip - base;
+			if (ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != seq) {
+				// Skip faster through data that doesn't compress
+				ip += 1 + ((ip - anchor) >> 6);
+				continue;
+			}
+
+			while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+				ip--;
+				ref--;
+			}
+			for (mp = ip + MIN_MATCH, mr = ref + MIN_MATCH; mp < matchlimit && *mp == *mr; mp++, mr++)
+				;
+
+			op = write_sequence(op, oend, anchor, ip - anchor, ip - ref, mp - ip);
+			if (!op) {
+				free(table);
+				return -1;
+			}
+
+			ip = anchor = mp;
+			table[hash4(read32(ip - 2))] = ip - 2 - base;
+		}
+		free(table);
+	}
+
+	op = write_sequence(op, oend, anchor, iend - anchor, 0, 0);
+	if (!op)
+		return -1;
+	return op - (uint8_t *)dst;
+}
+
+static inline int read_length(const uint8_t **ip, const uint8_t *iend, size_t *len)
+{
+	unsigned int b;
+
+	do {
+		if (*ip >= iend)
+			return -1;
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255);
+	return 0;
+}
+
+int lz4_block_decompress(const void *src, size_t src_size, void *dst, size_t dst_size)
+{
+	const uint8_t *ip = src, *iend = ip + src_size;
+	uint8_t *op = dst, *oend = op + dst_size;
+
+	for (;;) {
+		const uint8_t *match;
+		unsigned int token;
+		size_t len, offset;
+
+		if (ip >= iend)
+			return -1;
+		token = *ip++;
+
+		len = token >> 4;
+		if (len == 15 && read_length(&ip, iend, &len) < 0)
+			return -1;
+		if (len > (size_t)(iend - ip) || len > (size_t)(oend - op))
+			return -1;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+
+		if (ip == iend)
+			break;
+
+		if (iend - ip < 2)
+			return -1;
+		offset = ip[0] | ip[1] << 8;
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - (uint8_t *)dst))
+			return -1;
+
+		len = token & 15;
+		if (len == 15 && read_length(&ip, iend, &len) < 0)
+			return -1;
+		len += MIN_MATCH;
+		if (len > (size_t)(oend - op))
+			return -1;
+
+		// Matches may overlap their own output, 8 bytes at a time only when they don't
+		match = op - offset;
+		if (offset >= 8) {
+			for (; len >= 8; len -= 8, op += 8, match += 8)
+				memcpy(op, match, 8);
+		}
+		while (len--)
+			*op++ = *match++;
+	}
+
+	return op - (uint8_t *)dst;
+}
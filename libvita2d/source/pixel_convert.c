@@ -0,0 +1,462 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pixel_convert.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PC_USE_NEON
+#endif
+
+/* Pixels converted per step when going through the RGBA8 intermediate */
+#define CHUNK_PIXELS 64
+
+uint32_t bpp_from_format(SceGxmTextureFormat format)
+{
+	// P4 packs two texels per byte, callers deal with it through the stride
+	if ((format & SCE_GXM_TEXTURE_BASE_FORMAT_MASK) == SCE_GXM_TEXTURE_BASE_FORMAT_P8 ||
+	    (format & SCE_GXM_TEXTURE_BASE_FORMAT_MASK) == SCE_GXM_TEXTURE_BASE_FORMAT_P4)
+		return 1;
+
+	switch (format) {
+	case SCE_GXM_TEXTURE_FORMAT_U8_R:
+		return 1;
+	case SCE_GXM_TEXTURE_FORMAT_U5U6U5_RGB:
+	case SCE_GXM_TEXTURE_FORMAT_U4U4U4U4_RGBA:
+	case SCE_GXM_TEXTURE_FORMAT_U5U5U5U1_RGBA:
+		return 2;
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8_RGB:
+		return 3;
+	default:
+		return 4;
+	}
+}
+
+int pixel_convert_supported(SceGxmTextureFormat format)
+{
+	switch (format) {
+	case SCE_GXM_TEXTURE_FORMAT_U8_R:
+	case SCE_GXM_TEXTURE_FORMAT_U5U6U5_RGB:
+	case SCE_GXM_TEXTURE_FORMAT_U4U4U4U4_RGBA:
+	case SCE_GXM_TEXTURE_FORMAT_U5U5U5U1_RGBA:
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8_RGB:
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ARGB:
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_RGBA:
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Rows are accessed bytewise: callers pass arbitrary strides, so 16 and
+ * 32-bit pixels aren't guaranteed to be aligned.
+ */
+static inline uint32_t read16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static inline void write16(uint8_t *p, uint32_t v)
+{
+	p[0] = v & 0xFF;
+	p[1] = v >> 8;
+}
+
+static inline uint8_t expand4(uint32_t v)
+{
+	return (v << 4) | v;
+}
+
+static inline uint8_t expand5(uint32_t v)
+{
+	return (v << 3) | (v >> 2);
+}
+
+static inline uint8_t expand6(uint32_t v)
+{
+	return (v << 2) | (v >> 4);
+}
+
+/* Any supported format to R, G, B, A bytes (U8U8U8U8_ABGR) */
+static void unpack_row(uint8_t *dst, const uint8_t *src, SceGxmTextureFormat format, unsigned int n)
+{
+	unsigned int i;
+	uint32_t p;
+
+	switch (format) {
+	case SCE_GXM_TEXTURE_FORMAT_U8_R:
+		for (i = 0; i < n; i++, dst += 4) {
+			dst[0] = dst[1] = dst[2] = src[i];
+			dst[3] = 0xFF;
+		}
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_U5U6U5_RGB:
+		for (i = 0; i < n; i++, src += 2, dst += 4) {
+			p = read16(src);
+			dst[0] = expand5(p >> 11);
+			dst[1] = expand6((p >> 5) & 0x3F);
+			dst[2] = expand5(p & 0x1F);
+			dst[3] = 0xFF;
+		}
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_U4U4U4U4_RGBA:
+		for (i = 0; i < n; i++, src += 2, dst += 4) {
+			p = read16(src);
+			dst[0] = expand4(p >> 12);
+			dst[1] = expand4((p >> 8) & 0xF);
+			dst[2] = expand4((p >> 4) & 0xF);
+			dst[3] = expand4(p & 0xF);
+		}
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_U5U5U5U1_RGBA:
+		for (i = 0; i < n; i++, src += 2, dst += 4) {
+			p = read16(src);
+			dst[0] = expand5(p >> 11);
+			dst[1] = expand5((p >> 6) & 0x1F);
+			dst[2] = expand5((p >> 1) & 0x1F);
+			dst[3] = (p & 1) ? 0xFF : 0;
+		}
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8_RGB:
+		for (i = 0; i < n; i++, src += 3, dst += 4) {
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+			dst[3] = 0xFF;
+		}
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ARGB:
+		for (i = 0; i < n; i++, src += 4, dst += 4) {
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+			dst[3] = src[3];
+		}
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_RGBA:
+		for (i = 0; i < n; i++, src += 4, dst += 4) {
+			dst[0] = src[3];
+			dst[1] = src[2];
+			dst[2] = src[1];
+			dst[3] = src[0];
+		}
+		break;
+	default:
+		memcpy(dst, src, n * 4);
+		break;
+	}
+}
+
+/* R, G, B, A bytes to any supported format */
+static void pack_row(uint8_t *dst, const uint8_t *src, SceGxmTextureFormat format, unsigned int n)
+{
+	unsigned int i = 0;
+
+	switch (format) {
+	case SCE_GXM_TEXTURE_FORMAT_U8_R:
+#ifdef PC_USE_NEON
+		for (; i + 8 <= n; i += 8, src += 32, dst += 8)
+			vst1_u8(dst, vld4_u8(src).val[0]);
+#endif
+		for (; i < n; i++, src += 4)
+			*dst++ = src[0];
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_U5U6U5_RGB:
+#ifdef PC_USE_NEON
+		for (; i + 8 <= n; i += 8, src += 32, dst += 16) {
+			uint8x8x4_t px = vld4_u8(src);
+			uint16x8_t p = vshll_n_u8(px.val[0], 8);
+			p = vsriq_n_u16(p, vshll_n_u8(px.val[1], 8), 5);
+			p = vsriq_n_u16(p, vshll_n_u8(px.val[2], 8), 11);
+			vst1q_u8(dst, vreinterpretq_u8_u16(p));
+		}
+#endif
+		for (; i < n; i++, src += 4, dst += 2)
+			write16(dst, ((src[0] >> 3) << 11) | ((src[1] >> 2) << 5) | (src[2] >> 3));
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_U4U4U4U4_RGBA:
+#ifdef PC_USE_NEON
+		for (; i + 8 <= n; i += 8, src += 32, dst += 16) {
+			uint8x8x4_t px = vld4_u8(src);
+			uint16x8_t p = vshll_n_u8(px.val[0], 8);
+			p = vsriq_n_u16(p, vshll_n_u8(px.val[1], 8), 4);
+			p = vsriq_n_u16(p, vshll_n_u8(px.val[2], 8), 8);
+			p = vsriq_n_u16(p, vshll_n_u8(px.val[3], 8), 12);
+			vst1q_u8(dst, vreinterpretq_u8_u16(p));
+		}
+#endif
+		for (; i < n; i++, src += 4, dst += 2)
+			write16(dst, ((src[0] >> 4) << 12) | ((src[1] >> 4) << 8) |
+				((src[2] >> 4) << 4) | (src[3] >> 4));
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_U5U5U5U1_RGBA:
+#ifdef PC_USE_NEON
+		for (; i + 8 <= n; i += 8, src += 32, dst += 16) {
+			uint8x8x4_t px = vld4_u8(src);
+			uint16x8_t p = vshll_n_u8(px.val[0], 8);
+			p = vsriq_n_u16(p, vshll_n_u8(px.val[1], 8), 5);
+			p = vsriq_n_u16(p, vshll_n_u8(px.val[2], 8), 10);
+			p = vsriq_n_u16(p, vshll_n_u8(px.val[3], 8), 15);
+			vst1q_u8(dst, vreinterpretq_u8_u16(p));
+		}
+#endif
+		for (; i < n; i++, src += 4, dst += 2)
+			write16(dst, ((src[0] >> 3) << 11) | ((src[1] >> 3) << 6) |
+				((src[2] >> 3) << 1) | (src[3] >> 7));
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8_RGB:
+#ifdef PC_USE_NEON
+		for (; i + 8 <= n; i += 8, src += 32, dst += 24) {
+			uint8x8x4_t px = vld4_u8(src);
+			uint8x8x3_t out = {{px.val[2], px.val[1], px.val[0]}};
+			vst3_u8(dst, out);
+		}
+#endif
+		for (; i < n; i++, src += 4, dst += 3) {
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+		}
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ARGB:
+#ifdef PC_USE_NEON
+		for (; i + 8 <= n; i += 8, src += 32, dst += 32) {
+			uint8x8x4_t px = vld4_u8(src);
+			uint8x8x4_t out = {{px.val[2], px.val[1], px.val[0], px.val[3]}};
+			vst4_u8(dst, out);
+		}
+#endif
+		for (; i < n; i++, src += 4, dst += 4) {
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+			dst[3] = src[3];
+		}
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_RGBA:
+#ifdef PC_USE_NEON
+		for (; i + 8 <= n; i += 8, src += 32, dst += 32) {
+			uint8x8x4_t px = vld4_u8(src);
+			uint8x8x4_t out = {{px.val[3], px.val[2], px.val[1], px.val[0]}};
+			vst4_u8(dst, out);
+		}
+#endif
+		for (; i < n; i++, src += 4, dst += 4) {
+			dst[0] = src[3];
+			dst[1] = src[2];
+			dst[2] = src[1];
+			dst[3] = src[0];
+		}
+		break;
+	default:
+		memcpy(dst, src, n * 4);
+		break;
+	}
+}
+
+void pixel_convert_row(void *dst, SceGxmTextureFormat dst_format,
+		       const void *src, SceGxmTextureFormat src_format,
+		       unsigned int n)
+{
+	uint8_t tmp[CHUNK_PIXELS * 4];
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+
+	if (dst_format == src_format) {
+		memcpy(dst, src, n * bpp_from_format(dst_format));
+		return;
+	}
+
+	if (src_format == SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR) {
+		pack_row(d, s, dst_format, n);
+		return;
+	}
+
+	if (dst_format == SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR) {
+		unpack_row(d, s, src_format, n);
+		return;
+	}
+
+	while (n > 0) {
+		unsigned int chunk = n < CHUNK_PIXELS ? n : CHUNK_PIXELS;
+		unpack_row(tmp, s, src_format, chunk);
+		pack_row(d, tmp, dst_format, chunk);
+		s += chunk * bpp_from_format(src_format);
+		d += chunk * bpp_from_format(dst_format);
+		n -= chunk;
+	}
+}
+
+static const uint8_t bayer4x4[4][4] = {
+	{ 0,  8,  2, 10},
+	{12,  4, 14,  6},
+	{ 3, 11,  1,  9},
+	{15,  7, 13,  5}
+};
+
+/* Bits kept per R, G, B, A channel; 8 means the channel isn't dithered */
+static int channel_bits(SceGxmTextureFormat format, int bits[4])
+{
+	switch (format) {
+	case SCE_GXM_TEXTURE_FORMAT_U5U6U5_RGB:
+		bits[0] = 5; bits[1] = 6; bits[2] = 5; bits[3] = 8;
+		return 1;
+	case SCE_GXM_TEXTURE_FORMAT_U4U4U4U4_RGBA:
+		bits[0] = 4; bits[1] = 4; bits[2] = 4; bits[3] = 4;
+		return 1;
+	case SCE_GXM_TEXTURE_FORMAT_U5U5U5U1_RGBA:
+		/* Dithering 1-bit alpha only adds noise to edges */
+		bits[0] = 5; bits[1] = 5; bits[2] = 5; bits[3] = 8;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * The packers truncate, so adding a threshold in [0, step) before packing
+ * turns truncation into ordered dithering. The pattern repeats every 4
+ * pixels, so one 16-byte threshold vector covers a whole row.
+ */
+static void dither_ordered_row(uint8_t *row, unsigned int n, unsigned int y, const int bits[4])
+{
+	uint8_t threshold[16];
+	unsigned int i, c;
+
+	for (i = 0; i < 4; i++) {
+		for (c = 0; c < 4; c++)
+			threshold[i * 4 + c] = (bayer4x4[y & 3][i] << (8 - bits[c])) >> 4;
+	}
+
+	i = 0;
+#ifdef PC_USE_NEON
+	uint8x16_t t = vld1q_u8(threshold);
+	for (; i + 4 <= n; i += 4, row += 16)
+		vst1q_u8(row, vqaddq_u8(vld1q_u8(row), t));
+#endif
+	for (; i < n; i++) {
+		for (c = 0; c < 4; c++, row++) {
+			unsigned int v = *row + threshold[(i & 3) * 4 + c];
+			*row = v > 0xFF ? 0xFF : v;
+		}
+	}
+}
+
+/* Floyd-Steinberg; errors are kept in 1/16ths, indexed from x = -1 */
+static void dither_error_diffusion_row(uint8_t *row, unsigned int n, const int bits[4],
+				       int16_t *cur, int16_t *next)
+{
+	unsigned int x, c;
+
+	memset(next, 0, (n + 2) * 4 * sizeof(*next));
+
+	for (x = 0; x < n; x++) {
+		for (c = 0; c < 4; c++) {
+			if (bits[c] == 8)
+				continue;
+
+			int shift = 8 - bits[c];
+			int v = row[x * 4 + c] + cur[(x + 1) * 4 + c] / 16;
+			v = v < 0 ? 0 : (v > 0xFF ? 0xFF : v);
+
+			int q = v >> shift;
+			int recon = (q << shift) | ((q << shift) >> bits[c]);
+			int err = v - recon;
+
+			row[x * 4 + c] = q << shift;
+			cur[(x + 2) * 4 + c] += err * 7;
+			next[x * 4 + c] += err * 3;
+			next[(x + 1) * 4 + c] += err * 5;
+			next[(x + 2) * 4 + c] += err;
+		}
+	}
+}
+
+int pixel_convert_image_dither(void *dst, unsigned int dst_stride, SceGxmTextureFormat dst_format,
+			       const void *src, unsigned int src_stride,
+			       unsigned int w, unsigned int h, vita2d_dither_mode mode)
+{
+	int bits[4];
+	unsigned int y;
+	uint8_t *row = NULL;
+	int16_t *errors = NULL;
+
+	if (mode == VITA2D_DITHER_NONE || !channel_bits(dst_format, bits)) {
+		for (y = 0; y < h; y++) {
+			pixel_convert_row((uint8_t *)dst + y * dst_stride, dst_format,
+				(const uint8_t *)src + y * src_stride, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR, w);
+		}
+		return 0;
+	}
+
+	row = malloc(w * 4);
+	if (mode == VITA2D_DITHER_ERROR_DIFFUSION)
+		errors = calloc(2 * (w + 2) * 4, sizeof(*errors));
+	if (!row || (mode == VITA2D_DITHER_ERROR_DIFFUSION && !errors)) {
+		free(row);
+		free(errors);
+		return -1;
+	}
+
+	for (y = 0; y < h; y++) {
+		memcpy(row, (const uint8_t *)src + y * src_stride, w * 4);
+
+		if (mode == VITA2D_DITHER_ORDERED) {
+			dither_ordered_row(row, w, y, bits);
+		} else {
+			int16_t *cur = errors + (y & 1) * (w + 2) * 4;
+			int16_t *next = errors + ((y + 1) & 1) * (w + 2) * 4;
+			dither_error_diffusion_row(row, w, bits, cur, next);
+		}
+
+		pack_row((uint8_t *)dst + y * dst_stride, row, dst_format, w);
+	}
+
+	free(row);
+	free(errors);
+	return 0;
+}
+
+void pixel_downsample_box(void *dst, unsigned int dst_stride, const void *src, unsigned int src_stride,
+			  unsigned int src_w, unsigned int src_h)
+{
+	unsigned int dst_w = src_w > 1 ? src_w / 2 : 1;
+	unsigned int dst_h = src_h > 1 ? src_h / 2 : 1;
+	unsigned int x, y, c;
+
+	for (y = 0; y < dst_h; y++) {
+		const uint8_t *row0 = (const uint8_t *)src + (y * 2) * src_stride;
+		const uint8_t *row1 = src_h > 1 ? row0 + src_stride : row0;
+		uint8_t *d = (uint8_t *)dst + y * dst_stride;
+
+		// 1 texel wide levels average vertically only
+		if (src_w == 1) {
+			for (c = 0; c < 4; c++)
+				d[c] = (row0[c] + row1[c] + 1) >> 1;
+			continue;
+		}
+
+		x = 0;
+#ifdef PC_USE_NEON
+		for (; x + 4 <= dst_w; x += 4) {
+			// Even texels in val[0], odd ones in val[1]
+			uint32x4x2_t a = vld2q_u32((const uint32_t *)(row0 + x * 8));
+			uint32x4x2_t b = vld2q_u32((const uint32_t *)(row1 + x * 8));
+			uint8x16_t a0 = vreinterpretq_u8_u32(a.val[0]), a1 = vreinterpretq_u8_u32(a.val[1]);
+			uint8x16_t b0 = vreinterpretq_u8_u32(b.val[0]), b1 = vreinterpretq_u8_u32(b.val[1]);
+			uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(a0), vget_low_u8(a1)),
+						  vaddl_u8(vget_low_u8(b0), vget_low_u8(b1)));
+			uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(a0), vget_high_u8(a1)),
+						  vaddl_u8(vget_high_u8(b0), vget_high_u8(b1)));
+			vst1q_u8(d + x * 4, vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+		}
+#endif
+		for (; x < dst_w; x++) {
+			const uint8_t *p0 = row0 + x * 8;
+			const uint8_t *p1 = row1 + x * 8;
+			for (c = 0; c < 4; c++)
+				d[x * 4 + c] = (p0[c] + p0[c + 4] + p1[c] + p1[c + 4] + 2) >> 2;
+		}
+	}
+}
@@ -28,6 +28,7 @@ texture_atlas *texture_atlas_create(int width, int height, SceGxmTextureFormat f
 	vita2d_texture_set_filters(atlas->texture,
 				   SCE_GXM_TEXTURE_FILTER_POINT,
 				   SCE_GXM_TEXTURE_FILTER_LINEAR);
+	vita2d_texture_set_category(atlas->texture, VITA2D_TEXTURE_CATEGORY_FONT_ATLAS);
 
 	return atlas;
 }
@@ -1,7 +1,138 @@
 #include "utils.h"
+#include <ctype.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+void *read_file(const char *path, unsigned long *size)
+{
+	FILE *fp = fopen(path, "rb");
+	void *data = NULL;
+	long len;
+
+	if (!fp)
+		return NULL;
+
+	if (fseek(fp, 0, SEEK_END) == 0 && (len = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0) {
+		data = malloc(len);
+		if (data && fread(data, 1, len, fp) != (size_t)len) {
+			free(data);
+			data = NULL;
+		}
+		if (data)
+			*size = len;
+	}
+
+	fclose(fp);
+	return data;
+}
+
+char *normalize_path(const char *path)
+{
+	size_t len = strlen(path);
+	char *out = malloc(len + 2);
+	size_t o = 0, root, i = 0;
+	const char *colon = strchr(path, ':');
+
+	if (!out)
+		return NULL;
+
+	// Keep the device, if any, it's the root of the path
+	if (colon && !memchr(path, '/', colon - path) && !memchr(path, '\\', colon - path)) {
+		for (; path + i <= colon; i++)
+			out[o++] = tolower((unsigned char)path[i]);
+		out[o++] = '/';
+	} else if (path[0] == '/' || path[0] == '\\') {
+		out[o++] = '/';
+	}
+	root = o;
+
+	while (path[i]) {
+		size_t start, n;
+
+		while (path[i] == '/' || path[i] == '\\')
+			i++;
+		start = i;
+		while (path[i] && path[i] != '/' && path[i] != '\\')
+			i++;
+		n = i - start;
+
+		if (n == 0 || (n == 1 && path[start] == '.'))
+			continue;
+
+		if (n == 2 && path[start] == '.' && path[start + 1] == '.') {
+			size_t last = o;
+			while (last > root && out[last - 1] != '/')
+				last--;
+			if (o > root && !(o - last == 2 && out[last] == '.' && out[last + 1] == '.')) {
+				// Drop the previous component and its separator
+				o = last > root ? last - 1 : root;
+				continue;
+			}
+			if (root > 0)
+				continue; // above the root is the root
+		}
+
+		if (o > root)
+			out[o++] = '/';
+		for (; start < i; start++)
+			out[o++] = tolower((unsigned char)path[start]);
+	}
+
+	out[o] = '\0';
+	return out;
+}
+
+uint64_t hash_buffer(const void *buffer, size_t size)
+{
+	const uint64_t m = 0xC6A4A7935BD1E995ULL;
+	const int r = 47;
+	const unsigned char *data = buffer;
+	const unsigned char *end = data + (size & ~(size_t)7);
+	uint64_t h = 0x8445D61A4E774912ULL ^ (size * m);
+
+	while (data != end) {
+		uint64_t k;
+		memcpy(&k, data, sizeof(k));
+		data += sizeof(k);
+
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+		h ^= k;
+		h *= m;
+	}
+
+	switch (size & 7) {
+	case 7: h ^= (uint64_t)data[6] << 48; // fallthrough
+	case 6: h ^= (uint64_t)data[5] << 40; // fallthrough
+	case 5: h ^= (uint64_t)data[4] << 32; // fallthrough
+	case 4: h ^= (uint64_t)data[3] << 24; // fallthrough
+	case 3: h ^= (uint64_t)data[2] << 16; // fallthrough
+	case 2: h ^= (uint64_t)data[1] << 8; // fallthrough
+	case 1: h ^= (uint64_t)data[0];
+		h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+	return h;
+}
+
+uint32_t hash_string(const char *str)
+{
+	uint32_t h = 2166136261u;
+
+	while (*str) {
+		h ^= (uint8_t)*str++;
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
 int utf8_to_ucs2(const char *utf8, unsigned int *character)
 {
 	if (((utf8[0] & 0xF0) == 0xE0) && ((utf8[1] & 0xC0) == 0x80) && ((utf8[2] & 0xC0) == 0x80)) {
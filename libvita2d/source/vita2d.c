@@ -1,13 +1,20 @@
 #include <vitasdk.h>
 #include <vitaGL.h>
+#include <sys/stat.h>
 #include "../include/vita2d_vgl.h"
+#include "vita2d_internal.h"
 #include "utils.h"
+#include "pixel_convert.h"
+#include "png_writer.h"
+#include "async_loader.h"
+#include "image_decode.h"
+#include "disk_cache.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-#define SCREEN_W 960
-#define SCREEN_H 544
+// Textured quads drawn with a single call at most, 6 indices each must fit in 16 bits
+#define BATCH_MAX_QUADS 1024
 
 static GLfloat v2d_clear_color[4] = {0.0f, 0.0f, 0.0f, 1.0f};
 static unsigned int v2d_clear_color_u32 = 0xFF000000;
@@ -15,13 +22,240 @@ static GLboolean has_common_dialog = GL_FALSE;
 static GLboolean has_clipping = GL_FALSE;
 static GLint v2d_scissor_region[4] = {0, 0, 960, 544};
 static GLuint v2d_curr_fbo = 0;
+GLuint v2d_bound_fbo = 0; // what start_drawing bound, v2d_curr_fbo only lasts for the call
 static const int v2d_num_circle_segments = 100;
 static vita2d_clear_vertex *v2d_circle_vertices;
 static uint16_t *v2d_circle_indices;
 static GLboolean has_additive_blending = GL_FALSE;
 static GLboolean v2d_inited = GL_FALSE;
+vita2d_draw_stats v2d_stats;
+unsigned int v2d_frame = 1;
+static GLfloat v2d_batch_vtx[BATCH_MAX_QUADS * 8];
+static GLfloat v2d_batch_tcoord[BATCH_MAX_QUADS * 8];
+static uint16_t v2d_batch_indices[BATCH_MAX_QUADS * 6];
+static unsigned int v2d_batch_quads;
+static GLuint v2d_batch_tex;
+static unsigned int v2d_batch_color;
+static vita2d_texture *v2d_live_textures; // every texture not freed yet, newest first
+static size_t v2d_category_bytes[VITA2D_TEXTURE_CATEGORY_COUNT];
+static size_t v2d_category_peak_bytes[VITA2D_TEXTURE_CATEGORY_COUNT];
+static size_t v2d_total_bytes;
+static size_t v2d_peak_total_bytes;
+static GLboolean v2d_frame_started;
+static char *v2d_disk_cache_dir; // NULL when the disk cache is off
+static vita2d_disk_cache_stats v2d_disk_cache_stats;
+
+static inline void _count_draw(unsigned int vertices) {
+	v2d_stats.draw_calls++;
+	v2d_stats.vertices += vertices;
+}
+
+/*
+ * Consecutive textured quads sharing the GL texture and color are drawn with one
+ * call. Anything else that draws, changes GL state or touches a texture submits
+ * the pending quads first.
+ */
+void _flush_batch() {
+	if (v2d_batch_quads == 0)
+		return;
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, v2d_batch_tex);
+	glColor4ubv((GLubyte *)&v2d_batch_color);
+	glVertexPointer(2, GL_FLOAT, 0, v2d_batch_vtx);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glTexCoordPointer(2, GL_FLOAT, 0, v2d_batch_tcoord);
+	if (v2d_batch_quads == 1) {
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		_count_draw(4);
+	} else {
+		glDrawElements(GL_TRIANGLES, v2d_batch_quads * 6, GL_UNSIGNED_SHORT, v2d_batch_indices);
+		_count_draw(v2d_batch_quads * 6);
+	}
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisable(GL_TEXTURE_2D);
+	v2d_stats.texture_binds++;
+	v2d_batch_quads = 0;
+}
+
+void _bind_texture(GLuint tex_id) {
+	_flush_batch();
+	glBindTexture(GL_TEXTURE_2D, tex_id);
+}
+
+static int _gl_format_from_gxm(SceGxmTextureFormat format, GLenum *gl_format, GLenum *gl_type) {
+	switch (format) {
+	case SCE_GXM_TEXTURE_FORMAT_U5U6U5_RGB:
+		*gl_format = GL_RGB;
+		*gl_type = GL_UNSIGNED_SHORT_5_6_5;
+		return 1;
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8_RGB:
+		*gl_format = GL_BGR;
+		*gl_type = GL_UNSIGNED_BYTE;
+		return 1;
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ARGB:
+		*gl_format = GL_BGRA;
+		*gl_type = GL_UNSIGNED_BYTE;
+		return 1;
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_RGBA:
+		*gl_format = GL_ABGR_EXT;
+		*gl_type = GL_UNSIGNED_BYTE;
+		return 1;
+	case SCE_GXM_TEXTURE_FORMAT_U4U4U4U4_RGBA:
+		*gl_format = GL_RGBA;
+		*gl_type = GL_UNSIGNED_SHORT_4_4_4_4;
+		return 1;
+	case SCE_GXM_TEXTURE_FORMAT_U5U5U5U1_RGBA:
+		*gl_format = GL_RGBA;
+		*gl_type = GL_UNSIGNED_SHORT_5_5_5_1;
+		return 1;
+	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR:
+		*gl_format = GL_RGBA;
+		*gl_type = GL_UNSIGNED_BYTE;
+		return 1;
+	case SCE_GXM_TEXTURE_FORMAT_U8_R:
+		*gl_format = GL_RED;
+		*gl_type = GL_UNSIGNED_BYTE;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+vita2d_texture *_alloc_texture() {
+	vita2d_texture *r = (vita2d_texture *)vglMalloc(sizeof(vita2d_texture));
+	if (r) {
+		memset(r, 0, sizeof(vita2d_texture));
+		r->next_live = v2d_live_textures;
+		if (v2d_live_textures)
+			v2d_live_textures->prev_live = r;
+		v2d_live_textures = r;
+	}
+	return r;
+}
+
+void _untrack_texture(vita2d_texture *texture) {
+	v2d_category_bytes[texture->category] -= texture->accounted_bytes;
+	v2d_total_bytes -= texture->accounted_bytes;
+	texture->accounted_bytes = 0;
+
+	if (texture->prev_live)
+		texture->prev_live->next_live = texture->next_live;
+	else
+		v2d_live_textures = texture->next_live;
+	if (texture->next_live)
+		texture->next_live->prev_live = texture->prev_live;
+	texture->prev_live = texture->next_live = NULL;
+}
+
+size_t _texture_bytes(const vita2d_texture *texture) {
+	size_t size;
 
-static void _reset_blending() {
+	switch (texture->format) {
+	case SCE_GXM_TEXTURE_FORMAT_UBC1_ABGR:
+	case SCE_GXM_TEXTURE_FORMAT_ETC1_RGB:
+		size = (size_t)ALIGN(texture->w, 4) * ALIGN(texture->h, 4) / 2;
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_UBC2_ABGR:
+	case SCE_GXM_TEXTURE_FORMAT_UBC3_ABGR:
+		size = (size_t)ALIGN(texture->w, 4) * ALIGN(texture->h, 4);
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_PVRT2BPP_ABGR:
+		size = (size_t)(texture->w < 16 ? 16 : texture->w) * (texture->h < 8 ? 8 : texture->h) / 4;
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_PVRT4BPP_ABGR:
+		size = (size_t)(texture->w < 8 ? 8 : texture->w) * (texture->h < 8 ? 8 : texture->h) / 2;
+		break;
+	default:
+		size = (size_t)vita2d_texture_get_stride(texture) * texture->h;
+		break;
+	}
+
+	// A full chain adds a third of the base level
+	if (texture->mip_levels > 1)
+		size += size / 3;
+	if (texture->palette)
+		size += vita2d_palette_get_entries(texture->palette) * sizeof(unsigned int);
+	return size;
+}
+
+void _account_texture(vita2d_texture *texture) {
+	// Subtextures are part of their page's bytes
+	size_t bytes = texture->parent || (texture->managed && !texture->managed->resident) ? 0 : _texture_bytes(texture);
+
+	v2d_category_bytes[texture->category] += bytes - texture->accounted_bytes;
+	v2d_total_bytes += bytes - texture->accounted_bytes;
+	texture->accounted_bytes = bytes;
+
+	if (v2d_category_bytes[texture->category] > v2d_category_peak_bytes[texture->category])
+		v2d_category_peak_bytes[texture->category] = v2d_category_bytes[texture->category];
+	if (v2d_total_bytes > v2d_peak_total_bytes)
+		v2d_peak_total_bytes = v2d_total_bytes;
+}
+
+/*
+ * Uploads the region touched by vita2d_texture_update_region since the last flush
+ * and drops the staging copy. glTexSubImage2D lets vitaGL move the texture to fresh
+ * storage if draws still in flight reference it, so neither side has to wait.
+ */
+static void _flush_texture(vita2d_texture *texture) {
+	GLenum gl_format, gl_type;
+
+	if (!texture->staging)
+		return;
+
+	if (_gl_format_from_gxm(texture->format, &gl_format, &gl_type)) {
+		_bind_texture(texture->tex_id);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, texture->dirty[0], texture->dirty[1],
+			texture->dirty[2] - texture->dirty[0], texture->dirty[3] - texture->dirty[1],
+			gl_format, gl_type, texture->staging);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	free(texture->staging);
+	texture->staging = NULL;
+	memset(texture->dirty, 0, sizeof(texture->dirty));
+}
+
+static void _draw_texture_quad(const vita2d_texture *texture, const GLfloat *vtx, const GLfloat *tcoord, unsigned int color) {
+	GLfloat sub_tcoord[8];
+
+	if (texture->parent) {
+		// Map the sprite's [0, 1] range to its rectangle in the page
+		int i;
+		for (i = 0; i < 4; i++) {
+			sub_tcoord[i * 2] = texture->uv[0] + tcoord[i * 2] * (texture->uv[2] - texture->uv[0]);
+			sub_tcoord[i * 2 + 1] = texture->uv[1] + tcoord[i * 2 + 1] * (texture->uv[3] - texture->uv[1]);
+		}
+		tcoord = sub_tcoord;
+		((vita2d_texture *)texture)->last_frame = v2d_frame;
+		texture = texture->parent;
+	}
+
+	if (texture->managed) {
+		if (texture->managed->resident)
+			v2d_cache_stats.hits++;
+		else
+			v2d_cache_stats.misses++;
+		if (!_make_resident((vita2d_texture *)texture))
+			return;
+	}
+	_flush_texture((vita2d_texture *)texture);
+
+	if (v2d_batch_quads == BATCH_MAX_QUADS ||
+	    (v2d_batch_quads > 0 && (texture->tex_id != v2d_batch_tex || color != v2d_batch_color)))
+		_flush_batch();
+	memcpy(&v2d_batch_vtx[v2d_batch_quads * 8], vtx, 8 * sizeof(GLfloat));
+	memcpy(&v2d_batch_tcoord[v2d_batch_quads * 8], tcoord, 8 * sizeof(GLfloat));
+	v2d_batch_tex = texture->tex_id;
+	v2d_batch_color = color;
+	v2d_batch_quads++;
+	((vita2d_texture *)texture)->last_frame = v2d_frame;
+}
+
+void _reset_blending() {
+	_flush_batch();
 	glEnable(GL_BLEND);
 	glBlendEquation(GL_FUNC_ADD);
 	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
@@ -37,13 +271,70 @@ void vita2d_set_blend_mode_add(int enable) {
 	_reset_blending();
 }
 
+static int _stb_copy(uint8_t *data, int w, int h, image_decode_alloc alloc, void *userdata) {
+	int y;
+	unsigned int stride;
+	if (!data)
+		return IMAGE_DECODE_UNSUPPORTED;
+
+	uint8_t *dst = alloc(w, h, &stride, userdata);
+	if (dst) {
+		for (y = 0; y < h; y++)
+			memcpy(dst + y * stride, data + y * w * 4, w * 4);
+	}
+	stbi_image_free(data);
+	return dst ? IMAGE_DECODE_OK : IMAGE_DECODE_ERROR;
+}
+
+// Fallback of the decoder registry, for everything the other decoders don't handle
+static int _stb_decode_buffer(const void *buffer, unsigned long size, image_decode_alloc alloc, void *userdata) {
+	int w, h;
+	uint8_t *data = stbi_load_from_memory(buffer, size, &w, &h, NULL, 4);
+	return _stb_copy(data, w, h, alloc, userdata);
+}
+
+static int _stb_read(void *user, char *data, int size) {
+	return image_stream_read(user, data, size);
+}
+
+static void _stb_skip(void *user, int n) {
+	if (n > 0)
+		image_stream_skip(user, n);
+}
+
+static int _stb_eof(void *user) {
+	return image_stream_eof(user);
+}
+
+static int _stb_decode_stream(image_stream *stream, image_decode_alloc alloc, void *userdata) {
+	const stbi_io_callbacks io = {_stb_read, _stb_skip, _stb_eof};
+	int w, h;
+	uint8_t *data = stbi_load_from_callbacks(&io, stream, &w, &h, NULL, 4);
+	return _stb_copy(data, w, h, alloc, userdata);
+}
+
+static const image_decoder v2d_stb_decoder = {"stb_image", NULL, 0, NULL, _stb_decode_buffer, _stb_decode_stream};
+
 int vita2d_init() {
+	unsigned int i;
+
 	if (v2d_inited)
 		return 0;
 	v2d_circle_vertices = (vita2d_clear_vertex *)vglMalloc((v2d_num_circle_segments + 1) * sizeof(vita2d_clear_vertex));
 	v2d_circle_indices = (uint16_t *)vglMalloc((v2d_num_circle_segments + 2) * sizeof(uint16_t));
-	
+
+	// Batched quad i is vertices 4i to 4i + 3 in triangle strip order
+	for (i = 0; i < BATCH_MAX_QUADS; i++) {
+		v2d_batch_indices[i * 6 + 0] = i * 4;
+		v2d_batch_indices[i * 6 + 1] = i * 4 + 1;
+		v2d_batch_indices[i * 6 + 2] = i * 4 + 2;
+		v2d_batch_indices[i * 6 + 3] = i * 4 + 2;
+		v2d_batch_indices[i * 6 + 4] = i * 4 + 1;
+		v2d_batch_indices[i * 6 + 5] = i * 4 + 3;
+	}
+
 	sceSysmoduleLoadModule(SCE_SYSMODULE_PGF);
+	image_decode_set_fallback(&v2d_stb_decoder);
 
 	v2d_inited = GL_TRUE;
 	return 0;
@@ -51,6 +342,9 @@ int vita2d_init() {
 
 int vita2d_fini() {
 	if (v2d_inited) {
+		_readbacks_fini();
+		png_writer_fini();
+		async_loader_fini();
 		vglFree(v2d_circle_vertices);
 		vglFree(v2d_circle_indices);
 		v2d_inited = GL_FALSE;
@@ -59,23 +353,43 @@ int vita2d_fini() {
 }
 
 void vita2d_wait_rendering_done() {
+	_flush_batch();
 	glFinish();
 }
 
 void vita2d_clear_screen() {
+	_flush_batch();
 	glClearColor(v2d_clear_color[0], v2d_clear_color[1], v2d_clear_color[2], v2d_clear_color[3]);
 	glClear(GL_COLOR_BUFFER_BIT);
 }
 
 void vita2d_swap_buffers() {
+	_flush_batch();
+	if (v2d_capturing)
+		_finish_capture();
+	v2d_frame_started = GL_FALSE;
 	vglSwapBuffers(has_common_dialog);
 	has_common_dialog = GL_FALSE;
+	v2d_frame++;
+	_process_readbacks();
+	async_loader_upload();
 }
 
 void vita2d_start_drawing() {
+	GLuint fbo = v2d_curr_fbo;
+
+	if (!fbo) {
+		if (!v2d_frame_started && v2d_capture)
+			v2d_capturing = GL_TRUE;
+		v2d_frame_started = GL_TRUE;
+		if (v2d_capturing)
+			fbo = v2d_capture->fbo;
+	}
+
 	glUseProgram(0);
 	_reset_blending();
-	glBindFramebuffer(GL_FRAMEBUFFER, v2d_curr_fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	v2d_bound_fbo = fbo;
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
 	glOrthof(0, SCREEN_W, SCREEN_H, 0, -1, 1);
@@ -98,15 +412,19 @@ void vita2d_start_drawing() {
 }
 
 void vita2d_start_drawing_advanced(vita2d_texture *target, unsigned int flags) {
+	// Pending updates land before the rendering, not on top of it
+	_flush_texture(target);
 	v2d_curr_fbo = target->fbo;
 	vita2d_start_drawing();
 	v2d_curr_fbo = 0;
 }
 
 void vita2d_end_drawing() {
+	_flush_batch();
 }
 
 int vita2d_common_dialog_update() {
+	_flush_batch();
 	has_common_dialog = GL_TRUE;
 	return 0;
 }
@@ -123,6 +441,14 @@ unsigned int vita2d_get_clear_color() {
 	return v2d_clear_color_u32;
 }
 
+void vita2d_get_draw_stats(vita2d_draw_stats *stats) {
+	*stats = v2d_stats;
+}
+
+void vita2d_reset_draw_stats() {
+	memset(&v2d_stats, 0, sizeof(v2d_stats));
+}
+
 void vita2d_set_vblank_wait(int enable) {
 	vglWaitVblankStart(enable);
 }
@@ -132,7 +458,8 @@ void vita2d_set_clip_rectangle(int x_min, int y_min, int x_max, int y_max) {
 	GLint y = SCREEN_H - y_min;
 	GLint w = x_max - x_min;
 	GLint h = y - (SCREEN_H - y_max);
-	glScissor(x_min, y, x_max, h);
+	_flush_batch();
+	glScissor(x_min, y, w, h);
 	v2d_scissor_region[0] = x_min;
 	v2d_scissor_region[1] = y;
 	v2d_scissor_region[2] = w;
@@ -147,11 +474,13 @@ void vita2d_get_clip_rectangle(int *x_min, int *y_min, int *x_max, int *y_max) {
 }
 
 void vita2d_enable_clipping() {
+	_flush_batch();
 	has_clipping = GL_TRUE;
 	glEnable(GL_SCISSOR_TEST);
 }
 
 void vita2d_disable_clipping() {
+	_flush_batch();
 	has_clipping = GL_FALSE;
 	glDisable(GL_SCISSOR_TEST);
 }
@@ -164,9 +493,11 @@ void vita2d_draw_pixel(float x, float y, unsigned int color) {
 	GLfloat vtx[2] = {
 		x, y
 	};
+	_flush_batch();
 	glColor4ubv((GLubyte *)&color);
 	glVertexPointer(2, GL_FLOAT, 0, vtx);
 	glDrawArrays(GL_POINTS, 0, 1);
+	_count_draw(1);
 }
 
 void vita2d_draw_line(float x0, float y0, float x1, float y1, unsigned int color) {
@@ -174,9 +505,11 @@ void vita2d_draw_line(float x0, float y0, float x1, float y1, unsigned int color
 		x0, y0,
 		x1, y1
 	};
+	_flush_batch();
 	glColor4ubv((GLubyte *)&color);
 	glVertexPointer(2, GL_FLOAT, 0, vtx);
 	glDrawArrays(GL_LINES, 0, 2);
+	_count_draw(2);
 }
 
 void vita2d_draw_rectangle(float x, float y, float w, float h, unsigned int color) {
@@ -186,9 +519,11 @@ void vita2d_draw_rectangle(float x, float y, float w, float h, unsigned int colo
 		x, y + h,
 		x + w, y + h
 	};
+	_flush_batch();
 	glColor4ubv((GLubyte *)&color);
 	glVertexPointer(2, GL_FLOAT, 0, vtx);
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	_count_draw(4);
 }
 
 void vita2d_draw_fill_circle(float x, float y, float radius, unsigned int color) {
@@ -216,61 +551,38 @@ void vita2d_draw_fill_circle(float x, float y, float radius, unsigned int color)
 	}
 
 	v2d_circle_indices[v2d_num_circle_segments + 1] = 1;
-	
+
+	_flush_batch();
 	glColor4ubv((GLubyte *)&color);
 	glVertexPointer(2, GL_FLOAT, 0, v2d_circle_vertices);
 	glDrawElements(GL_TRIANGLE_FAN, v2d_num_circle_segments + 2, GL_UNSIGNED_SHORT, v2d_circle_indices);
-}
-
-uint32_t bpp_from_format(SceGxmTextureFormat format) {
-	switch (format) {
-	case SCE_GXM_TEXTURE_FORMAT_U8_R:
-		return 1;
-	case SCE_GXM_TEXTURE_FORMAT_U5U6U5_RGB:
-	case SCE_GXM_TEXTURE_FORMAT_U4U4U4U4_RGBA:
-	case SCE_GXM_TEXTURE_FORMAT_U5U5U5U1_RGBA:
-		return 2;
-	case SCE_GXM_TEXTURE_FORMAT_U8U8U8_RGB:
-		return 3;
-	default:
-		return 4;
-	}
+	_count_draw(v2d_num_circle_segments + 2);
 }
 
 vita2d_texture *vita2d_create_empty_texture_format(unsigned int w, unsigned int h, SceGxmTextureFormat format) {
-	vita2d_texture *r = (vita2d_texture *)vglMalloc(sizeof(vita2d_texture));
+	GLenum gl_format, gl_type;
+	vita2d_texture *r = _alloc_texture();
 	glGenTextures(1, &r->tex_id);
 	glBindTexture(GL_TEXTURE_2D, r->tex_id);
-	switch (format) {
-	case SCE_GXM_TEXTURE_FORMAT_U5U6U5_RGB:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, NULL);
-		break;
-	case SCE_GXM_TEXTURE_FORMAT_U8U8U8_RGB:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_BGR, w, h, 0, GL_BGR, GL_UNSIGNED_BYTE, NULL);
-		break;
-	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ARGB:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_BGRA, w, h, 0, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
-		break;
-	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_RGBA:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_ABGR_EXT, w, h, 0, GL_ABGR_EXT, GL_UNSIGNED_BYTE, NULL);
-		break;
-	case SCE_GXM_TEXTURE_FORMAT_U4U4U4U4_RGBA:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, NULL);
-		break;
-	case SCE_GXM_TEXTURE_FORMAT_U5U5U5U1_RGBA:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, NULL);
-		break;
-	case SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-		break;
-	case SCE_GXM_TEXTURE_FORMAT_U8_R:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
-		SceGxmTexture *gxm_tex = vglGetGxmTexture(GL_TEXTURE_2D);
-		sceGxmTextureSetFormat(gxm_tex, SCE_GXM_TEXTURE_FORMAT_U8_R111);
-		break;
-	default:
+	if (_is_paletted(format)) {
+		// Allocate the index memory as U8, then describe it to GXM as it really is
+		unsigned int stride = (format & SCE_GXM_TEXTURE_BASE_FORMAT_MASK) == SCE_GXM_TEXTURE_BASE_FORMAT_P4 ? ALIGN(w, 8) / 2 : ALIGN(w, 8);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, stride, h, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+		sceGxmTextureInitLinear(vglGetGxmTexture(GL_TEXTURE_2D), vglGetTexDataPointer(GL_TEXTURE_2D), format, w, h, 0);
+		vita2d_palette *palette = vita2d_create_palette(_palette_entries(format));
+		if (palette) {
+			r->format = format;
+			vita2d_texture_set_palette(r, palette);
+			vita2d_free_palette(palette);
+		}
+	} else if (_gl_format_from_gxm(format, &gl_format, &gl_type)) {
+		glTexImage2D(GL_TEXTURE_2D, 0, gl_format, w, h, 0, gl_format, gl_type, NULL);
+		if (format == SCE_GXM_TEXTURE_FORMAT_U8_R) {
+			SceGxmTexture *gxm_tex = vglGetGxmTexture(GL_TEXTURE_2D);
+			sceGxmTextureSetFormat(gxm_tex, SCE_GXM_TEXTURE_FORMAT_U8_R111);
+		}
+	} else {
 		printf("Invalid format on vita2d_create_empty_texture_format: 0x%08X\n", format);
-		break;
 	}
 	
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -279,6 +591,7 @@ vita2d_texture *vita2d_create_empty_texture_format(unsigned int w, unsigned int
 	r->w = w;
 	r->h = h;
 	r->format = format;
+	_account_texture(r);
 	
 	return r;
 }
@@ -289,14 +602,32 @@ vita2d_texture *vita2d_create_empty_texture(unsigned int w, unsigned int h) {
 
 vita2d_texture *vita2d_create_empty_texture_rendertarget(unsigned int w, unsigned int h, SceGxmTextureFormat format) {
 	vita2d_texture *r = vita2d_create_empty_texture_format(w, h, format);
+	if (!r)
+		return NULL;
+	vita2d_texture_set_category(r, VITA2D_TEXTURE_CATEGORY_RENDER_TARGET);
+	_flush_batch();
 	glGenFramebuffers(1, &r->fbo);
 	glBindFramebuffer(GL_FRAMEBUFFER, r->fbo);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, r->tex_id, 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, v2d_curr_fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, v2d_bound_fbo);
 	return r;
 }
 
 void vita2d_free_texture(vita2d_texture *texture) {
+	if (texture->cached && _texture_cache_release(texture->cached) > 0)
+		return;
+	_untrack_texture(texture);
+	free(texture->tag);
+	if (texture->managed)
+		_managed_texture_free(texture->managed);
+	if (texture->parent) {
+		vglFree(texture);
+		return;
+	}
+	free(texture->staging);
+	if (texture->palette)
+		vita2d_free_palette(texture->palette);
+	_flush_batch();
 	glDeleteFramebuffers(1, &texture->fbo);
 	glDeleteTextures(1, &texture->tex_id);
 	vglFree(texture);
@@ -311,6 +642,8 @@ unsigned int vita2d_texture_get_height(const vita2d_texture *texture) {
 }
 
 unsigned int vita2d_texture_get_stride(const vita2d_texture *texture) {
+	if ((texture->format & SCE_GXM_TEXTURE_BASE_FORMAT_MASK) == SCE_GXM_TEXTURE_BASE_FORMAT_P4)
+		return ALIGN(texture->w, 8) / 2;
 	return ALIGN(texture->w, 8) * bpp_from_format(texture->format);
 }
 
@@ -319,10 +652,116 @@ SceGxmTextureFormat vita2d_texture_get_format(const vita2d_texture *texture) {
 }
 
 void *vita2d_texture_get_datap(const vita2d_texture *texture) {
-	glBindTexture(GL_TEXTURE_2D, texture->tex_id);
+	// A subtexture's texels are a rectangle of its page, not a texture of their own
+	if (texture->parent)
+		return NULL;
+	// The caller may write the returned memory directly, pending updates go first
+	_flush_texture((vita2d_texture *)texture);
+	if (texture->managed && !texture->managed->resident) {
+		v2d_cache_stats.misses++;
+		if (!_make_resident((vita2d_texture *)texture))
+			return NULL;
+	}
+	_bind_texture(texture->tex_id);
 	return vglGetTexDataPointer(GL_TEXTURE_2D);
 }
 
+/*
+ * Makes the staging copy cover x0..x1, y0..y1 (the dirty region grown to fit a
+ * new write, which is given by wx..wx1, wy..wy1 and needs no seeding). What the
+ * pending writes don't cover is seeded from the texture, the whole copy gets uploaded.
+ */
+static int _stage_region(vita2d_texture *texture, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1,
+			 unsigned int wx0, unsigned int wy0, unsigned int wx1, unsigned int wy1) {
+	unsigned int bpp = bpp_from_format(texture->format);
+	unsigned int stride = (x1 - x0) * bpp;
+	unsigned int y;
+	uint8_t *staging = malloc((size_t)stride * (y1 - y0));
+
+	if (!staging)
+		return -1;
+
+	if (x0 != wx0 || y0 != wy0 || x1 != wx1 || y1 != wy1) {
+		glBindTexture(GL_TEXTURE_2D, texture->tex_id);
+		const uint8_t *tex_data = vglGetTexDataPointer(GL_TEXTURE_2D);
+		unsigned int tex_stride = vita2d_texture_get_stride(texture);
+		for (y = y0; y < y1; y++)
+			memcpy(staging + (y - y0) * stride, tex_data + y * tex_stride + x0 * bpp, stride);
+	}
+
+	if (texture->staging) {
+		unsigned int old_stride = (texture->dirty[2] - texture->dirty[0]) * bpp;
+		for (y = texture->dirty[1]; y < texture->dirty[3]; y++)
+			memcpy(staging + (y - y0) * stride + (texture->dirty[0] - x0) * bpp,
+				(uint8_t *)texture->staging + (y - texture->dirty[1]) * old_stride, old_stride);
+		free(texture->staging);
+	}
+
+	texture->staging = staging;
+	texture->dirty[0] = x0;
+	texture->dirty[1] = y0;
+	texture->dirty[2] = x1;
+	texture->dirty[3] = y1;
+	return 0;
+}
+
+int vita2d_texture_update_region(vita2d_texture *texture, unsigned int x, unsigned int y, unsigned int w, unsigned int h, const void *src, unsigned int src_stride, SceGxmTextureFormat src_format) {
+	if (texture->parent || x > texture->w || w > texture->w - x || y > texture->h || h > texture->h - y ||
+	    !pixel_convert_supported(texture->format) || !pixel_convert_supported(src_format))
+		return -1;
+	if (w == 0 || h == 0)
+		return 0;
+
+	unsigned int bpp = bpp_from_format(texture->format);
+	unsigned int x0 = x, y0 = y, x1 = x + w, y1 = y + h;
+	unsigned int i;
+
+	if (texture->staging) {
+		if (x0 >= texture->dirty[0] && y0 >= texture->dirty[1] && x1 <= texture->dirty[2] && y1 <= texture->dirty[3]) {
+			x0 = texture->dirty[0];
+			y0 = texture->dirty[1];
+			x1 = texture->dirty[2];
+			y1 = texture->dirty[3];
+		} else if (texture->fbo) {
+			// Rendering may not have reached the texture memory yet, so it can't seed the copy
+			_flush_texture(texture);
+		} else {
+			if (texture->dirty[0] < x0) x0 = texture->dirty[0];
+			if (texture->dirty[1] < y0) y0 = texture->dirty[1];
+			if (texture->dirty[2] > x1) x1 = texture->dirty[2];
+			if (texture->dirty[3] > y1) y1 = texture->dirty[3];
+		}
+	}
+
+	if (!texture->staging || x0 != texture->dirty[0] || y0 != texture->dirty[1] ||
+	    x1 != texture->dirty[2] || y1 != texture->dirty[3]) {
+		if (_stage_region(texture, x0, y0, x1, y1, x, y, x + w, y + h) < 0)
+			return -1;
+	}
+
+	unsigned int stride = (x1 - x0) * bpp;
+	for (i = 0; i < h; i++) {
+		pixel_convert_row((uint8_t *)texture->staging + (y - y0 + i) * stride + (x - x0) * bpp, texture->format,
+			(const uint8_t *)src + i * src_stride, src_format, w);
+	}
+
+	return 0;
+}
+
+int vita2d_texture_get_dirty_region(const vita2d_texture *texture, unsigned int *x, unsigned int *y, unsigned int *w, unsigned int *h) {
+	if (texture->dirty[0] >= texture->dirty[2])
+		return 0;
+	*x = texture->dirty[0];
+	*y = texture->dirty[1];
+	*w = texture->dirty[2] - texture->dirty[0];
+	*h = texture->dirty[3] - texture->dirty[1];
+	return 1;
+}
+
+void vita2d_texture_flush(vita2d_texture *texture) {
+	_flush_texture(texture);
+}
+
 SceGxmTextureFilter vita2d_texture_get_min_filter(const vita2d_texture *texture) {
 	return texture->filters[0];
 }
@@ -331,12 +770,187 @@ SceGxmTextureFilter vita2d_texture_get_mag_filter(const vita2d_texture *texture)
 	return texture->filters[1];
 }
 
+static GLint _gl_min_filter(const vita2d_texture *texture) {
+	int linear = texture->filters[0] != SCE_GXM_TEXTURE_FILTER_POINT;
+
+	if (texture->mip_levels <= 1)
+		return linear ? GL_LINEAR : GL_NEAREST;
+
+	switch (texture->mip_filter) {
+	case VITA2D_MIP_FILTER_NEAREST:
+		return linear ? GL_LINEAR_MIPMAP_NEAREST : GL_NEAREST_MIPMAP_NEAREST;
+	case VITA2D_MIP_FILTER_LINEAR:
+		return linear ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR;
+	default:
+		return linear ? GL_LINEAR : GL_NEAREST;
+	}
+}
+
 void vita2d_texture_set_filters(vita2d_texture *texture, SceGxmTextureFilter min_filter, SceGxmTextureFilter mag_filter) {
-	glBindTexture(GL_TEXTURE_2D, texture->tex_id);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter == SCE_GXM_TEXTURE_FILTER_POINT ? GL_NEAREST : GL_LINEAR);
+	texture->filters[0] = min_filter;
+	texture->filters[1] = mag_filter;
+	_bind_texture(texture->tex_id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _gl_min_filter(texture));
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter == SCE_GXM_TEXTURE_FILTER_POINT ? GL_NEAREST : GL_LINEAR);
 }
 
+void vita2d_texture_set_mip_filter(vita2d_texture *texture, vita2d_mip_filter mip_filter) {
+	texture->mip_filter = mip_filter;
+	_bind_texture(texture->tex_id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _gl_min_filter(texture));
+}
+
+vita2d_mip_filter vita2d_texture_get_mip_filter(const vita2d_texture *texture) {
+	return texture->mip_filter;
+}
+
+void vita2d_texture_set_tag(vita2d_texture *texture, const char *tag) {
+	free(texture->tag);
+	texture->tag = tag ? strdup(tag) : NULL;
+}
+
+const char *vita2d_texture_get_tag(const vita2d_texture *texture) {
+	return texture->tag;
+}
+
+void vita2d_texture_set_category(vita2d_texture *texture, vita2d_texture_category category) {
+	if (category >= VITA2D_TEXTURE_CATEGORY_COUNT)
+		return;
+
+	v2d_category_bytes[texture->category] -= texture->accounted_bytes;
+	v2d_total_bytes -= texture->accounted_bytes;
+	texture->accounted_bytes = 0;
+	texture->category = category;
+	_account_texture(texture);
+}
+
+int vita2d_get_memory_report(vita2d_memory_report *report) {
+	vita2d_texture *texture;
+	unsigned int i = 0;
+
+	memset(report, 0, sizeof(*report));
+	for (texture = v2d_live_textures; texture; texture = texture->next_live)
+		report->num_textures++;
+
+	if (report->num_textures) {
+		report->entries = malloc(report->num_textures * sizeof(*report->entries));
+		if (!report->entries) {
+			report->num_textures = 0;
+			return -1;
+		}
+	}
+
+	for (texture = v2d_live_textures; texture; texture = texture->next_live, i++) {
+		report->entries[i].texture = texture;
+		report->entries[i].w = texture->w;
+		report->entries[i].h = texture->h;
+		report->entries[i].format = texture->format;
+		report->entries[i].bytes = texture->accounted_bytes;
+		report->entries[i].category = texture->category;
+		report->entries[i].tag = texture->tag;
+	}
+
+	report->total_bytes = v2d_total_bytes;
+	report->peak_total_bytes = v2d_peak_total_bytes;
+	memcpy(report->category_bytes, v2d_category_bytes, sizeof(v2d_category_bytes));
+	memcpy(report->category_peak_bytes, v2d_category_peak_bytes, sizeof(v2d_category_peak_bytes));
+	return 0;
+}
+
+void vita2d_free_memory_report(vita2d_memory_report *report) {
+	free(report->entries);
+	report->entries = NULL;
+	report->num_textures = 0;
+}
+
+static int _compare_report_entries(const void *a, const void *b) {
+	size_t bytes_a = ((const vita2d_memory_report_entry *)a)->bytes;
+	size_t bytes_b = ((const vita2d_memory_report_entry *)b)->bytes;
+	return bytes_a < bytes_b ? 1 : bytes_a > bytes_b ? -1 : 0;
+}
+
+void vita2d_print_memory_report() {
+	static const char *category_names[VITA2D_TEXTURE_CATEGORY_COUNT] = {"user", "font atlas", "render target"};
+	vita2d_memory_report report;
+	unsigned int i;
+
+	if (vita2d_get_memory_report(&report) < 0)
+		return;
+
+	qsort(report.entries, report.num_textures, sizeof(*report.entries), _compare_report_entries);
+
+	printf("vita2d texture memory: %u bytes in %u textures (peak %u)\n",
+	       (unsigned int)report.total_bytes, report.num_textures, (unsigned int)report.peak_total_bytes);
+	for (i = 0; i < VITA2D_TEXTURE_CATEGORY_COUNT; i++) {
+		printf("  %-13s %10u bytes (peak %u)\n", category_names[i],
+		       (unsigned int)report.category_bytes[i], (unsigned int)report.category_peak_bytes[i]);
+	}
+	for (i = 0; i < report.num_textures; i++) {
+		const vita2d_memory_report_entry *e = &report.entries[i];
+		printf("  %10u bytes %4ux%-4u 0x%08X %-13s %s\n", (unsigned int)e->bytes, e->w, e->h,
+		       (unsigned int)e->format, category_names[e->category], e->tag ? e->tag : "-");
+	}
+
+	vita2d_free_memory_report(&report);
+}
+
+int vita2d_texture_generate_mipmaps(vita2d_texture *texture) {
+	GLenum gl_format, gl_type;
+	unsigned int w = texture->w, h = texture->h, levels = 1;
+	const uint8_t *src;
+
+	// Subtextures share their page's mips, and get_datap fails for a managed texture
+	// that can't be reloaded. It also flushes pending updates to the base level.
+	if (texture->parent || _is_paletted(texture->format) || !_gl_format_from_gxm(texture->format, &gl_format, &gl_type))
+		return -1;
+	src = vita2d_texture_get_datap(texture);
+	if (!src)
+		return -1;
+
+	if (texture->format != SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR || texture->fbo) {
+		_bind_texture(texture->tex_id);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		while (w > 1 || h > 1) {
+			w = w > 1 ? w / 2 : 1;
+			h = h > 1 ? h / 2 : 1;
+			levels++;
+		}
+	} else {
+		unsigned int src_stride = vita2d_texture_get_stride(texture);
+		uint8_t *buf = malloc(ALIGN(w, 2) / 2 * ALIGN(h, 2) / 2 * 4);
+		if (!buf)
+			return -1;
+
+		// Each level is built in place from the previous one, which only ever shrinks
+		_bind_texture(texture->tex_id);
+		while (w > 1 || h > 1) {
+			unsigned int dw = w > 1 ? w / 2 : 1;
+			unsigned int dh = h > 1 ? h / 2 : 1;
+			pixel_downsample_box(buf, dw * 4, src, src_stride, w, h);
+			glTexImage2D(GL_TEXTURE_2D, levels, GL_RGBA, dw, dh, 0, GL_RGBA, GL_UNSIGNED_BYTE, buf);
+			src = buf;
+			src_stride = dw * 4;
+			w = dw;
+			h = dh;
+			levels++;
+		}
+		free(buf);
+	}
+
+	texture->mip_levels = levels;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _gl_min_filter(texture));
+	_account_texture(texture);
+
+	if (texture->managed && texture->managed->resident) {
+		texture->managed->want_mipmaps = 1;
+		v2d_cache_stats.resident_bytes -= texture->managed->bytes;
+		texture->managed->bytes = _texture_bytes(texture);
+		v2d_cache_stats.resident_bytes += texture->managed->bytes;
+		_enforce_texture_budget(texture->managed);
+	}
+	return 0;
+}
+
 void vita2d_draw_texture_tint(const vita2d_texture *texture, float x, float y, unsigned int color) {
 	GLfloat vtx[8] = {
 		             x,              y,
@@ -350,15 +964,7 @@ void vita2d_draw_texture_tint(const vita2d_texture *texture, float x, float y, u
 		0, 1,
 		1, 1
 	};
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture->tex_id);
-	glColor4ubv((GLubyte *)&color);
-	glVertexPointer(2, GL_FLOAT, 0, vtx);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-	glTexCoordPointer(2, GL_FLOAT, 0, tcoord);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	glDisable(GL_TEXTURE_2D);
+	_draw_texture_quad(texture, vtx, tcoord, color);
 }
 
 void vita2d_draw_texture(const vita2d_texture *texture, float x, float y) {
@@ -380,15 +986,7 @@ void vita2d_draw_texture_tint_scale(const vita2d_texture *texture, float x, floa
 		0, 1,
 		1, 1
 	};
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture->tex_id);
-	glColor4ubv((GLubyte *)&color);
-	glVertexPointer(2, GL_FLOAT, 0, vtx);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-	glTexCoordPointer(2, GL_FLOAT, 0, tcoord);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	glDisable(GL_TEXTURE_2D);
+	_draw_texture_quad(texture, vtx, tcoord, color);
 }
 
 void vita2d_draw_texture_scale(const vita2d_texture *texture, float x, float y, float x_scale, float y_scale) {
@@ -419,15 +1017,7 @@ void vita2d_draw_texture_tint_rotate_hotspot(const vita2d_texture *texture, floa
 		0, 1,
 		1, 1
 	};
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture->tex_id);
-	glColor4ubv((GLubyte *)&color);
-	glVertexPointer(2, GL_FLOAT, 0, vtx);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-	glTexCoordPointer(2, GL_FLOAT, 0, tcoord);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	glDisable(GL_TEXTURE_2D);
+	_draw_texture_quad(texture, vtx, tcoord, color);
 }
 
 void vita2d_draw_texture_rotate_hotspot(const vita2d_texture *texture, float x, float y, float rad, float center_x, float center_y) {
@@ -457,19 +1047,11 @@ void vita2d_draw_texture_tint_part(const vita2d_texture *texture, float x, float
 	GLfloat th = (tex_y + tex_h) / (float)texture->h;
 	GLfloat tcoord[8] = {
 		tx, ty,
-		tx, ty,
+		tw, ty,
 		tx, th,
 		tw, th
 	};
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture->tex_id);
-	glColor4ubv((GLubyte *)&color);
-	glVertexPointer(2, GL_FLOAT, 0, vtx);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-	glTexCoordPointer(2, GL_FLOAT, 0, tcoord);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	glDisable(GL_TEXTURE_2D);
+	_draw_texture_quad(texture, vtx, tcoord, color);
 }
 
 void vita2d_draw_texture_part(const vita2d_texture *texture, float x, float y, float tex_x, float tex_y, float tex_w, float tex_h) {
@@ -495,15 +1077,7 @@ void vita2d_draw_texture_tint_part_scale(const vita2d_texture *texture, float x,
 		tx, th,
 		tw, th
 	};
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture->tex_id);
-	glColor4ubv((GLubyte *)&color);
-	glVertexPointer(2, GL_FLOAT, 0, vtx);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-	glTexCoordPointer(2, GL_FLOAT, 0, tcoord);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	glDisable(GL_TEXTURE_2D);
+	_draw_texture_quad(texture, vtx, tcoord, color);
 }
 
 void vita2d_draw_texture_part_scale(const vita2d_texture *texture, float x, float y, float tex_x, float tex_y, float tex_w, float tex_h, float x_scale, float y_scale) {
@@ -538,15 +1112,7 @@ void vita2d_draw_texture_tint_scale_rotate_hotspot(const vita2d_texture *texture
 		vtx[i*2+1] = _x*s + _y*c + y;
 	}
 	
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture->tex_id);
-	glColor4ubv((GLubyte *)&color);
-	glVertexPointer(2, GL_FLOAT, 0, vtx);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-	glTexCoordPointer(2, GL_FLOAT, 0, tcoord);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	glDisable(GL_TEXTURE_2D);
+	_draw_texture_quad(texture, vtx, tcoord, color);
 }
 
 void vita2d_draw_texture_scale_rotate_hotspot(const vita2d_texture *texture, float x, float y, float x_scale, float y_scale, float rad, float center_x, float center_y) {
@@ -577,7 +1143,7 @@ void vita2d_draw_texture_part_tint_scale_rotate(const vita2d_texture *texture, f
 	GLfloat th = (tex_y + tex_h) / (float)texture->h;
 	GLfloat tcoord[8] = {
 		tx, ty,
-		tx, ty,
+		tw, ty,
 		tx, th,
 		tw, th
 	};
@@ -591,43 +1157,349 @@ void vita2d_draw_texture_part_tint_scale_rotate(const vita2d_texture *texture, f
 		vtx[i*2+1] = _x*s + _y*c + y;
 	}
 	
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture->tex_id);
-	glColor4ubv((GLubyte *)&color);
-	glVertexPointer(2, GL_FLOAT, 0, vtx);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-	glTexCoordPointer(2, GL_FLOAT, 0, tcoord);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	glDisable(GL_TEXTURE_2D);
+	_draw_texture_quad(texture, vtx, tcoord, color);
 }
 
 void vita2d_draw_texture_part_scale_rotate(const vita2d_texture *texture, float x, float y, float tex_x, float tex_y, float tex_w, float tex_h, float x_scale, float y_scale, float rad) {
 	vita2d_draw_texture_part_tint_scale_rotate(texture, x, y, tex_x, tex_y, tex_w, tex_h, x_scale, y_scale, rad, 0xFFFFFFFF);
 }
 
-vita2d_texture *vita2d_load_PNG_file(const char *filename) {
-	int w, h;
-	uint32_t *data = (uint32_t *)stbi_load(filename, &w, &h, NULL, 4);
-	if (!data)
+static vita2d_texture *_texture_from_rgba(const uint8_t *data, int w, int h, SceGxmTextureFormat format, vita2d_dither_mode dither) {
+	vita2d_texture *r;
+
+	if (format == SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR) {
+		r = _alloc_texture();
+		glGenTextures(1, &r->tex_id);
+		glBindTexture(GL_TEXTURE_2D, r->tex_id);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		r->filters[0] = r->filters[1] = SCE_GXM_TEXTURE_FILTER_POINT;
+		r->w = w;
+		r->h = h;
+		r->format = format;
+		_account_texture(r);
+		return r;
+	}
+
+	if (!pixel_convert_supported(format))
 		return NULL;
 
-	vita2d_texture *r = (vita2d_texture *)vglMalloc(sizeof(vita2d_texture));
-	glGenTextures(1, &r->tex_id);
-	glBindTexture(GL_TEXTURE_2D, r->tex_id);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-	vglFree(data);
-	
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	r->filters[0] = r->filters[1] = SCE_GXM_TEXTURE_FILTER_POINT;
-	r->w = w;
-	r->h = h;
-	r->format = SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR;
-	
+	r = vita2d_create_empty_texture_format(w, h, format);
+	if (!r)
+		return NULL;
+
+	if (pixel_convert_image_dither(vita2d_texture_get_datap(r), vita2d_texture_get_stride(r), format,
+				       data, w * 4, w, h, dither) < 0) {
+		vita2d_free_texture(r);
+		return NULL;
+	}
+
+	return r;
+}
+
+static void *_decode_alloc_texture(unsigned int w, unsigned int h, unsigned int *stride, void *userdata) {
+	vita2d_texture **texture = userdata;
+
+	*texture = vita2d_create_empty_texture(w, h);
+	if (!*texture)
+		return NULL;
+	*stride = vita2d_texture_get_stride(*texture);
+	return vita2d_texture_get_datap(*texture);
+}
+
+static vita2d_texture *_decoded_texture(int ret, vita2d_texture *texture) {
+	if (ret != IMAGE_DECODE_OK && texture) {
+		vita2d_free_texture(texture);
+		return NULL;
+	}
+	return texture;
+}
+
+void *_decode_alloc_rgba(unsigned int w, unsigned int h, unsigned int *stride, void *userdata) {
+	decoded_image *image = userdata;
+
+	// Decoders cap the size, this only guards against ones that don't
+	if (h == 0 || w > SIZE_MAX / 4 / h) {
+		image->pixels = NULL;
+		return NULL;
+	}
+	image->pixels = malloc((size_t)w * h * 4);
+	image->w = w;
+	image->h = h;
+	*stride = w * 4;
+	return image->pixels;
+}
+
+// One of filename, io or buffer
+typedef struct image_source {
+	const char *filename;
+	const image_decode_io *io;
+	void *user;
+	const void *buffer;
+	unsigned long buffer_size;
+	const image_decode_scale *scale; // NULL for full size
+} image_source;
+
+typedef struct memory_reader {
+	const uint8_t *data;
+	unsigned long size;
+	unsigned long pos;
+} memory_reader;
+
+static int _memory_read(void *user, char *data, int size) {
+	memory_reader *reader = user;
+	if ((unsigned long)size > reader->size - reader->pos)
+		size = reader->size - reader->pos;
+	memcpy(data, reader->data + reader->pos, size);
+	reader->pos += size;
+	return size;
+}
+
+static void _memory_skip(void *user, int n) {
+	memory_reader *reader = user;
+	if (n < 0 && (unsigned long)-n > reader->pos)
+		reader->pos = 0;
+	else if (n > 0 && (unsigned long)n > reader->size - reader->pos)
+		reader->pos = reader->size;
+	else
+		reader->pos += n;
+}
+
+static int _memory_eof(void *user) {
+	memory_reader *reader = user;
+	return reader->pos >= reader->size;
+}
+
+static const image_decode_io v2d_memory_io = {_memory_read, _memory_skip, _memory_eof};
+
+static int _decode_source(const image_source *src, image_decode_alloc alloc, void *userdata) {
+	if (src->filename)
+		return image_decode_file_scaled(src->filename, src->scale, alloc, userdata);
+	if (src->io)
+		return image_decode_callbacks_scaled(src->io, src->user, src->scale, alloc, userdata);
+	if (src->scale) {
+		memory_reader reader = {src->buffer, src->buffer_size, 0};
+		return image_decode_callbacks_scaled(&v2d_memory_io, &reader, src->scale, alloc, userdata);
+	}
+	return image_decode_buffer(src->buffer, src->buffer_size, alloc, userdata);
+}
+
+static vita2d_texture *_decode_image(const image_source *src, SceGxmTextureFormat format, vita2d_dither_mode dither) {
+	// RGBA8 images are decoded straight into the texture
+	if (format == SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR) {
+		vita2d_texture *texture = NULL;
+		int ret = _decode_source(src, _decode_alloc_texture, &texture);
+		return _decoded_texture(ret, texture);
+	}
+
+	decoded_image image = {NULL, 0, 0};
+	vita2d_texture *r = NULL;
+	if (_decode_source(src, _decode_alloc_rgba, &image) == IMAGE_DECODE_OK)
+		r = _texture_from_rgba(image.pixels, image.w, image.h, format, dither);
+	free(image.pixels);
+	return r;
+}
+
+static void *_disk_cache_alloc(const disk_cache_header *header, void *userdata) {
+	vita2d_texture **texture = userdata;
+
+	*texture = vita2d_create_empty_texture_format(header->w, header->h, header->key.format);
+	// Another stride means the entry was written by a build that lays textures out differently
+	if (!*texture || vita2d_texture_get_stride(*texture) != header->stride)
+		return NULL;
+	return vita2d_texture_get_datap(*texture);
+}
+
+static vita2d_texture *_load_image_cached(const image_source *src, SceGxmTextureFormat format, vita2d_dither_mode dither) {
+	uint64_t start = sceKernelGetProcessTimeWide();
+	vita2d_texture *r = NULL;
+	disk_cache_header header;
+	disk_cache_key key;
+	char path[512];
+
+	memset(&key, 0, sizeof(key));
+	if (src->filename) {
+		// Files are keyed by where they are and when they changed, so they still stream
+		struct stat st;
+		char *normalized = normalize_path(src->filename);
+		if (!normalized || stat(src->filename, &st) < 0) {
+			free(normalized);
+			return _decode_image(src, format, dither);
+		}
+		key.hash = hash_buffer(normalized, strlen(normalized));
+		key.mtime = st.st_mtime;
+		key.size = st.st_size;
+		free(normalized);
+	} else {
+		key.hash = hash_buffer(src->buffer, src->buffer_size);
+		key.size = src->buffer_size;
+	}
+	key.format = format;
+	key.options[0] = dither;
+	if (src->scale) {
+		key.options[1] = src->scale->max_w;
+		key.options[2] = src->scale->max_h;
+		key.options[3] = src->scale->filter + 1;
+	}
+
+	if (disk_cache_path(v2d_disk_cache_dir, &key, path, sizeof(path)) < 0) {
+		r = _decode_image(src, format, dither);
+	} else if (disk_cache_read(path, &key, _disk_cache_alloc, &r, &header) == 0) {
+		// Both sides include computing the key, the difference is what the entry saved
+		uint64_t load_us = sceKernelGetProcessTimeWide() - start;
+		v2d_disk_cache_stats.hits++;
+		if (header.decode_us > load_us)
+			v2d_disk_cache_stats.time_saved_us += header.decode_us - load_us;
+	} else {
+		if (r)
+			vita2d_free_texture(r);
+		v2d_disk_cache_stats.misses++;
+		r = _decode_image(src, format, dither);
+		if (r && disk_cache_write(path, &key, r->w, r->h, vita2d_texture_get_stride(r),
+					  sceKernelGetProcessTimeWide() - start, vita2d_texture_get_datap(r)) >= 0)
+			v2d_disk_cache_stats.writes++;
+	}
+
+	return r;
+}
+
+static vita2d_texture *_load_image(const image_source *src, SceGxmTextureFormat format, vita2d_dither_mode dither) {
+	vita2d_texture *r;
+
+	// Callback sources can't be hashed before they're decoded
+	if (v2d_disk_cache_dir && !src->io)
+		r = _load_image_cached(src, format, dither);
+	else
+		r = _decode_image(src, format, dither);
+
+	if (r && src->filename)
+		vita2d_texture_set_tag(r, src->filename);
 	return r;
 }
 
+int vita2d_set_disk_cache(const char *dir) {
+	char *copy = NULL;
+	struct stat st;
+
+	if (dir) {
+		mkdir(dir, 0777);
+		if (stat(dir, &st) < 0 || !S_ISDIR(st.st_mode))
+			return -1;
+		copy = strdup(dir);
+		if (!copy)
+			return -1;
+	}
+
+	free(v2d_disk_cache_dir);
+	v2d_disk_cache_dir = copy;
+	return 0;
+}
+
+void vita2d_get_disk_cache_stats(vita2d_disk_cache_stats *stats) {
+	*stats = v2d_disk_cache_stats;
+	stats->disk_bytes = 0;
+	stats->entries = 0;
+	if (v2d_disk_cache_dir)
+		stats->disk_bytes = disk_cache_size(v2d_disk_cache_dir, &stats->entries);
+}
+
+void vita2d_reset_disk_cache_stats() {
+	memset(&v2d_disk_cache_stats, 0, sizeof(v2d_disk_cache_stats));
+}
+
+unsigned int vita2d_clear_disk_cache() {
+	return v2d_disk_cache_dir ? disk_cache_clear(v2d_disk_cache_dir) : 0;
+}
+
+int vita2d_register_image_decoder(const vita2d_image_decoder *decoder) {
+	image_decoder *copy = malloc(sizeof(*copy));
+	if (!copy)
+		return -1;
+
+	copy->name = decoder->name;
+	copy->magic = decoder->magic;
+	copy->magic_size = decoder->magic_size;
+	copy->probe = decoder->probe;
+	copy->decode_buffer = decoder->decode;
+	copy->decode_stream = NULL;
+	if (image_decode_register(copy) < 0) {
+		free(copy);
+		return -1;
+	}
+	return 0;
+}
+
+unsigned int vita2d_get_image_decoder_count() {
+	return image_decode_get_decoder_count();
+}
+
+int vita2d_get_image_decoder_stats(unsigned int index, vita2d_image_decoder_stats *stats) {
+	image_decoder_stats s;
+	const image_decoder *decoder = image_decode_get_decoder(index, &s);
+	if (!decoder)
+		return -1;
+
+	stats->name = decoder->name;
+	stats->images = s.images;
+	stats->failures = s.failures;
+	stats->bytes_in = s.bytes_in;
+	stats->pixels_out = s.pixels_out;
+	stats->time_us = s.time_us;
+	return 0;
+}
+
+void vita2d_reset_image_decoder_stats() {
+	image_decode_reset_stats();
+}
+
+vita2d_texture *vita2d_load_PNG_file_format(const char *filename, SceGxmTextureFormat format, vita2d_dither_mode dither) {
+	image_source src = {filename, NULL, NULL, NULL, 0, NULL};
+	return _load_image(&src, format, dither);
+}
+
+vita2d_texture *vita2d_load_PNG_buffer_format(const void *buffer, unsigned long buffer_size, SceGxmTextureFormat format, vita2d_dither_mode dither) {
+	image_source src = {NULL, NULL, NULL, buffer, buffer_size, NULL};
+	return _load_image(&src, format, dither);
+}
+
+vita2d_texture *vita2d_load_image_callbacks_format(const vita2d_io_callbacks *callbacks, void *user, SceGxmTextureFormat format, vita2d_dither_mode dither) {
+	const image_decode_io io = {callbacks->read, callbacks->skip, callbacks->eof};
+	image_source src = {NULL, &io, user, NULL, 0, NULL};
+	return _load_image(&src, format, dither);
+}
+
+vita2d_texture *vita2d_load_image_callbacks(const vita2d_io_callbacks *callbacks, void *user) {
+	return vita2d_load_image_callbacks_format(callbacks, user, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR, VITA2D_DITHER_NONE);
+}
+
+vita2d_texture *vita2d_load_image_scaled(const char *filename, unsigned int max_w, unsigned int max_h, SceGxmTextureFilter filter) {
+	const image_decode_scale scale = {max_w, max_h, filter == SCE_GXM_TEXTURE_FILTER_POINT ? IMAGE_DECODE_FILTER_POINT : IMAGE_DECODE_FILTER_BOX};
+	image_source src = {filename, NULL, NULL, NULL, 0, &scale};
+	return _load_image(&src, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR, VITA2D_DITHER_NONE);
+}
+
+vita2d_texture *vita2d_load_JPEG_file_format(const char *filename, SceGxmTextureFormat format, vita2d_dither_mode dither) {
+	return vita2d_load_PNG_file_format(filename, format, dither);
+}
+
+vita2d_texture *vita2d_load_JPEG_buffer_format(const void *buffer, unsigned long buffer_size, SceGxmTextureFormat format, vita2d_dither_mode dither) {
+	return vita2d_load_PNG_buffer_format(buffer, buffer_size, format, dither);
+}
+
+vita2d_texture *vita2d_load_BMP_file_format(const char *filename, SceGxmTextureFormat format, vita2d_dither_mode dither) {
+	return vita2d_load_PNG_file_format(filename, format, dither);
+}
+
+vita2d_texture *vita2d_load_BMP_buffer_format(const void *buffer, unsigned long buffer_size, SceGxmTextureFormat format, vita2d_dither_mode dither) {
+	return vita2d_load_PNG_buffer_format(buffer, buffer_size, format, dither);
+}
+
+vita2d_texture *vita2d_load_PNG_file(const char *filename) {
+	return vita2d_load_PNG_file_format(filename, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR, VITA2D_DITHER_NONE);
+}
+
 vita2d_texture *vita2d_load_JPEG_file(const char *filename) {
 	return vita2d_load_PNG_file(filename);
 }
@@ -637,25 +1509,7 @@ vita2d_texture *vita2d_load_BMP_file(const char *filename) {
 }
 
 vita2d_texture *vita2d_load_PNG_buffer(const void *buffer, unsigned long buffer_size) {
-	int w, h;
-	uint32_t *data = (uint32_t *)stbi_load_from_memory(buffer, buffer_size, &w, &h, NULL, 4);
-	if (!data)
-		return NULL;
-
-	vita2d_texture *r = (vita2d_texture *)vglMalloc(sizeof(vita2d_texture));
-	glGenTextures(1, &r->tex_id);
-	glBindTexture(GL_TEXTURE_2D, r->tex_id);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-	vglFree(data);
-	
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	r->filters[0] = r->filters[1] = SCE_GXM_TEXTURE_FILTER_POINT;
-	r->w = w;
-	r->h = h;
-	r->format = SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR;
-	
-	return r;
+	return vita2d_load_PNG_buffer_format(buffer, buffer_size, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR, VITA2D_DITHER_NONE);
 }
 
 vita2d_texture *vita2d_load_JPEG_buffer(const void *buffer, unsigned long buffer_size) {
@@ -664,4 +1518,4 @@ vita2d_texture *vita2d_load_JPEG_buffer(const void *buffer, unsigned long buffer
 
 vita2d_texture *vita2d_load_BMP_buffer(const void *buffer, unsigned long buffer_size) {
 	return vita2d_load_PNG_buffer(buffer, buffer_size);
-}
\ No newline at end of file
+}
@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vita2d_vgl.h"
+#include "vita2d_internal.h"
+#include "image_decode.h"
+#include "utils.h"
+#include "stb_image.h"
+
+struct vita2d_animation {
+	vita2d_texture *sheet; // every frame, in a grid of (w + 2) x (h + 2) cells
+	vita2d_subtexture **frames;
+	unsigned int *start; // ms into the loop each frame starts at, num_frames + 1 of them (the last is the duration)
+	unsigned int num_frames;
+};
+
+// Frame delays below this are shown at 100 ms, like browsers do
+#define ANIMATION_MIN_DELAY 20
+#define ANIMATION_MAX_SIZE  4096
+
+// frames: num_frames w x h RGBA8 images back to back, delays in ms (NULL for a still image)
+static vita2d_animation *_create_animation(const uint8_t *frames, const int *delays, unsigned int num_frames, unsigned int w, unsigned int h) {
+	unsigned int cell_w = w + 2, cell_h = h + 2, cols, rows, i;
+
+	if (num_frames == 0 || cell_w > ANIMATION_MAX_SIZE || cell_h > ANIMATION_MAX_SIZE)
+		return NULL;
+
+	// Roughly square sheet, as wide as needed if that's too tall
+	cols = (unsigned int)ceilf(sqrtf(num_frames * (float)cell_h / cell_w));
+	if (cols < 1)
+		cols = 1;
+	if (cols > num_frames)
+		cols = num_frames;
+	if (cols * cell_w > ANIMATION_MAX_SIZE)
+		cols = ANIMATION_MAX_SIZE / cell_w;
+	rows = (num_frames + cols - 1) / cols;
+	if (rows * cell_h > ANIMATION_MAX_SIZE) {
+		cols = ANIMATION_MAX_SIZE / cell_w;
+		rows = (num_frames + cols - 1) / cols;
+		if (rows * cell_h > ANIMATION_MAX_SIZE) {
+			printf("vita2d_load_animation: %u frames of %ux%u don't fit in a texture\n", num_frames, w, h);
+			return NULL;
+		}
+	}
+
+	vita2d_animation *anim = calloc(1, sizeof(*anim));
+	if (!anim)
+		return NULL;
+	anim->frames = calloc(num_frames, sizeof(*anim->frames));
+	anim->start = malloc((num_frames + 1) * sizeof(*anim->start));
+	anim->sheet = anim->frames && anim->start ? vita2d_create_empty_texture(cols * cell_w, rows * cell_h) : NULL;
+	if (!anim->sheet) {
+		vita2d_free_animation(anim);
+		return NULL;
+	}
+
+	uint8_t *data = vita2d_texture_get_datap(anim->sheet);
+	unsigned int stride = vita2d_texture_get_stride(anim->sheet);
+	float sheet_w = cols * cell_w, sheet_h = rows * cell_h;
+	anim->start[0] = 0;
+
+	for (i = 0; i < num_frames; i++) {
+		unsigned int x = (i % cols) * cell_w + 1, y = (i / cols) * cell_h + 1;
+		vita2d_subtexture *frame = _alloc_texture();
+		if (!frame) {
+			vita2d_free_animation(anim);
+			return NULL;
+		}
+
+		_blit_with_ring(data + (y - 1) * stride + (x - 1) * 4, stride, frames + (size_t)i * w * h * 4, w * 4, w, h);
+
+		frame->parent = anim->sheet;
+		frame->tex_id = anim->sheet->tex_id;
+		frame->format = anim->sheet->format;
+		frame->w = w;
+		frame->h = h;
+		frame->filters[0] = anim->sheet->filters[0];
+		frame->filters[1] = anim->sheet->filters[1];
+		frame->uv[0] = x / sheet_w;
+		frame->uv[1] = y / sheet_h;
+		frame->uv[2] = (x + w) / sheet_w;
+		frame->uv[3] = (y + h) / sheet_h;
+		anim->frames[i] = frame;
+		anim->num_frames = i + 1;
+
+		unsigned int delay = delays ? delays[i] : 0;
+		if (delays && delay < ANIMATION_MIN_DELAY)
+			delay = 100;
+		anim->start[i + 1] = anim->start[i] + delay;
+	}
+
+	return anim;
+}
+
+vita2d_animation *vita2d_load_animation_buffer(const void *buffer, unsigned long buffer_size) {
+	static const uint8_t gif_magic[] = {'G', 'I', 'F', '8'};
+	vita2d_animation *anim = NULL;
+
+	if (buffer_size >= sizeof(gif_magic) && !memcmp(buffer, gif_magic, sizeof(gif_magic))) {
+		int *delays = NULL;
+		int w, h, frames;
+		// Frames come out composited (disposal and transparency applied), one full canvas each
+		uint8_t *data = stbi_load_gif_from_memory(buffer, buffer_size, &delays, &w, &h, &frames, NULL, 4);
+		if (data)
+			anim = _create_animation(data, delays, frames, w, h);
+		stbi_image_free(data);
+		free(delays);
+		return anim;
+	}
+
+	// Anything else is a still image
+	decoded_image image = {NULL, 0, 0};
+	if (image_decode_buffer(buffer, buffer_size, _decode_alloc_rgba, &image) == IMAGE_DECODE_OK)
+		anim = _create_animation(image.pixels, NULL, 1, image.w, image.h);
+	free(image.pixels);
+	return anim;
+}
+
+vita2d_animation *vita2d_load_animation(const char *filename) {
+	unsigned long size;
+	void *data = read_file(filename, &size);
+	if (!data)
+		return NULL;
+
+	vita2d_animation *anim = vita2d_load_animation_buffer(data, size);
+	free(data);
+	if (anim)
+		vita2d_texture_set_tag(anim->sheet, filename);
+	return anim;
+}
+
+void vita2d_free_animation(vita2d_animation *anim) {
+	unsigned int i;
+
+	for (i = 0; i < anim->num_frames; i++)
+		vita2d_free_texture(anim->frames[i]);
+	if (anim->sheet)
+		vita2d_free_texture(anim->sheet);
+	free(anim->frames);
+	free(anim->start);
+	free(anim);
+}
+
+unsigned int vita2d_animation_get_frame_count(const vita2d_animation *anim) {
+	return anim->num_frames;
+}
+
+unsigned int vita2d_animation_get_duration(const vita2d_animation *anim) {
+	return anim->start[anim->num_frames];
+}
+
+vita2d_texture *vita2d_animation_get_texture(const vita2d_animation *anim) {
+	return anim->sheet;
+}
+
+vita2d_subtexture *vita2d_animation_get_frame(const vita2d_animation *anim, unsigned int index, unsigned int *delay) {
+	if (index >= anim->num_frames)
+		return NULL;
+	if (delay)
+		*delay = anim->start[index + 1] - anim->start[index];
+	return anim->frames[index];
+}
+
+vita2d_subtexture *vita2d_animation_get_frame_at(const vita2d_animation *anim, unsigned int time) {
+	unsigned int duration = anim->start[anim->num_frames];
+	unsigned int lo = 0, hi = anim->num_frames - 1;
+
+	if (duration == 0)
+		return anim->frames[0];
+	time %= duration;
+
+	// Last frame starting at or before 'time'
+	while (lo < hi) {
+		unsigned int mid = (lo + hi + 1) / 2;
+		if (anim->start[mid] <= time)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return anim->frames[lo];
+}
+
+void vita2d_draw_animation(const vita2d_animation *anim, unsigned int time, float x, float y) {
+	vita2d_draw_texture(vita2d_animation_get_frame_at(anim, time), x, y);
+}
@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include "vita2d_vgl.h"
+#include "asset_pack.h"
+#include "compressed_texture.h"
+#include "gxt.h"
+#include "utils.h"
+
+struct vita2d_asset_pack {
+	const asset_pack_header *header;
+	void *data; // NULL if the pack was opened from the caller's buffer
+};
+
+static vita2d_asset_pack *_open_asset_pack(const void *buffer, unsigned long size, void *data) {
+	const asset_pack_header *header = asset_pack_validate(buffer, size);
+	if (!header)
+		return NULL;
+
+	vita2d_asset_pack *pack = malloc(sizeof(*pack));
+	if (!pack)
+		return NULL;
+	pack->header = header;
+	pack->data = data;
+	return pack;
+}
+
+vita2d_asset_pack *vita2d_open_asset_pack(const char *filename) {
+	unsigned long size;
+	void *data = read_file(filename, &size);
+	if (!data)
+		return NULL;
+
+	vita2d_asset_pack *pack = _open_asset_pack(data, size, data);
+	if (!pack)
+		free(data);
+	return pack;
+}
+
+vita2d_asset_pack *vita2d_open_asset_pack_buffer(const void *buffer, unsigned long buffer_size) {
+	return _open_asset_pack(buffer, buffer_size, NULL);
+}
+
+void vita2d_close_asset_pack(vita2d_asset_pack *pack) {
+	free(pack->data);
+	free(pack);
+}
+
+const void *vita2d_asset_pack_find(const vita2d_asset_pack *pack, const char *name, unsigned long *size) {
+	int index = asset_pack_find(pack->header, name);
+	if (index < 0)
+		return NULL;
+
+	const asset_pack_entry *entry = &asset_pack_entries(pack->header)[index];
+	if (size)
+		*size = entry->size;
+	return (const uint8_t *)pack->header + entry->offset;
+}
+
+unsigned int vita2d_asset_pack_get_count(const vita2d_asset_pack *pack) {
+	return pack->header->num_entries;
+}
+
+const char *vita2d_asset_pack_get_name(const vita2d_asset_pack *pack, unsigned int index) {
+	if (index >= pack->header->num_entries)
+		return NULL;
+	return asset_pack_name(pack->header, &asset_pack_entries(pack->header)[index]);
+}
+
+vita2d_texture *vita2d_asset_pack_load_texture(const vita2d_asset_pack *pack, const char *name) {
+	compressed_texture ct;
+	vita2d_texture *r;
+	unsigned long size;
+	const void *data = vita2d_asset_pack_find(pack, name, &size);
+	if (!data)
+		return NULL;
+
+	// GXT and block compressed textures are uploaded as they are, anything else is decoded
+	if (gxt_get_texture_count(data, size) > 0)
+		r = vita2d_load_GXT_buffer(data, size, 0);
+	else if (compressed_texture_parse(data, size, &ct) == 0)
+		r = vita2d_load_compressed_buffer(data, size);
+	else
+		r = vita2d_load_PNG_buffer(data, size);
+
+	if (r)
+		vita2d_texture_set_tag(r, name);
+	return r;
+}
+
+vita2d_font *vita2d_asset_pack_load_font(const vita2d_asset_pack *pack, const char *name) {
+	unsigned long size;
+	const void *data = vita2d_asset_pack_find(pack, name, &size);
+	return data ? vita2d_load_font_mem(data, size) : NULL;
+}
@@ -0,0 +1,433 @@
+#include <vitasdk.h>
+#include <string.h>
+#include "vita2d_vgl.h"
+#include "async_loader.h"
+#include "image_decode.h"
+
+#define DEFAULT_WORKERS       2
+#define MAX_WORKERS           4
+#define DEFAULT_UPLOAD_BUDGET (1024 * 1024)
+
+struct vita2d_image_request {
+	char *filename;
+	int priority;
+	volatile vita2d_image_status status;
+	int cancelled; // freed while a worker was decoding it
+	uint8_t *pixels;
+	unsigned int w;
+	unsigned int h;
+	unsigned int rows_uploaded;
+	vita2d_texture *texture;
+	struct vita2d_image_request *next;
+};
+
+struct vita2d_image_batch {
+	vita2d_image_request **requests;
+	unsigned int count;
+};
+
+static SceUID workers[MAX_WORKERS];
+static unsigned int num_workers;
+static unsigned int wanted_workers = DEFAULT_WORKERS;
+static SceUID jobs_sema = -1;
+static SceKernelLwMutexWork loader_mutex;
+static int workers_quit;
+// Waiting for a worker, highest priority first
+static vita2d_image_request *pending_head;
+// Decoded, waiting for the render thread
+static vita2d_image_request *decoded_head;
+static vita2d_image_request *decoded_tail;
+// Render thread only
+static vita2d_image_request *uploading;
+static size_t upload_budget = DEFAULT_UPLOAD_BUDGET;
+static vita2d_texture *placeholder;
+
+static void *alloc_pixels(unsigned int w, unsigned int h, unsigned int *stride, void *userdata)
+{
+	vita2d_image_request *req = userdata;
+
+	// Decoders cap the size, this only guards against ones that don't
+	if (h == 0 || w > SIZE_MAX / 4 / h) {
+		req->pixels = NULL;
+		return NULL;
+	}
+	req->pixels = malloc((size_t)w * h * 4);
+	req->w = w;
+	req->h = h;
+	*stride = w * 4;
+	return req->pixels;
+}
+
+static int worker_thread(SceSize args, void *argp)
+{
+	for (;;) {
+		vita2d_image_request *req;
+
+		sceKernelWaitSema(jobs_sema, 1, NULL);
+		sceKernelLockLwMutex(&loader_mutex, 1, NULL);
+		if (workers_quit) {
+			sceKernelUnlockLwMutex(&loader_mutex, 1);
+			break;
+		}
+		req = pending_head;
+		if (req) {
+			pending_head = req->next;
+			req->next = NULL;
+			req->status = VITA2D_IMAGE_DECODING;
+		}
+		sceKernelUnlockLwMutex(&loader_mutex, 1);
+
+		// Cancelled requests leave their semaphore count behind
+		if (!req)
+			continue;
+
+		// Only this worker touches req->pixels until it's queued for upload
+		if (image_decode_file(req->filename, alloc_pixels, req) != IMAGE_DECODE_OK) {
+			free(req->pixels);
+			req->pixels = NULL;
+		}
+
+		sceKernelLockLwMutex(&loader_mutex, 1, NULL);
+		if (req->cancelled) {
+			free(req->pixels);
+			free(req->filename);
+			free(req);
+		} else if (!req->pixels) {
+			req->status = VITA2D_IMAGE_FAILED;
+		} else {
+			req->status = VITA2D_IMAGE_UPLOADING;
+			if (decoded_tail)
+				decoded_tail->next = req;
+			else
+				decoded_head = req;
+			decoded_tail = req;
+		}
+		sceKernelUnlockLwMutex(&loader_mutex, 1);
+	}
+
+	return sceKernelExitDeleteThread(0);
+}
+
+static int start_workers()
+{
+	unsigned int i;
+
+	jobs_sema = sceKernelCreateSema("vita2d_loader_sema", 0, 0, 0x7FFFFFFF, NULL);
+	if (jobs_sema < 0)
+		return -1;
+	sceKernelCreateLwMutex(&loader_mutex, "vita2d_loader_mutex", 0, 0, NULL);
+
+	workers_quit = 0;
+	for (i = 0; i < wanted_workers; i++) {
+		SceUID thid = sceKernelCreateThread("vita2d_loader", worker_thread, 0x10000100 + 16, 0x10000, 0, 0, NULL);
+		if (thid < 0)
+			break;
+		workers[num_workers++] = thid;
+		sceKernelStartThread(thid, 0, NULL);
+	}
+
+	if (num_workers == 0) {
+		sceKernelDeleteLwMutex(&loader_mutex);
+		sceKernelDeleteSema(jobs_sema);
+		jobs_sema = -1;
+		return -1;
+	}
+
+	return 0;
+}
+
+void vita2d_set_image_loader_workers(unsigned int count)
+{
+	if (count < 1)
+		count = 1;
+	if (count > MAX_WORKERS)
+		count = MAX_WORKERS;
+	wanted_workers = count;
+}
+
+void vita2d_set_upload_budget(size_t bytes_per_frame)
+{
+	upload_budget = bytes_per_frame;
+}
+
+void vita2d_set_image_placeholder(vita2d_texture *texture)
+{
+	placeholder = texture;
+}
+
+vita2d_image_request *vita2d_load_image_async(const char *filename, int priority)
+{
+	vita2d_image_request **link;
+
+	if (num_workers == 0 && start_workers() < 0)
+		return NULL;
+
+	vita2d_image_request *req = calloc(1, sizeof(*req));
+	if (!req)
+		return NULL;
+
+	req->filename = strdup(filename);
+	if (!req->filename) {
+		free(req);
+		return NULL;
+	}
+	req->priority = priority;
+	req->status = VITA2D_IMAGE_PENDING;
+
+	// Behind the requests of the same priority, so they're served in order
+	sceKernelLockLwMutex(&loader_mutex, 1, NULL);
+	for (link = &pending_head; *link && (*link)->priority >= priority; link = &(*link)->next)
+		;
+	req->next = *link;
+	*link = req;
+	sceKernelUnlockLwMutex(&loader_mutex, 1);
+	sceKernelSignalSema(jobs_sema, 1);
+
+	return req;
+}
+
+vita2d_image_status vita2d_image_request_get_status(const vita2d_image_request *req)
+{
+	return req->status;
+}
+
+vita2d_texture *vita2d_image_request_get_texture(const vita2d_image_request *req)
+{
+	return req->status == VITA2D_IMAGE_READY && req->texture ? req->texture : placeholder;
+}
+
+vita2d_texture *vita2d_image_request_take_texture(vita2d_image_request *req)
+{
+	vita2d_texture *texture = NULL;
+
+	if (req->status == VITA2D_IMAGE_READY) {
+		texture = req->texture;
+		req->texture = NULL;
+	}
+	return texture;
+}
+
+static void unlink_request(vita2d_image_request **head, vita2d_image_request **tail, vita2d_image_request *req)
+{
+	vita2d_image_request *prev = NULL, *it;
+
+	for (it = *head; it && it != req; it = it->next)
+		prev = it;
+	if (!it)
+		return;
+
+	if (prev)
+		prev->next = req->next;
+	else
+		*head = req->next;
+	if (tail && *tail == req)
+		*tail = prev;
+}
+
+void vita2d_free_image_request(vita2d_image_request *req)
+{
+	// Requests failed by vita2d_fini() outlive the loader
+	if (num_workers == 0)
+		goto free_request;
+
+	sceKernelLockLwMutex(&loader_mutex, 1, NULL);
+	switch (req->status) {
+	case VITA2D_IMAGE_PENDING:
+		unlink_request(&pending_head, NULL, req);
+		break;
+	case VITA2D_IMAGE_DECODING:
+		// The worker frees it once the decode returns
+		req->cancelled = 1;
+		sceKernelUnlockLwMutex(&loader_mutex, 1);
+		return;
+	case VITA2D_IMAGE_UPLOADING:
+		if (req == uploading)
+			uploading = NULL;
+		else
+			unlink_request(&decoded_head, &decoded_tail, req);
+		break;
+	default:
+		break;
+	}
+	sceKernelUnlockLwMutex(&loader_mutex, 1);
+
+free_request:
+	free(req->pixels);
+	if (req->texture)
+		vita2d_free_texture(req->texture);
+	free(req->filename);
+	free(req);
+}
+
+vita2d_image_batch *vita2d_load_image_batch_async(const char * const *filenames, unsigned int count, int priority)
+{
+	unsigned int i;
+
+	vita2d_image_batch *batch = malloc(sizeof(*batch));
+	if (!batch)
+		return NULL;
+
+	batch->requests = calloc(count, sizeof(*batch->requests));
+	if (!batch->requests && count > 0) {
+		free(batch);
+		return NULL;
+	}
+	batch->count = count;
+
+	for (i = 0; i < count; i++) {
+		batch->requests[i] = vita2d_load_image_async(filenames[i], priority);
+		if (!batch->requests[i]) {
+			vita2d_free_image_batch(batch);
+			return NULL;
+		}
+	}
+
+	return batch;
+}
+
+vita2d_image_request *vita2d_image_batch_get_request(const vita2d_image_batch *batch, unsigned int index)
+{
+	return index < batch->count ? batch->requests[index] : NULL;
+}
+
+float vita2d_image_batch_get_progress(const vita2d_image_batch *batch, unsigned int *finished)
+{
+	unsigned int i, done = 0;
+	float progress = 0.0f;
+
+	for (i = 0; i < batch->count; i++) {
+		const vita2d_image_request *req = batch->requests[i];
+		vita2d_image_status status = req->status;
+
+		if (status == VITA2D_IMAGE_READY || status == VITA2D_IMAGE_FAILED) {
+			done++;
+			progress += 1.0f;
+		} else if (status == VITA2D_IMAGE_UPLOADING && req == uploading) {
+			// Decoding is counted as the first half, uploading as the second one
+			progress += 0.5f + 0.5f * req->rows_uploaded / req->h;
+		} else if (status == VITA2D_IMAGE_UPLOADING) {
+			progress += 0.5f;
+		}
+	}
+
+	if (finished)
+		*finished = done;
+	return batch->count > 0 ? progress / batch->count : 1.0f;
+}
+
+void vita2d_free_image_batch(vita2d_image_batch *batch)
+{
+	unsigned int i;
+
+	for (i = 0; i < batch->count; i++) {
+		if (batch->requests[i])
+			vita2d_free_image_request(batch->requests[i]);
+	}
+	free(batch->requests);
+	free(batch);
+}
+
+void async_loader_upload(void)
+{
+	size_t budget = upload_budget;
+
+	if (num_workers == 0)
+		return;
+
+	for (;;) {
+		if (!uploading) {
+			sceKernelLockLwMutex(&loader_mutex, 1, NULL);
+			uploading = decoded_head;
+			if (uploading) {
+				decoded_head = uploading->next;
+				if (!decoded_head)
+					decoded_tail = NULL;
+				uploading->next = NULL;
+			}
+			sceKernelUnlockLwMutex(&loader_mutex, 1);
+			if (!uploading)
+				return;
+		}
+
+		vita2d_image_request *req = uploading;
+		if (!req->texture) {
+			req->texture = vita2d_create_empty_texture(req->w, req->h);
+			if (!req->texture) {
+				free(req->pixels);
+				req->pixels = NULL;
+				req->status = VITA2D_IMAGE_FAILED;
+				uploading = NULL;
+				continue;
+			}
+			vita2d_texture_set_tag(req->texture, req->filename);
+		}
+
+		// Always move at least one row, or a budget below a row would never finish
+		unsigned int row_bytes = req->w * 4;
+		unsigned int rows = req->h - req->rows_uploaded;
+		if (upload_budget > 0 && (size_t)rows * row_bytes > budget)
+			rows = budget / row_bytes > 0 ? budget / row_bytes : 1;
+
+		unsigned int stride = vita2d_texture_get_stride(req->texture);
+		uint8_t *dst = (uint8_t *)vita2d_texture_get_datap(req->texture) + req->rows_uploaded * stride;
+		const uint8_t *src = req->pixels + req->rows_uploaded * row_bytes;
+		unsigned int i;
+		for (i = 0; i < rows; i++)
+			memcpy(dst + i * stride, src + i * row_bytes, row_bytes);
+		req->rows_uploaded += rows;
+
+		if (req->rows_uploaded == req->h) {
+			free(req->pixels);
+			req->pixels = NULL;
+			req->status = VITA2D_IMAGE_READY;
+			uploading = NULL;
+		}
+
+		if (upload_budget > 0) {
+			if ((size_t)rows * row_bytes >= budget)
+				return;
+			budget -= rows * row_bytes;
+		}
+	}
+}
+
+static void fail_request_list(vita2d_image_request *req)
+{
+	while (req) {
+		vita2d_image_request *next = req->next;
+		free(req->pixels);
+		req->pixels = NULL;
+		if (req->texture)
+			vita2d_free_texture(req->texture);
+		req->texture = NULL;
+		req->next = NULL;
+		req->status = VITA2D_IMAGE_FAILED;
+		req = next;
+	}
+}
+
+void async_loader_fini(void)
+{
+	unsigned int i;
+
+	if (num_workers == 0)
+		return;
+
+	sceKernelLockLwMutex(&loader_mutex, 1, NULL);
+	workers_quit = 1;
+	sceKernelUnlockLwMutex(&loader_mutex, 1);
+	sceKernelSignalSema(jobs_sema, num_workers);
+	for (i = 0; i < num_workers; i++)
+		sceKernelWaitThreadEnd(workers[i], NULL, NULL);
+	num_workers = 0;
+
+	// The application still owns the requests, they just fail
+	fail_request_list(pending_head);
+	fail_request_list(decoded_head);
+	fail_request_list(uploading);
+	pending_head = decoded_head = decoded_tail = uploading = NULL;
+
+	sceKernelDeleteLwMutex(&loader_mutex);
+	sceKernelDeleteSema(jobs_sema);
+	jobs_sema = -1;
+}
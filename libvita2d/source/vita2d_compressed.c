@@ -0,0 +1,214 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vita2d_vgl.h"
+#include "vita2d_internal.h"
+#include "compressed_texture.h"
+#include "gxt.h"
+#include "utils.h"
+
+static int _gl_format_from_compressed(compressed_texture_format format, GLenum *gl_format, SceGxmTextureFormat *gxm_format) {
+	switch (format) {
+	case COMPRESSED_TEXTURE_DXT1_RGB:
+		*gl_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_UBC1_ABGR;
+		return 1;
+	case COMPRESSED_TEXTURE_DXT1_RGBA:
+		*gl_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_UBC1_ABGR;
+		return 1;
+	case COMPRESSED_TEXTURE_DXT3:
+		*gl_format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_UBC2_ABGR;
+		return 1;
+	case COMPRESSED_TEXTURE_DXT5:
+		*gl_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_UBC3_ABGR;
+		return 1;
+	case COMPRESSED_TEXTURE_PVRTC_2BPP_RGB:
+		*gl_format = GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG;
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_PVRT2BPP_ABGR;
+		return 1;
+	case COMPRESSED_TEXTURE_PVRTC_2BPP_RGBA:
+		*gl_format = GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG;
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_PVRT2BPP_ABGR;
+		return 1;
+	case COMPRESSED_TEXTURE_PVRTC_4BPP_RGB:
+		*gl_format = GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG;
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_PVRT4BPP_ABGR;
+		return 1;
+	case COMPRESSED_TEXTURE_PVRTC_4BPP_RGBA:
+		*gl_format = GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG;
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_PVRT4BPP_ABGR;
+		return 1;
+	case COMPRESSED_TEXTURE_ETC1:
+		*gl_format = GL_ETC1_RGB8_OES;
+		*gxm_format = SCE_GXM_TEXTURE_FORMAT_ETC1_RGB;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+vita2d_texture *vita2d_load_compressed_buffer(const void *buffer, unsigned long buffer_size) {
+	compressed_texture ct;
+	GLenum gl_format;
+	SceGxmTextureFormat gxm_format;
+	unsigned int i;
+
+	if (compressed_texture_parse(buffer, buffer_size, &ct) < 0 ||
+	    !_gl_format_from_compressed(ct.format, &gl_format, &gxm_format))
+		return NULL;
+
+	vita2d_texture *r = _alloc_texture();
+	glGenTextures(1, &r->tex_id);
+	glBindTexture(GL_TEXTURE_2D, r->tex_id);
+	for (i = 0; i < ct.num_levels; i++) {
+		glCompressedTexImage2D(GL_TEXTURE_2D, i, gl_format, ct.levels[i].w, ct.levels[i].h, 0,
+				       ct.levels[i].size, ct.levels[i].data);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	r->filters[0] = r->filters[1] = SCE_GXM_TEXTURE_FILTER_POINT;
+	r->w = ct.w;
+	r->h = ct.h;
+	r->format = gxm_format;
+	r->mip_levels = ct.num_levels;
+	_account_texture(r);
+
+	return r;
+}
+
+vita2d_texture *vita2d_load_compressed_file(const char *filename) {
+	unsigned long size;
+	void *data = read_file(filename, &size);
+	if (!data)
+		return NULL;
+
+	vita2d_texture *r = vita2d_load_compressed_buffer(data, size);
+	free(data);
+	if (r)
+		vita2d_texture_set_tag(r, filename);
+	return r;
+}
+
+static vita2d_texture *_texture_from_gxt(const gxt_texture *gt) {
+	SceGxmTexture *gxm_tex;
+	void *data;
+
+	// Let vitaGL allocate a U8 texture big enough for the payload, then describe it to GXM as it really is
+	unsigned int alloc_w = gt->size < 4096 ? ALIGN(gt->size, 8) : 4096;
+	unsigned int alloc_h = (gt->size + alloc_w - 1) / alloc_w;
+	if (gt->size == 0 || alloc_h > 4096)
+		return NULL;
+
+	vita2d_texture *r = _alloc_texture();
+	glGenTextures(1, &r->tex_id);
+	glBindTexture(GL_TEXTURE_2D, r->tex_id);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, alloc_w, alloc_h, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+	data = vglGetTexDataPointer(GL_TEXTURE_2D);
+	gxm_tex = vglGetGxmTexture(GL_TEXTURE_2D);
+	if (!data) {
+		vita2d_free_texture(r);
+		return NULL;
+	}
+	memcpy(data, gt->data, gt->size);
+
+	switch (gt->type) {
+	case SCE_GXM_TEXTURE_SWIZZLED:
+		sceGxmTextureInitSwizzled(gxm_tex, data, gt->format, gt->w, gt->h, gt->mip_count);
+		break;
+	case SCE_GXM_TEXTURE_SWIZZLED_ARBITRARY:
+		sceGxmTextureInitSwizzledArbitrary(gxm_tex, data, gt->format, gt->w, gt->h, gt->mip_count);
+		break;
+	case SCE_GXM_TEXTURE_LINEAR:
+		sceGxmTextureInitLinear(gxm_tex, data, gt->format, gt->w, gt->h, gt->mip_count);
+		break;
+	case SCE_GXM_TEXTURE_TILED:
+		sceGxmTextureInitTiled(gxm_tex, data, gt->format, gt->w, gt->h, gt->mip_count);
+		break;
+	default:
+		printf("Unsupported GXT texture type: 0x%08X\n", (unsigned int)gt->type);
+		vita2d_free_texture(r);
+		return NULL;
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	r->filters[0] = r->filters[1] = SCE_GXM_TEXTURE_FILTER_POINT;
+	r->w = gt->w;
+	r->h = gt->h;
+	r->format = gt->format;
+	r->mip_levels = gt->mip_count;
+
+	if (gt->palette) {
+		vita2d_palette *palette = vita2d_create_palette(gt->palette_size / 4);
+		if (!palette || vita2d_texture_set_palette(r, palette) < 0) {
+			if (palette)
+				vita2d_free_palette(palette);
+			vita2d_free_texture(r);
+			return NULL;
+		}
+		vita2d_palette_update(palette, 0, vita2d_palette_get_entries(palette), (const unsigned int *)gt->palette);
+		vita2d_free_palette(palette);
+	}
+
+	_account_texture(r);
+	return r;
+}
+
+vita2d_texture *vita2d_load_GXT_buffer(const void *buffer, unsigned long buffer_size, unsigned int index) {
+	gxt_texture gt;
+
+	if (gxt_get_texture(buffer, buffer_size, index, &gt) < 0)
+		return NULL;
+
+	return _texture_from_gxt(&gt);
+}
+
+vita2d_texture *vita2d_load_GXT_file(const char *filename, unsigned int index) {
+	unsigned long size;
+	void *data = read_file(filename, &size);
+	if (!data)
+		return NULL;
+
+	vita2d_texture *r = vita2d_load_GXT_buffer(data, size, index);
+	free(data);
+	if (r)
+		vita2d_texture_set_tag(r, filename);
+	return r;
+}
+
+int vita2d_load_GXT_buffer_all(const void *buffer, unsigned long buffer_size, vita2d_texture **textures, unsigned int max_textures) {
+	int i, count = gxt_get_texture_count(buffer, buffer_size);
+	if (count < 0)
+		return -1;
+
+	if ((unsigned int)count > max_textures)
+		count = max_textures;
+
+	for (i = 0; i < count; i++) {
+		textures[i] = vita2d_load_GXT_buffer(buffer, buffer_size, i);
+		if (!textures[i]) {
+			while (i--)
+				vita2d_free_texture(textures[i]);
+			return -1;
+		}
+	}
+
+	return count;
+}
+
+int vita2d_load_GXT_file_all(const char *filename, vita2d_texture **textures, unsigned int max_textures) {
+	unsigned long size;
+	void *data = read_file(filename, &size);
+	if (!data)
+		return -1;
+
+	int i, count = vita2d_load_GXT_buffer_all(data, size, textures, max_textures);
+	free(data);
+	for (i = 0; i < count; i++)
+		vita2d_texture_set_tag(textures[i], filename);
+	return count;
+}
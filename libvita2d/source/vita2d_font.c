@@ -149,6 +149,7 @@ void vita2d_free_font(vita2d_font *font)
 		FTC_FaceID face_id = (FTC_FaceID)font;
 		FTC_Manager_RemoveFaceID(font->ftcmanager, face_id);
 		FTC_Manager_Done(font->ftcmanager);
+		FT_Done_FreeType(font->ftlibrary);
 		if (font->load_from == VITA2D_LOAD_FONT_FROM_FILE) {
 			free(font->filename);
 		}
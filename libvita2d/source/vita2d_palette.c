@@ -0,0 +1,175 @@
+#include <stdlib.h>
+#include <string.h>
+#include "vita2d_vgl.h"
+#include "vita2d_internal.h"
+#include "utils.h"
+#include "stb_image.h"
+
+struct vita2d_palette {
+	unsigned int *colors; // GPU mapped, SCE_GXM_PALETTE_ALIGNMENT aligned
+	unsigned int entries;
+	unsigned int refs;
+};
+
+void *vita2d_texture_get_palette(const vita2d_texture *texture) {
+	return texture->palette ? texture->palette->colors : NULL;
+}
+
+int vita2d_texture_set_palette(vita2d_texture *texture, vita2d_palette *palette) {
+	if (!_is_paletted(texture->format) || palette->entries != _palette_entries(texture->format))
+		return -1;
+
+	palette->refs++;
+	if (texture->palette)
+		vita2d_free_palette(texture->palette);
+	texture->palette = palette;
+
+	_bind_texture(texture->tex_id);
+	sceGxmTextureSetPalette(vglGetGxmTexture(GL_TEXTURE_2D), palette->colors);
+	return 0;
+}
+
+vita2d_palette *vita2d_create_palette(unsigned int entries) {
+	if (entries != 16 && entries != 256)
+		return NULL;
+
+	vita2d_palette *palette = malloc(sizeof(*palette));
+	if (!palette)
+		return NULL;
+
+	palette->colors = vglMemalign(SCE_GXM_PALETTE_ALIGNMENT, entries * sizeof(unsigned int));
+	if (!palette->colors) {
+		free(palette);
+		return NULL;
+	}
+
+	memset(palette->colors, 0, entries * sizeof(unsigned int));
+	palette->entries = entries;
+	palette->refs = 1;
+	return palette;
+}
+
+void vita2d_free_palette(vita2d_palette *palette) {
+	if (--palette->refs > 0)
+		return;
+	vglFree(palette->colors);
+	free(palette);
+}
+
+unsigned int vita2d_palette_get_entries(const vita2d_palette *palette) {
+	return palette->entries;
+}
+
+int vita2d_palette_update(vita2d_palette *palette, unsigned int first, unsigned int count, const unsigned int *colors) {
+	if (first > palette->entries || count > palette->entries - first)
+		return -1;
+	memcpy(palette->colors + first, colors, count * sizeof(unsigned int));
+	return 0;
+}
+
+// Reads the PLTE and tRNS chunks of an indexed color PNG, returns the number of entries (0 if there's no palette)
+static unsigned int _png_read_palette(const uint8_t *buf, unsigned long size, unsigned int *palette) {
+	static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	unsigned long pos = 8;
+	unsigned int i, entries = 0;
+
+	// IHDR comes first, color type 3 is indexed color
+	if (size < 8 + 25 || memcmp(buf, signature, sizeof(signature)) != 0 || buf[25] != 3)
+		return 0;
+
+	while (pos + 12 <= size) {
+		uint32_t len = ((uint32_t)buf[pos] << 24) | (buf[pos + 1] << 16) | (buf[pos + 2] << 8) | buf[pos + 3];
+		const uint8_t *type = buf + pos + 4;
+		const uint8_t *data = buf + pos + 8;
+
+		if (len > size - pos - 12 || memcmp(type, "IDAT", 4) == 0)
+			break;
+
+		if (memcmp(type, "PLTE", 4) == 0) {
+			entries = len / 3 > 256 ? 256 : len / 3;
+			for (i = 0; i < entries; i++)
+				palette[i] = RGBA8(data[i * 3], data[i * 3 + 1], data[i * 3 + 2], 0xFF);
+		} else if (memcmp(type, "tRNS", 4) == 0) {
+			for (i = 0; i < len && i < entries; i++)
+				palette[i] = (palette[i] & 0x00FFFFFF) | ((unsigned int)data[i] << 24);
+		}
+
+		pos += 12 + len;
+	}
+
+	return entries;
+}
+
+vita2d_texture *vita2d_load_PNG_buffer_paletted(const void *buffer, unsigned long buffer_size) {
+	unsigned int palette[256];
+	// color -> palette index + 1, stb_image expands the palette so every pixel matches an entry exactly
+	uint32_t keys[512];
+	uint16_t values[512] = {0};
+	unsigned int i, x, y, entries;
+	int w, h;
+
+	entries = _png_read_palette(buffer, buffer_size, palette);
+	if (entries == 0)
+		return NULL;
+
+	for (i = entries; i-- > 0; ) {
+		unsigned int slot = (palette[i] * 2654435761u) >> 23;
+		while (values[slot] && keys[slot] != palette[i])
+			slot = (slot + 1) & 511;
+		keys[slot] = palette[i];
+		values[slot] = i + 1; // walking backwards leaves the first duplicate in the table
+	}
+
+	uint32_t *data = (uint32_t *)stbi_load_from_memory(buffer, buffer_size, &w, &h, NULL, 4);
+	if (!data)
+		return NULL;
+
+	int p4 = entries <= 16;
+	vita2d_texture *r = vita2d_create_empty_texture_format(w, h, p4 ? SCE_GXM_TEXTURE_FORMAT_P4_ABGR : SCE_GXM_TEXTURE_FORMAT_P8_ABGR);
+	if (!r) {
+		vglFree(data);
+		return NULL;
+	}
+	if (!r->palette) {
+		vita2d_free_texture(r);
+		vglFree(data);
+		return NULL;
+	}
+
+	uint8_t *dst = vita2d_texture_get_datap(r);
+	unsigned int stride = vita2d_texture_get_stride(r);
+	for (y = 0; y < (unsigned int)h; y++) {
+		uint8_t *row = dst + y * stride;
+		for (x = 0; x < (unsigned int)w; x++) {
+			uint32_t color = data[y * w + x];
+			unsigned int slot = (color * 2654435761u) >> 23;
+			while (values[slot] && keys[slot] != color)
+				slot = (slot + 1) & 511;
+			unsigned int index = values[slot] ? values[slot] - 1 : 0;
+
+			// P4 stores the first texel in the low nibble
+			if (p4)
+				row[x / 2] = (x & 1) ? (row[x / 2] | (index << 4)) : index;
+			else
+				row[x] = index;
+		}
+	}
+	vglFree(data);
+
+	memset(palette + entries, 0, (vita2d_palette_get_entries(r->palette) - entries) * sizeof(unsigned int));
+	vita2d_palette_update(r->palette, 0, vita2d_palette_get_entries(r->palette), palette);
+	return r;
+}
+
+vita2d_texture *vita2d_load_PNG_file_paletted(const char *filename) {
+	unsigned long size;
+	void *data = read_file(filename, &size);
+	if (!data)
+		return NULL;
+
+	vita2d_texture *r = vita2d_load_PNG_buffer_paletted(data, size);
+	free(data);
+	if (r)
+		vita2d_texture_set_tag(r, filename);
+	return r;
+}
@@ -247,7 +247,7 @@ static int atlas_add_glyph(vita2d_pgf *font, unsigned int character)
 	glyph_image.bufHeight = vita2d_texture_get_height(tex);
 	glyph_image.bytesPerLine = vita2d_texture_get_stride(tex);
 	glyph_image.pad = 0;
-	glyph_image.bufferPtr = (unsigned int)texture_data;
+	glyph_image.bufferPtr = (uintptr_t)texture_data;
 
 	return sceFontGetCharGlyphImage(font_handle, character, &glyph_image) == 0;
 }
@@ -0,0 +1,155 @@
+#include <vitasdk.h>
+#include <string.h>
+#include <png.h>
+#include "vita2d_vgl.h"
+#include "png_writer.h"
+
+typedef struct png_job {
+	char *filename;
+	void *pixels;
+	unsigned int w;
+	unsigned int h;
+	vita2d_png_done_callback done;
+	void *userdata;
+	struct png_job *next;
+} png_job;
+
+static SceUID writer_thread = -1;
+static SceUID writer_sema = -1;
+static SceKernelLwMutexWork writer_mutex;
+static png_job *queue_head;
+static png_job *queue_tail;
+
+static int write_png(const png_job *job)
+{
+	png_structp png_ptr;
+	png_infop info_ptr;
+	unsigned int y;
+	FILE *fp = fopen(job->filename, "wb");
+
+	if (!fp)
+		return -1;
+
+	png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	info_ptr = png_ptr ? png_create_info_struct(png_ptr) : NULL;
+	if (!info_ptr || setjmp(png_jmpbuf(png_ptr))) {
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		fclose(fp);
+		return -1;
+	}
+
+	png_init_io(png_ptr, fp);
+	// Screenshots are big and flat, favor speed over size
+	png_set_compression_level(png_ptr, 3);
+	png_set_IHDR(png_ptr, info_ptr, job->w, job->h, 8, PNG_COLOR_TYPE_RGBA,
+		     PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_write_info(png_ptr, info_ptr);
+	for (y = 0; y < job->h; y++)
+		png_write_row(png_ptr, (png_const_bytep)job->pixels + y * job->w * 4);
+	png_write_end(png_ptr, NULL);
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+
+	return fclose(fp) == 0 ? 0 : -1;
+}
+
+static int writer_thread_func(SceSize args, void *argp)
+{
+	for (;;) {
+		png_job *job;
+
+		sceKernelWaitSema(writer_sema, 1, NULL);
+		sceKernelLockLwMutex(&writer_mutex, 1, NULL);
+		job = queue_head;
+		if (job) {
+			queue_head = job->next;
+			if (!queue_head)
+				queue_tail = NULL;
+		}
+		sceKernelUnlockLwMutex(&writer_mutex, 1);
+
+		// The quit request is queued behind the pending jobs
+		if (!job)
+			break;
+
+		int result = write_png(job);
+		if (job->done)
+			job->done(result, job->userdata);
+		free(job->filename);
+		free(job->pixels);
+		free(job);
+	}
+
+	return sceKernelExitDeleteThread(0);
+}
+
+static int start_writer()
+{
+	writer_sema = sceKernelCreateSema("vita2d_png_writer_sema", 0, 0, 0x7FFFFFFF, NULL);
+	if (writer_sema < 0)
+		return -1;
+
+	sceKernelCreateLwMutex(&writer_mutex, "vita2d_png_writer_mutex", 0, 0, NULL);
+	writer_thread = sceKernelCreateThread("vita2d_png_writer", writer_thread_func, 0x10000100 + 32, 0x10000, 0, 0, NULL);
+	if (writer_thread < 0) {
+		sceKernelDeleteLwMutex(&writer_mutex);
+		sceKernelDeleteSema(writer_sema);
+		writer_sema = -1;
+		return -1;
+	}
+
+	sceKernelStartThread(writer_thread, 0, NULL);
+	return 0;
+}
+
+int vita2d_write_PNG_async(const char *filename, const void *pixels, unsigned int w, unsigned int h, unsigned int stride, vita2d_png_done_callback done, void *userdata)
+{
+	unsigned int y;
+
+	if (w == 0 || h == 0 || (writer_thread < 0 && start_writer() < 0))
+		return -1;
+
+	png_job *job = calloc(1, sizeof(*job));
+	if (!job)
+		return -1;
+
+	job->filename = strdup(filename);
+	job->pixels = malloc(w * h * 4);
+	if (!job->filename || !job->pixels) {
+		free(job->filename);
+		free(job->pixels);
+		free(job);
+		return -1;
+	}
+
+	for (y = 0; y < h; y++)
+		memcpy((uint8_t *)job->pixels + y * w * 4, (const uint8_t *)pixels + y * stride, w * 4);
+	job->w = w;
+	job->h = h;
+	job->done = done;
+	job->userdata = userdata;
+
+	sceKernelLockLwMutex(&writer_mutex, 1, NULL);
+	if (queue_tail)
+		queue_tail->next = job;
+	else
+		queue_head = job;
+	queue_tail = job;
+	sceKernelUnlockLwMutex(&writer_mutex, 1);
+	sceKernelSignalSema(writer_sema, 1);
+
+	return 0;
+}
+
+void png_writer_fini(void)
+{
+	if (writer_thread < 0)
+		return;
+
+	// An empty queue tells the thread to exit once the jobs before it are done
+	sceKernelSignalSema(writer_sema, 1);
+	sceKernelWaitThreadEnd(writer_thread, NULL, NULL);
+	sceKernelDeleteLwMutex(&writer_mutex);
+	sceKernelDeleteSema(writer_sema);
+	writer_thread = -1;
+	writer_sema = -1;
+}
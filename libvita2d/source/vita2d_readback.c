@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vita2d_vgl.h"
+#include "vita2d_internal.h"
+
+typedef struct vita2d_readback {
+	vita2d_texture *copy; // the rectangle for render targets, the whole frame for the screen
+	int screen;
+	int x;
+	int y;
+	unsigned int w;
+	unsigned int h;
+	unsigned int frame;
+	vita2d_readback_callback callback;
+	void *userdata;
+	struct vita2d_readback *next;
+} vita2d_readback;
+
+static vita2d_readback *v2d_readback_head; // oldest first
+static vita2d_readback *v2d_readback_tail;
+vita2d_texture *v2d_capture;
+GLboolean v2d_capturing;
+
+// Frees an unlinked request, and its copy unless a queued one shares it
+static void _free_readback(vita2d_readback *rb) {
+	vita2d_readback *other;
+
+	for (other = v2d_readback_head; other; other = other->next) {
+		if (other->copy == rb->copy)
+			break;
+	}
+	if (!other && rb->copy != v2d_capture)
+		vita2d_free_texture(rb->copy);
+	free(rb);
+}
+
+static void _run_readback(vita2d_readback *rb) {
+	const uint8_t *data = vita2d_texture_get_datap(rb->copy);
+	unsigned int stride = vita2d_texture_get_stride(rb->copy);
+
+	if (!rb->screen) {
+		rb->callback(data, rb->w, rb->h, stride, rb->userdata);
+		return;
+	}
+
+	// The frame's alpha is meaningless, hand out an opaque copy of the rectangle
+	uint32_t *pixels = malloc(rb->w * rb->h * 4);
+	if (!pixels) {
+		rb->callback(NULL, rb->w, rb->h, 0, rb->userdata);
+		return;
+	}
+	unsigned int i, j;
+	for (i = 0; i < rb->h; i++) {
+		const uint32_t *src = (const uint32_t *)(data + (rb->y + i) * stride) + rb->x;
+		for (j = 0; j < rb->w; j++)
+			pixels[i * rb->w + j] = src[j] | 0xFF000000;
+	}
+	rb->callback(pixels, rb->w, rb->h, rb->w * 4, rb->userdata);
+	free(pixels);
+}
+
+void _process_readbacks() {
+	// Requests are queued in frame order, so the ready ones are at the front
+	while (v2d_readback_head && v2d_readback_head->copy != v2d_capture &&
+	       v2d_frame - v2d_readback_head->frame > GPU_FRAMES_IN_FLIGHT) {
+		vita2d_readback *rb = v2d_readback_head;
+		v2d_readback_head = rb->next;
+		if (!v2d_readback_head)
+			v2d_readback_tail = NULL;
+		_run_readback(rb);
+		_free_readback(rb);
+	}
+}
+
+void _finish_capture() {
+	vita2d_draw_stats stats = v2d_stats;
+	vita2d_readback *rb;
+
+	_flush_batch();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDisable(GL_BLEND);
+	glDisable(GL_SCISSOR_TEST);
+	vita2d_draw_texture(v2d_capture, 0, 0);
+	_flush_batch();
+	_reset_blending();
+	if (vita2d_get_clipping_enabled())
+		glEnable(GL_SCISSOR_TEST);
+	v2d_bound_fbo = 0;
+	// Internal copy, not part of what the application drew
+	v2d_stats = stats;
+
+	for (rb = v2d_readback_head; rb; rb = rb->next) {
+		if (rb->copy == v2d_capture)
+			rb->frame = v2d_frame;
+	}
+	v2d_capture = NULL;
+	v2d_capturing = GL_FALSE;
+}
+
+int vita2d_read_pixels_async(const vita2d_texture *target, int x, int y, unsigned int w, unsigned int h, vita2d_readback_callback callback, void *userdata) {
+	unsigned int target_w = target ? target->w : SCREEN_W;
+	unsigned int target_h = target ? target->h : SCREEN_H;
+
+	if (!callback || x < 0 || y < 0 || w == 0 || h == 0 || x + w > target_w || y + h > target_h)
+		return -1;
+
+	vita2d_readback *rb = calloc(1, sizeof(*rb));
+	if (!rb)
+		return -1;
+
+	if (target) {
+		// Snapshot the rectangle now, the CPU reads the copy once the GPU has caught up
+		rb->copy = vita2d_create_empty_texture_rendertarget(w, h, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR);
+		if (!rb->copy) {
+			free(rb);
+			return -1;
+		}
+		vita2d_texture_set_tag(rb->copy, "readback");
+		vita2d_draw_stats stats = v2d_stats;
+		_flush_batch();
+		glBindFramebuffer(GL_FRAMEBUFFER, rb->copy->fbo);
+		glDisable(GL_BLEND);
+		glDisable(GL_SCISSOR_TEST);
+		vita2d_draw_texture_part(target, 0, 0, x, y, w, h);
+		_flush_batch();
+		glBindFramebuffer(GL_FRAMEBUFFER, v2d_bound_fbo);
+		_reset_blending();
+		if (vita2d_get_clipping_enabled())
+			glEnable(GL_SCISSOR_TEST);
+		// Internal copy, not part of what the application drew
+		v2d_stats = stats;
+	} else {
+		// The frame being drawn if it's being captured or hasn't started yet, the next one otherwise
+		if (!v2d_capture) {
+			v2d_capture = vita2d_create_empty_texture_rendertarget(SCREEN_W, SCREEN_H, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR);
+			if (!v2d_capture) {
+				free(rb);
+				return -1;
+			}
+			vita2d_texture_set_tag(v2d_capture, "screen readback");
+		}
+		rb->copy = v2d_capture;
+		rb->screen = 1;
+	}
+
+	rb->x = x;
+	rb->y = y;
+	rb->w = w;
+	rb->h = h;
+	rb->frame = v2d_frame;
+	rb->callback = callback;
+	rb->userdata = userdata;
+	if (v2d_readback_tail)
+		v2d_readback_tail->next = rb;
+	else
+		v2d_readback_head = rb;
+	v2d_readback_tail = rb;
+	return 0;
+}
+
+static void _screenshot_written(int result, void *userdata) {
+	if (result < 0)
+		printf("vita2d_screenshot_async: failed to write %s\n", (char *)userdata);
+	free(userdata);
+}
+
+static void _screenshot_readback(const void *pixels, unsigned int w, unsigned int h, unsigned int stride, void *userdata) {
+	if (!pixels || vita2d_write_PNG_async(userdata, pixels, w, h, stride, _screenshot_written, userdata) < 0) {
+		printf("vita2d_screenshot_async: failed to capture %s\n", (char *)userdata);
+		free(userdata);
+	}
+}
+
+int vita2d_screenshot_async(const vita2d_texture *target, const char *filename) {
+	char *name = strdup(filename);
+	if (!name)
+		return -1;
+
+	if (vita2d_read_pixels_async(target, 0, 0, target ? target->w : SCREEN_W, target ? target->h : SCREEN_H, _screenshot_readback, name) < 0) {
+		free(name);
+		return -1;
+	}
+	return 0;
+}
+
+void _readbacks_fini() {
+	// Cleared first so the last request sharing the capture frees it
+	v2d_capture = NULL;
+	v2d_capturing = GL_FALSE;
+	while (v2d_readback_head) {
+		vita2d_readback *rb = v2d_readback_head;
+		v2d_readback_head = rb->next;
+		rb->callback(NULL, rb->w, rb->h, 0, rb->userdata);
+		_free_readback(rb);
+	}
+	v2d_readback_tail = NULL;
+}
@@ -0,0 +1,300 @@
+#include <stdlib.h>
+#include <string.h>
+#include "vita2d_vgl.h"
+#include "vita2d_internal.h"
+#include "bin_packing_2d.h"
+#include "atlas_index.h"
+#include "image_decode.h"
+#include "utils.h"
+
+typedef struct vita2d_sprite_atlas_page {
+	vita2d_texture *texture;
+	bp2d_node *bp_root; // NULL for baked pages, they're full as far as we know
+} vita2d_sprite_atlas_page;
+
+struct vita2d_sprite_atlas {
+	unsigned int page_w;
+	unsigned int page_h;
+	unsigned int padding;
+	vita2d_sprite_atlas_page *pages;
+	unsigned int num_pages;
+	vita2d_subtexture **sprites;
+	unsigned int num_sprites;
+	unsigned int max_sprites;
+	const atlas_index_header *index; // baked sprites come first in sprites[], in index order
+};
+
+vita2d_sprite_atlas *vita2d_create_sprite_atlas(unsigned int page_w, unsigned int page_h, unsigned int padding) {
+	if (page_w == 0 || page_h == 0)
+		return NULL;
+
+	vita2d_sprite_atlas *atlas = calloc(1, sizeof(*atlas));
+	if (!atlas)
+		return NULL;
+
+	atlas->page_w = page_w;
+	atlas->page_h = page_h;
+	atlas->padding = padding;
+	return atlas;
+}
+
+void vita2d_free_sprite_atlas(vita2d_sprite_atlas *atlas) {
+	unsigned int i;
+
+	for (i = 0; i < atlas->num_sprites; i++)
+		vita2d_free_texture(atlas->sprites[i]);
+	for (i = 0; i < atlas->num_pages; i++) {
+		vita2d_free_texture(atlas->pages[i].texture);
+		bp2d_free(atlas->pages[i].bp_root);
+	}
+	free(atlas->sprites);
+	free(atlas->pages);
+	free((void *)atlas->index);
+	free(atlas);
+}
+
+static vita2d_sprite_atlas_page *_sprite_atlas_add_page(vita2d_sprite_atlas *atlas) {
+	vita2d_sprite_atlas_page *pages = realloc(atlas->pages, (atlas->num_pages + 1) * sizeof(*pages));
+	if (!pages)
+		return NULL;
+	atlas->pages = pages;
+
+	bp2d_rectangle rect = {0, 0, atlas->page_w, atlas->page_h};
+	vita2d_sprite_atlas_page *page = &pages[atlas->num_pages];
+	page->texture = vita2d_create_empty_texture(atlas->page_w, atlas->page_h);
+	page->bp_root = bp2d_create(&rect);
+	if (!page->texture || !page->bp_root) {
+		if (page->texture)
+			vita2d_free_texture(page->texture);
+		if (page->bp_root)
+			bp2d_free(page->bp_root);
+		return NULL;
+	}
+
+	vita2d_texture_set_tag(page->texture, "sprite atlas page");
+	atlas->num_pages++;
+	return page;
+}
+
+void _blit_with_ring(uint8_t *dst, unsigned int dst_stride, const uint8_t *src, unsigned int src_stride,
+		     unsigned int w, unsigned int h) {
+	unsigned int y;
+
+	for (y = 0; y < h + 2; y++) {
+		const uint8_t *row = src + (y == 0 ? 0 : y > h ? h - 1 : y - 1) * src_stride;
+		uint8_t *out = dst + y * dst_stride;
+		memcpy(out, row, 4);
+		memcpy(out + 4, row, w * 4);
+		memcpy(out + (w + 1) * 4, row + (w - 1) * 4, 4);
+	}
+}
+
+// Copies the sprite to x, y of the page, with 'ring' in one update together with its edge texels
+static int _sprite_atlas_copy(vita2d_texture *page, unsigned int x, unsigned int y, const uint8_t *src,
+			      unsigned int w, unsigned int h, unsigned int stride, int ring) {
+	const SceGxmTextureFormat format = SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR;
+	int ret;
+
+	if (!ring)
+		return vita2d_texture_update_region(page, x, y, w, h, src, stride, format);
+
+	uint8_t *block = malloc((size_t)(w + 2) * (h + 2) * 4);
+	if (!block)
+		return -1;
+	_blit_with_ring(block, (w + 2) * 4, src, stride, w, h);
+	ret = vita2d_texture_update_region(page, x - 1, y - 1, w + 2, h + 2, block, (w + 2) * 4, format);
+	free(block);
+	return ret;
+}
+
+vita2d_subtexture *vita2d_sprite_atlas_add(vita2d_sprite_atlas *atlas, const void *pixels, unsigned int w, unsigned int h, unsigned int stride) {
+	const SceGxmTextureFormat format = SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR;
+	const uint8_t *src = pixels;
+	vita2d_sprite_atlas_page *page = NULL;
+	bp2d_position pos;
+	bp2d_node *node;
+	unsigned int i, pad = atlas->padding;
+	bp2d_size size = {w + pad * 2, h + pad * 2};
+
+	if (w == 0 || h == 0 || (unsigned int)size.w > atlas->page_w || (unsigned int)size.h > atlas->page_h)
+		return NULL;
+
+	// Older pages are the fullest, try the newest one first
+	for (i = atlas->num_pages; i-- > 0; ) {
+		if (atlas->pages[i].bp_root && bp2d_insert(atlas->pages[i].bp_root, &size, &pos, &node)) {
+			page = &atlas->pages[i];
+			break;
+		}
+	}
+	if (!page) {
+		page = _sprite_atlas_add_page(atlas);
+		if (!page || !bp2d_insert(page->bp_root, &size, &pos, &node))
+			return NULL;
+	}
+
+	if (atlas->num_sprites == atlas->max_sprites) {
+		unsigned int max = atlas->max_sprites ? atlas->max_sprites * 2 : 32;
+		vita2d_subtexture **sprites = realloc(atlas->sprites, max * sizeof(*sprites));
+		if (!sprites) {
+			bp2d_delete(page->bp_root, node);
+			return NULL;
+		}
+		atlas->sprites = sprites;
+		atlas->max_sprites = max;
+	}
+
+	unsigned int x = pos.x + pad, y = pos.y + pad;
+	vita2d_subtexture *sprite = NULL;
+	if (_sprite_atlas_copy(page->texture, x, y, src, w, h, stride, pad > 0) == 0)
+		sprite = _alloc_texture();
+	if (!sprite) {
+		bp2d_delete(page->bp_root, node);
+		return NULL;
+	}
+
+	sprite->parent = page->texture;
+	sprite->tex_id = page->texture->tex_id;
+	sprite->format = format;
+	sprite->w = w;
+	sprite->h = h;
+	sprite->filters[0] = page->texture->filters[0];
+	sprite->filters[1] = page->texture->filters[1];
+	sprite->uv[0] = x / (float)atlas->page_w;
+	sprite->uv[1] = y / (float)atlas->page_h;
+	sprite->uv[2] = (x + w) / (float)atlas->page_w;
+	sprite->uv[3] = (y + h) / (float)atlas->page_h;
+
+	atlas->sprites[atlas->num_sprites++] = sprite;
+	return sprite;
+}
+
+vita2d_subtexture *vita2d_sprite_atlas_load_PNG_buffer(vita2d_sprite_atlas *atlas, const void *buffer, unsigned long buffer_size) {
+	decoded_image image = {NULL, 0, 0};
+	vita2d_subtexture *sprite = NULL;
+
+	if (image_decode_buffer(buffer, buffer_size, _decode_alloc_rgba, &image) == IMAGE_DECODE_OK)
+		sprite = vita2d_sprite_atlas_add(atlas, image.pixels, image.w, image.h, image.w * 4);
+	free(image.pixels);
+	return sprite;
+}
+
+vita2d_subtexture *vita2d_sprite_atlas_load_PNG_file(vita2d_sprite_atlas *atlas, const char *filename) {
+	decoded_image image = {NULL, 0, 0};
+	vita2d_subtexture *sprite = NULL;
+
+	if (image_decode_file(filename, _decode_alloc_rgba, &image) == IMAGE_DECODE_OK)
+		sprite = vita2d_sprite_atlas_add(atlas, image.pixels, image.w, image.h, image.w * 4);
+	free(image.pixels);
+	if (sprite)
+		vita2d_texture_set_tag(sprite, filename);
+	return sprite;
+}
+
+vita2d_sprite_atlas *vita2d_load_sprite_atlas(const char *index_filename) {
+	const atlas_index_header *index;
+	const atlas_index_sprite *entries;
+	vita2d_texture **pages;
+	unsigned long size;
+	unsigned int i;
+	char *path;
+
+	void *data = read_file(index_filename, &size);
+	if (!data)
+		return NULL;
+
+	index = atlas_index_validate(data, size);
+	if (!index || index->num_pages == 0) {
+		free(data);
+		return NULL;
+	}
+
+	// The GXT file sits next to the index
+	const char *slash = strrchr(index_filename, '/');
+	size_t dir_len = slash ? slash - index_filename + 1 : 0;
+	path = malloc(dir_len + strlen(index->texture_file) + 1);
+	pages = malloc(index->num_pages * sizeof(*pages));
+	vita2d_sprite_atlas *atlas = calloc(1, sizeof(*atlas));
+	if (!path || !pages || !atlas)
+		goto error;
+
+	memcpy(path, index_filename, dir_len);
+	strcpy(path + dir_len, index->texture_file);
+	int loaded = vita2d_load_GXT_file_all(path, pages, index->num_pages);
+	if (loaded != (int)index->num_pages) {
+		for (i = 0; (int)i < loaded; i++)
+			vita2d_free_texture(pages[i]);
+		goto error;
+	}
+
+	atlas->pages = malloc(index->num_pages * sizeof(*atlas->pages));
+	atlas->sprites = malloc(index->num_sprites * sizeof(*atlas->sprites));
+	if (!atlas->pages || (index->num_sprites && !atlas->sprites)) {
+		for (i = 0; i < index->num_pages; i++)
+			vita2d_free_texture(pages[i]);
+		goto error;
+	}
+
+	for (i = 0; i < index->num_pages; i++) {
+		atlas->pages[i].texture = pages[i];
+		atlas->pages[i].bp_root = NULL;
+	}
+	atlas->num_pages = index->num_pages;
+	atlas->max_sprites = index->num_sprites;
+	atlas->page_w = pages[0]->w;
+	atlas->page_h = pages[0]->h;
+	atlas->padding = 1;
+	atlas->index = index;
+	free(pages);
+	free(path);
+
+	entries = atlas_index_sprites(index);
+	for (i = 0; i < index->num_sprites; i++) {
+		vita2d_subtexture *sprite = entries[i].page < index->num_pages ? _alloc_texture() : NULL;
+		if (!sprite) {
+			vita2d_free_sprite_atlas(atlas);
+			return NULL;
+		}
+
+		vita2d_texture *page = atlas->pages[entries[i].page].texture;
+		sprite->parent = page;
+		sprite->tex_id = page->tex_id;
+		sprite->format = page->format;
+		sprite->w = entries[i].w;
+		sprite->h = entries[i].h;
+		sprite->filters[0] = page->filters[0];
+		sprite->filters[1] = page->filters[1];
+		memcpy(sprite->uv, entries[i].uv, sizeof(sprite->uv));
+		atlas->sprites[atlas->num_sprites++] = sprite;
+	}
+
+	return atlas;
+
+error:
+	if (atlas) {
+		free(atlas->pages);
+		free(atlas->sprites);
+		free(atlas);
+	}
+	free(pages);
+	free(path);
+	free(data);
+	return NULL;
+}
+
+vita2d_subtexture *vita2d_sprite_atlas_find(const vita2d_sprite_atlas *atlas, const char *name) {
+	int i;
+
+	if (!atlas->index)
+		return NULL;
+
+	i = atlas_index_find(atlas->index, name);
+	return i < 0 ? NULL : atlas->sprites[i];
+}
+
+unsigned int vita2d_sprite_atlas_get_page_count(const vita2d_sprite_atlas *atlas) {
+	return atlas->num_pages;
+}
+
+vita2d_texture *vita2d_sprite_atlas_get_page(const vita2d_sprite_atlas *atlas, unsigned int page) {
+	return page < atlas->num_pages ? atlas->pages[page].texture : NULL;
+}
@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include "vita2d_vgl.h"
+#include "vita2d_internal.h"
+
+typedef struct vita2d_streaming_texture {
+	vita2d_texture **buffers;
+	unsigned int num_buffers;
+	unsigned int current;
+	int writing;
+} vita2d_streaming_texture;
+
+vita2d_streaming_texture *vita2d_create_streaming_texture(unsigned int w, unsigned int h, SceGxmTextureFormat format, unsigned int buffers) {
+	unsigned int i;
+
+	if (buffers < 2)
+		return NULL;
+
+	vita2d_streaming_texture *stream = malloc(sizeof(*stream));
+	if (!stream)
+		return NULL;
+
+	stream->buffers = calloc(buffers, sizeof(vita2d_texture *));
+	if (!stream->buffers) {
+		free(stream);
+		return NULL;
+	}
+
+	stream->num_buffers = buffers;
+	stream->current = 0;
+	stream->writing = -1;
+
+	for (i = 0; i < buffers; i++) {
+		stream->buffers[i] = vita2d_create_empty_texture_format(w, h, format);
+		if (!stream->buffers[i]) {
+			vita2d_free_streaming_texture(stream);
+			return NULL;
+		}
+	}
+
+	return stream;
+}
+
+void vita2d_free_streaming_texture(vita2d_streaming_texture *stream) {
+	unsigned int i;
+
+	if (stream) {
+		for (i = 0; i < stream->num_buffers; i++) {
+			if (stream->buffers[i])
+				vita2d_free_texture(stream->buffers[i]);
+		}
+		free(stream->buffers);
+		free(stream);
+	}
+}
+
+void *vita2d_streaming_texture_begin_write(vita2d_streaming_texture *stream, unsigned int *stride) {
+	unsigned int i;
+	int oldest = -1;
+
+	// Until end_write, the same buffer is handed back
+	if (stream->writing < 0) {
+		/*
+		 * A buffer is free once the frames that sampled it have left the GPU,
+		 * and the current one is skipped so it stays drawable until end_write.
+		 */
+		for (i = 1; i < stream->num_buffers; i++) {
+			unsigned int idx = (stream->current + i) % stream->num_buffers;
+			vita2d_texture *tex = stream->buffers[idx];
+			if (tex->last_frame != 0 && v2d_frame - tex->last_frame <= GPU_FRAMES_IN_FLIGHT)
+				continue;
+			if (oldest < 0 || tex->last_frame < stream->buffers[oldest]->last_frame)
+				oldest = idx;
+		}
+
+		if (oldest < 0)
+			return NULL;
+		stream->writing = oldest;
+	}
+
+	if (stride)
+		*stride = vita2d_texture_get_stride(stream->buffers[stream->writing]);
+	return vita2d_texture_get_datap(stream->buffers[stream->writing]);
+}
+
+void vita2d_streaming_texture_end_write(vita2d_streaming_texture *stream) {
+	if (stream->writing >= 0) {
+		stream->current = stream->writing;
+		stream->writing = -1;
+	}
+}
+
+vita2d_texture *vita2d_streaming_texture_get_texture(const vita2d_streaming_texture *stream) {
+	return stream->buffers[stream->current];
+}
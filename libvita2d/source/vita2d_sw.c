@@ -0,0 +1,583 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vita2d_sw.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SW_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SW_USE_SSE2
+#endif
+
+#define SUBPIXEL_BITS 4
+#define SUBPIXEL_ONE (1 << SUBPIXEL_BITS)
+#define SPAN_CHUNK 256
+
+/* Exact round(x / 255) for x in [0, 255 * 255] */
+static inline uint32_t div255(uint32_t x)
+{
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+static inline uint32_t modulate(uint32_t t, uint32_t c)
+{
+	return div255((t & 0xFF) * (c & 0xFF)) |
+		(div255(((t >> 8) & 0xFF) * ((c >> 8) & 0xFF)) << 8) |
+		(div255(((t >> 16) & 0xFF) * ((c >> 16) & 0xFF)) << 16) |
+		(div255((t >> 24) * (c >> 24)) << 24);
+}
+
+static inline uint32_t blend_alpha(uint32_t s, uint32_t d)
+{
+	uint32_t a = s >> 24;
+	uint32_t ia = 255 - a;
+	return div255((s & 0xFF) * a + (d & 0xFF) * ia) |
+		(div255(((s >> 8) & 0xFF) * a + ((d >> 8) & 0xFF) * ia) << 8) |
+		(div255(((s >> 16) & 0xFF) * a + ((d >> 16) & 0xFF) * ia) << 16) |
+		(div255((s >> 24) * a + (d >> 24) * ia) << 24);
+}
+
+static inline uint32_t blend_add(uint32_t s, uint32_t d)
+{
+	uint32_t r = 0;
+	int i;
+	for (i = 0; i < 32; i += 8) {
+		uint32_t c = ((s >> i) & 0xFF) + ((d >> i) & 0xFF);
+		r |= (c > 0xFF ? 0xFF : c) << i;
+	}
+	return r;
+}
+
+/*
+ * Blends n source pixels over dst. The SIMD paths produce bit-identical
+ * results to the scalar tail, so goldens don't depend on the host CPU.
+ */
+static void span_blend(uint32_t *dst, const uint32_t *src, int n, int additive)
+{
+	int i = 0;
+
+#if defined(SW_USE_NEON)
+	if (additive) {
+		for (; i + 4 <= n; i += 4) {
+			uint8x16_t s = vld1q_u8((const uint8_t *)(src + i));
+			uint8x16_t d = vld1q_u8((const uint8_t *)(dst + i));
+			vst1q_u8((uint8_t *)(dst + i), vqaddq_u8(s, d));
+		}
+	} else {
+		const uint16x8_t bias = vdupq_n_u16(128);
+		for (; i + 4 <= n; i += 4) {
+			uint8x16_t s = vld1q_u8((const uint8_t *)(src + i));
+			uint8x16_t d = vld1q_u8((const uint8_t *)(dst + i));
+			uint32x4_t a32 = vmulq_n_u32(vshrq_n_u32(vreinterpretq_u32_u8(s), 24), 0x01010101);
+			uint8x16_t a = vreinterpretq_u8_u32(a32);
+			uint8x16_t ia = vmvnq_u8(a);
+			uint16x8_t lo = vmull_u8(vget_low_u8(s), vget_low_u8(a));
+			uint16x8_t hi = vmull_u8(vget_high_u8(s), vget_high_u8(a));
+			lo = vmlal_u8(lo, vget_low_u8(d), vget_low_u8(ia));
+			hi = vmlal_u8(hi, vget_high_u8(d), vget_high_u8(ia));
+			lo = vaddq_u16(lo, bias);
+			hi = vaddq_u16(hi, bias);
+			lo = vaddq_u16(lo, vshrq_n_u16(lo, 8));
+			hi = vaddq_u16(hi, vshrq_n_u16(hi, 8));
+			vst1q_u8((uint8_t *)(dst + i), vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+		}
+	}
+#elif defined(SW_USE_SSE2)
+	if (additive) {
+		for (; i + 4 <= n; i += 4) {
+			__m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+			__m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+			_mm_storeu_si128((__m128i *)(dst + i), _mm_adds_epu8(s, d));
+		}
+	} else {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i bias = _mm_set1_epi16(128);
+		const __m128i full = _mm_set1_epi16(255);
+		for (; i + 4 <= n; i += 4) {
+			__m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+			__m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+			__m128i slo = _mm_unpacklo_epi8(s, zero);
+			__m128i shi = _mm_unpackhi_epi8(s, zero);
+			__m128i dlo = _mm_unpacklo_epi8(d, zero);
+			__m128i dhi = _mm_unpackhi_epi8(d, zero);
+			__m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(slo, 0xFF), 0xFF);
+			__m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(shi, 0xFF), 0xFF);
+			__m128i lo = _mm_add_epi16(_mm_mullo_epi16(slo, alo),
+				_mm_mullo_epi16(dlo, _mm_sub_epi16(full, alo)));
+			__m128i hi = _mm_add_epi16(_mm_mullo_epi16(shi, ahi),
+				_mm_mullo_epi16(dhi, _mm_sub_epi16(full, ahi)));
+			lo = _mm_add_epi16(lo, bias);
+			hi = _mm_add_epi16(hi, bias);
+			lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+			hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+			_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+		}
+	}
+#endif
+
+	for (; i < n; i++)
+		dst[i] = additive ? blend_add(src[i], dst[i]) : blend_alpha(src[i], dst[i]);
+}
+
+static void span_fill(uint32_t *dst, uint32_t color, int n)
+{
+	int i = 0;
+
+#if defined(SW_USE_NEON)
+	uint32x4_t c = vdupq_n_u32(color);
+	for (; i + 4 <= n; i += 4)
+		vst1q_u32(dst + i, c);
+#elif defined(SW_USE_SSE2)
+	__m128i c = _mm_set1_epi32(color);
+	for (; i + 4 <= n; i += 4)
+		_mm_storeu_si128((__m128i *)(dst + i), c);
+#endif
+
+	for (; i < n; i++)
+		dst[i] = color;
+}
+
+static inline uint32_t fetch_texel(const vita2d_sw_texture *texture, int x, int y)
+{
+	const uint8_t *row = (const uint8_t *)texture->data + y * texture->stride;
+
+	if (texture->format == VITA2D_SW_FORMAT_U8_R)
+		return RGBA8(0xFF, 0xFF, 0xFF, row[x]);
+
+	return ((const uint32_t *)row)[x];
+}
+
+static inline int wrap(int64_t x, unsigned int size)
+{
+	if ((size & (size - 1)) == 0)
+		return x & (size - 1);
+	x %= size;
+	return x < 0 ? x + size : x;
+}
+
+/* fx and fy are texel coordinates in 16.16 fixed point */
+static uint32_t sample(const vita2d_sw_texture *texture, int64_t fx, int64_t fy)
+{
+	if (texture->filter == VITA2D_SW_FILTER_POINT)
+		return fetch_texel(texture, wrap(fx >> 16, texture->w),
+				   wrap(fy >> 16, texture->h));
+
+	fx -= 0x8000;
+	fy -= 0x8000;
+	uint32_t wx = (fx >> 8) & 0xFF;
+	uint32_t wy = (fy >> 8) & 0xFF;
+	int x0 = wrap(fx >> 16, texture->w);
+	int y0 = wrap(fy >> 16, texture->h);
+	int x1 = wrap((fx >> 16) + 1, texture->w);
+	int y1 = wrap((fy >> 16) + 1, texture->h);
+
+	uint32_t c00 = fetch_texel(texture, x0, y0);
+	uint32_t c10 = fetch_texel(texture, x1, y0);
+	uint32_t c01 = fetch_texel(texture, x0, y1);
+	uint32_t c11 = fetch_texel(texture, x1, y1);
+	uint32_t w00 = (256 - wx) * (256 - wy);
+	uint32_t w10 = wx * (256 - wy);
+	uint32_t w01 = (256 - wx) * wy;
+	uint32_t w11 = wx * wy;
+	uint32_t r = 0;
+	int i;
+
+	for (i = 0; i < 32; i += 8) {
+		uint32_t c = ((c00 >> i) & 0xFF) * w00 + ((c10 >> i) & 0xFF) * w10 +
+			((c01 >> i) & 0xFF) * w01 + ((c11 >> i) & 0xFF) * w11;
+		r |= ((c + 0x8000) >> 16) << i;
+	}
+
+	return r;
+}
+
+static void clip_bounds(const vita2d_sw_target *target, int *x0, int *y0, int *x1, int *y1)
+{
+	*x0 = 0;
+	*y0 = 0;
+	*x1 = target->w;
+	*y1 = target->h;
+
+	if (target->clipping) {
+		if (target->clip[0] > *x0) *x0 = target->clip[0];
+		if (target->clip[1] > *y0) *y0 = target->clip[1];
+		if (target->clip[2] < *x1) *x1 = target->clip[2];
+		if (target->clip[3] < *y1) *y1 = target->clip[3];
+	}
+}
+
+static void write_pixel(vita2d_sw_target *target, int x, int y, uint32_t color)
+{
+	int cx0, cy0, cx1, cy1;
+	clip_bounds(target, &cx0, &cy0, &cx1, &cy1);
+	if (x < cx0 || x >= cx1 || y < cy0 || y >= cy1)
+		return;
+
+	uint32_t *dst = &target->pixels[y * target->stride + x];
+	if (target->no_blending)
+		*dst = color;
+	else
+		*dst = target->additive_blending ? blend_add(color, *dst) : blend_alpha(color, *dst);
+}
+
+static void raster_point(vita2d_sw_target *target, const float *p, uint32_t color)
+{
+	write_pixel(target, (int)floorf(p[0]), (int)floorf(p[1]), color);
+}
+
+/* Bresenham, last pixel excluded like the GL diamond-exit rule */
+static void raster_line(vita2d_sw_target *target, const float *p0, const float *p1, uint32_t color)
+{
+	int x0 = (int)floorf(p0[0]);
+	int y0 = (int)floorf(p0[1]);
+	int x1 = (int)floorf(p1[0]);
+	int y1 = (int)floorf(p1[1]);
+	int dx = abs(x1 - x0);
+	int dy = -abs(y1 - y0);
+	int sx = x0 < x1 ? 1 : -1;
+	int sy = y0 < y1 ? 1 : -1;
+	int err = dx + dy;
+
+	while (x0 != x1 || y0 != y1) {
+		write_pixel(target, x0, y0, color);
+		int e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			x0 += sx;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+}
+
+static inline int64_t floor_div(int64_t a, int64_t b)
+{
+	int64_t q = a / b;
+	return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+static inline int64_t ceil_div(int64_t a, int64_t b)
+{
+	return -floor_div(-a, b);
+}
+
+typedef struct sw_edge {
+	int64_t x, y;   /* start vertex, subpixel units */
+	int64_t dx, dy;
+	int bias;       /* 0 if pixels exactly on the edge are covered, 1 otherwise */
+} sw_edge;
+
+static void setup_edge(sw_edge *e, const int64_t *a, const int64_t *b)
+{
+	e->x = a[0];
+	e->y = a[1];
+	e->dx = b[0] - a[0];
+	e->dy = b[1] - a[1];
+	/*
+	 * Edges shared by two triangles are walked in opposite directions,
+	 * so this picks exactly one owner for the pixels lying on them.
+	 */
+	e->bias = (e->dy < 0 || (e->dy == 0 && e->dx > 0)) ? 0 : 1;
+}
+
+/* Narrows [*xs, *xe) to the pixels of row py that lie inside the edge */
+static void clip_span_to_edge(const sw_edge *e, int64_t py, int *xs, int *xe)
+{
+	/* E(px) = dx * (py - y) - dy * (px - x), px = x * ONE + ONE / 2 */
+	int64_t a = -e->dy * SUBPIXEL_ONE;
+	int64_t r = e->bias - e->dx * (py - e->y) - e->dy * e->x + e->dy * (SUBPIXEL_ONE / 2);
+
+	if (a > 0) {
+		int64_t lo = ceil_div(r, a);
+		if (lo > *xs)
+			*xs = lo > *xe ? *xe : (int)lo;
+	} else if (a < 0) {
+		int64_t hi = floor_div(r, a) + 1;
+		if (hi < *xe)
+			*xe = hi < *xs ? *xs : (int)hi;
+	} else if (r > 0) {
+		*xe = *xs;
+	}
+}
+
+static void raster_triangle(vita2d_sw_target *target,
+			    const float *p0, const float *p1, const float *p2,
+			    const float *t0, const float *t1, const float *t2,
+			    uint32_t color, const vita2d_sw_texture *texture)
+{
+	int64_t v[3][2];
+	const float *tc[3] = {t0, t1, t2};
+	int i;
+
+	v[0][0] = (int64_t)lrintf(p0[0] * SUBPIXEL_ONE);
+	v[0][1] = (int64_t)lrintf(p0[1] * SUBPIXEL_ONE);
+	v[1][0] = (int64_t)lrintf(p1[0] * SUBPIXEL_ONE);
+	v[1][1] = (int64_t)lrintf(p1[1] * SUBPIXEL_ONE);
+	v[2][0] = (int64_t)lrintf(p2[0] * SUBPIXEL_ONE);
+	v[2][1] = (int64_t)lrintf(p2[1] * SUBPIXEL_ONE);
+
+	int64_t area = (v[1][0] - v[0][0]) * (v[2][1] - v[0][1]) -
+		       (v[1][1] - v[0][1]) * (v[2][0] - v[0][0]);
+	if (area == 0)
+		return;
+
+	/* Normalize the winding so that inside means E >= 0 for every edge */
+	if (area < 0) {
+		int64_t tmp[2] = {v[1][0], v[1][1]};
+		const float *ttmp = tc[1];
+		v[1][0] = v[2][0];
+		v[1][1] = v[2][1];
+		v[2][0] = tmp[0];
+		v[2][1] = tmp[1];
+		tc[1] = tc[2];
+		tc[2] = ttmp;
+		area = -area;
+	}
+
+	sw_edge edges[3];
+	setup_edge(&edges[0], v[1], v[2]);
+	setup_edge(&edges[1], v[2], v[0]);
+	setup_edge(&edges[2], v[0], v[1]);
+
+	int cx0, cy0, cx1, cy1;
+	clip_bounds(target, &cx0, &cy0, &cx1, &cy1);
+
+	int64_t min_y = v[0][1], max_y = v[0][1];
+	for (i = 1; i < 3; i++) {
+		if (v[i][1] < min_y) min_y = v[i][1];
+		if (v[i][1] > max_y) max_y = v[i][1];
+	}
+	int y_start = (int)floor_div(min_y, SUBPIXEL_ONE);
+	int y_end = (int)floor_div(max_y, SUBPIXEL_ONE) + 1;
+	if (y_start < cy0) y_start = cy0;
+	if (y_end > cy1) y_end = cy1;
+
+	/*
+	 * Vertex i's barycentric weight is edge i's function over the area,
+	 * so u/v are affine in x and y with these gradients.
+	 */
+	int64_t dfu = 0, dfv = 0;
+	if (texture) {
+		double du_dx = 0, dv_dx = 0;
+		for (i = 0; i < 3; i++) {
+			double w = (double)(-edges[i].dy * SUBPIXEL_ONE) / area;
+			du_dx += w * tc[i][0];
+			dv_dx += w * tc[i][1];
+		}
+		dfu = (int64_t)floor(du_dx * texture->w * 65536.0 + 0.5);
+		dfv = (int64_t)floor(dv_dx * texture->h * 65536.0 + 0.5);
+	}
+
+	const int additive = target->additive_blending;
+	const int replace = target->no_blending;
+	const uint32_t alpha = color >> 24;
+	uint32_t src[SPAN_CHUNK];
+	int y;
+
+	if (!texture)
+		span_fill(src, color, SPAN_CHUNK);
+
+	for (y = y_start; y < y_end; y++) {
+		int64_t py = (int64_t)y * SUBPIXEL_ONE + SUBPIXEL_ONE / 2;
+		int xs = cx0, xe = cx1;
+
+		for (i = 0; i < 3 && xs < xe; i++)
+			clip_span_to_edge(&edges[i], py, &xs, &xe);
+		if (xs >= xe)
+			continue;
+
+		uint32_t *dst = &target->pixels[y * target->stride + xs];
+		int n = xe - xs;
+
+		if (!texture) {
+			if (replace || (!additive && alpha == 0xFF)) {
+				span_fill(dst, color, n);
+			} else if (additive || alpha != 0) {
+				int done;
+				for (done = 0; done < n; done += SPAN_CHUNK)
+					span_blend(dst + done, src, n - done < SPAN_CHUNK ? n - done : SPAN_CHUNK, additive);
+			}
+			continue;
+		}
+
+		int64_t px = (int64_t)xs * SUBPIXEL_ONE + SUBPIXEL_ONE / 2;
+		double u = 0, tv = 0;
+		for (i = 0; i < 3; i++) {
+			const sw_edge *e = &edges[i];
+			double w = (double)(e->dx * (py - e->y) - e->dy * (px - e->x)) / area;
+			u += w * tc[i][0];
+			tv += w * tc[i][1];
+		}
+
+		int64_t fu = (int64_t)floor(u * texture->w * 65536.0);
+		int64_t fv = (int64_t)floor(tv * texture->h * 65536.0);
+
+		while (n > 0) {
+			int chunk = n < SPAN_CHUNK ? n : SPAN_CHUNK;
+			int j;
+			for (j = 0; j < chunk; j++) {
+				uint32_t texel = sample(texture, fu, fv);
+				src[j] = color == 0xFFFFFFFF ? texel : modulate(texel, color);
+				fu += dfu;
+				fv += dfv;
+			}
+			if (replace)
+				memcpy(dst, src, chunk * sizeof(*dst));
+			else
+				span_blend(dst, src, chunk, additive);
+			dst += chunk;
+			n -= chunk;
+		}
+	}
+}
+
+static void draw_primitives(vita2d_sw_target *target, vita2d_sw_primitive mode,
+			    const float *vtx, const float *tcoord,
+			    const uint16_t *indices, unsigned int count,
+			    uint32_t color, const vita2d_sw_texture *texture)
+{
+#define IDX(n) (indices ? indices[(n)] : (n))
+#define VTX(n) (&vtx[IDX(n) * 2])
+#define TC(n) (tcoord ? &tcoord[IDX(n) * 2] : NULL)
+	unsigned int i;
+
+	if (!tcoord)
+		texture = NULL;
+
+	target->draw_calls++;
+	target->vertices += count;
+
+	switch (mode) {
+	case VITA2D_SW_POINTS:
+		for (i = 0; i < count; i++)
+			raster_point(target, VTX(i), color);
+		break;
+	case VITA2D_SW_LINES:
+		for (i = 0; i + 1 < count; i += 2)
+			raster_line(target, VTX(i), VTX(i + 1), color);
+		break;
+	case VITA2D_SW_TRIANGLES:
+		for (i = 0; i + 2 < count; i += 3)
+			raster_triangle(target, VTX(i), VTX(i + 1), VTX(i + 2),
+					TC(i), TC(i + 1), TC(i + 2), color, texture);
+		break;
+	case VITA2D_SW_TRIANGLE_STRIP:
+		for (i = 0; i + 2 < count; i++)
+			raster_triangle(target, VTX(i), VTX(i + 1), VTX(i + 2),
+					TC(i), TC(i + 1), TC(i + 2), color, texture);
+		break;
+	case VITA2D_SW_TRIANGLE_FAN:
+		for (i = 1; i + 1 < count; i++)
+			raster_triangle(target, VTX(0), VTX(i), VTX(i + 1),
+					TC(0), TC(i), TC(i + 1), color, texture);
+		break;
+	}
+#undef TC
+#undef VTX
+#undef IDX
+}
+
+vita2d_sw_target *vita2d_sw_create_target(unsigned int w, unsigned int h)
+{
+	vita2d_sw_target *target = malloc(sizeof(*target));
+	if (!target)
+		return NULL;
+
+	uint32_t *pixels = malloc(w * h * sizeof(uint32_t));
+	if (!pixels) {
+		free(target);
+		return NULL;
+	}
+
+	vita2d_sw_init_target(target, pixels, w, h, w);
+	target->owns_pixels = 1;
+	vita2d_sw_clear_screen(target);
+
+	return target;
+}
+
+void vita2d_sw_init_target(vita2d_sw_target *target, uint32_t *pixels, unsigned int w, unsigned int h, unsigned int stride)
+{
+	memset(target, 0, sizeof(*target));
+	target->pixels = pixels;
+	target->w = w;
+	target->h = h;
+	target->stride = stride;
+	target->clip[2] = w;
+	target->clip[3] = h;
+	target->clear_color = RGBA8(0, 0, 0, 0xFF);
+}
+
+void vita2d_sw_free_target(vita2d_sw_target *target)
+{
+	if (target) {
+		if (target->owns_pixels)
+			free(target->pixels);
+		free(target);
+	}
+}
+
+void vita2d_sw_set_clear_color(vita2d_sw_target *target, uint32_t color)
+{
+	target->clear_color = color;
+}
+
+void vita2d_sw_clear_screen(vita2d_sw_target *target)
+{
+	unsigned int y;
+	for (y = 0; y < target->h; y++)
+		span_fill(&target->pixels[y * target->stride], target->clear_color, target->w);
+}
+
+void vita2d_sw_set_blend_mode_add(vita2d_sw_target *target, int enable)
+{
+	target->additive_blending = enable;
+}
+
+void vita2d_sw_set_blending(vita2d_sw_target *target, int enable)
+{
+	target->no_blending = !enable;
+}
+
+void vita2d_sw_enable_clipping(vita2d_sw_target *target)
+{
+	target->clipping = 1;
+}
+
+void vita2d_sw_disable_clipping(vita2d_sw_target *target)
+{
+	target->clipping = 0;
+}
+
+void vita2d_sw_set_clip_rectangle(vita2d_sw_target *target, int x_min, int y_min, int x_max, int y_max)
+{
+	target->clip[0] = x_min;
+	target->clip[1] = y_min;
+	target->clip[2] = x_max;
+	target->clip[3] = y_max;
+}
+
+void vita2d_sw_init_texture(vita2d_sw_texture *texture, const void *data, unsigned int w, unsigned int h, unsigned int stride, vita2d_sw_format format)
+{
+	texture->data = data;
+	texture->w = w;
+	texture->h = h;
+	texture->stride = stride;
+	texture->format = format;
+	texture->filter = VITA2D_SW_FILTER_POINT;
+}
+
+void vita2d_sw_draw_arrays(vita2d_sw_target *target, vita2d_sw_primitive mode, const float *vtx, const float *tcoord, unsigned int count, uint32_t color, const vita2d_sw_texture *texture)
+{
+	draw_primitives(target, mode, vtx, tcoord, NULL, count, color, texture);
+}
+
+void vita2d_sw_draw_elements(vita2d_sw_target *target, vita2d_sw_primitive mode, const float *vtx, const float *tcoord, const uint16_t *indices, unsigned int count, uint32_t color, const vita2d_sw_texture *texture)
+{
+	draw_primitives(target, mode, vtx, tcoord, indices, count, color, texture);
+}
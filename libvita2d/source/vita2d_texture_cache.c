@@ -0,0 +1,274 @@
+#include <stdlib.h>
+#include <string.h>
+#include "vita2d_vgl.h"
+#include "vita2d_internal.h"
+#include "utils.h"
+
+#define TEXTURE_CACHE_BUCKETS 64
+
+struct vita2d_cached_texture {
+	vita2d_texture *texture;
+	char *path; // normalized, NULL for entries keyed by content
+	uint64_t content_hash;
+	unsigned long size;
+	uint32_t bucket;
+	unsigned int refs;
+	vita2d_cached_texture *next;
+};
+
+static vita2d_managed_texture *v2d_lru_head;
+static vita2d_managed_texture *v2d_lru_tail;
+static vita2d_cached_texture *v2d_texture_cache[TEXTURE_CACHE_BUCKETS];
+vita2d_texture_cache_stats v2d_cache_stats;
+
+static void _lru_unlink(vita2d_managed_texture *m) {
+	if (m->prev)
+		m->prev->next = m->next;
+	else
+		v2d_lru_head = m->next;
+	if (m->next)
+		m->next->prev = m->prev;
+	else
+		v2d_lru_tail = m->prev;
+	m->prev = m->next = NULL;
+}
+
+static void _lru_push_front(vita2d_managed_texture *m) {
+	m->prev = NULL;
+	m->next = v2d_lru_head;
+	if (v2d_lru_head)
+		v2d_lru_head->prev = m;
+	else
+		v2d_lru_tail = m;
+	v2d_lru_head = m;
+}
+
+static void _evict_texture(vita2d_managed_texture *m) {
+	vita2d_texture *texture = m->texture;
+
+	// vitaGL keeps the memory alive until the GPU is done with it
+	_flush_batch();
+	free(texture->staging);
+	texture->staging = NULL;
+	if (texture->palette) {
+		vita2d_free_palette(texture->palette);
+		texture->palette = NULL;
+	}
+	glDeleteTextures(1, &texture->tex_id);
+	texture->tex_id = 0;
+
+	_lru_unlink(m);
+	m->resident = 0;
+	v2d_cache_stats.resident_bytes -= m->bytes;
+	v2d_cache_stats.evictions++;
+	_account_texture(texture);
+}
+
+void _enforce_texture_budget(const vita2d_managed_texture *keep) {
+	vita2d_managed_texture *m = v2d_lru_tail;
+
+	if (v2d_cache_stats.budget_bytes == 0)
+		return;
+
+	// Textures drawn in the current frame would only be reloaded straight away
+	while (m && v2d_cache_stats.resident_bytes > v2d_cache_stats.budget_bytes) {
+		vita2d_managed_texture *prev = m->prev;
+		if (m != keep && m->texture->last_frame != v2d_frame)
+			_evict_texture(m);
+		m = prev;
+	}
+}
+
+int _make_resident(vita2d_texture *texture) {
+	vita2d_managed_texture *m = texture->managed;
+	vita2d_texture *loaded;
+
+	if (!m)
+		return 1;
+
+	if (m->resident) {
+		_lru_unlink(m);
+		_lru_push_front(m);
+		return 1;
+	}
+
+	loaded = m->filename ? m->file_loader(m->filename) : m->buffer_loader(m->buffer, m->buffer_size);
+	if (!loaded) {
+		v2d_cache_stats.reload_failures++;
+		return 0;
+	}
+
+	// Adopt the new GL texture, the filters chosen by the user are kept
+	texture->tex_id = loaded->tex_id;
+	texture->format = loaded->format;
+	texture->w = loaded->w;
+	texture->h = loaded->h;
+	texture->palette = loaded->palette;
+	texture->mip_levels = loaded->mip_levels;
+	_untrack_texture(loaded);
+	free(loaded->tag);
+	vglFree(loaded);
+
+	if (m->want_mipmaps && texture->mip_levels <= 1)
+		vita2d_texture_generate_mipmaps(texture);
+	vita2d_texture_set_filters(texture, texture->filters[0], texture->filters[1]);
+
+	m->resident = 1;
+	m->bytes = _texture_bytes(texture);
+	_account_texture(texture);
+	_lru_push_front(m);
+	v2d_cache_stats.resident_bytes += m->bytes;
+	_enforce_texture_budget(m);
+	return 1;
+}
+
+static vita2d_texture *_create_managed(vita2d_managed_texture *m) {
+	vita2d_texture *loaded = m->filename ? m->file_loader(m->filename) : m->buffer_loader(m->buffer, m->buffer_size);
+	if (!loaded) {
+		free(m->filename);
+		free(m);
+		return NULL;
+	}
+
+	m->texture = loaded;
+	m->resident = 1;
+	m->bytes = _texture_bytes(loaded);
+	loaded->managed = m;
+	_lru_push_front(m);
+	v2d_cache_stats.resident_bytes += m->bytes;
+	_enforce_texture_budget(m);
+	return loaded;
+}
+
+vita2d_texture *vita2d_load_managed_file(const char *filename, vita2d_file_loader loader) {
+	vita2d_managed_texture *m = calloc(1, sizeof(*m));
+	if (!m)
+		return NULL;
+
+	m->filename = strdup(filename);
+	m->file_loader = loader;
+	if (!m->filename) {
+		free(m);
+		return NULL;
+	}
+
+	return _create_managed(m);
+}
+
+vita2d_texture *vita2d_load_managed_buffer(const void *buffer, unsigned long buffer_size, vita2d_buffer_loader loader) {
+	vita2d_managed_texture *m = calloc(1, sizeof(*m));
+	if (!m)
+		return NULL;
+
+	m->buffer = buffer;
+	m->buffer_size = buffer_size;
+	m->buffer_loader = loader;
+	return _create_managed(m);
+}
+
+void vita2d_set_texture_budget(size_t bytes) {
+	v2d_cache_stats.budget_bytes = bytes;
+	_enforce_texture_budget(NULL);
+}
+
+void vita2d_get_texture_cache_stats(vita2d_texture_cache_stats *stats) {
+	*stats = v2d_cache_stats;
+}
+
+void vita2d_reset_texture_cache_stats() {
+	v2d_cache_stats.hits = 0;
+	v2d_cache_stats.misses = 0;
+	v2d_cache_stats.evictions = 0;
+	v2d_cache_stats.reload_failures = 0;
+}
+
+int vita2d_texture_is_resident(const vita2d_texture *texture) {
+	return !texture->managed || texture->managed->resident;
+}
+
+static vita2d_cached_texture *_cache_insert(vita2d_texture *texture, uint32_t bucket) {
+	vita2d_cached_texture *c = calloc(1, sizeof(*c));
+	if (!c)
+		return NULL;
+
+	c->texture = texture;
+	c->bucket = bucket;
+	c->refs = 1;
+	c->next = v2d_texture_cache[bucket];
+	v2d_texture_cache[bucket] = c;
+	texture->cached = c;
+	return c;
+}
+
+vita2d_texture *vita2d_texture_cache_get(const char *filename) {
+	vita2d_cached_texture *c;
+	char *path = normalize_path(filename);
+	if (!path)
+		return NULL;
+
+	uint32_t bucket = hash_buffer(path, strlen(path)) % TEXTURE_CACHE_BUCKETS;
+	for (c = v2d_texture_cache[bucket]; c; c = c->next) {
+		if (c->path && !strcmp(c->path, path)) {
+			free(path);
+			c->refs++;
+			return c->texture;
+		}
+	}
+
+	vita2d_texture *texture = vita2d_load_PNG_file(filename);
+	if (!texture || !(c = _cache_insert(texture, bucket))) {
+		if (texture)
+			vita2d_free_texture(texture);
+		free(path);
+		return NULL;
+	}
+
+	c->path = path;
+	return texture;
+}
+
+vita2d_texture *vita2d_texture_cache_get_buffer(const void *buffer, unsigned long buffer_size) {
+	vita2d_cached_texture *c;
+	uint64_t content_hash = hash_buffer(buffer, buffer_size);
+	uint32_t bucket = content_hash % TEXTURE_CACHE_BUCKETS;
+
+	for (c = v2d_texture_cache[bucket]; c; c = c->next) {
+		if (!c->path && c->size == buffer_size && c->content_hash == content_hash) {
+			c->refs++;
+			return c->texture;
+		}
+	}
+
+	vita2d_texture *texture = vita2d_load_PNG_buffer(buffer, buffer_size);
+	if (!texture || !(c = _cache_insert(texture, bucket))) {
+		if (texture)
+			vita2d_free_texture(texture);
+		return NULL;
+	}
+
+	c->content_hash = content_hash;
+	c->size = buffer_size;
+	return texture;
+}
+
+void _managed_texture_free(vita2d_managed_texture *m) {
+	if (m->resident) {
+		_lru_unlink(m);
+		v2d_cache_stats.resident_bytes -= m->bytes;
+	}
+	free(m->filename);
+	free(m);
+}
+
+unsigned int _texture_cache_release(vita2d_cached_texture *c) {
+	vita2d_cached_texture **link;
+
+	if (--c->refs > 0)
+		return c->refs;
+	for (link = &v2d_texture_cache[c->bucket]; *link != c; link = &(*link)->next)
+		;
+	*link = c->next;
+	free(c->path);
+	free(c);
+	return 0;
+}
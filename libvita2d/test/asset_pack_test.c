@@ -0,0 +1,188 @@
+/*
+ * Host tests for asset_pack.c: validation of every offset in the pack and
+ * the hash lookup, on packs laid out in memory the way tools/asset_packer
+ * writes them.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "asset_pack.h"
+#include "utils.h"
+#include "check.h"
+
+typedef struct pack {
+	uint8_t *data;
+	size_t size;
+	asset_pack_header *header;
+	asset_pack_entry *entries;
+} pack;
+
+static const char *names[] = {"ui/button.png", "ui/font.pvf", "music/title.ogg", "empty", "level1.bin"};
+#define NUM_NAMES (sizeof(names) / sizeof(*names))
+
+static int compare_hash(const void *a, const void *b)
+{
+	const asset_pack_entry *ea = a, *eb = b;
+	return ea->hash < eb->hash ? -1 : ea->hash > eb->hash;
+}
+
+/*
+ * Entry i holds names[i] and i * 5 bytes of the value i. Hashes are taken from
+ * 'hashes' when given, so collisions can be forced.
+ */
+static void make_pack(pack *p, const char **pack_names, unsigned int count, const uint32_t *hashes)
+{
+	uint32_t names_size = 0, offset;
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		names_size += strlen(pack_names[i]) + 1;
+	uint32_t names_offset = sizeof(asset_pack_header) + count * sizeof(asset_pack_entry);
+	offset = ALIGN(names_offset + names_size, ASSET_PACK_ALIGNMENT);
+	p->size = offset;
+	for (i = 0; i < count; i++)
+		p->size = ALIGN(p->size + i * 5, ASSET_PACK_ALIGNMENT);
+
+	p->data = calloc(1, p->size);
+	p->header = (asset_pack_header *)p->data;
+	p->entries = (asset_pack_entry *)(p->header + 1);
+	p->header->magic = ASSET_PACK_MAGIC;
+	p->header->version = ASSET_PACK_VERSION;
+	p->header->num_entries = count;
+	p->header->names_offset = names_offset;
+	p->header->names_size = names_size;
+
+	names_size = 0;
+	for (i = 0; i < count; i++) {
+		asset_pack_entry *e = &p->entries[i];
+		e->hash = hashes ? hashes[i] : asset_pack_hash(pack_names[i]);
+		e->name = names_size;
+		e->offset = offset;
+		e->size = i * 5;
+		strcpy((char *)p->data + names_offset + names_size, pack_names[i]);
+		memset(p->data + offset, i, e->size);
+		names_size += strlen(pack_names[i]) + 1;
+		offset = ALIGN(offset + e->size, ASSET_PACK_ALIGNMENT);
+	}
+	qsort(p->entries, count, sizeof(*p->entries), compare_hash);
+}
+
+static void test_hash(void)
+{
+	/* The pack format is FNV-1a, shared with the atlas index */
+	CHECK(asset_pack_hash("") == 0x811C9DC5u);
+	CHECK(asset_pack_hash("foobar") == 0xBF9CF968u);
+	CHECK(asset_pack_hash("ui/button.png") == hash_string("ui/button.png"));
+}
+
+static void test_validate(void)
+{
+	pack p;
+
+	make_pack(&p, names, NUM_NAMES, NULL);
+	CHECK(asset_pack_validate(p.data, p.size) == p.header);
+	CHECK(asset_pack_validate(p.data, sizeof(asset_pack_header) - 1) == NULL);
+
+	/* The last blob has to fit */
+	CHECK(asset_pack_validate(p.data, p.size - ASSET_PACK_ALIGNMENT) == NULL);
+
+	p.header->magic++;
+	CHECK(asset_pack_validate(p.data, p.size) == NULL);
+	p.header->magic--;
+	p.header->version++;
+	CHECK(asset_pack_validate(p.data, p.size) == NULL);
+	p.header->version--;
+
+	p.header->num_entries = 0x10000000;
+	CHECK(asset_pack_validate(p.data, p.size) == NULL);
+	p.header->num_entries = NUM_NAMES;
+
+	/* String table: inside the pack, not empty, NUL terminated */
+	p.header->names_offset = p.size + 1;
+	CHECK(asset_pack_validate(p.data, p.size) == NULL);
+	p.header->names_offset = sizeof(asset_pack_header) + NUM_NAMES * sizeof(asset_pack_entry);
+	p.header->names_size += p.size;
+	CHECK(asset_pack_validate(p.data, p.size) == NULL);
+	p.header->names_size -= p.size;
+	p.header->names_size--;
+	CHECK(asset_pack_validate(p.data, p.size) == NULL);
+	p.header->names_size++;
+	CHECK(asset_pack_validate(p.data, p.size) == p.header);
+
+	/* Entries: name and blob inside the pack, sorted by hash */
+	p.entries[1].name = p.header->names_size;
+	CHECK(asset_pack_validate(p.data, p.size) == NULL);
+	p.entries[1].name = 0;
+	p.entries[2].offset = p.size + 1;
+	CHECK(asset_pack_validate(p.data, p.size) == NULL);
+	p.entries[2].offset = p.size - 4;
+	p.entries[2].size = 5;
+	CHECK(asset_pack_validate(p.data, p.size) == NULL);
+	p.entries[2].size = 4;
+	CHECK(asset_pack_validate(p.data, p.size) == p.header);
+
+	asset_pack_entry tmp = p.entries[0];
+	p.entries[0] = p.entries[1];
+	p.entries[1] = tmp;
+	CHECK(asset_pack_validate(p.data, p.size) == NULL);
+	free(p.data);
+
+	/* A pack without entries has no string table, the packer never writes one */
+	make_pack(&p, names, 0, NULL);
+	CHECK(asset_pack_validate(p.data, p.size) == NULL);
+	free(p.data);
+}
+
+static void test_find(void)
+{
+	const asset_pack_entry *e;
+	unsigned int i;
+	int found;
+	pack p;
+
+	make_pack(&p, names, NUM_NAMES, NULL);
+	for (i = 0; i < NUM_NAMES; i++) {
+		found = asset_pack_find(p.header, names[i]);
+		CHECK(found >= 0 && !strcmp(asset_pack_name(p.header, &p.entries[found]), names[i]));
+		e = &p.entries[found >= 0 ? found : 0];
+		CHECK(found >= 0 && e->size == i * 5 && (e->size == 0 || p.data[e->offset] == i));
+	}
+	CHECK(asset_pack_find(p.header, "ui/missing.png") == -1);
+	CHECK(asset_pack_find(p.header, "UI/button.png") == -1);
+	CHECK(asset_pack_find(p.header, "") == -1);
+	free(p.data);
+}
+
+static void test_find_collision(void)
+{
+	static const char *colliding[] = {"first", "second", "third"};
+	uint32_t hashes[3];
+	unsigned int i;
+	pack p;
+
+	/* "second" and "third" are stored under the hash of "first" */
+	hashes[0] = hashes[1] = hashes[2] = asset_pack_hash("first");
+	make_pack(&p, colliding, 3, hashes);
+	CHECK(asset_pack_validate(p.data, p.size) == p.header);
+
+	/* Move "first" to the end of the run, the lookup has to walk past the others */
+	for (i = 0; i < 2; i++) {
+		if (!strcmp(asset_pack_name(p.header, &p.entries[i]), "first")) {
+			asset_pack_entry tmp = p.entries[i];
+			p.entries[i] = p.entries[2];
+			p.entries[2] = tmp;
+		}
+	}
+	CHECK(asset_pack_find(p.header, "first") == 2);
+	CHECK(asset_pack_find(p.header, "second") == -1);
+	free(p.data);
+}
+
+int main(void)
+{
+	test_hash();
+	test_validate();
+	test_find();
+	test_find_collision();
+	return check_report("asset_pack");
+}
@@ -0,0 +1,112 @@
+/*
+ * Host tests for atlas_index.c: the name hash, header validation and the
+ * sorted lookup, on indexes built in memory the way tools/atlas_baker does.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "atlas_index.h"
+#include "check.h"
+
+static const char *names[] = {"player", "enemy", "coin", "tiles/grass", "tiles/water", "ui_button"};
+#define NUM_NAMES (sizeof(names) / sizeof(*names))
+
+static int compare_hash(const void *a, const void *b)
+{
+	const atlas_index_sprite *sa = a, *sb = b;
+	return sa->hash < sb->hash ? -1 : sa->hash > sb->hash;
+}
+
+/* Header plus every name in names[], page i % 2 */
+static atlas_index_header *make_index(size_t *size)
+{
+	atlas_index_header *header;
+	atlas_index_sprite *sprites;
+	unsigned int i;
+
+	*size = sizeof(*header) + NUM_NAMES * sizeof(*sprites);
+	header = calloc(1, *size);
+	header->magic = ATLAS_INDEX_MAGIC;
+	header->version = ATLAS_INDEX_VERSION;
+	header->num_pages = 2;
+	header->num_sprites = NUM_NAMES;
+	strcpy(header->texture_file, "atlas.gxt");
+
+	sprites = (atlas_index_sprite *)(header + 1);
+	for (i = 0; i < NUM_NAMES; i++) {
+		sprites[i].hash = atlas_index_hash(names[i]);
+		sprites[i].page = i % 2;
+		sprites[i].w = 16 + i;
+		sprites[i].h = 8 + i;
+	}
+	qsort(sprites, NUM_NAMES, sizeof(*sprites), compare_hash);
+	return header;
+}
+
+static void test_hash(void)
+{
+	/* Reference FNV-1a values, the baked files depend on them */
+	CHECK(atlas_index_hash("") == 0x811C9DC5u);
+	CHECK(atlas_index_hash("a") == 0xE40C292Cu);
+	CHECK(atlas_index_hash("foobar") == 0xBF9CF968u);
+	CHECK(atlas_index_hash("player") != atlas_index_hash("Player"));
+}
+
+static void test_validate(void)
+{
+	atlas_index_header *header;
+	size_t size;
+
+	header = make_index(&size);
+	CHECK(atlas_index_validate(header, size) == header);
+	CHECK(atlas_index_validate(header, sizeof(*header) - 1) == NULL);
+	/* The sprite table has to fit */
+	CHECK(atlas_index_validate(header, size - 1) == NULL);
+	header->num_sprites = 0xFFFFFFFF;
+	CHECK(atlas_index_validate(header, size) == NULL);
+	header->num_sprites = NUM_NAMES;
+
+	header->magic ^= 1;
+	CHECK(atlas_index_validate(header, size) == NULL);
+	header->magic ^= 1;
+	header->version++;
+	CHECK(atlas_index_validate(header, size) == NULL);
+	header->version--;
+
+	/* The GXT name must be terminated inside the header */
+	memset(header->texture_file, 'x', sizeof(header->texture_file));
+	CHECK(atlas_index_validate(header, size) == NULL);
+	free(header);
+}
+
+static void test_find(void)
+{
+	const atlas_index_sprite *sprites;
+	atlas_index_header *header;
+	unsigned int i;
+	size_t size;
+	int found;
+
+	header = make_index(&size);
+	sprites = atlas_index_sprites(header);
+	for (i = 0; i < NUM_NAMES; i++) {
+		found = atlas_index_find(header, names[i]);
+		CHECK(found >= 0 && sprites[found].hash == atlas_index_hash(names[i]));
+		CHECK(found >= 0 && sprites[found].w == 16 + i && sprites[found].page == i % 2);
+	}
+	CHECK(atlas_index_find(header, "missing") == -1);
+	CHECK(atlas_index_find(header, "") == -1);
+	CHECK(atlas_index_find(header, "player.png") == -1);
+
+	header->num_sprites = 0;
+	CHECK(atlas_index_find(header, "player") == -1);
+	free(header);
+}
+
+int main(void)
+{
+	test_hash();
+	test_validate();
+	test_find();
+	return check_report("atlas_index");
+}
@@ -0,0 +1,29 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+/*
+ * Minimal check macros shared by the host unit tests. A failed CHECK prints
+ * its location and keeps going, so one run reports every broken case.
+ */
+
+#include <stdio.h>
+
+static int checks_run;
+static int checks_failed;
+
+#define CHECK(cond) do { \
+	checks_run++; \
+	if (!(cond)) { \
+		checks_failed++; \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+	} \
+} while (0)
+
+/* Prints the summary line, returns the process exit code */
+static inline int check_report(const char *name)
+{
+	printf("%s: %d/%d checks passed\n", name, checks_run - checks_failed, checks_run);
+	return checks_failed ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,302 @@
+/*
+ * Host tests for compressed_texture.c: DDS (with and without the DX10
+ * header), PVR v2/v3 and KTX in both byte orders, built in memory, plus the
+ * level size rules and truncated inputs.
+ */
+
+#include <string.h>
+#include "compressed_texture.h"
+#include "check.h"
+
+#define FOURCC(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+static uint8_t buf[8192];
+
+static void put_u32(uint8_t *p, uint32_t v, int big_endian)
+{
+	if (big_endian) {
+		p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+	} else {
+		p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+	}
+}
+
+/* DDS header for w x h, 'levels' mips, returns where the payload starts */
+static size_t make_dds(uint32_t fourcc, unsigned int w, unsigned int h, unsigned int levels)
+{
+	uint8_t *header = buf + 4;
+
+	memset(buf, 0, sizeof(buf));
+	put_u32(buf, FOURCC('D', 'D', 'S', ' '), 0);
+	put_u32(header, 124, 0);
+	put_u32(header + 4, levels ? 0x20000 : 0, 0);
+	put_u32(header + 8, h, 0);
+	put_u32(header + 12, w, 0);
+	put_u32(header + 24, levels, 0);
+	put_u32(header + 72 + 4, 0x4, 0);
+	put_u32(header + 72 + 8, fourcc, 0);
+	return 4 + 124;
+}
+
+static size_t make_pvr3(uint32_t format, unsigned int w, unsigned int h, unsigned int levels,
+			unsigned int surfaces, unsigned int faces, unsigned int meta_size)
+{
+	memset(buf, 0, sizeof(buf));
+	put_u32(buf, 0x03525650, 0);
+	put_u32(buf + 8, format, 0);
+	put_u32(buf + 24, h, 0);
+	put_u32(buf + 28, w, 0);
+	put_u32(buf + 32, 1, 0);
+	put_u32(buf + 36, surfaces, 0);
+	put_u32(buf + 40, faces, 0);
+	put_u32(buf + 44, levels, 0);
+	put_u32(buf + 48, meta_size, 0);
+	return 52 + meta_size;
+}
+
+static size_t make_pvr2(uint32_t flags, uint32_t alpha_mask, unsigned int w, unsigned int h, unsigned int levels)
+{
+	memset(buf, 0, sizeof(buf));
+	put_u32(buf, 52, 0);
+	put_u32(buf + 4, h, 0);
+	put_u32(buf + 8, w, 0);
+	put_u32(buf + 12, levels - 1, 0);
+	put_u32(buf + 16, flags, 0);
+	put_u32(buf + 40, alpha_mask, 0);
+	put_u32(buf + 44, 0x21525650, 0);
+	return 52;
+}
+
+static size_t make_ktx(uint32_t internal_format, unsigned int w, unsigned int h, unsigned int levels,
+		       unsigned int faces, unsigned int kv_size, int big_endian)
+{
+	static const uint8_t identifier[12] = {
+		0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+	};
+
+	memset(buf, 0, sizeof(buf));
+	memcpy(buf, identifier, sizeof(identifier));
+	put_u32(buf + 12, 0x04030201, big_endian);
+	put_u32(buf + 28, internal_format, big_endian);
+	put_u32(buf + 36, w, big_endian);
+	put_u32(buf + 40, h, big_endian);
+	put_u32(buf + 52, faces, big_endian);
+	put_u32(buf + 56, levels, big_endian);
+	put_u32(buf + 60, kv_size, big_endian);
+	return 64 + kv_size;
+}
+
+static int check_level(const compressed_texture *tex, unsigned int i, size_t offset, size_t size,
+		       unsigned int w, unsigned int h)
+{
+	return i < tex->num_levels && tex->levels[i].data == buf + offset && tex->levels[i].size == size &&
+	       tex->levels[i].w == w && tex->levels[i].h == h;
+}
+
+static void test_level_size(void)
+{
+	CHECK(compressed_texture_level_size(COMPRESSED_TEXTURE_DXT1_RGBA, 1, 1) == 8);
+	CHECK(compressed_texture_level_size(COMPRESSED_TEXTURE_DXT1_RGB, 5, 5) == 32);
+	CHECK(compressed_texture_level_size(COMPRESSED_TEXTURE_DXT3, 1, 1) == 16);
+	CHECK(compressed_texture_level_size(COMPRESSED_TEXTURE_DXT5, 8, 4) == 32);
+	CHECK(compressed_texture_level_size(COMPRESSED_TEXTURE_ETC1, 4, 4) == 8);
+
+	/* PVRTC is padded to 2x2 blocks: 16x8 pixels at 2bpp, 8x8 at 4bpp */
+	CHECK(compressed_texture_level_size(COMPRESSED_TEXTURE_PVRTC_2BPP_RGB, 1, 1) == 32);
+	CHECK(compressed_texture_level_size(COMPRESSED_TEXTURE_PVRTC_2BPP_RGBA, 16, 8) == 32);
+	CHECK(compressed_texture_level_size(COMPRESSED_TEXTURE_PVRTC_2BPP_RGBA, 32, 8) == 64);
+	CHECK(compressed_texture_level_size(COMPRESSED_TEXTURE_PVRTC_4BPP_RGB, 1, 1) == 32);
+	CHECK(compressed_texture_level_size(COMPRESSED_TEXTURE_PVRTC_4BPP_RGBA, 8, 8) == 32);
+	CHECK(compressed_texture_level_size(COMPRESSED_TEXTURE_PVRTC_4BPP_RGBA, 4, 16) == 64);
+
+	CHECK(compressed_texture_level_size(COMPRESSED_TEXTURE_UNKNOWN, 4, 4) == 0);
+}
+
+static void test_dds(void)
+{
+	compressed_texture tex;
+	size_t off;
+
+	/* 4x4 DXT1 down to 1x1, every level is one block */
+	off = make_dds(FOURCC('D', 'X', 'T', '1'), 4, 4, 3);
+	CHECK(compressed_texture_parse(buf, off + 24, &tex) == 0);
+	CHECK(tex.format == COMPRESSED_TEXTURE_DXT1_RGBA && tex.w == 4 && tex.h == 4);
+	CHECK(tex.num_levels == 3);
+	CHECK(check_level(&tex, 0, off, 8, 4, 4));
+	CHECK(check_level(&tex, 1, off + 8, 8, 2, 2));
+	CHECK(check_level(&tex, 2, off + 16, 8, 1, 1));
+
+	/* No DDSD_MIPMAPCOUNT means a single level */
+	off = make_dds(FOURCC('D', 'X', 'T', '5'), 8, 8, 0);
+	CHECK(compressed_texture_parse(buf, off + 64, &tex) == 0);
+	CHECK(tex.format == COMPRESSED_TEXTURE_DXT5 && tex.num_levels == 1);
+	CHECK(check_level(&tex, 0, off, 64, 8, 8));
+
+	/* DX10 header, BC2 */
+	off = make_dds(FOURCC('D', 'X', '1', '0'), 8, 4, 2);
+	put_u32(buf + off, 74, 0);
+	off += 20;
+	CHECK(compressed_texture_parse(buf, off + 32 + 16, &tex) == 0);
+	CHECK(tex.format == COMPRESSED_TEXTURE_DXT3 && tex.num_levels == 2);
+	CHECK(check_level(&tex, 0, off, 32, 8, 4));
+	CHECK(check_level(&tex, 1, off + 32, 16, 4, 2));
+
+	/* Unsupported DXGI format, and a DX10 header cut short */
+	off = make_dds(FOURCC('D', 'X', '1', '0'), 4, 4, 1);
+	put_u32(buf + off, 28, 0);
+	CHECK(compressed_texture_parse(buf, off + 20 + 8, &tex) == -1);
+	put_u32(buf + off, 71, 0);
+	CHECK(compressed_texture_parse(buf, off + 20 + 8, &tex) == 0);
+	CHECK(compressed_texture_parse(buf, off + 10, &tex) == -1);
+
+	/* Uncompressed pixel formats aren't handled */
+	off = make_dds(0, 4, 4, 1);
+	put_u32(buf + 4 + 72 + 4, 0x40, 0);
+	CHECK(compressed_texture_parse(buf, off + 64, &tex) == -1);
+}
+
+static void test_pvr3(void)
+{
+	compressed_texture tex;
+	size_t off;
+
+	/* Metadata is skipped, 8x8 PVRTC 4bpp down to the 8x8 minimum */
+	off = make_pvr3(3, 16, 16, 3, 1, 1, 12);
+	CHECK(compressed_texture_parse(buf, off + 128 + 32 + 32, &tex) == 0);
+	CHECK(tex.format == COMPRESSED_TEXTURE_PVRTC_4BPP_RGBA && tex.w == 16 && tex.h == 16);
+	CHECK(tex.num_levels == 3);
+	CHECK(check_level(&tex, 0, off, 128, 16, 16));
+	CHECK(check_level(&tex, 1, off + 128, 32, 8, 8));
+	CHECK(check_level(&tex, 2, off + 160, 32, 4, 4));
+
+	/* Each level holds every surface and face, only the first copy is used */
+	off = make_pvr3(7, 8, 8, 2, 2, 6, 0);
+	CHECK(compressed_texture_parse(buf, off + 32 * 12 + 8 * 12, &tex) == 0);
+	CHECK(tex.format == COMPRESSED_TEXTURE_DXT1_RGBA && tex.num_levels == 2);
+	CHECK(check_level(&tex, 0, off, 32, 8, 8));
+	CHECK(check_level(&tex, 1, off + 32 * 12, 8, 4, 4));
+
+	/* The second level's copies don't all fit, it is still usable */
+	CHECK(compressed_texture_parse(buf, off + 32 * 12 + 8, &tex) == 0);
+	CHECK(tex.num_levels == 2);
+	CHECK(compressed_texture_parse(buf, off + 32 * 12 + 4, &tex) == 0);
+	CHECK(tex.num_levels == 1);
+
+	/* Channel layouts (uncompressed) and metadata past the end */
+	off = make_pvr3(0, 16, 8, 1, 1, 1, 0);
+	put_u32(buf + 12, 0x08080808, 0);
+	CHECK(compressed_texture_parse(buf, off + 32, &tex) == -1);
+	off = make_pvr3(0, 16, 8, 1, 1, 1, 4096);
+	CHECK(compressed_texture_parse(buf, 52 + 100, &tex) == -1);
+	CHECK(compressed_texture_parse(buf, 40, &tex) == -1);
+}
+
+static void test_pvr2(void)
+{
+	compressed_texture tex;
+	size_t off;
+
+	/* PVRTC 2bpp pads to 16x8 */
+	off = make_pvr2(0x18, 0xFF, 32, 16, 3);
+	CHECK(compressed_texture_parse(buf, off + 128 + 32 + 32, &tex) == 0);
+	CHECK(tex.format == COMPRESSED_TEXTURE_PVRTC_2BPP_RGBA && tex.num_levels == 3);
+	CHECK(check_level(&tex, 0, off, 128, 32, 16));
+	CHECK(check_level(&tex, 1, off + 128, 32, 16, 8));
+	CHECK(check_level(&tex, 2, off + 160, 32, 8, 4));
+
+	off = make_pvr2(0x19, 0, 8, 8, 1);
+	CHECK(compressed_texture_parse(buf, off + 32, &tex) == 0);
+	CHECK(tex.format == COMPRESSED_TEXTURE_PVRTC_4BPP_RGB && tex.num_levels == 1);
+
+	off = make_pvr2(0x36, 0, 8, 8, 1);
+	CHECK(compressed_texture_parse(buf, off + 32, &tex) == 0);
+	CHECK(tex.format == COMPRESSED_TEXTURE_ETC1);
+
+	/* Not a compressed format, and no room for the first level */
+	off = make_pvr2(0x12, 0, 8, 8, 1);
+	CHECK(compressed_texture_parse(buf, off + 256, &tex) == -1);
+	off = make_pvr2(0x19, 0, 8, 8, 1);
+	CHECK(compressed_texture_parse(buf, off + 31, &tex) == -1);
+}
+
+static void test_ktx(int big_endian)
+{
+	compressed_texture tex;
+	size_t off;
+
+	/* Level sizes are prefixed, key/value data is skipped */
+	off = make_ktx(0x83F3, 8, 8, 4, 1, 16, big_endian);
+	put_u32(buf + off, 64, big_endian);
+	put_u32(buf + off + 4 + 64, 16, big_endian);
+	put_u32(buf + off + 4 + 64 + 4 + 16, 16, big_endian);
+	put_u32(buf + off + 4 + 64 + 4 + 16 + 4 + 16, 16, big_endian);
+	CHECK(compressed_texture_parse(buf, off + 4 * 4 + 64 + 16 * 3, &tex) == 0);
+	CHECK(tex.format == COMPRESSED_TEXTURE_DXT5 && tex.w == 8 && tex.h == 8);
+	CHECK(tex.num_levels == 4);
+	CHECK(check_level(&tex, 0, off + 4, 64, 8, 8));
+	CHECK(check_level(&tex, 1, off + 4 + 64 + 4, 16, 4, 4));
+	CHECK(check_level(&tex, 3, off + 4 * 4 + 64 + 16 * 2, 16, 1, 1));
+
+	/* Last level cut short: dropped */
+	CHECK(compressed_texture_parse(buf, off + 4 * 4 + 64 + 16 * 3 - 1, &tex) == 0);
+	CHECK(tex.num_levels == 3);
+	/* Size prefix of the first level missing */
+	CHECK(compressed_texture_parse(buf, off + 2, &tex) == -1);
+
+	/*
+	 * Cube map: six faces per level, each padded to 4 bytes. The 10-byte
+	 * imageSize is larger than the one DXT1 block, so padding shows.
+	 */
+	off = make_ktx(0x83F0, 4, 4, 2, 6, 0, big_endian);
+	put_u32(buf + off, 10, big_endian);
+	put_u32(buf + off + 4 + 12 * 6, 8, big_endian);
+	CHECK(compressed_texture_parse(buf, off + 4 + 12 * 6 + 4 + 8 * 6, &tex) == 0);
+	CHECK(tex.format == COMPRESSED_TEXTURE_DXT1_RGB && tex.num_levels == 2);
+	CHECK(check_level(&tex, 0, off + 4, 8, 4, 4));
+	CHECK(check_level(&tex, 1, off + 4 + 12 * 6 + 4, 8, 2, 2));
+
+	/* imageSize smaller than the format needs */
+	off = make_ktx(0x8C00, 8, 8, 1, 1, 0, big_endian);
+	put_u32(buf + off, 16, big_endian);
+	CHECK(compressed_texture_parse(buf, off + 4 + 32, &tex) == -1);
+	put_u32(buf + off, 32, big_endian);
+	CHECK(compressed_texture_parse(buf, off + 4 + 32, &tex) == 0);
+	CHECK(tex.format == COMPRESSED_TEXTURE_PVRTC_4BPP_RGB);
+
+	/* Uncompressed glType, and key/value data past the end */
+	off = make_ktx(0x83F1, 4, 4, 1, 1, 0, big_endian);
+	put_u32(buf + 16, 0x1401, big_endian);
+	CHECK(compressed_texture_parse(buf, off + 12, &tex) == -1);
+	off = make_ktx(0x83F1, 4, 4, 1, 1, 1024, big_endian);
+	CHECK(compressed_texture_parse(buf, 64 + 12, &tex) == -1);
+}
+
+static void test_garbage(void)
+{
+	compressed_texture tex;
+
+	memset(buf, 0, sizeof(buf));
+	CHECK(compressed_texture_parse(buf, 256, &tex) == -1);
+	CHECK(compressed_texture_parse(buf, 0, &tex) == -1);
+
+	/* Truncated headers */
+	make_dds(FOURCC('D', 'X', 'T', '1'), 4, 4, 1);
+	CHECK(compressed_texture_parse(buf, 100, &tex) == -1);
+	make_ktx(0x83F1, 4, 4, 1, 1, 0, 0);
+	CHECK(compressed_texture_parse(buf, 60, &tex) == -1);
+	make_ktx(0x83F1, 4, 4, 1, 1, 0, 0);
+	put_u32(buf + 12, 0x01020304 ^ 0xFF, 0);
+	CHECK(compressed_texture_parse(buf, 256, &tex) == -1);
+}
+
+int main(void)
+{
+	test_level_size();
+	test_dds();
+	test_pvr3();
+	test_pvr2();
+	test_ktx(0);
+	test_ktx(1);
+	test_garbage();
+	return check_report("compressed_texture");
+}
@@ -0,0 +1,244 @@
+/*
+ * Host tests for disk_cache.c: entry names, write/read round trips and every
+ * reason an entry counts as a miss (key, version, checksum, size, truncation),
+ * in a temporary directory.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "disk_cache.h"
+#include "check.h"
+
+typedef struct destination {
+	uint8_t *pixels;
+	size_t size;
+	int fail;
+} destination;
+
+static void *destination_alloc(const disk_cache_header *header, void *userdata)
+{
+	destination *dst = userdata;
+
+	if (dst->fail)
+		return NULL;
+	free(dst->pixels);
+	dst->size = (size_t)header->stride * header->h;
+	dst->pixels = malloc(dst->size);
+	return dst->pixels;
+}
+
+static disk_cache_key make_key(uint64_t hash)
+{
+	disk_cache_key key;
+
+	memset(&key, 0, sizeof(key));
+	key.hash = hash;
+	key.mtime = 1700000000;
+	key.size = 12345;
+	key.format = 0x0C001000;
+	key.options[0] = 1;
+	return key;
+}
+
+/* Overwrites 'size' bytes of the file at 'offset' */
+static void patch_file(const char *path, long offset, const void *data, size_t size)
+{
+	FILE *fp = fopen(path, "r+b");
+
+	fseek(fp, offset, SEEK_SET);
+	fwrite(data, 1, size, fp);
+	fclose(fp);
+}
+
+static void flip_byte(const char *path, long offset)
+{
+	FILE *fp = fopen(path, "r+b");
+	int c;
+
+	fseek(fp, offset, SEEK_SET);
+	c = fgetc(fp);
+	fseek(fp, offset, SEEK_SET);
+	fputc(c ^ 0xFF, fp);
+	fclose(fp);
+}
+
+static void test_path(void)
+{
+	disk_cache_key a = make_key(1), b = make_key(1);
+	char path_a[256], path_b[256], small[24];
+
+	CHECK(disk_cache_path("ux0:data/cache", &a, path_a, sizeof(path_a)) == 0);
+	CHECK(strncmp(path_a, "ux0:data/cache/", 15) == 0 && strlen(path_a) == 15 + 16 + 5);
+	CHECK(strcmp(path_a + strlen(path_a) - 5, DISK_CACHE_EXTENSION) == 0);
+
+	/* Every key field changes the name */
+	CHECK(disk_cache_path("ux0:data/cache", &b, path_b, sizeof(path_b)) == 0 && !strcmp(path_a, path_b));
+	b.mtime++;
+	CHECK(disk_cache_path("ux0:data/cache", &b, path_b, sizeof(path_b)) == 0 && strcmp(path_a, path_b));
+	b = a;
+	b.options[3] = 1;
+	CHECK(disk_cache_path("ux0:data/cache", &b, path_b, sizeof(path_b)) == 0 && strcmp(path_a, path_b));
+
+	CHECK(disk_cache_path("ux0:data/cache", &a, small, sizeof(small)) == -1);
+}
+
+static void test_round_trip(const char *dir)
+{
+	disk_cache_key key = make_key(0xFEEDFACECAFEBEEFULL), other;
+	destination dst = {0};
+	disk_cache_header header;
+	unsigned int w = 100, h = 60, stride = 128 * 4, i;
+	uint8_t *pixels = malloc(stride * h);
+	char path[256];
+	long written;
+
+	for (i = 0; i < stride * h; i++)
+		pixels[i] = (i % stride) < w * 4 ? (uint8_t)(i / 4 + i / stride) : 0;
+
+	CHECK(disk_cache_path(dir, &key, path, sizeof(path)) == 0);
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == -1);
+
+	written = disk_cache_write(path, &key, w, h, stride, 4321, pixels);
+	CHECK(written > (long)sizeof(header) && written < (long)(sizeof(header) + stride * h));
+	CHECK(access(path, F_OK) == 0);
+
+	memset(&header, 0, sizeof(header));
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == 0);
+	CHECK(header.w == w && header.h == h && header.stride == stride && header.decode_us == 4321);
+	CHECK(header.compressed_size == written - sizeof(header));
+	CHECK(dst.pixels && dst.size == stride * h && memcmp(dst.pixels, pixels, dst.size) == 0);
+
+	/* A key that differs in any field is a miss, even under the same name */
+	other = key;
+	other.format++;
+	CHECK(disk_cache_read(path, &other, destination_alloc, &dst, &header) == -1);
+
+	/* No destination, no hit */
+	dst.fail = 1;
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == -1);
+	dst.fail = 0;
+
+	/* Rewriting an entry replaces it */
+	pixels[0] ^= 0xFF;
+	CHECK(disk_cache_write(path, &key, w, h, stride, 1, pixels) > 0);
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == 0);
+	CHECK(header.decode_us == 1 && dst.pixels[0] == pixels[0]);
+
+	/* Nothing to write */
+	CHECK(disk_cache_write(path, &key, w, 0, stride, 1, pixels) == -1);
+	CHECK(disk_cache_write(path, &key, 8192, 8192, 8192 * 4, 1, pixels) == -1);
+
+	free(dst.pixels);
+	free(pixels);
+}
+
+static void test_corrupt(const char *dir)
+{
+	disk_cache_key key = make_key(42);
+	destination dst = {0};
+	disk_cache_header header;
+	uint32_t pixels[64 * 64], value;
+	char path[256];
+	long written;
+	unsigned int i;
+
+	for (i = 0; i < 64 * 64; i++)
+		pixels[i] = i * 2654435761u;
+	CHECK(disk_cache_path(dir, &key, path, sizeof(path)) == 0);
+
+	/* Version */
+	written = disk_cache_write(path, &key, 64, 64, 64 * 4, 0, pixels);
+	CHECK(written > 0);
+	value = DISK_CACHE_VERSION + 1;
+	patch_file(path, offsetof(disk_cache_header, version), &value, sizeof(value));
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == -1);
+
+	/* Magic */
+	disk_cache_write(path, &key, 64, 64, 64 * 4, 0, pixels);
+	value = 0;
+	patch_file(path, offsetof(disk_cache_header, magic), &value, sizeof(value));
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == -1);
+
+	/* Checksum: one flipped byte in the compressed pixels */
+	disk_cache_write(path, &key, 64, 64, 64 * 4, 0, pixels);
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == 0);
+	flip_byte(path, sizeof(header) + (written - sizeof(header)) / 2);
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == -1);
+
+	/* Sizes that don't match the payload or are out of range */
+	disk_cache_write(path, &key, 64, 64, 64 * 4, 0, pixels);
+	value = 64 * 4 + 4;
+	patch_file(path, offsetof(disk_cache_header, stride), &value, sizeof(value));
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == -1);
+	value = 0x7FFFFFFF;
+	patch_file(path, offsetof(disk_cache_header, stride), &value, sizeof(value));
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == -1);
+	disk_cache_write(path, &key, 64, 64, 64 * 4, 0, pixels);
+	value = 0;
+	patch_file(path, offsetof(disk_cache_header, w), &value, sizeof(value));
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == -1);
+
+	/* Truncated entry */
+	disk_cache_write(path, &key, 64, 64, 64 * 4, 0, pixels);
+	CHECK(truncate(path, written - 1) == 0);
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == -1);
+	CHECK(truncate(path, sizeof(header) - 1) == 0);
+	CHECK(disk_cache_read(path, &key, destination_alloc, &dst, &header) == -1);
+
+	free(dst.pixels);
+}
+
+static void test_size_and_clear(const char *dir)
+{
+	uint8_t pixels[16 * 4] = {0};
+	unsigned int entries = 99, i;
+	char path[256];
+	uint64_t size;
+	long total = 0;
+	FILE *fp;
+
+	disk_cache_clear(dir);
+	CHECK(disk_cache_size(dir, &entries) == 0 && entries == 0);
+
+	for (i = 0; i < 3; i++) {
+		disk_cache_key key = make_key(100 + i);
+		disk_cache_path(dir, &key, path, sizeof(path));
+		total += disk_cache_write(path, &key, 16, 1, 16 * 4, 0, pixels);
+	}
+
+	/* Other files in the directory are left alone */
+	snprintf(path, sizeof(path), "%s/readme.txt", dir);
+	fp = fopen(path, "wb");
+	fputs("not an entry", fp);
+	fclose(fp);
+
+	size = disk_cache_size(dir, &entries);
+	CHECK(entries == 3 && size == (uint64_t)total);
+	CHECK(disk_cache_clear(dir) == 3);
+	CHECK(disk_cache_size(dir, NULL) == 0);
+	CHECK(access(path, F_OK) == 0);
+	remove(path);
+
+	CHECK(disk_cache_size("/nonexistent/v2dc", &entries) == 0 && entries == 0);
+	CHECK(disk_cache_clear("/nonexistent/v2dc") == 0);
+}
+
+int main(void)
+{
+	char dir[] = "/tmp/disk_cache_test.XXXXXX";
+
+	if (!mkdtemp(dir)) {
+		printf("disk_cache: can't create a temporary directory\n");
+		return 1;
+	}
+
+	test_path();
+	test_round_trip(dir);
+	test_corrupt(dir);
+	test_size_and_clear(dir);
+
+	disk_cache_clear(dir);
+	rmdir(dir);
+	return check_report("disk_cache");
+}
@@ -0,0 +1,363 @@
+/*
+ * Golden image tests: scripted scenes drawn by vita2d's own sources on the
+ * vitaGL shim, rasterized by vita2d_sw and compared to the PNGs in test/golden.
+ * Each scene also has a draw call and vertex budget, so a change that breaks
+ * batching fails here even when the picture stays the same. Scenes are drawn
+ * twice and the second frame is checked, once the glyph caches are warm.
+ *
+ * Usage: golden [-u] [-d golden_dir] [scene...]
+ *   -u  rewrite the reference PNGs from the current output
+ *
+ * Mismatching scenes are written next to their reference as <scene>.actual.png.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <png.h>
+#include <vitagl_sw.h>
+#include "vita2d_vgl.h"
+
+/* Per channel difference a pixel may have, and how many pixels may exceed it */
+#define PIXEL_TOLERANCE 8
+#define MAX_BAD_PIXELS 64
+
+typedef struct golden_scene {
+	const char *name;
+	void (*draw)(void);
+	unsigned int max_draw_calls;
+	unsigned int max_vertices;
+} golden_scene;
+
+static vita2d_texture *checker;
+static vita2d_texture *sprite;
+static vita2d_font *font;
+static vita2d_pgf *pgf;
+static vita2d_pvf *pvf;
+
+static const char text[] = "The quick brown fox jumps over the lazy dog 0123456789";
+
+static void draw_shapes(void)
+{
+	int i;
+
+	vita2d_draw_rectangle(20, 20, 200, 120, RGBA8(0xFF, 0x40, 0x20, 0xFF));
+	vita2d_draw_rectangle(120, 80, 200, 120, RGBA8(0x20, 0x80, 0xFF, 0x80));
+	vita2d_draw_fill_circle(500, 120, 80, RGBA8(0x40, 0xFF, 0x40, 0xFF));
+	vita2d_draw_fill_circle(560, 160, 60, RGBA8(0xFF, 0xFF, 0x00, 0x60));
+	for (i = 0; i < 16; i++)
+		vita2d_draw_line(20 + i * 20, 260, 340 - i * 20, 520, RGBA8(i * 16, 0xFF - i * 16, 0x80, 0xFF));
+	for (i = 0; i < 64; i++)
+		vita2d_draw_pixel(700 + (i % 8) * 4, 300 + (i / 8) * 4, RGBA8(0xFF, 0xFF, 0xFF, 0xFF));
+}
+
+/* Same-texture quads of one color batch into a single draw */
+static void draw_textures(void)
+{
+	vita2d_draw_texture(checker, 20, 20);
+	vita2d_draw_texture_scale(checker, 100, 20, 3, 2);
+	vita2d_draw_texture_rotate(checker, 360, 60, 0.6f);
+	vita2d_draw_texture_rotate_hotspot(checker, 460, 60, -0.3f, 0, 0);
+	vita2d_draw_texture_part(checker, 560, 20, 8, 8, 16, 16);
+	vita2d_draw_texture_part_scale(checker, 600, 20, 8, 8, 16, 16, 4, 4);
+	vita2d_draw_texture_scale_rotate(checker, 160, 300, 4, 3, 0.4f);
+	vita2d_draw_texture_part_scale_rotate(checker, 440, 300, 0, 0, 16, 32, 3, 3, -0.8f);
+	vita2d_draw_texture_tint(checker, 700, 20, RGBA8(0xFF, 0x80, 0x40, 0xFF));
+	vita2d_draw_texture_tint_scale_rotate(checker, 800, 140, 2, 2, 1.2f, RGBA8(0x40, 0xFF, 0xFF, 0xA0));
+
+	vita2d_texture_set_filters(sprite, SCE_GXM_TEXTURE_FILTER_LINEAR, SCE_GXM_TEXTURE_FILTER_LINEAR);
+	vita2d_draw_texture_scale(sprite, 600, 300, 6, 6);
+	vita2d_texture_set_filters(sprite, SCE_GXM_TEXTURE_FILTER_POINT, SCE_GXM_TEXTURE_FILTER_POINT);
+	vita2d_draw_texture_scale_rotate(sprite, 860, 420, 4, 4, 0.25f);
+}
+
+static void draw_text_freetype(void)
+{
+	vita2d_font_draw_text(font, 20, 40, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 12, text);
+	vita2d_font_draw_text(font, 20, 100, RGBA8(0xFF, 0xC0, 0x40, 0xFF), 20, text);
+	vita2d_font_draw_text(font, 20, 180, RGBA8(0x40, 0xC0, 0xFF, 0xC0), 32, "vita2d FreeType");
+	vita2d_font_draw_text_ls(font, 20, 260, 1.5f, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 16, "first line\nsecond line\nthird line");
+}
+
+static void draw_text_pgf(void)
+{
+	vita2d_pgf_draw_text(pgf, 20, 40, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 1.0f, text);
+	vita2d_pgf_draw_text(pgf, 20, 120, RGBA8(0xFF, 0xC0, 0x40, 0xFF), 1.5f, "vita2d PGF");
+	vita2d_pgf_draw_text(pgf, 20, 200, RGBA8(0x40, 0xC0, 0xFF, 0xC0), 0.75f, text);
+	vita2d_pgf_draw_text_ls(pgf, 20, 280, 1.5f, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 1.0f, "first line\nsecond line\nthird line");
+}
+
+static void draw_text_pvf(void)
+{
+	vita2d_pvf_draw_text(pvf, 20, 40, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 1.0f, text);
+	vita2d_pvf_draw_text(pvf, 20, 120, RGBA8(0xFF, 0xC0, 0x40, 0xFF), 1.5f, "vita2d PVF");
+	vita2d_pvf_draw_text(pvf, 20, 200, RGBA8(0x40, 0xC0, 0xFF, 0xC0), 0.75f, text);
+	vita2d_pvf_draw_text_ls(pvf, 20, 280, 1.5f, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 1.0f, "first line\nsecond line\nthird line");
+}
+
+static void draw_clipping(void)
+{
+	int x_min, y_min, x_max, y_max;
+
+	vita2d_set_clip_rectangle(100, 60, 400, 300);
+	vita2d_enable_clipping();
+	vita2d_draw_rectangle(0, 0, 960, 544, RGBA8(0x30, 0x30, 0x80, 0xFF));
+	vita2d_draw_fill_circle(100, 60, 120, RGBA8(0xFF, 0x40, 0x40, 0xFF));
+	vita2d_draw_texture_scale_rotate(checker, 380, 280, 4, 4, 0.7f);
+	vita2d_font_draw_text(font, 60, 200, RGBA8(0xFF, 0xFF, 0xFF, 0xFF), 24, text);
+
+	/* The rectangle has to come back as it was set */
+	vita2d_get_clip_rectangle(&x_min, &y_min, &x_max, &y_max);
+	vita2d_set_clip_rectangle(x_min + 400, y_min + 100, x_max + 400, y_max + 100);
+	vita2d_draw_fill_circle(700, 300, 200, RGBA8(0x40, 0xFF, 0x40, 0xFF));
+	vita2d_disable_clipping();
+
+	vita2d_draw_rectangle(20, 480, 200, 40, RGBA8(0xFF, 0xFF, 0x00, 0xFF));
+}
+
+static void draw_blend_add(void)
+{
+	vita2d_set_blend_mode_add(1);
+	vita2d_draw_fill_circle(300, 220, 140, RGBA8(0xC0, 0x20, 0x20, 0xFF));
+	vita2d_draw_fill_circle(400, 220, 140, RGBA8(0x20, 0xC0, 0x20, 0xFF));
+	vita2d_draw_fill_circle(350, 320, 140, RGBA8(0x20, 0x20, 0xC0, 0xFF));
+	vita2d_draw_rectangle(600, 60, 300, 200, RGBA8(0x80, 0x80, 0x80, 0x80));
+	vita2d_draw_texture_scale(checker, 620, 280, 8, 6);
+	vita2d_draw_texture_scale_rotate(checker, 760, 400, 6, 6, 0.5f);
+	vita2d_font_draw_text(font, 620, 520, RGBA8(0xFF, 0x80, 0x20, 0xFF), 20, "additive");
+	vita2d_set_blend_mode_add(0);
+	vita2d_draw_rectangle(40, 420, 200, 100, RGBA8(0x80, 0x80, 0xFF, 0x80));
+}
+
+/* Budgets are the counts the scenes take today, raise them only on purpose */
+static const golden_scene scenes[] = {
+	{"shapes",        draw_shapes,        84, 308},
+	{"textures",      draw_textures,       5,  64},
+	{"text_freetype", draw_text_freetype,  4, 924},
+	{"text_pgf",      draw_text_pgf,       4, 894},
+	{"text_pvf",      draw_text_pvf,       4, 894},
+	{"clipping",      draw_clipping,       6, 540},
+	{"blend_add",     draw_blend_add,      7, 374},
+};
+
+static int read_png(const char *path, uint32_t **pixels, unsigned int *w, unsigned int *h)
+{
+	png_image image;
+
+	memset(&image, 0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+	if (!png_image_begin_read_from_file(&image, path))
+		return -1;
+
+	image.format = PNG_FORMAT_RGBA;
+	*pixels = malloc(PNG_IMAGE_SIZE(image));
+	if (!*pixels) {
+		png_image_free(&image);
+		return -1;
+	}
+	if (!png_image_finish_read(&image, NULL, *pixels, 0, NULL)) {
+		free(*pixels);
+		return -1;
+	}
+
+	*w = image.width;
+	*h = image.height;
+	return 0;
+}
+
+static int write_png(const char *path, const vita2d_sw_target *screen)
+{
+	png_image image;
+
+	memset(&image, 0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+	image.width = screen->w;
+	image.height = screen->h;
+	image.format = PNG_FORMAT_RGBA;
+
+	/* RGBA8() keeps red in the low byte, which is PNG's byte order */
+	return png_image_write_to_file(&image, path, 0, screen->pixels,
+				       screen->stride * sizeof(*screen->pixels), NULL) ? 0 : -1;
+}
+
+static unsigned int count_bad_pixels(const vita2d_sw_target *screen, const uint32_t *ref)
+{
+	unsigned int x, y, c, bad = 0;
+
+	for (y = 0; y < screen->h; y++) {
+		for (x = 0; x < screen->w; x++) {
+			uint32_t a = screen->pixels[y * screen->stride + x];
+			uint32_t b = ref[y * screen->w + x];
+			for (c = 0; c < 32; c += 8) {
+				if (abs((int)((a >> c) & 0xFF) - (int)((b >> c) & 0xFF)) > PIXEL_TOLERANCE) {
+					bad++;
+					break;
+				}
+			}
+		}
+	}
+	return bad;
+}
+
+static int run_scene(const golden_scene *scene, const char *dir, int update)
+{
+	vita2d_sw_target *screen = vitagl_sw_get_screen();
+	vita2d_draw_stats stats;
+	unsigned int draw_calls, vertices, w, h, bad;
+	uint32_t *ref;
+	char path[512];
+	int ret = 0, frame;
+
+	/* The first frame fills the glyph caches, the second is what a game redraws */
+	for (frame = 0; frame < 2; frame++) {
+		vita2d_start_drawing();
+		vita2d_clear_screen();
+		vita2d_reset_draw_stats();
+		vitagl_sw_reset_draw_stats();
+		scene->draw();
+		vita2d_end_drawing();
+		vita2d_swap_buffers();
+	}
+
+	vita2d_get_draw_stats(&stats);
+	vitagl_sw_get_draw_stats(&draw_calls, &vertices);
+	if (stats.draw_calls != draw_calls || stats.vertices != vertices) {
+		printf("%s: vita2d counted %u draws/%u vertices, vitaGL got %u/%u\n", scene->name,
+		       stats.draw_calls, stats.vertices, draw_calls, vertices);
+		ret = -1;
+	}
+	if (draw_calls > scene->max_draw_calls || vertices > scene->max_vertices) {
+		printf("%s: %u draws/%u vertices, over the budget of %u/%u\n", scene->name,
+		       draw_calls, vertices, scene->max_draw_calls, scene->max_vertices);
+		ret = -1;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s.png", dir, scene->name);
+	if (update) {
+		if (write_png(path, screen) < 0) {
+			printf("%s: can't write %s\n", scene->name, path);
+			return -1;
+		}
+		printf("%s: updated (%u draws, %u vertices)\n", scene->name, draw_calls, vertices);
+		return ret;
+	}
+
+	if (read_png(path, &ref, &w, &h) < 0) {
+		printf("%s: can't read %s\n", scene->name, path);
+		return -1;
+	}
+	if (w != screen->w || h != screen->h) {
+		printf("%s: reference is %ux%u, the screen %ux%u\n", scene->name, w, h, screen->w, screen->h);
+		free(ref);
+		return -1;
+	}
+
+	bad = count_bad_pixels(screen, ref);
+	free(ref);
+	if (bad > MAX_BAD_PIXELS) {
+		snprintf(path, sizeof(path), "%s/%s.actual.png", dir, scene->name);
+		write_png(path, screen);
+		printf("%s: %u pixels differ, output written to %s\n", scene->name, bad, path);
+		ret = -1;
+	}
+
+	if (ret == 0)
+		printf("%s: ok (%u draws, %u vertices)\n", scene->name, draw_calls, vertices);
+	return ret;
+}
+
+static int setup(void)
+{
+	const void *font_data;
+	size_t font_size;
+	unsigned int *pixels;
+	unsigned int stride, x, y;
+
+	if (vita2d_init() < 0)
+		return -1;
+	vita2d_set_clear_color(RGBA8(0x10, 0x10, 0x10, 0xFF));
+
+	checker = vita2d_create_empty_texture(32, 32);
+	sprite = vita2d_create_empty_texture(16, 16);
+	font_data = vitagl_sw_get_builtin_font(&font_size);
+	font = font_data ? vita2d_load_font_mem(font_data, font_size) : NULL;
+	pgf = vita2d_load_default_pgf();
+	pvf = vita2d_load_default_pvf();
+	if (!checker || !sprite || !font || !pgf || !pvf)
+		return -1;
+
+	/* Checkerboard with a gradient, so scaling and rotation errors show */
+	pixels = vita2d_texture_get_datap(checker);
+	stride = vita2d_texture_get_stride(checker) / 4;
+	for (y = 0; y < 32; y++) {
+		for (x = 0; x < 32; x++) {
+			unsigned int on = ((x / 4) ^ (y / 4)) & 1;
+			pixels[y * stride + x] = on ? RGBA8(x * 8, y * 8, 0xFF, 0xFF) : RGBA8(0x20, 0x20, 0x20, 0xC0);
+		}
+	}
+
+	/* Soft round sprite for the filtering cases */
+	pixels = vita2d_texture_get_datap(sprite);
+	stride = vita2d_texture_get_stride(sprite) / 4;
+	for (y = 0; y < 16; y++) {
+		for (x = 0; x < 16; x++) {
+			float dx = x - 7.5f, dy = y - 7.5f;
+			float d = sqrtf(dx * dx + dy * dy) / 8.0f;
+			unsigned int a = d >= 1.0f ? 0 : (unsigned int)((1.0f - d) * 0xFF);
+			pixels[y * stride + x] = RGBA8(0xFF, x * 16, y * 16, a);
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *dir = "test/golden";
+	int update = 0, failed = 0, ran = 0;
+	int i, j, first_scene = argc;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-u")) {
+			update = 1;
+		} else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+			dir = argv[++i];
+		} else if (argv[i][0] == '-') {
+			fprintf(stderr, "usage: %s [-u] [-d golden_dir] [scene...]\n", argv[0]);
+			return 1;
+		} else {
+			first_scene = i;
+			break;
+		}
+	}
+
+	if (setup() < 0) {
+		printf("golden: vita2d setup failed\n");
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(scenes) / sizeof(*scenes); i++) {
+		int selected = first_scene == argc;
+		for (j = first_scene; j < argc; j++)
+			selected |= !strcmp(argv[j], scenes[i].name);
+		if (!selected)
+			continue;
+		failed += run_scene(&scenes[i], dir, update) < 0;
+		ran++;
+	}
+
+	vita2d_free_font(font);
+	vita2d_free_pgf(pgf);
+	vita2d_free_pvf(pvf);
+	vita2d_free_texture(checker);
+	vita2d_free_texture(sprite);
+	vita2d_fini();
+
+	if (!ran) {
+		printf("golden: no scene matched\n");
+		return 1;
+	}
+	printf("%d/%d scenes passed\n", ran - failed, ran);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,472 @@
+/*
+ * Host tests for image_decode.c: the built in BMP and TGA decoders on images
+ * built in memory, decoded from a buffer and streamed through callbacks, and
+ * downscaling while decoding, in the decoders and through the temporary
+ * buffer used for decoders that can't scale.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <png.h>
+#include <jpeglib.h>
+#include "image_decode.h"
+#include "check.h"
+
+/* Destination with padded rows, so decoders have to honor the stride */
+typedef struct image {
+	uint8_t *pixels;
+	unsigned int w;
+	unsigned int h;
+	unsigned int stride;
+	unsigned int allocs;
+} image;
+
+static void *image_alloc(unsigned int w, unsigned int h, unsigned int *stride, void *userdata)
+{
+	image *img = userdata;
+
+	free(img->pixels);
+	img->w = w;
+	img->h = h;
+	img->stride = w * 4 + 12;
+	img->pixels = calloc(h, img->stride);
+	img->allocs++;
+	*stride = img->stride;
+	return img->pixels;
+}
+
+static uint32_t image_pixel(const image *img, unsigned int x, unsigned int y)
+{
+	const uint8_t *p = img->pixels + y * img->stride + x * 4;
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+typedef struct memory_source {
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+} memory_source;
+
+static int memory_read(void *user, char *data, int size)
+{
+	memory_source *src = user;
+	size_t n = src->size - src->pos < (size_t)size ? src->size - src->pos : (size_t)size;
+
+	memcpy(data, src->data + src->pos, n);
+	src->pos += n;
+	return n;
+}
+
+static void memory_skip(void *user, int n)
+{
+	memory_source *src = user;
+	src->pos = src->size - src->pos < (size_t)n ? src->size : src->pos + n;
+}
+
+static int memory_eof(void *user)
+{
+	memory_source *src = user;
+	return src->pos >= src->size;
+}
+
+static const image_decode_io memory_io = {memory_read, memory_skip, memory_eof};
+
+static int decode_stream(const uint8_t *data, size_t size, const image_decode_scale *scale, image *img)
+{
+	memory_source src = {data, size, 0};
+	return image_decode_callbacks_scaled(&memory_io, &src, scale, image_alloc, img);
+}
+
+static void put_le(uint8_t *p, uint32_t v, int bytes)
+{
+	while (bytes-- > 0) {
+		*p++ = v;
+		v >>= 8;
+	}
+}
+
+/* Test pattern, RGBA8 with red in the low byte */
+static uint32_t pattern(unsigned int x, unsigned int y, int bpp)
+{
+	return (x * 16) | ((y * 16) << 8) | ((uint32_t)(x + y) << 16) |
+	       (bpp == 32 ? (uint32_t)(0x80 + x + y) << 24 : 0xFF000000u);
+}
+
+/* Uncompressed BMP, bottom-up for positive heights, rows padded to 4 bytes */
+static uint8_t *make_bmp(unsigned int w, int h, int bpp, uint32_t (*color)(unsigned int, unsigned int, int), size_t *size)
+{
+	unsigned int rows = h < 0 ? -h : h;
+	unsigned int row_size = (w * (bpp / 8) + 3) & ~3u;
+	unsigned int x, y;
+	uint8_t *bmp;
+
+	*size = 54 + row_size * rows;
+	bmp = calloc(1, *size);
+	bmp[0] = 'B';
+	bmp[1] = 'M';
+	put_le(bmp + 2, *size, 4);
+	put_le(bmp + 10, 54, 4);
+	put_le(bmp + 14, 40, 4);
+	put_le(bmp + 18, w, 4);
+	put_le(bmp + 22, (uint32_t)h, 4);
+	put_le(bmp + 26, 1, 2);
+	put_le(bmp + 28, bpp, 2);
+
+	for (y = 0; y < rows; y++) {
+		unsigned int file_y = h > 0 ? rows - 1 - y : y;
+		uint8_t *p = bmp + 54 + file_y * row_size;
+		for (x = 0; x < w; x++) {
+			uint32_t c = color(x, y, bpp);
+			*p++ = c >> 16;
+			*p++ = c >> 8;
+			*p++ = c;
+			if (bpp == 32)
+				*p++ = c >> 24;
+		}
+	}
+	return bmp;
+}
+
+static uint8_t *make_tga(unsigned int w, unsigned int h, int bpp, int top_down, unsigned int id_length, size_t *size)
+{
+	unsigned int x, y;
+	uint8_t *tga;
+
+	*size = 18 + id_length + w * h * (bpp / 8);
+	tga = calloc(1, *size);
+	tga[0] = id_length;
+	tga[2] = 2;
+	put_le(tga + 12, w, 2);
+	put_le(tga + 14, h, 2);
+	tga[16] = bpp;
+	tga[17] = top_down ? 0x20 : 0;
+	memset(tga + 18, 0xEE, id_length);
+
+	uint8_t *p = tga + 18 + id_length;
+	for (y = 0; y < h; y++) {
+		unsigned int image_y = top_down ? y : h - 1 - y;
+		for (x = 0; x < w; x++) {
+			uint32_t c = pattern(x, image_y, bpp);
+			*p++ = c >> 16;
+			*p++ = c >> 8;
+			*p++ = c;
+			if (bpp == 32)
+				*p++ = c >> 24;
+		}
+	}
+	return tga;
+}
+
+static int matches_pattern(const image *img, unsigned int w, unsigned int h, int bpp)
+{
+	unsigned int x, y;
+
+	if (!img->pixels || img->w != w || img->h != h)
+		return 0;
+	for (y = 0; y < h; y++)
+		for (x = 0; x < w; x++)
+			if (image_pixel(img, x, y) != pattern(x, y, bpp))
+				return 0;
+	return 1;
+}
+
+static uint32_t transparent(unsigned int x, unsigned int y, int bpp)
+{
+	return pattern(x, y, bpp) & 0x00FFFFFF;
+}
+
+static void test_bmp(void)
+{
+	image img = {0};
+	uint8_t *bmp;
+	size_t size;
+
+	/* 24 bpp bottom-up, 5 * 3 bytes per row pads to 16 */
+	bmp = make_bmp(5, 3, 24, pattern, &size);
+	CHECK(image_decode_buffer(bmp, size, image_alloc, &img) == IMAGE_DECODE_OK);
+	CHECK(matches_pattern(&img, 5, 3, 24));
+	CHECK(decode_stream(bmp, size, NULL, &img) == IMAGE_DECODE_OK);
+	CHECK(matches_pattern(&img, 5, 3, 24));
+
+	/* Pixel data cut short */
+	CHECK(image_decode_buffer(bmp, size - 1, image_alloc, &img) == IMAGE_DECODE_ERROR);
+	CHECK(decode_stream(bmp, size - 1, NULL, &img) == IMAGE_DECODE_ERROR);
+	free(bmp);
+
+	/* 32 bpp top-down keeps its alpha */
+	bmp = make_bmp(4, -3, 32, pattern, &size);
+	CHECK(decode_stream(bmp, size, NULL, &img) == IMAGE_DECODE_OK);
+	CHECK(matches_pattern(&img, 4, 3, 32));
+	free(bmp);
+
+	/* 32 bpp with no alpha at all is opaque, like stb_image */
+	bmp = make_bmp(4, 2, 32, transparent, &size);
+	CHECK(image_decode_buffer(bmp, size, image_alloc, &img) == IMAGE_DECODE_OK);
+	CHECK(image_pixel(&img, 1, 1) == (transparent(1, 1, 32) | 0xFF000000u));
+	free(bmp);
+
+	/* Bitfields are left to the fallback, and there's none here */
+	bmp = make_bmp(4, 2, 32, pattern, &size);
+	put_le(bmp + 30, 3, 4);
+	img.allocs = 0;
+	CHECK(image_decode_buffer(bmp, size, image_alloc, &img) == IMAGE_DECODE_UNSUPPORTED);
+	CHECK(decode_stream(bmp, size, NULL, &img) == IMAGE_DECODE_UNSUPPORTED);
+
+	/* Oversized images fail before anything is allocated */
+	put_le(bmp + 30, 0, 4);
+	put_le(bmp + 18, IMAGE_DECODE_MAX_DIMENSION + 1, 4);
+	CHECK(image_decode_buffer(bmp, size, image_alloc, &img) == IMAGE_DECODE_ERROR);
+	put_le(bmp + 18, 4, 4);
+	put_le(bmp + 22, IMAGE_DECODE_MAX_DIMENSION + 1, 4);
+	CHECK(decode_stream(bmp, size, NULL, &img) == IMAGE_DECODE_ERROR);
+	CHECK(img.allocs == 0);
+	free(bmp);
+
+	free(img.pixels);
+}
+
+static void test_tga(void)
+{
+	image img = {0};
+	uint8_t *tga;
+	size_t size;
+
+	/* Bottom-up 24 bpp with an image ID to skip */
+	tga = make_tga(6, 4, 24, 0, 7, &size);
+	CHECK(image_decode_buffer(tga, size, image_alloc, &img) == IMAGE_DECODE_OK);
+	CHECK(matches_pattern(&img, 6, 4, 24));
+	CHECK(decode_stream(tga, size, NULL, &img) == IMAGE_DECODE_OK);
+	CHECK(matches_pattern(&img, 6, 4, 24));
+	CHECK(decode_stream(tga, size - 3, NULL, &img) == IMAGE_DECODE_ERROR);
+	free(tga);
+
+	/* Top-left origin, 32 bpp */
+	tga = make_tga(3, 5, 32, 1, 0, &size);
+	CHECK(decode_stream(tga, size, NULL, &img) == IMAGE_DECODE_OK);
+	CHECK(matches_pattern(&img, 3, 5, 32));
+
+	/* Right-to-left and color mapped images aren't recognized */
+	tga[17] |= 0x10;
+	CHECK(image_decode_buffer(tga, size, image_alloc, &img) == IMAGE_DECODE_UNSUPPORTED);
+	tga[17] &= ~0x10;
+	tga[1] = 1;
+	CHECK(decode_stream(tga, size, NULL, &img) == IMAGE_DECODE_UNSUPPORTED);
+	free(tga);
+
+	free(img.pixels);
+}
+
+static int decoded_size(const uint8_t *data, size_t size, unsigned int max_w, unsigned int max_h,
+			unsigned int *w, unsigned int *h)
+{
+	image_decode_scale scale = {max_w, max_h, IMAGE_DECODE_FILTER_BOX};
+	image img = {0};
+	int ret = decode_stream(data, size, &scale, &img);
+
+	*w = img.w;
+	*h = img.h;
+	free(img.pixels);
+	return ret;
+}
+
+static void test_scale_bmp(void)
+{
+	image_decode_scale scale = {4, 4, IMAGE_DECODE_FILTER_BOX};
+	image img = {0};
+	unsigned int x, y, w, h;
+	uint8_t *bmp;
+	size_t size;
+	int ok;
+
+	/* 8x4 into 4x4 is 4x2, each pixel the average of a 2x2 box */
+	bmp = make_bmp(8, 4, 24, pattern, &size);
+	CHECK(decode_stream(bmp, size, &scale, &img) == IMAGE_DECODE_OK);
+	CHECK(img.w == 4 && img.h == 2 && img.allocs == 1);
+	for (ok = 1, y = 0; y < 2; y++)
+		for (x = 0; x < 4; x++)
+			ok &= image_pixel(&img, x, y) == ((32 * x + 8) | ((32 * y + 8) << 8) | ((2 * x + 2 * y + 1) << 16) | 0xFF000000u);
+	CHECK(ok);
+
+	/* Point sampling keeps the middle pixel of each box, rounded up-left */
+	scale.filter = IMAGE_DECODE_FILTER_POINT;
+	CHECK(decode_stream(bmp, size, &scale, &img) == IMAGE_DECODE_OK);
+	for (ok = img.w == 4 && img.h == 2, y = 0; y < 2; y++)
+		for (x = 0; x < 4; x++)
+			ok &= image_pixel(&img, x, y) == pattern(2 * x, 2 * y, 24);
+	CHECK(ok);
+
+	/* Smaller images are never enlarged */
+	scale.max_w = 16;
+	scale.max_h = 16;
+	CHECK(decode_stream(bmp, size, &scale, &img) == IMAGE_DECODE_OK);
+	CHECK(matches_pattern(&img, 8, 4, 24));
+
+	/* The aspect ratio is kept, a 0 limit is no limit */
+	CHECK(decoded_size(bmp, size, 0, 2, &w, &h) == IMAGE_DECODE_OK && w == 4 && h == 2);
+	CHECK(decoded_size(bmp, size, 3, 0, &w, &h) == IMAGE_DECODE_OK && w == 3 && h == 2);
+	CHECK(decoded_size(bmp, size, 1, 1, &w, &h) == IMAGE_DECODE_OK && w == 1 && h == 1);
+	CHECK(decoded_size(bmp, size, 0, 0, &w, &h) == IMAGE_DECODE_OK && w == 8 && h == 4);
+	free(bmp);
+
+	/* Uneven boxes: 5 columns into 2 are 3 + 2 wide */
+	bmp = make_bmp(5, 3, 24, pattern, &size);
+	scale.max_w = 2;
+	scale.max_h = 0;
+	scale.filter = IMAGE_DECODE_FILTER_BOX;
+	CHECK(decode_stream(bmp, size, &scale, &img) == IMAGE_DECODE_OK);
+	CHECK(img.w == 2 && img.h == 1);
+	CHECK((image_pixel(&img, 0, 0) & 0xFF) == 16 && (image_pixel(&img, 1, 0) & 0xFF) == 56);
+	CHECK(((image_pixel(&img, 0, 0) >> 8) & 0xFF) == 16);
+	free(bmp);
+
+	free(img.pixels);
+}
+
+/* 16x16 RGBA, one solid color per 8x8 quadrant */
+static const uint32_t quadrant_colors[4] = {0xFF0000FF, 0x8000FF00, 0xFFFF0000, 0x40FFFFFF};
+
+static uint32_t quadrant(unsigned int x, unsigned int y)
+{
+	return quadrant_colors[(y / 8) * 2 + x / 8];
+}
+
+static void test_scale_png(void)
+{
+	image_decode_scale scale = {2, 2, IMAGE_DECODE_FILTER_BOX};
+	uint32_t pixels[16 * 16];
+	png_alloc_size_t size = 0;
+	png_image png;
+	image img = {0};
+	unsigned int x, y;
+	uint8_t *data;
+
+	for (y = 0; y < 16; y++)
+		for (x = 0; x < 16; x++)
+			pixels[y * 16 + x] = quadrant(x, y);
+
+	memset(&png, 0, sizeof(png));
+	png.version = PNG_IMAGE_VERSION;
+	png.width = 16;
+	png.height = 16;
+	png.format = PNG_FORMAT_RGBA;
+	png_image_write_to_memory(&png, NULL, &size, 0, pixels, 0, NULL);
+	data = malloc(size);
+	CHECK(data && png_image_write_to_memory(&png, data, &size, 0, pixels, 0, NULL));
+
+	CHECK(decode_stream(data, size, &scale, &img) == IMAGE_DECODE_OK);
+	CHECK(img.w == 2 && img.h == 2);
+	CHECK(img.pixels && image_pixel(&img, 0, 0) == quadrant_colors[0] && image_pixel(&img, 1, 0) == quadrant_colors[1] &&
+	      image_pixel(&img, 0, 1) == quadrant_colors[2] && image_pixel(&img, 1, 1) == quadrant_colors[3]);
+
+	/* Full size, the PNG is decoded straight into the destination */
+	CHECK(image_decode_buffer(data, size, image_alloc, &img) == IMAGE_DECODE_OK);
+	CHECK(img.w == 16 && img.h == 16 && image_pixel(&img, 15, 15) == quadrant_colors[3]);
+
+	free(data);
+	free(img.pixels);
+}
+
+static void test_scale_jpeg(void)
+{
+	image_decode_scale scale = {16, 16, IMAGE_DECODE_FILTER_BOX};
+	struct jpeg_compress_struct cinfo;
+	struct jpeg_error_mgr jerr;
+	uint8_t row[64 * 3];
+	unsigned char *data = NULL;
+	unsigned long size = 0;
+	image img = {0};
+	unsigned int x;
+	int ok;
+
+	/* 64x32 of flat gray, JPEG scales by 1/4 in the decoder and the rest after */
+	cinfo.err = jpeg_std_error(&jerr);
+	jpeg_create_compress(&cinfo);
+	jpeg_mem_dest(&cinfo, &data, &size);
+	cinfo.image_width = 64;
+	cinfo.image_height = 32;
+	cinfo.input_components = 3;
+	cinfo.in_color_space = JCS_RGB;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, 95, TRUE);
+	jpeg_start_compress(&cinfo, TRUE);
+	memset(row, 0x80, sizeof(row));
+	while (cinfo.next_scanline < cinfo.image_height) {
+		JSAMPROW rows[1] = {row};
+		jpeg_write_scanlines(&cinfo, rows, 1);
+	}
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+
+	CHECK(decode_stream(data, size, &scale, &img) == IMAGE_DECODE_OK);
+	CHECK(img.w == 16 && img.h == 8 && img.allocs == 1);
+	for (ok = img.pixels != NULL, x = 0; ok && x < 16; x++) {
+		uint32_t c = image_pixel(&img, x, 4);
+		ok = abs((int)(c & 0xFF) - 0x80) <= 2 && (c >> 24) == 0xFF;
+	}
+	CHECK(ok);
+
+	free(data);
+	free(img.pixels);
+}
+
+/*
+ * A decoder that ignores the requested scale: "RAW!", u16 width, u16 height,
+ * then RGBA8 pixels. It is handed a temporary full size buffer, which is then
+ * shrunk into the destination.
+ */
+static int raw_decode_stream(image_stream *stream, image_decode_alloc alloc, void *userdata)
+{
+	uint8_t header[8], *out;
+	unsigned int w, h, stride, y;
+
+	if (image_stream_read(stream, header, sizeof(header)) != sizeof(header) || memcmp(header, "RAW!", 4))
+		return IMAGE_DECODE_UNSUPPORTED;
+	w = header[4] | (header[5] << 8);
+	h = header[6] | (header[7] << 8);
+	out = alloc(w, h, &stride, userdata);
+	if (!out)
+		return IMAGE_DECODE_ERROR;
+	for (y = 0; y < h; y++)
+		if (image_stream_read(stream, out + y * stride, w * 4) != w * 4)
+			return IMAGE_DECODE_ERROR;
+	return IMAGE_DECODE_OK;
+}
+
+static const image_decoder raw_decoder = {"raw", "RAW!", 4, NULL, NULL, raw_decode_stream};
+
+static void test_scale_fallback(void)
+{
+	image_decode_scale scale = {2, 2, IMAGE_DECODE_FILTER_BOX};
+	uint8_t raw[8 + 16 * 16 * 4];
+	image_decoder_stats stats;
+	image img = {0};
+	unsigned int x, y;
+
+	memcpy(raw, "RAW!\x10\x00\x10\x00", 8);
+	for (y = 0; y < 16; y++)
+		for (x = 0; x < 16; x++)
+			put_le(raw + 8 + (y * 16 + x) * 4, quadrant(x, y), 4);
+
+	CHECK(image_decode_register(&raw_decoder) == 0);
+	CHECK(image_decode_get_decoder(0, &stats) == &raw_decoder);
+
+	CHECK(decode_stream(raw, sizeof(raw), &scale, &img) == IMAGE_DECODE_OK);
+	CHECK(img.w == 2 && img.h == 2 && img.allocs == 1);
+	CHECK(img.pixels && image_pixel(&img, 0, 0) == quadrant_colors[0] && image_pixel(&img, 1, 1) == quadrant_colors[3]);
+
+	CHECK(image_decode_get_decoder(0, &stats) == &raw_decoder);
+	CHECK(stats.images == 1 && stats.pixels_out == 4);
+
+	free(img.pixels);
+}
+
+int main(void)
+{
+	test_bmp();
+	test_tga();
+	test_scale_bmp();
+	test_scale_png();
+	test_scale_jpeg();
+	test_scale_fallback();
+	return check_report("image_decode");
+}
@@ -0,0 +1,181 @@
+/*
+ * Host tests for lz4_block.c: round trips over data that compresses well,
+ * badly and not at all, hand-made blocks in the reference format, and
+ * corrupt or truncated input, which must fail without writing past dst.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "lz4_block.h"
+#include "check.h"
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+static int round_trips(const uint8_t *data, size_t size)
+{
+	size_t bound = LZ4_BLOCK_BOUND(size);
+	uint8_t *compressed = malloc(bound);
+	uint8_t *out = malloc(size + 16);
+	int compressed_size, ok = 0;
+
+	compressed_size = lz4_block_compress(data, size, compressed, bound);
+	if (compressed_size > 0 && (size_t)compressed_size <= bound) {
+		/* Exactly the original size, the 16 spare bytes must stay untouched */
+		memset(out, 0xA5, size + 16);
+		ok = lz4_block_decompress(compressed, compressed_size, out, size + 16) == (int)size &&
+		     memcmp(out, data, size) == 0 && out[size] == 0xA5 && out[size + 15] == 0xA5;
+		/* and one byte less doesn't fit */
+		if (size > 0)
+			ok &= lz4_block_decompress(compressed, compressed_size, out, size - 1) == -1;
+	}
+
+	free(compressed);
+	free(out);
+	return ok;
+}
+
+static void test_round_trip(void)
+{
+	static const size_t sizes[] = {0, 1, 5, 12, 13, 64, 255, 1000, 65536 + 7, 300000};
+	static const char text[] = "vita2d draws textures, text and shapes with vitaGL. ";
+	unsigned int i;
+	size_t j, max = 300000;
+	uint8_t *data = malloc(max);
+
+	for (i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+		size_t size = sizes[i];
+
+		memset(data, 0, size);
+		CHECK(round_trips(data, size));
+
+		for (j = 0; j < size; j++)
+			data[j] = rng();
+		CHECK(round_trips(data, size));
+
+		for (j = 0; j < size; j++)
+			data[j] = text[j % (sizeof(text) - 1)];
+		CHECK(round_trips(data, size));
+
+		/* Texture-like: runs, gradients and noise, matches far apart */
+		for (j = 0; j < size; j++)
+			data[j] = (j / 4096) & 1 ? (uint8_t)(j / 7) : (j % 97 < 50 ? 0x80 : rng() & 3);
+		CHECK(round_trips(data, size));
+	}
+
+	/* Zeros compress to next to nothing */
+	int compressed_size;
+	uint8_t *compressed = malloc(LZ4_BLOCK_BOUND(max));
+	memset(data, 0, max);
+	compressed_size = lz4_block_compress(data, max, compressed, LZ4_BLOCK_BOUND(max));
+	CHECK(compressed_size > 0 && compressed_size < 2000);
+
+	/* Too small a destination fails instead of overflowing, noise never fits in its own size */
+	CHECK(lz4_block_compress(data, max, compressed, compressed_size - 1) == -1);
+	for (j = 0; j < max; j++)
+		data[j] = rng();
+	CHECK(lz4_block_compress(data, max, compressed, max) == -1);
+
+	free(compressed);
+	free(data);
+}
+
+static void test_reference_blocks(void)
+{
+	/* "abc", then a 9 byte match at offset 3, then the literals "XYZXY" */
+	static const uint8_t overlap[] = {0x35, 'a', 'b', 'c', 0x03, 0x00, 0x50, 'X', 'Y', 'Z', 'X', 'Y'};
+	/* 20 literals, the length continues in the next byte */
+	static const uint8_t long_literals[] = {0xF0, 0x05, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j',
+						'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't'};
+	/* 'z', then 4 + 15 + 255 + 1 = 275 copies of it, then "end!!" */
+	static const uint8_t long_match[] = {0x1F, 'z', 0x01, 0x00, 0xFF, 0x01, 0x50, 'e', 'n', 'd', '!', '!'};
+	/* Empty input is a single empty literal run */
+	static const uint8_t empty[] = {0x00};
+	uint8_t out[512];
+	unsigned int i;
+	int ok;
+
+	CHECK(lz4_block_decompress(overlap, sizeof(overlap), out, sizeof(out)) == 17);
+	CHECK(memcmp(out, "abcabcabcabcXYZXY", 17) == 0);
+
+	CHECK(lz4_block_decompress(long_literals, sizeof(long_literals), out, sizeof(out)) == 20);
+	CHECK(memcmp(out, "abcdefghijklmnopqrst", 20) == 0);
+
+	CHECK(lz4_block_decompress(long_match, sizeof(long_match), out, sizeof(out)) == 281);
+	for (ok = 1, i = 0; i < 276; i++)
+		ok &= out[i] == 'z';
+	CHECK(ok && memcmp(out + 276, "end!!", 5) == 0);
+
+	CHECK(lz4_block_decompress(empty, sizeof(empty), out, sizeof(out)) == 0);
+	CHECK(lz4_block_compress("", 0, out, sizeof(out)) == 1 && out[0] == 0x00);
+}
+
+static void test_corrupt(void)
+{
+	/* Match offsets of 0 and before the start of the output */
+	static const uint8_t zero_offset[] = {0x10, 'a', 0x00, 0x00, 0x10, 'b'};
+	static const uint8_t far_offset[] = {0x10, 'a', 0x02, 0x00, 0x10, 'b'};
+	/* More literals than there is input, a length byte missing */
+	static const uint8_t short_literals[] = {0x50, 'a', 'b'};
+	static const uint8_t missing_length[] = {0xF0};
+	/* Ending on a match, or halfway through an offset */
+	static const uint8_t ends_on_match[] = {0x10, 'a', 0x01, 0x00};
+	static const uint8_t half_offset[] = {0x10, 'a', 0x01};
+	size_t size = 20000, j, n;
+	uint8_t *data = malloc(size), *compressed = malloc(LZ4_BLOCK_BOUND(size)), *out = malloc(size + 64);
+	int compressed_size, ret, ok;
+
+	CHECK(lz4_block_decompress(zero_offset, sizeof(zero_offset), out, 64) == -1);
+	CHECK(lz4_block_decompress(far_offset, sizeof(far_offset), out, 64) == -1);
+	CHECK(lz4_block_decompress(short_literals, sizeof(short_literals), out, 64) == -1);
+	CHECK(lz4_block_decompress(missing_length, sizeof(missing_length), out, 64) == -1);
+	CHECK(lz4_block_decompress(ends_on_match, sizeof(ends_on_match), out, 64) == -1);
+	CHECK(lz4_block_decompress(half_offset, sizeof(half_offset), out, 64) == -1);
+	CHECK(lz4_block_decompress(zero_offset, 0, out, 64) == -1);
+
+	for (j = 0; j < size; j++)
+		data[j] = j % 251 < 120 ? (uint8_t)(j / 3) : rng() & 7;
+	compressed_size = lz4_block_compress(data, size, compressed, LZ4_BLOCK_BOUND(size));
+	CHECK(compressed_size > 0);
+
+	/* Every truncation fails or decodes less, never past the destination */
+	for (ok = 1, n = 0; n < (size_t)compressed_size; n++) {
+		memset(out + size, 0xA5, 64);
+		ret = lz4_block_decompress(compressed, n, out, size);
+		ok &= ret < (int)size && out[size] == 0xA5;
+	}
+	CHECK(ok);
+
+	/* Random byte damage, same rule */
+	for (ok = 1, n = 0; n < 2000; n++) {
+		uint8_t *damaged = malloc(compressed_size);
+		memcpy(damaged, compressed, compressed_size);
+		damaged[rng() % compressed_size] ^= 1 + rng() % 255;
+		damaged[rng() % compressed_size] = rng();
+		memset(out + size, 0xA5, 64);
+		ret = lz4_block_decompress(damaged, compressed_size, out, size);
+		ok &= ret <= (int)size && out[size] == 0xA5;
+		free(damaged);
+	}
+	CHECK(ok);
+
+	free(data);
+	free(compressed);
+	free(out);
+}
+
+int main(void)
+{
+	test_round_trip();
+	test_reference_blocks();
+	test_corrupt();
+	return check_report("lz4_block");
+}
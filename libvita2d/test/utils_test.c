@@ -0,0 +1,96 @@
+/*
+ * Host tests for the path and hash helpers in utils.c that the texture
+ * cache and the disk cache key on.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+#include "check.h"
+
+static int normalizes_to(const char *path, const char *expected)
+{
+	char *out = normalize_path(path);
+	int ok = out && strcmp(out, expected) == 0;
+
+	if (out && !ok)
+		printf("normalize_path(\"%s\") = \"%s\", expected \"%s\"\n", path, out, expected);
+	free(out);
+	return ok;
+}
+
+static void test_normalize_path(void)
+{
+	/* Every spelling of a device path ends up the same */
+	CHECK(normalizes_to("ux0:/data/sprites/player.png", "ux0:/data/sprites/player.png"));
+	CHECK(normalizes_to("ux0:data/sprites/player.png", "ux0:/data/sprites/player.png"));
+	CHECK(normalizes_to("UX0:\\Data\\Sprites\\Player.PNG", "ux0:/data/sprites/player.png"));
+	CHECK(normalizes_to("ux0://data/./sprites//player.png", "ux0:/data/sprites/player.png"));
+	CHECK(normalizes_to("ux0:/data/tmp/../sprites/player.png", "ux0:/data/sprites/player.png"));
+	CHECK(normalizes_to("app0:", "app0:/"));
+
+	/* ".." stops at the root */
+	CHECK(normalizes_to("ux0:/../data", "ux0:/data"));
+	CHECK(normalizes_to("/a/b/../../../c", "/c"));
+	CHECK(normalizes_to("/", "/"));
+
+	/* Relative paths keep the ".." they can't resolve */
+	CHECK(normalizes_to("a/b/..", "a"));
+	CHECK(normalizes_to("a/../../b", "../b"));
+	CHECK(normalizes_to("../../x/./y/", "../../x/y"));
+	CHECK(normalizes_to("./", ""));
+	CHECK(normalizes_to("", ""));
+
+	/* A colon after a separator isn't a device */
+	CHECK(normalizes_to("dir/Name:2.png", "dir/name:2.png"));
+}
+
+static void test_hash_buffer(void)
+{
+	static const char text[] = "ux0:/data/sprites/player.png";
+	char copy[sizeof(text) + 1];
+	uint64_t hashes[17];
+	unsigned int i, j;
+
+	/* MurmurHash64A reference values, cache keys on disk depend on them */
+	CHECK(hash_buffer("", 0) == 0x409820713D71EE3DULL);
+	CHECK(hash_buffer("a", 1) == 0x172D1A1C63AC4FA0ULL);
+	CHECK(hash_buffer("vita2d", 6) == 0x16BEE1D735D43F55ULL);
+	CHECK(hash_buffer(text, strlen(text)) == 0x23CE913F4A6163EDULL);
+
+	/* Unaligned input hashes the same */
+	memcpy(copy + 1, text, sizeof(text));
+	CHECK(hash_buffer(copy + 1, strlen(text)) == hash_buffer(text, strlen(text)));
+
+	/* Every tail length counts */
+	for (i = 0; i <= 16; i++)
+		hashes[i] = hash_buffer(text, i);
+	for (i = 0; i <= 16; i++)
+		for (j = i + 1; j <= 16; j++)
+			CHECK(hashes[i] != hashes[j]);
+
+	/* So does every bit */
+	for (i = 0; i < 16 * 8; i++) {
+		memcpy(copy, text, sizeof(text));
+		copy[i / 8] ^= 1 << (i % 8);
+		if (hash_buffer(copy, 16) == hash_buffer(text, 16))
+			break;
+	}
+	CHECK(i == 16 * 8);
+}
+
+static void test_hash_string(void)
+{
+	/* 32-bit FNV-1a, the name hash of the atlas index and asset pack formats */
+	CHECK(hash_string("") == 0x811C9DC5u);
+	CHECK(hash_string("a") == 0xE40C292Cu);
+	CHECK(hash_string("foobar") == 0xBF9CF968u);
+}
+
+int main(void)
+{
+	test_normalize_path();
+	test_hash_buffer();
+	test_hash_string();
+	return check_report("utils");
+}
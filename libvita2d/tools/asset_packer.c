@@ -0,0 +1,188 @@
+/*
+ * Packs every file under a directory into one asset pack, read by
+ * vita2d_open_asset_pack(). Assets are named after their path relative to
+ * the directory, '/' separated ("ui/button.png").
+ *
+ * Usage: asset_packer input_dir output.v2dp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "asset_pack.h"
+#include "utils.h"
+
+typedef struct asset {
+	char *name;
+	char *path;
+	uint32_t hash;
+	uint32_t name_offset;
+	uint32_t offset;
+	uint32_t size;
+} asset;
+
+static asset *assets;
+static unsigned int num_assets;
+
+static void add_dir(const char *dir_path, const char *prefix)
+{
+	DIR *dir = opendir(dir_path);
+	struct dirent *entry;
+	struct stat st;
+	char path[4096], name[4096];
+
+	if (!dir) {
+		fprintf(stderr, "Can't open %s\n", dir_path);
+		exit(1);
+	}
+
+	while ((entry = readdir(dir))) {
+		if (entry->d_name[0] == '.')
+			continue;
+
+		snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+		snprintf(name, sizeof(name), "%s%s", prefix, entry->d_name);
+		if (stat(path, &st) < 0)
+			continue;
+
+		if (S_ISDIR(st.st_mode)) {
+			strcat(name, "/");
+			add_dir(path, name);
+		} else if (S_ISREG(st.st_mode)) {
+			assets = realloc(assets, (num_assets + 1) * sizeof(*assets));
+			memset(&assets[num_assets], 0, sizeof(*assets));
+			assets[num_assets].name = strdup(name);
+			assets[num_assets].path = strdup(path);
+			assets[num_assets].hash = asset_pack_hash(name);
+			num_assets++;
+		}
+	}
+	closedir(dir);
+}
+
+static int compare_names(const void *a, const void *b)
+{
+	return strcmp(((const asset *)a)->name, ((const asset *)b)->name);
+}
+
+// Same hash: by name, asset_pack_find() checks them all anyway
+static int compare_hash(const void *a, const void *b)
+{
+	const asset *ia = a, *ib = b;
+	if (ia->hash != ib->hash)
+		return ia->hash < ib->hash ? -1 : 1;
+	return strcmp(ia->name, ib->name);
+}
+
+static void write_u32(FILE *fp, uint32_t v)
+{
+	uint8_t b[4] = {v, v >> 8, v >> 16, v >> 24};
+	fwrite(b, 1, 4, fp);
+}
+
+static void pad_to(FILE *fp, unsigned long offset)
+{
+	unsigned long pos = ftell(fp);
+	while (pos++ < offset)
+		fputc(0, fp);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long names_size = 0, offset, total = 0;
+	unsigned int i;
+	FILE *fp;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s input_dir output.v2dp\n", argv[0]);
+		return 1;
+	}
+
+	add_dir(argv[1], "");
+	if (num_assets == 0) {
+		fprintf(stderr, "No file in %s\n", argv[1]);
+		return 1;
+	}
+
+	// Blobs in name order, so a directory's files stay together
+	qsort(assets, num_assets, sizeof(*assets), compare_names);
+
+	for (i = 0; i < num_assets; i++) {
+		assets[i].name_offset = names_size;
+		names_size += strlen(assets[i].name) + 1;
+	}
+
+	uint32_t names_offset = sizeof(asset_pack_header) + num_assets * sizeof(asset_pack_entry);
+	offset = ALIGN(names_offset + names_size, ASSET_PACK_ALIGNMENT);
+	for (i = 0; i < num_assets; i++) {
+		struct stat st;
+		if (stat(assets[i].path, &st) < 0) {
+			fprintf(stderr, "Can't read %s\n", assets[i].path);
+			return 1;
+		}
+		assets[i].offset = offset;
+		assets[i].size = st.st_size;
+		offset = ALIGN(offset + st.st_size, ASSET_PACK_ALIGNMENT);
+		total += st.st_size;
+		if (offset > UINT32_MAX) {
+			fprintf(stderr, "Pack would be larger than 4 GiB\n");
+			return 1;
+		}
+	}
+
+	fp = fopen(argv[2], "wb");
+	if (!fp) {
+		fprintf(stderr, "Can't write %s\n", argv[2]);
+		return 1;
+	}
+
+	write_u32(fp, ASSET_PACK_MAGIC);
+	write_u32(fp, ASSET_PACK_VERSION);
+	write_u32(fp, num_assets);
+	write_u32(fp, names_offset);
+	write_u32(fp, names_size);
+	for (i = 0; i < 3; i++)
+		write_u32(fp, 0);
+
+	// The index is sorted by hash, the string table and blobs stay in name order
+	asset *index = malloc(num_assets * sizeof(*index));
+	memcpy(index, assets, num_assets * sizeof(*index));
+	qsort(index, num_assets, sizeof(*index), compare_hash);
+	for (i = 0; i < num_assets; i++) {
+		write_u32(fp, index[i].hash);
+		write_u32(fp, index[i].name_offset);
+		write_u32(fp, index[i].offset);
+		write_u32(fp, index[i].size);
+	}
+	free(index);
+
+	for (i = 0; i < num_assets; i++)
+		fwrite(assets[i].name, 1, strlen(assets[i].name) + 1, fp);
+
+	for (i = 0; i < num_assets; i++) {
+		unsigned long size;
+		void *data;
+
+		pad_to(fp, assets[i].offset);
+		if (assets[i].size == 0)
+			continue;
+		data = read_file(assets[i].path, &size);
+		if (!data || size != assets[i].size) {
+			fprintf(stderr, "Can't read %s\n", assets[i].path);
+			return 1;
+		}
+		fwrite(data, 1, size, fp);
+		free(data);
+	}
+	pad_to(fp, offset);
+
+	if (fclose(fp) != 0) {
+		fprintf(stderr, "Can't write %s\n", argv[2]);
+		return 1;
+	}
+
+	printf("%u files, %lu bytes of data, %lu byte pack\n", num_assets, total, offset);
+	return 0;
+}
@@ -0,0 +1,328 @@
+/*
+ * Packs a directory of PNGs into sprite atlas pages at build time.
+ * Writes <output>.gxt, holding every page as a linear RGBA8 texture that
+ * vita2d uploads without decoding, and <output>.v2da, the sorted index
+ * vita2d_load_sprite_atlas() uses to look sprites up by name.
+ *
+ * Usage: atlas_baker [-w page_width] [-h page_height] [-p padding] input_dir output
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include <png.h>
+#include "bin_packing_2d.h"
+#include "atlas_index.h"
+#include "utils.h"
+
+#define GXT_MAGIC          0x00545847
+#define GXT_VERSION_3      0x10000003
+#define GXT_NO_PALETTE     0xFFFFFFFF
+#define GXT_TYPE_LINEAR    0x60000000 // SCE_GXM_TEXTURE_LINEAR
+#define GXT_FORMAT_RGBA8   0x0C000000 // SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR
+#define GXT_DATA_ALIGNMENT 16
+
+typedef struct image {
+	char *name;
+	uint32_t *pixels;
+	unsigned int w;
+	unsigned int h;
+	unsigned int page;
+	unsigned int x; // position of the pixels, padding excluded
+	unsigned int y;
+	uint32_t hash;
+} image;
+
+typedef struct page {
+	bp2d_node *bp_root;
+	uint32_t *pixels;
+	unsigned int stride; // in pixels, GXM linear textures are 8 texel aligned
+} page;
+
+static unsigned int page_w = 1024;
+static unsigned int page_h = 1024;
+static unsigned int padding = 1;
+
+static int load_png(const char *path, image *img)
+{
+	png_image png;
+
+	memset(&png, 0, sizeof(png));
+	png.version = PNG_IMAGE_VERSION;
+	if (!png_image_begin_read_from_file(&png, path))
+		return -1;
+
+	png.format = PNG_FORMAT_RGBA;
+	img->w = png.width;
+	img->h = png.height;
+	img->pixels = malloc(PNG_IMAGE_SIZE(png));
+	if (!img->pixels || !png_image_finish_read(&png, NULL, img->pixels, 0, NULL)) {
+		png_image_free(&png);
+		free(img->pixels);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int compare_names(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Tallest first packs noticeably tighter with the guillotine packer
+static int compare_size(const void *a, const void *b)
+{
+	const image *ia = a, *ib = b;
+	if (ia->h != ib->h)
+		return ia->h < ib->h ? 1 : -1;
+	if (ia->w != ib->w)
+		return ia->w < ib->w ? 1 : -1;
+	return strcmp(ia->name, ib->name);
+}
+
+static int compare_hash(const void *a, const void *b)
+{
+	const image *ia = a, *ib = b;
+	return ia->hash < ib->hash ? -1 : ia->hash > ib->hash;
+}
+
+static void blit(page *p, const image *img)
+{
+	unsigned int y;
+	uint32_t *dst = p->pixels + img->y * p->stride + img->x;
+
+	for (y = 0; y < img->h; y++)
+		memcpy(dst + y * p->stride, img->pixels + y * img->w, img->w * 4);
+
+	if (padding == 0)
+		return;
+
+	// Repeat the edge texels into the first ring of padding, like vita2d_sprite_atlas_add()
+	memcpy(dst - p->stride, dst, img->w * 4);
+	memcpy(dst + img->h * p->stride, dst + (img->h - 1) * p->stride, img->w * 4);
+	for (y = 0; y < img->h; y++) {
+		uint32_t *row = dst + y * p->stride;
+		row[-1] = row[0];
+		row[img->w] = row[img->w - 1];
+	}
+}
+
+static void write_u32(FILE *fp, uint32_t v)
+{
+	uint8_t b[4] = {v, v >> 8, v >> 16, v >> 24};
+	fwrite(b, 1, 4, fp);
+}
+
+static void write_u16(FILE *fp, uint16_t v)
+{
+	uint8_t b[2] = {v, v >> 8};
+	fwrite(b, 1, 2, fp);
+}
+
+static int write_gxt(const char *path, const page *pages, unsigned int num_pages)
+{
+	uint32_t page_size = pages[0].stride * page_h * 4;
+	uint32_t data_offset = ALIGN(32 + 32 * num_pages, GXT_DATA_ALIGNMENT);
+	uint32_t padded_size = ALIGN(page_size, GXT_DATA_ALIGNMENT);
+	unsigned int i;
+	FILE *fp = fopen(path, "wb");
+
+	if (!fp)
+		return -1;
+
+	write_u32(fp, GXT_MAGIC);
+	write_u32(fp, GXT_VERSION_3);
+	write_u32(fp, num_pages);
+	write_u32(fp, data_offset);
+	write_u32(fp, padded_size * num_pages);
+	write_u32(fp, 0); // P4 palettes
+	write_u32(fp, 0); // P8 palettes
+	write_u32(fp, 0);
+
+	for (i = 0; i < num_pages; i++) {
+		write_u32(fp, data_offset + i * padded_size);
+		write_u32(fp, page_size);
+		write_u32(fp, GXT_NO_PALETTE);
+		write_u32(fp, 0); // flags
+		write_u32(fp, GXT_TYPE_LINEAR);
+		write_u32(fp, GXT_FORMAT_RGBA8);
+		write_u16(fp, page_w);
+		write_u16(fp, page_h);
+		write_u32(fp, 1); // mip count and padding
+	}
+
+	for (i = ftell(fp); i < data_offset; i++)
+		fputc(0, fp);
+
+	for (i = 0; i < num_pages; i++) {
+		static const uint8_t zero[GXT_DATA_ALIGNMENT];
+		fwrite(pages[i].pixels, 1, page_size, fp);
+		fwrite(zero, 1, padded_size - page_size, fp);
+	}
+
+	return fclose(fp) == 0 ? 0 : -1;
+}
+
+static int write_index(const char *path, const char *texture_file, const image *images, unsigned int num_images, unsigned int num_pages)
+{
+	atlas_index_header header;
+	unsigned int i;
+	FILE *fp = fopen(path, "wb");
+
+	if (!fp)
+		return -1;
+
+	memset(&header, 0, sizeof(header));
+	header.magic = ATLAS_INDEX_MAGIC;
+	header.version = ATLAS_INDEX_VERSION;
+	header.num_pages = num_pages;
+	header.num_sprites = num_images;
+	memcpy(header.texture_file, texture_file, strlen(texture_file) + 1); // length checked by main()
+	fwrite(&header, sizeof(header), 1, fp);
+
+	for (i = 0; i < num_images; i++) {
+		atlas_index_sprite sprite;
+		sprite.hash = images[i].hash;
+		sprite.page = images[i].page;
+		sprite.w = images[i].w;
+		sprite.h = images[i].h;
+		sprite.reserved = 0;
+		sprite.uv[0] = images[i].x / (float)page_w;
+		sprite.uv[1] = images[i].y / (float)page_h;
+		sprite.uv[2] = (images[i].x + images[i].w) / (float)page_w;
+		sprite.uv[3] = (images[i].y + images[i].h) / (float)page_h;
+		fwrite(&sprite, sizeof(sprite), 1, fp);
+	}
+
+	return fclose(fp) == 0 ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *input_dir = NULL, *output = NULL;
+	char **names = NULL;
+	image *images;
+	page *pages = NULL;
+	unsigned int num_names = 0, num_pages = 0, i, j;
+	struct dirent *entry;
+	char path[4096];
+	DIR *dir;
+
+	for (i = 1; i < (unsigned int)argc; i++) {
+		if (!strcmp(argv[i], "-w") && i + 1 < (unsigned int)argc) {
+			page_w = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-h") && i + 1 < (unsigned int)argc) {
+			page_h = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-p") && i + 1 < (unsigned int)argc) {
+			padding = atoi(argv[++i]);
+		} else if (!input_dir) {
+			input_dir = argv[i];
+		} else if (!output) {
+			output = argv[i];
+		} else {
+			input_dir = NULL;
+			break;
+		}
+	}
+
+	if (!input_dir || !output || page_w == 0 || page_h == 0 || page_w > 4096 || page_h > 4096) {
+		fprintf(stderr, "usage: %s [-w page_width] [-h page_height] [-p padding] input_dir output\n", argv[0]);
+		return 1;
+	}
+
+	dir = opendir(input_dir);
+	if (!dir) {
+		fprintf(stderr, "Can't open %s\n", input_dir);
+		return 1;
+	}
+	while ((entry = readdir(dir))) {
+		size_t len = strlen(entry->d_name);
+		if (len > 4 && !strcasecmp(entry->d_name + len - 4, ".png")) {
+			names = realloc(names, (num_names + 1) * sizeof(*names));
+			names[num_names++] = strdup(entry->d_name);
+		}
+	}
+	closedir(dir);
+
+	if (num_names == 0) {
+		fprintf(stderr, "No PNG in %s\n", input_dir);
+		return 1;
+	}
+
+	// Sorted input keeps the output identical from one run to the next
+	qsort(names, num_names, sizeof(*names), compare_names);
+	images = calloc(num_names, sizeof(*images));
+	for (i = 0; i < num_names; i++) {
+		snprintf(path, sizeof(path), "%s/%s", input_dir, names[i]);
+		if (load_png(path, &images[i]) < 0) {
+			fprintf(stderr, "Can't load %s\n", path);
+			return 1;
+		}
+		names[i][strlen(names[i]) - 4] = '\0';
+		images[i].name = names[i];
+		images[i].hash = atlas_index_hash(names[i]);
+	}
+
+	qsort(images, num_names, sizeof(*images), compare_size);
+	for (i = 0; i < num_names; i++) {
+		bp2d_size size = {images[i].w + padding * 2, images[i].h + padding * 2};
+		bp2d_position pos;
+		bp2d_node *node;
+
+		if ((unsigned int)size.w > page_w || (unsigned int)size.h > page_h) {
+			fprintf(stderr, "%s (%ux%u) doesn't fit in a page\n", images[i].name, images[i].w, images[i].h);
+			return 1;
+		}
+
+		for (j = 0; j < num_pages; j++) {
+			if (bp2d_insert(pages[j].bp_root, &size, &pos, &node))
+				break;
+		}
+		if (j == num_pages) {
+			bp2d_rectangle rect = {0, 0, page_w, page_h};
+			pages = realloc(pages, (num_pages + 1) * sizeof(*pages));
+			pages[j].bp_root = bp2d_create(&rect);
+			pages[j].stride = ALIGN(page_w, 8);
+			pages[j].pixels = calloc(pages[j].stride * page_h, 4);
+			num_pages++;
+			bp2d_insert(pages[j].bp_root, &size, &pos, &node);
+		}
+
+		images[i].page = j;
+		images[i].x = pos.x + padding;
+		images[i].y = pos.y + padding;
+		blit(&pages[j], &images[i]);
+	}
+
+	qsort(images, num_names, sizeof(*images), compare_hash);
+	for (i = 1; i < num_names; i++) {
+		if (images[i].hash == images[i - 1].hash) {
+			fprintf(stderr, "Name hash collision: %s and %s, rename one of them\n", images[i - 1].name, images[i].name);
+			return 1;
+		}
+	}
+
+	const char *base = strrchr(output, '/') ? strrchr(output, '/') + 1 : output;
+	char texture_file[sizeof(((atlas_index_header *)0)->texture_file)];
+	if ((size_t)snprintf(texture_file, sizeof(texture_file), "%s.gxt", base) >= sizeof(texture_file)) {
+		fprintf(stderr, "Output name too long\n");
+		return 1;
+	}
+
+	snprintf(path, sizeof(path), "%s.gxt", output);
+	if (write_gxt(path, pages, num_pages) < 0) {
+		fprintf(stderr, "Can't write %s\n", path);
+		return 1;
+	}
+	snprintf(path, sizeof(path), "%s.v2da", output);
+	if (write_index(path, texture_file, images, num_names, num_pages) < 0) {
+		fprintf(stderr, "Can't write %s\n", path);
+		return 1;
+	}
+
+	printf("%u sprites in %u %ux%u pages\n", num_names, num_pages, page_w, page_h);
+	return 0;
+}